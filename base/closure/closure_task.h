@@ -25,6 +25,7 @@
 #include "glog/logging.h"
 
 #include "base/lt_micro.h"
+#include "base/ltio_config.h"
 #include "location.h"
 
 namespace base {
@@ -41,8 +42,17 @@ public:
   const Location& TaskLocation() const { return location_; }
   std::string ClosureInfo() const { return location_.ToString(); }
 
+#ifdef LTIO_WITH_LOOP_TRACE
+  // time(us) when posted to a loop, 0: not traced
+  int64_t PostTime() const { return post_us_; }
+  void SetPostTime(int64_t us) { post_us_ = us; }
+#endif
+
 private:
   Location location_;
+#ifdef LTIO_WITH_LOOP_TRACE
+  int64_t post_us_ = 0;
+#endif
 };
 using TaskBasePtr = std::unique_ptr<TaskBase>;
 
@@ -6,6 +6,7 @@
 #include "base/logging.h"
 #include "base/lt_micro.h"
 #include "base/queue/linked_list.h"
+#include "co_context.h"
 #include "fcontext/fcontext.h"
 #include "glog/logging.h"
 
@@ -100,6 +101,8 @@ public:
     }
     return oss.str();
   }
+  // context of the task running on it, see CoroRunner::CurrentContext
+  RefContext context_;
 private:
   uint64_t resume_id_ = 0;
 
@@ -0,0 +1,115 @@
+#include "co_context.h"
+
+#include <algorithm>
+
+#include "base/time/time_utils.h"
+#include "co_runner.h"
+
+namespace co {
+
+// static
+RefContext Context::New(const RefContext& parent) {
+  return Create(parent, 0);
+}
+
+// static
+RefContext Context::WithTimeout(int64_t ms, const RefContext& parent) {
+  return Create(parent, base::time_ms() + ms);
+}
+
+// static
+RefContext Context::Create(const RefContext& parent, int64_t deadline) {
+  RefContext ctx(new Context(parent, deadline));
+  if (parent) {
+    std::weak_ptr<Context> weak(ctx);
+    ctx->parent_hook_ = parent->AddCancelHook([weak]() {
+      if (RefContext ctx = weak.lock()) {
+        ctx->Cancel();
+      }
+    });
+  }
+  return ctx;
+}
+
+// static
+RefContext Context::Current() {
+  return CoroRunner::CurrentContext();
+}
+
+Context::Context(const RefContext& parent, int64_t deadline)
+  : parent_(parent),
+    deadline_(deadline),
+    cancelled_(false) {
+  if (parent_ && parent_->deadline_ > 0) {
+    deadline_ = deadline_ > 0 ? std::min(deadline_, parent_->deadline_)
+                              : parent_->deadline_;
+  }
+}
+
+Context::~Context() {
+  if (parent_ && parent_hook_) {
+    parent_->RemoveCancelHook(parent_hook_);
+  }
+}
+
+int64_t Context::RemainMs() const {
+  if (deadline_ <= 0) {
+    return -1;
+  }
+  return std::max<int64_t>(deadline_ - base::time_ms(), 0);
+}
+
+int64_t Context::LimitTimeout(int64_t ms) const {
+  int64_t remain = RemainMs();
+  if (remain < 0) {
+    return ms;
+  }
+  return ms > 0 ? std::min(ms, remain) : remain;
+}
+
+bool Context::Done() const {
+  return cancelled_ || (deadline_ > 0 && base::time_ms() >= deadline_);
+}
+
+void Context::Cancel() {
+  std::map<uint64_t, base::LtClosure> hooks;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (cancelled_) {
+      return;
+    }
+    cancelled_ = true;
+    hooks.swap(hooks_);
+  }
+  for (auto& kv : hooks) {
+    kv.second();
+  }
+}
+
+uint64_t Context::AddCancelHook(base::LtClosure hook) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (!cancelled_) {
+      hooks_[++next_hook_] = std::move(hook);
+      return next_hook_;
+    }
+  }
+  hook();
+  return 0;
+}
+
+void Context::RemoveCancelHook(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  hooks_.erase(id);
+}
+
+ScopedContext::ScopedContext(RefContext ctx)
+  : prev_(CoroRunner::CurrentContext()) {
+  CoroRunner::SetContext(std::move(ctx));
+}
+
+ScopedContext::~ScopedContext() {
+  CoroRunner::SetContext(std::move(prev_));
+}
+
+}  // namespace co
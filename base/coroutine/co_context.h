@@ -0,0 +1,117 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LT_CORO_CONTEXT_H_
+#define _LT_CORO_CONTEXT_H_
+
+#include <atomic>
+#include <cinttypes>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <base/closure/closure_task.h>
+#include <base/lt_micro.h>
+
+namespace co {
+
+class Context;
+using RefContext = std::shared_ptr<Context>;
+
+/*
+ * deadline and cancellation of a piece of work, eg: a inbound request,
+ * shared by all coroutines working for it
+ *
+ * - HandlerFactory attach one to the handler coroutine, with the
+ *   request's TimeoutMs() as deadline
+ * - `co_go` children inherit the context of the coroutine create them
+ * - co_sleep and WaitGroup::Wait return early when it done
+ * - Client::DoRequest fail fast when it done, else take the remaining
+ *   time as request timeout
+ *
+ * auto ctx = co::Context::WithTimeout(100);
+ * co::ScopedContext scope(ctx);
+ * co_go []() {
+ *   co_sleep(1000); // wakeup after 100ms
+ * };
+ * ctx->Cancel();    // or wakeup at once, thread safe
+ * */
+class Context : public EnableShared(Context) {
+public:
+  // a child done when parent done
+  static RefContext New(const RefContext& parent = Current());
+
+  static RefContext WithTimeout(int64_t ms,
+                                const RefContext& parent = Current());
+
+  // context of current coroutine(or thread outside coroutine), maybe null
+  static RefContext Current();
+
+  ~Context();
+
+  // ms timestamp, 0 for no deadline
+  int64_t Deadline() const { return deadline_; }
+
+  // -1 for no deadline
+  int64_t RemainMs() const;
+
+  // timeout for a wait of ms(<= 0 for infinite) within deadline
+  int64_t LimitTimeout(int64_t ms) const;
+
+  // cancelled or deadline reached
+  bool Done() const;
+
+  bool IsCancelled() const { return cancelled_; }
+
+  void Cancel();
+
+  /* hook called once in Cancel's thread, at once when cancelled already;
+   * return a id for RemoveCancelHook, 0 when called at once */
+  uint64_t AddCancelHook(base::LtClosure hook);
+
+  void RemoveCancelHook(uint64_t id);
+
+private:
+  static RefContext Create(const RefContext& parent, int64_t deadline);
+  Context(const RefContext& parent, int64_t deadline);
+
+  RefContext parent_;
+  uint64_t parent_hook_ = 0;
+
+  int64_t deadline_ = 0;
+  std::atomic<bool> cancelled_;
+
+  std::mutex mtx_;
+  uint64_t next_hook_ = 0;
+  std::map<uint64_t, base::LtClosure> hooks_;
+
+  DISALLOW_COPY_AND_ASSIGN(Context);
+};
+
+// context of current coroutine replaced in this scope
+class ScopedContext {
+public:
+  explicit ScopedContext(RefContext ctx);
+  ~ScopedContext();
+
+private:
+  RefContext prev_;
+  DISALLOW_COPY_AND_ASSIGN(ScopedContext);
+};
+
+}  // namespace co
+#endif
@@ -17,6 +17,9 @@
 
 #include "co_runner.h"
 
+#include <mutex>
+#include <set>
+
 #include <base/closure/closure_task.h>
 #include <base/memory/lazy_instance.h>
 #include "bstctx_impl.hpp"
@@ -36,6 +39,17 @@ constexpr size_t kMillsPerSec = 1000;
 
 base::TaskQueue g_remote;
 
+// all alive runners for stats, leaked for runners destructed at exit
+struct RunnerRegistry {
+  std::mutex lock;
+  std::set<const co::CoroRunner*> runners;
+};
+
+RunnerRegistry* runner_registry() {
+  static RunnerRegistry* registry = new RunnerRegistry();
+  return registry;
+}
+
 class OneRunContext final {
 public:
   OneRunContext() { Reset(); };
@@ -45,6 +59,7 @@ public:
     total_cnt = 0;
     tasks.clear();
 
+    dequeued = 0;
     max_dequeue = 0;
     tsk_queue = nullptr;
   }
@@ -58,6 +73,7 @@ public:
     while (max_dequeue > 0) {
       if (tsk_queue->try_dequeue(task)) {
         max_dequeue--;
+        dequeued++;
         return true;
       }
       max_dequeue = 0;
@@ -67,6 +83,8 @@ public:
 
   size_t Remain() const { return (total_cnt - task_idx) + max_dequeue; }
 
+  size_t Dequeued() const { return dequeued; }
+
   size_t PumpFromQueue(base::TaskQueue& tq, size_t batch) {
     tq.try_dequeue_bulk(std::back_inserter(tasks), batch);
     return total_cnt = tasks.size();
@@ -94,6 +112,7 @@ private:
   size_t total_cnt;
   ::TaskList tasks;
 
+  size_t dequeued;
   size_t max_dequeue;
   base::TaskQueue* tsk_queue;
 
@@ -106,6 +125,8 @@ namespace co {
 
 class CoroRunnerImpl;
 thread_local CoroRunnerImpl* g = NULL;
+// for thread without a runner
+thread_local RefContext thread_context;
 
 template <typename Rec>
 fcontext_transfer_t context_exit(fcontext_transfer_t from) noexcept {
@@ -156,6 +177,7 @@ public:
     while ((co = freelist_.First())) {
       freelist_.Remove(co);
       co->ReleaseSelfHolder();
+      coro_count_--;
     }
     main_->ReleaseSelfHolder();
     current_ = nullptr;
@@ -169,6 +191,7 @@ public:
     do {
       base::TaskBasePtr task;
       while (run_.PopTask(task)) {
+        tasks_run_++;
         task->Run();
       }
       task.reset();  // ensure task destruction
@@ -240,6 +263,7 @@ public:
     while ((co = gc_list_.First())) {
       gc_list_.Remove(co);
       co->ReleaseSelfHolder();
+      coro_count_--;
     }
   }
 
@@ -284,6 +308,7 @@ public:
       SwitchContext(Spawn());
       FreeCoros();
     }
+    tasks_stolen_ += g->run_.Dequeued();
 
     // resume any ready coros
     while ((co = ready_list_.First())) {
@@ -298,6 +323,15 @@ public:
       sched_ticks_ = ticks;
       max_reuse_co_ = std::max(kMinReuseCoros, peek_co_actives_);
     }
+    PublishStats();
+  }
+
+  void PublishStats() {
+    stat_coroutines_.store(coro_count_, std::memory_order_relaxed);
+    stat_free_.store(freelist_.size(), std::memory_order_relaxed);
+    stat_ready_.store(ready_list_.size(), std::memory_order_relaxed);
+    stat_tasks_run_.store(tasks_run_, std::memory_order_relaxed);
+    stat_tasks_stolen_.store(tasks_stolen_, std::memory_order_relaxed);
   }
 
   /* override from MessageLoop::PersistRunner*/
@@ -320,6 +354,7 @@ public:
       // coro->Reset(context_entry<CoroRunnerImpl>, this);
       return coro;
     }
+    coro_count_++;
     return Coroutine::New(context_entry<CoroRunnerImpl>, this)->SelfHolder();
   }
 
@@ -342,6 +377,11 @@ public:
   size_t max_reuse_co_ = 64;
   size_t sched_ticks_ = 0;
   size_t peek_co_actives_ = 0;
+
+  // stats counters, published by PublishStats
+  size_t coro_count_ = 0;
+  uint64_t tasks_run_ = 0;
+  uint64_t tasks_stolen_ = 0;
 };  // end CoroRunnerImpl
 
 // static
@@ -403,9 +443,24 @@ void CoroRunner::Sleep(uint64_t ms) {
 
   MessageLoop* loop = g->bind_loop_;
 
+  // wakeup at the deadline or cancelled
+  RefContext ctx = g->current_->context_;
+  if (ctx) {
+    if (ctx->Done()) {
+      return;
+    }
+    int64_t remain = ctx->RemainMs();
+    ms = remain >= 0 ? std::min<uint64_t>(ms, remain) : ms;
+  }
+
   CHECK(loop->PostDelayTask(NewClosure(MakeResumer()), ms));
+  uint64_t hook = ctx ? ctx->AddCancelHook(MakeResumer()) : 0;
 
   g->SwitchContext(g->main_);
+
+  if (hook) {
+    ctx->RemoveCancelHook(hook);
+  }
 }
 
 // static
@@ -424,6 +479,48 @@ MessageLoop* CoroRunner::BindLoop() {
   return g ? g->bind_loop_ : nullptr;
 }
 
+// static
+RefContext CoroRunner::CurrentContext() {
+  return g ? g->current_->context_ : thread_context;
+}
+
+// static
+void CoroRunner::SetContext(RefContext ctx) {
+  if (g) {
+    g->current_->context_ = std::move(ctx);
+    return;
+  }
+  thread_context = std::move(ctx);
+}
+
+// static
+std::vector<CoroRunnerStats> CoroRunner::AllStats() {
+  std::vector<CoroRunnerStats> result;
+  RunnerRegistry* registry = runner_registry();
+  std::lock_guard<std::mutex> guard(registry->lock);
+  for (const CoroRunner* runner : registry->runners) {
+    CoroRunnerStats stats;
+    stats.loop_name = runner->stat_loop_name_;
+    stats.loop_id = runner->stat_loop_id_;
+    stats.coroutines = runner->stat_coroutines_.load(std::memory_order_relaxed);
+    stats.free = runner->stat_free_.load(std::memory_order_relaxed);
+    stats.ready = runner->stat_ready_.load(std::memory_order_relaxed);
+    size_t idle = stats.free + stats.ready;
+    stats.parked = stats.coroutines > idle ? stats.coroutines - idle : 0;
+    stats.pending_tasks = runner->remote_sched_.size_approx();
+    stats.tasks_run = runner->stat_tasks_run_.load(std::memory_order_relaxed);
+    stats.tasks_stolen =
+        runner->stat_tasks_stolen_.load(std::memory_order_relaxed);
+    result.push_back(std::move(stats));
+  }
+  return result;
+}
+
+// static
+size_t CoroRunner::PublishedTaskCount() {
+  return g_remote.size_approx();
+}
+
 // static publish a task for any runner
 bool CoroRunner::Publish(base::TaskBasePtr&& task) {
   return g_remote.enqueue(std::move(task));
@@ -431,10 +528,21 @@ bool CoroRunner::Publish(base::TaskBasePtr&& task) {
 
 CoroRunner::CoroRunner(MessageLoop* loop) : bind_loop_(loop) {
   CHECK(bind_loop_);
+  stat_loop_name_ = bind_loop_->LoopName();
+  stat_loop_id_ = bind_loop_->Pump()->LoopID();
+
+  RunnerRegistry* registry = runner_registry();
+  std::lock_guard<std::mutex> guard(registry->lock);
+  registry->runners.insert(this);
   VLOG(VINFO) << "CoroutineRunner@" << this << " initialized";
 }
 
 CoroRunner::~CoroRunner() {
+  {
+    RunnerRegistry* registry = runner_registry();
+    std::lock_guard<std::mutex> guard(registry->lock);
+    registry->runners.erase(this);
+  }
   VLOG(VINFO) << "CoroutineRunner@" << this << " gone";
 }
 
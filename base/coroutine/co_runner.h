@@ -18,11 +18,14 @@
 #ifndef BASE_COROUTINE_SCHEDULER_H_H_
 #define BASE_COROUTINE_SCHEDULER_H_H_
 
+#include <atomic>
 #include <cinttypes>
+#include <string>
 #include <vector>
 
 #include <base/lt_micro.h>
 #include <base/message_loop/message_loop.h>
+#include "co_context.h"
 
 namespace co {
 
@@ -42,12 +45,32 @@ namespace co {
  * */
 class Coroutine;
 
+/* runtime counters of a runner, see CoroRunner::AllStats */
+struct CoroRunnerStats {
+  std::string loop_name;
+  uint64_t loop_id = 0;
+  // alive coroutines, exclude main coroutine
+  size_t coroutines = 0;
+  // cached in freelist for reuse
+  size_t free = 0;
+  // resumed and waiting to run
+  size_t ready = 0;
+  // yield and waiting for a resumer
+  size_t parked = 0;
+  // scheduled tasks not run yet
+  size_t pending_tasks = 0;
+  // total tasks run by this runner, and stolen from the global queue
+  uint64_t tasks_run = 0;
+  uint64_t tasks_stolen = 0;
+};
+
 class CoroRunner : public base::PersistRunner {
 public:
   typedef struct _go {
     _go(const char* func, const char* file, int line)
       : location_(func, file, line),
-        loop_(base::MessageLoop::Current()) {}
+        loop_(base::MessageLoop::Current()),
+        context_(CoroRunner::CurrentContext()) {}
 
     /* specific a loop for this task*/
     inline _go& operator-(base::MessageLoop* loop) {
@@ -62,14 +85,42 @@ public:
      * */
     template <typename Functor>
     inline void operator-(Functor func) {
-      CoroRunner::Publish(CreateClosure(location_, func));
-      loop()->WakeUpIfNeeded();
+      if (context_) {
+        return publish(with_context(context_, func));
+      }
+      publish(func);
     }
 
     // here must make sure all things wrapper(copy) into closue,
     // becuase __go object will destruction before task closure run
     template <typename Functor>
     inline void operator<<(Functor closure_fn) {
+      if (context_) {
+        return post(with_context(context_, closure_fn));
+      }
+      post(closure_fn);
+    }
+
+    inline base::MessageLoop* loop() {
+      return loop_ ? loop_ : CoroRunner::backgroup();
+    }
+
+    template <typename Functor>
+    static auto with_context(RefContext ctx, Functor func) {
+      return [ctx, func]() mutable {
+        ScopedContext scope(ctx);
+        func();
+      };
+    }
+
+    template <typename Functor>
+    inline void publish(Functor func) {
+      CoroRunner::Publish(CreateClosure(location_, func));
+      loop()->WakeUpIfNeeded();
+    }
+
+    template <typename Functor>
+    inline void post(Functor closure_fn) {
       auto func = [closure_fn](const base::Location& location) {
         CoroRunner& runner = CoroRunner::instance();
         runner.AppendTask(CreateClosure(location, closure_fn));
@@ -77,11 +128,10 @@ public:
       loop()->PostTask(location_, func, location_);
     }
 
-    inline base::MessageLoop* loop() {
-      return loop_ ? loop_ : CoroRunner::backgroup();
-    }
     base::Location location_;
     base::MessageLoop* loop_ = nullptr;
+    // inherited by the task
+    RefContext context_;
   } _go;
 
 public:
@@ -108,6 +158,17 @@ public:
 
   static base::MessageLoop* BindLoop();
 
+  // context of current coroutine, see co::Context
+  static RefContext CurrentContext();
+
+  static void SetContext(RefContext ctx);
+
+  // thread safe, stats of all runners published at the end of each Run
+  static std::vector<CoroRunnerStats> AllStats();
+
+  // tasks published by CO_GO not picked by any runner
+  static size_t PublishedTaskCount();
+
 public:
   virtual ~CoroRunner();
 
@@ -132,6 +193,15 @@ protected:
 
   base::MessageLoop* bind_loop_ = nullptr;
 
+  // stats, written by runner's loop thread only
+  std::string stat_loop_name_;
+  uint64_t stat_loop_id_ = 0;
+  std::atomic<size_t> stat_coroutines_ = {0};
+  std::atomic<size_t> stat_free_ = {0};
+  std::atomic<size_t> stat_ready_ = {0};
+  std::atomic<uint64_t> stat_tasks_run_ = {0};
+  std::atomic<uint64_t> stat_tasks_stolen_ = {0};
+
   DISALLOW_COPY_AND_ASSIGN(CoroRunner);
 };
 
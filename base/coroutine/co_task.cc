@@ -0,0 +1,156 @@
+#include "co_task.h"
+
+#include <glog/logging.h>
+
+namespace co {
+
+namespace {
+
+// frames rounded up to 64 bytes, larger than 4k not cached
+const size_t kFrameAlign = 64;
+const size_t kBucketCount = 64;
+const size_t kMaxCachedPerBucket = 16384;
+
+struct FreeFrame {
+  FreeFrame* next;
+};
+
+struct FrameCache {
+  ~FrameCache() {
+    for (size_t i = 0; i < kBucketCount; i++) {
+      while (buckets[i]) {
+        FreeFrame* frame = buckets[i];
+        buckets[i] = frame->next;
+        ::operator delete(frame);
+      }
+    }
+  }
+
+  FreeFrame* buckets[kBucketCount] = {nullptr};
+  size_t counts[kBucketCount] = {0};
+  size_t cached = 0;
+};
+
+thread_local FrameCache frame_cache;
+
+inline size_t bucket_of(size_t size) {
+  return (size + kFrameAlign - 1) / kFrameAlign - 1;
+}
+
+void resume_later(base::MessageLoop* loop, std::coroutine_handle<> handle) {
+  loop->PostTask(FROM_HERE, [handle]() { handle.resume(); });
+}
+
+}  // namespace
+
+// static
+void* FramePool::Alloc(size_t size) {
+  size_t bucket = bucket_of(size);
+  if (bucket >= kBucketCount) {
+    return ::operator new(size);
+  }
+  FrameCache& cache = frame_cache;
+  FreeFrame* frame = cache.buckets[bucket];
+  if (frame) {
+    cache.buckets[bucket] = frame->next;
+    cache.counts[bucket]--;
+    cache.cached--;
+    return frame;
+  }
+  return ::operator new((bucket + 1) * kFrameAlign);
+}
+
+// static
+void FramePool::Free(void* ptr, size_t size) {
+  size_t bucket = bucket_of(size);
+  FrameCache& cache = frame_cache;
+  if (bucket >= kBucketCount ||
+      cache.counts[bucket] >= kMaxCachedPerBucket) {
+    return ::operator delete(ptr);
+  }
+  // may freed by other loop, then cached by that one
+  FreeFrame* frame = static_cast<FreeFrame*>(ptr);
+  frame->next = cache.buckets[bucket];
+  cache.buckets[bucket] = frame;
+  cache.counts[bucket]++;
+  cache.cached++;
+}
+
+// static
+size_t FramePool::CachedCount() {
+  return frame_cache.cached;
+}
+
+void Spawn(base::MessageLoop* loop, Task<void>&& task) {
+  CHECK(loop && task.Valid());
+
+  Task<void>::Handle handle = task.Release();
+  handle.promise().detached_ = true;
+  resume_later(loop, handle);
+}
+
+void SleepAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  base::MessageLoop* loop = base::MessageLoop::Current();
+  CHECK(loop);
+  loop->PostDelayTask(NewClosure([handle]() { handle.resume(); }), ms_);
+}
+
+IOAwaiter::IOAwaiter(base::FdEvent* fdev, int64_t ms)
+  : fdev_(fdev),
+    ms_(ms) {}
+
+IOAwaiter::~IOAwaiter() {
+  CHECK(!handle_) << "destroyed while waiting";
+}
+
+void IOAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  loop_ = base::MessageLoop::Current();
+  CHECK(loop_ && fdev_->GetFd() > 0);
+
+  handle_ = handle;
+  fdev_->SetHandler(this);
+  if (fdev_->MonitorEvents() == LtEv::NONE) {
+    fdev_->EnableReading();
+    fdev_->EnableWriting();
+  }
+  CHECK(loop_->Pump()->InstallFdEvent(fdev_));
+
+  if (ms_ > 0) {
+    timer_.reset(new base::TimeoutEvent(ms_, false));
+    timer_->SetAutoDelete(false);
+    timer_->InstallHandler(NewClosure([this]() { done(IOEvent::Timeout); }));
+    loop_->Pump()->AddTimeoutEvent(timer_.get());
+  }
+}
+
+void IOAwaiter::HandleEvent(base::FdEvent* fdev, LtEv::Event ev) {
+  done((fdev->MonitorEvents() & ev) ? IOEvent::Ok : IOEvent::Error);
+}
+
+void IOAwaiter::done(IOEvent::Result res) {
+  if (!handle_) {
+    return;
+  }
+  result_ = res;
+  if (timer_) {
+    loop_->Pump()->RemoveTimeoutEvent(timer_.get());
+  }
+  fdev_->SetHandler(nullptr);
+  loop_->Pump()->RemoveFdEvent(fdev_);
+
+  // not in handler, this gone when task resumed
+  resume_later(loop_, std::exchange(handle_, nullptr));
+}
+
+bool WaitGroupAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  base::MessageLoop* loop = wg_->loop_;
+  CHECK(loop->IsInLoopThread());
+  return wg_->wait_prepare([loop, handle]() { resume_later(loop, handle); },
+                           ms_);
+}
+
+WaitGroup::Result WaitGroupAwaiter::await_resume() {
+  return wg_->wait_finish();
+}
+
+}  // namespace co
@@ -0,0 +1,330 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LT_CORO_CO_TASK_H_
+#define _LT_CORO_CO_TASK_H_
+
+#include <base/ltio_config.h>
+
+#ifdef LTIO_WITH_CXX20_COROUTINE
+
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include <base/lt_micro.h>
+#include <base/message_loop/fd_event.h>
+#include <base/message_loop/message_loop.h>
+#include <base/message_loop/timeout_event.h>
+#include "io_event.h"
+#include "wait_group.h"
+
+/*
+ * stackless c++20 coroutine, build with LTIO_WITH_CXX20_COROUTINE
+ *
+ * a co::Task frame is a few hundred bytes from a per loop(thread)
+ * FramePool instead of a 64k stack of the fcontext Coroutine, use it
+ * for a huge number of concurrent waits, eg: fan-out requests
+ *
+ * co::Task<int> fetch(lt::net::Client* client, RefCodecMessage req) {
+ *   CodecMessage* res = co_await client->AwaitRequest(req);
+ *   co_return res ? 0 : -1;
+ * }
+ *
+ * co::Task<> handle() {
+ *   co_await co::SleepFor(10);
+ *   int code = co_await fetch(client, req);
+ * }
+ *
+ * co::Spawn(loop, handle());
+ *
+ * a Task is lazy, it run when co_await-ed or spawned; awaiters resume
+ * the task in the loop it suspended, so all of a task run in one loop
+ *
+ * NOTE: a coroutine lambda take things by parameters, not captures,
+ * the closure object gone before the task run
+ * */
+namespace co {
+
+// freelist of coroutine frames per thread(loop), bucketed by size
+class FramePool {
+public:
+  static void* Alloc(size_t size);
+
+  static void Free(void* ptr, size_t size);
+
+  // frames cached in current thread
+  static size_t CachedCount();
+};
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+class PromiseBase {
+public:
+  static void* operator new(size_t size) { return FramePool::Alloc(size); }
+  static void operator delete(void* ptr, size_t size) {
+    FramePool::Free(ptr, size);
+  }
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> handle) noexcept {
+      PromiseBase& promise = handle.promise();
+      if (promise.continuation_) {
+        return promise.continuation_;
+      }
+      if (promise.detached_) {
+        // nobody take the exception of a spawned task
+        if (promise.exception_) {
+          std::rethrow_exception(promise.exception_);
+        }
+        handle.destroy();
+      }
+      return std::noop_coroutine();
+    }
+
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  FinalAwaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() { exception_ = std::current_exception(); }
+
+  void rethrow_if_exception() {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+  }
+
+  // awaiting task resumed when this one done
+  std::coroutine_handle<> continuation_;
+  std::exception_ptr exception_;
+  // spawned, frame destroy itself when done
+  bool detached_ = false;
+};
+
+template <typename T>
+class Promise : public PromiseBase {
+public:
+  Task<T> get_return_object() noexcept;
+
+  template <typename U>
+  void return_value(U&& value) {
+    value_.emplace(std::forward<U>(value));
+  }
+
+  T result() {
+    rethrow_if_exception();
+    return std::move(*value_);
+  }
+
+private:
+  std::optional<T> value_;
+};
+
+template <>
+class Promise<void> : public PromiseBase {
+public:
+  Task<void> get_return_object() noexcept;
+
+  void return_void() noexcept {}
+
+  void result() { rethrow_if_exception(); }
+};
+
+}  // namespace detail
+
+template <typename T>
+class Task {
+public:
+  using promise_type = detail::Promise<T>;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  Task() = default;
+  explicit Task(Handle handle) : handle_(handle) {}
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      reset();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  ~Task() { reset(); }
+
+  bool Valid() const { return bool(handle_); }
+  bool Done() const { return handle_ && handle_.done(); }
+
+  // start this task and resume the awaiting one when it done
+  auto operator co_await() noexcept {
+    struct Awaiter {
+      bool await_ready() noexcept { return !handle_ || handle_.done(); }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation_ = awaiting;
+        return handle_;
+      }
+      T await_resume() { return handle_.promise().result(); }
+      Handle handle_;
+    };
+    return Awaiter{handle_};
+  }
+
+  // give up the frame, caller in charge of it
+  Handle Release() { return std::exchange(handle_, {}); }
+
+private:
+  void reset() {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = nullptr;
+    }
+  }
+
+  Handle handle_;
+  DISALLOW_COPY_AND_ASSIGN(Task);
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> Promise<T>::get_return_object() noexcept {
+  return Task<T>(Task<T>::Handle::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object() noexcept {
+  return Task<void>(Task<void>::Handle::from_promise(*this));
+}
+
+}  // namespace detail
+
+// run a task in loop without waiting for it, frame freed when done
+void Spawn(base::MessageLoop* loop, Task<void>&& task);
+
+// co_await SleepFor(ms), timer of current loop
+class SleepAwaiter {
+public:
+  explicit SleepAwaiter(int64_t ms) : ms_(ms) {}
+
+  bool await_ready() const noexcept { return ms_ <= 0; }
+  void await_suspend(std::coroutine_handle<> handle);
+  void await_resume() noexcept {}
+
+private:
+  int64_t ms_;
+};
+
+inline SleepAwaiter SleepFor(int64_t ms) {
+  return SleepAwaiter(ms);
+}
+
+/* co_await WaitIO(fdev, ms) till fd ready or timeout, result same as
+ * co::IOEvent::Wait; fdev installed only while waiting */
+class IOAwaiter : public base::FdEvent::Handler {
+public:
+  IOAwaiter(base::FdEvent* fdev, int64_t ms);
+  ~IOAwaiter();
+
+  bool await_ready() const noexcept { return false; }
+  void await_suspend(std::coroutine_handle<> handle);
+  IOEvent::Result await_resume() noexcept { return result_; }
+
+private:
+  void HandleEvent(base::FdEvent* fdev, LtEv::Event ev) override;
+  void done(IOEvent::Result res);
+
+  base::FdEvent* fdev_;
+  int64_t ms_;
+  base::MessageLoop* loop_ = nullptr;
+  std::unique_ptr<base::TimeoutEvent> timer_;
+  std::coroutine_handle<> handle_;
+  IOEvent::Result result_ = IOEvent::None;
+  DISALLOW_COPY_AND_ASSIGN(IOAwaiter);
+};
+
+inline IOAwaiter WaitIO(base::FdEvent* fdev, int64_t ms = -1) {
+  return IOAwaiter(fdev, ms);
+}
+
+// co_await WaitAll(wg, ms) like wg->Wait(ms), in the wg's loop
+class WaitGroupAwaiter {
+public:
+  WaitGroupAwaiter(RefWaitGroup wg, int64_t ms)
+    : wg_(std::move(wg)), ms_(ms) {}
+
+  bool await_ready() const noexcept { return false; }
+  bool await_suspend(std::coroutine_handle<> handle);
+  WaitGroup::Result await_resume();
+
+private:
+  RefWaitGroup wg_;
+  int64_t ms_;
+};
+
+inline WaitGroupAwaiter WaitAll(RefWaitGroup wg, int64_t ms = -1) {
+  return WaitGroupAwaiter(std::move(wg), ms);
+}
+
+/* bridge a callback style api, `start` get a callback and return false
+ * when nothing started, then T() returned without suspending; callback
+ * must be called once, from any thread
+ *
+ * auto res = co_await CallbackAwaiter<int>([](std::function<void(int)> cb) {
+ *   return async_call(cb);
+ * });
+ * */
+template <typename T>
+class CallbackAwaiter {
+public:
+  using Callback = std::function<void(T)>;
+  using Starter = std::function<bool(Callback)>;
+
+  explicit CallbackAwaiter(Starter start) : start_(std::move(start)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    base::MessageLoop* loop = base::MessageLoop::Current();
+    CHECK(loop);
+    // always posted, callback may be called before start_ return
+    return start_([this, loop, handle](T value) {
+      value_ = std::move(value);
+      loop->PostTask(FROM_HERE, [handle]() { handle.resume(); });
+    });
+  }
+
+  T await_resume() { return std::move(value_); }
+
+private:
+  Starter start_;
+  T value_ = T();
+};
+
+}  // namespace co
+
+#endif  // LTIO_WITH_CXX20_COROUTINE
+#endif
@@ -79,6 +79,10 @@ IOEvent::Result IOEvent::Wait(int ms) {
 }
 
 void IOEvent::HandleEvent(base::FdEvent* fdev, LtEv::Event ev) {
+  // nobody waiting, eg: a edge triggered fd ready while coro busy
+  if (!resumer_) {
+    return;
+  }
   if (fdev->MonitorEvents() & ev) {
     set_result(Result::Ok);
   } else {
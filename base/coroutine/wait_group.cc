@@ -49,26 +49,67 @@ void WaitGroup::Add(int64_t count) {
 }
 
 void WaitGroup::OnTimeOut() {
+  // done already, waiting for resume
+  if (!resumer_) {
+    return;
+  }
   result_status_ = kTimeout;
   wakeup_internal();
 }
 
 void WaitGroup::wakeup_internal() {
-  if (resumer_)
-    resumer_();
+  // once, a stackless waiter can't be resumed twice
+  base::LtClosure resumer = std::move(resumer_);
+  resumer_ = nullptr;
+  if (resumer)
+    resumer();
 }
 
 WaitGroup::Result WaitGroup::Wait(int64_t timeout_ms) {
+  // give up as timeout when context done
+  RefContext ctx = Context::Current();
+  if (ctx) {
+    if (ctx->Done()) {
+      return wait_count_.load() == 0 ? kSuccess : kTimeout;
+    }
+    timeout_ms = ctx->LimitTimeout(timeout_ms);
+    // deadline passed since Done(), 0 means no timer to wait_prepare
+    if (ctx->Deadline() > 0 && timeout_ms <= 0) {
+      return wait_count_.load() == 0 ? kSuccess : kTimeout;
+    }
+  }
+
+  if (!wait_prepare(CO_RESUMER, timeout_ms)) {
+    return kSuccess;
+  }
+
+  uint64_t hook = 0;
+  if (ctx) {
+    auto guard = shared_from_this();
+    hook = ctx->AddCancelHook([guard]() {
+      guard->loop_->PostTask(FROM_HERE, &WaitGroup::OnTimeOut, guard);
+    });
+  }
+
+  CO_YIELD;
+
+  if (hook) {
+    ctx->RemoveCancelHook(hook);
+  }
+  return wait_finish();
+}
+
+bool WaitGroup::wait_prepare(base::LtClosure resumer, int64_t timeout_ms) {
   if (flag_.test_and_set()) {
     CHECK(false);
-    return kSuccess;
+    return false;
   }
 
   if (0 == wait_count_.load()) {
-    return kSuccess;
+    return false;
   }
 
-  resumer_ = CO_RESUMER;
+  resumer_ = std::move(resumer);
 
   if (timeout_ms > 0) {
     timeout_.reset(base::TimeoutEvent::CreateOneShot(timeout_ms, false));
@@ -79,9 +120,10 @@ WaitGroup::Result WaitGroup::Wait(int64_t timeout_ms) {
     timeout_->InstallHandler(NewClosure(std::move(functor)));
     loop_->Pump()->AddTimeoutEvent(timeout_.get());
   }
+  return true;
+}
 
-  CO_YIELD;
-
+WaitGroup::Result WaitGroup::wait_finish() {
   if (timeout_) {
     loop_->Pump()->RemoveTimeoutEvent(timeout_.get());
   }
@@ -42,6 +42,7 @@
  *
  * // max 1secon timeout waith;
  * // must in same context
+ * // kTimeout too when co::Context of the coroutine done
  * wg->Wait(1000);
  * ```
  *
@@ -67,11 +68,16 @@ public:
   Result Wait(int64_t timeout_ms = -1);
 
 private:
+  friend class WaitGroupAwaiter;
   WaitGroup();
 
   void OnTimeOut();
   void wakeup_internal();
 
+  // false when nothing to wait, else resumer called once all done
+  bool wait_prepare(base::LtClosure resumer, int64_t timeout_ms);
+  Result wait_finish();
+
   base::LtClosure resumer_;
 
   // only rw same loop
@@ -20,11 +20,13 @@
 #include <algorithm>
 
 #include "base/logging.h"
+#include "base/time/time_utils.h"
 #include "event_pump.h"
 #include "fd_event.h"
 #include "io_multiplexer.h"
 #include "io_mux_epoll.h"
 #include "linux_signal.h"
+#include "loop_tracer.h"
 
 #include "glog/logging.h"
 
@@ -72,7 +74,9 @@ void EventPump::Pump(uint64_t ms) {
 
   ms = std::min(ms, NextTimeout());
 
+  wakeup_us_.store(0, std::memory_order_relaxed);
   int count = io_mux_->WaitingIO(fired_list_, ms);
+  wakeup_us_.store(time_us(), std::memory_order_relaxed);
 
   ProcessTimerEvent();
 
@@ -104,12 +108,18 @@ bool EventPump::RemoveFdEvent(FdEvent* fd_event) {
 void EventPump::AddTimeoutEvent(TimeoutEvent* timeout_ev) {
   CHECK(IsInLoop());
 
+  if (!timeout_ev->IsAttached()) {
+    timer_count_.fetch_add(1, std::memory_order_relaxed);
+  }
   add_timer_internal(time_ms(), timeout_ev);
 }
 
 void EventPump::RemoveTimeoutEvent(TimeoutEvent* timeout_ev) {
   CHECK(IsInLoop());
 
+  if (timeout_ev->IsAttached()) {
+    timer_count_.fetch_sub(1, std::memory_order_relaxed);
+  }
   ::timeouts_del(timeout_wheel_, timeout_ev);
 }
 
@@ -125,6 +135,10 @@ void EventPump::ProcessTimerEvent() {
   Timeout* expired = NULL;
   while (NULL != (expired = timeouts_get(timeout_wheel_))) {
     TimeoutEvent* timeout_ev = static_cast<TimeoutEvent*>(expired);
+    // repeated event has been re-added by timeouts_get
+    if (!timeout_ev->IsAttached()) {
+      timer_count_.fetch_sub(1, std::memory_order_relaxed);
+    }
 
     timeout_ev->Invoke();
 
@@ -138,6 +152,15 @@ void EventPump::InvokeFiredEvent(FiredEvent* evs, int count) {
   for (int i = 0; i < count; i++) {
     FdEvent* fd_event = io_mux_->FindFdEvent(evs[i].fd_id);
     if (fd_event) {
+#ifdef LTIO_WITH_LOOP_TRACE
+      LoopTracer* tracer = GetLoopTracer();
+      if (tracer) {
+        internal::ScopedIOEventTrace trace(tracer, fd_event->GetFd());
+        fd_event->Invoke(evs[i].event_mask);
+        evs[i].reset();
+        continue;
+      }
+#endif
       fd_event->Invoke(evs[i].event_mask);
     } else {
       LOG(ERROR) << "event removed by previous handler or timeout";
@@ -190,6 +213,7 @@ void EventPump::FinalizeTimeWheel() {
 
   ::timeouts_close(timeout_wheel_);
   timeout_wheel_ = NULL;
+  timer_count_.store(0, std::memory_order_relaxed);
 }
 
 }  // namespace base
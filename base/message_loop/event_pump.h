@@ -20,6 +20,7 @@
 
 #include <inttypes.h>
 
+#include <atomic>
 #include <map>
 #include <memory>
 #include <thread>
@@ -69,6 +70,17 @@ public:
   uint64_t LoopID() const { return loop_id_;}
 
   static uint64_t CurrentThreadLoopID();
+
+  /* counters below written by loop thread, can be read in any thread*/
+  // timeout events in the time wheel
+  size_t TimerCount() const {
+    return timer_count_.load(std::memory_order_relaxed);
+  }
+
+  // time(us) of last wakeup from io waiting, 0 when waiting io
+  int64_t WakeupTime() const {
+    return wakeup_us_.load(std::memory_order_relaxed);
+  }
 protected:
   /* update the time wheel mononic time and get all expired
    * timeoutevent will be invoke and re shedule if was repeated*/
@@ -102,6 +114,10 @@ private:
   std::vector<FiredEvent> fired_list_;
 
   TimeoutWheel* timeout_wheel_ = nullptr;
+
+  std::atomic<size_t> timer_count_ = {0};
+
+  std::atomic<int64_t> wakeup_us_ = {0};
 };
 
 }  // namespace base
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "loop_tracer.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "base/time/time_utils.h"
+#include "glog/logging.h"
+#include "message_loop.h"
+
+namespace base {
+
+namespace {
+
+std::atomic<LoopTracer*> g_tracer = {nullptr};
+
+// slow tasks reported in current thread
+thread_local uint64_t slow_task_count = 0;
+
+const char* loop_name(const MessageLoop* loop) {
+  return loop ? loop->LoopName().c_str() : "";
+}
+
+}  // namespace
+
+void SetLoopTracer(LoopTracer* tracer) {
+#ifndef LTIO_WITH_LOOP_TRACE
+  LOG_IF(WARNING, tracer)
+      << "ltio built without LTIO_WITH_LOOP_TRACE, tracer never be called";
+#endif
+  g_tracer.store(tracer, std::memory_order_release);
+}
+
+LoopTracer* GetLoopTracer() {
+  return g_tracer.load(std::memory_order_acquire);
+}
+
+namespace internal {
+
+ScopedTaskTrace::ScopedTaskTrace(LoopTracer* tracer,
+                                 const Location& location,
+                                 int64_t post_us)
+  : tracer_(tracer),
+    location_(location),
+    post_us_(post_us),
+    start_us_(time_us()) {}
+
+ScopedTaskTrace::~ScopedTaskTrace() {
+  int64_t run_us = time_us() - start_us_;
+  int64_t queue_us = post_us_ > 0 ? std::max(start_us_ - post_us_, int64_t(0))
+                                  : -1;
+  const MessageLoop* loop = MessageLoop::Current();
+  tracer_->OnTaskRun(loop, location_, queue_us, run_us);
+
+  int64_t threshold = tracer_->GetOptions().slow_task_us;
+  if (threshold > 0 && run_us >= threshold) {
+    LOG(WARNING) << "slow task, loop:" << loop_name(loop)
+                 << ", cost:" << run_us << "us, queued:" << queue_us
+                 << "us, from:" << location_.ToString();
+    tracer_->OnSlowTask(loop, location_, run_us);
+    slow_task_count++;
+  }
+}
+
+ScopedIOEventTrace::ScopedIOEventTrace(LoopTracer* tracer, int fd)
+  : tracer_(tracer),
+    fd_(fd),
+    slow_count_(slow_task_count),
+    start_us_(time_us()) {}
+
+ScopedIOEventTrace::~ScopedIOEventTrace() {
+  int64_t run_us = time_us() - start_us_;
+  int64_t threshold = tracer_->GetOptions().slow_task_us;
+  // the slow task run inside has been reported
+  if (threshold <= 0 || run_us < threshold ||
+      slow_task_count != slow_count_) {
+    return;
+  }
+  const MessageLoop* loop = MessageLoop::Current();
+  LOG(WARNING) << "slow io event, loop:" << loop_name(loop) << ", fd:" << fd_
+               << ", cost:" << run_us << "us";
+  tracer_->OnSlowTask(loop, FROM_HERE, run_us);
+  slow_task_count++;
+}
+
+}  // namespace internal
+}  // namespace base
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LT_BASE_LOOP_TRACER_H_
+#define _LT_BASE_LOOP_TRACER_H_
+
+#include <cinttypes>
+
+#include "base/closure/location.h"
+#include "base/ltio_config.h"
+
+namespace base {
+
+class MessageLoop;
+
+/* opt-in timing of loop tasks, the hooks are compiled into
+ * MessageLoop/EventPump only when build with LTIO_WITH_LOOP_TRACE
+ * (cmake -DLTIO_WITH_LOOP_TRACE=ON), otherwise a installed tracer
+ * is never called
+ *
+ * traced: tasks run by loop(queueing delay + run time), timer tasks
+ * (run time), io events(slow log only) and a periodic lag probe
+ *
+ * callbacks are invoked in loop threads, must be cheap and thread safe
+ * */
+class LoopTracer {
+public:
+  struct Options {
+    // log tasks/io events run longer than this, 0: disable
+    int64_t slow_task_us = 50000;
+    // interval of loop lag probe timer, 0: disable
+    uint32_t lag_probe_ms = 100;
+  };
+
+  LoopTracer() {}
+  explicit LoopTracer(const Options& options) : options_(options) {}
+  virtual ~LoopTracer() {}
+
+  const Options& GetOptions() const { return options_; }
+
+  // queue_us: from post to run, -1 when unknown(timer task etc)
+  virtual void OnTaskRun(const MessageLoop* loop,
+                         const Location& location,
+                         int64_t queue_us,
+                         int64_t run_us) {}
+
+  // a task or io event run longer than slow_task_us, logged already
+  virtual void OnSlowTask(const MessageLoop* loop,
+                          const Location& location,
+                          int64_t run_us) {}
+
+  // lag_us: how late the probe timer fired
+  virtual void OnLoopLag(const MessageLoop* loop, int64_t lag_us) {}
+
+private:
+  Options options_;
+};
+
+/* install for all loops, nullptr to uninstall; not owned, must outlive
+ * all loops; lag probe is installed by a loop in one second after*/
+void SetLoopTracer(LoopTracer* tracer);
+
+LoopTracer* GetLoopTracer();
+
+namespace internal {
+
+// measure a task run, report to tracer and log the slow one
+class ScopedTaskTrace {
+public:
+  ScopedTaskTrace(LoopTracer* tracer,
+                  const Location& location,
+                  int64_t post_us);
+  ~ScopedTaskTrace();
+
+private:
+  LoopTracer* tracer_;
+  const Location location_;
+  const int64_t post_us_;
+  const int64_t start_us_;
+};
+
+// measure a io event, log it when slow and no slow task inside reported
+class ScopedIOEventTrace {
+public:
+  ScopedIOEventTrace(LoopTracer* tracer, int fd);
+  ~ScopedIOEventTrace();
+
+private:
+  LoopTracer* tracer_;
+  const int fd_;
+  const uint64_t slow_count_;
+  const int64_t start_us_;
+};
+
+}  // namespace internal
+}  // namespace base
+#endif
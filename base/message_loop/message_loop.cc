@@ -32,6 +32,7 @@
 #include <csignal>
 #include <functional>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <string>
 
@@ -67,6 +68,17 @@ std::string generate_loop_name() {
   return "loop@" + std::to_string(_id.fetch_add(1));
 }
 
+// all alive loops for stats, leaked for loops destructed at exit
+struct LoopRegistry {
+  std::mutex lock;
+  std::set<const MessageLoop*> loops;
+};
+
+LoopRegistry* loop_registry() {
+  static LoopRegistry* registry = new LoopRegistry();
+  return registry;
+}
+
 }  // namespace
 
 MessageLoop* MessageLoop::Current() {
@@ -97,10 +109,19 @@ MessageLoop::MessageLoop(const std::string& name)
   task_event_ = FdEvent::Create(this, ev_fd, LtEv::READ);
 
   pump_.SetLoopId(GenLoopID());
+
+  LoopRegistry* registry = loop_registry();
+  std::lock_guard<std::mutex> guard(registry->lock);
+  registry->loops.insert(this);
 }
 
 MessageLoop::~MessageLoop() {
   CHECK(!(running_ && IsInLoopThread()));
+  {
+    LoopRegistry* registry = loop_registry();
+    std::lock_guard<std::mutex> guard(registry->lock);
+    registry->loops.erase(this);
+  }
 
   QuitLoop();
   Notify(wakeup_pipe_in_, &kQuit, sizeof(kQuit));
@@ -220,12 +241,18 @@ void MessageLoop::ThreadMain() {
     pump_.Pump(PumpTimeout());
 
     RunNestedTask();
+
+    RecordIteration();
   }
 
   RunNestedTask();
 
   RunScheduledTask();
 
+#ifdef LTIO_WITH_LOOP_TRACE
+  UninstallLagProbe();
+#endif
+
   pump_.RemoveFdEvent(task_event_.get());
 
   pump_.RemoveFdEvent(wakeup_event_.get());
@@ -251,6 +278,12 @@ bool MessageLoop::PostDelayTask(TaskBasePtr task, uint32_t ms) {
 bool MessageLoop::PostTask(TaskBasePtr&& task) {
   CHECK(running_) << LOOP_LOG_DETAIL << task->ClosureInfo();
 
+#ifdef LTIO_WITH_LOOP_TRACE
+  if (GetLoopTracer()) {
+    task->SetPostTime(time_us());
+  }
+#endif
+
   if (IsInLoopThread()) {
     in_loop_tasks_.push_back(std::move(task));
     return true;
@@ -265,7 +298,8 @@ void MessageLoop::RunScheduledTask() {
 
   TaskBasePtr task;  // instead of pinco *p;
   while (scheduled_tasks_.try_dequeue(task)) {
-    task->Run(), task.reset();
+    RunTask(task.get()), task.reset();
+    iteration_tasks_++;
   }
 }
 
@@ -274,8 +308,9 @@ void MessageLoop::RunNestedTask() {
 
   std::vector<TaskBasePtr> nest_tasks(std::move(in_loop_tasks_));
   for (const auto& task : nest_tasks) {
-    task->Run();
+    RunTask(task.get());
   }
+  iteration_tasks_ += nest_tasks.size();
 
   // Note: can't in Sched uninstall runner
   if (delegate_runner_) {
@@ -283,6 +318,104 @@ void MessageLoop::RunNestedTask() {
   }
 }
 
+void MessageLoop::RecordIteration() {
+  int64_t now = time_us();
+  int64_t wakeup = pump_.WakeupTime();
+  int64_t busy = wakeup > 0 ? std::max(now - wakeup, int64_t(0)) : 0;
+
+  // single writer, plain load/store instead of atomic rmw
+  iterations_.store(iterations_.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+  tasks_run_.store(tasks_run_.load(std::memory_order_relaxed) +
+                       iteration_tasks_,
+                   std::memory_order_relaxed);
+  last_busy_us_.store(busy, std::memory_order_relaxed);
+  iteration_tasks_ = 0;
+
+  busy_window_max_ = std::max(busy_window_max_, busy);
+  if (now - busy_window_start_ >= kNumMicrosecsPerSec) {
+    max_busy_us_.store(busy_window_max_, std::memory_order_relaxed);
+    busy_window_max_ = 0;
+    busy_window_start_ = now;
+#ifdef LTIO_WITH_LOOP_TRACE
+    MaybeInstallLagProbe();
+#endif
+  }
+}
+
+void MessageLoop::RunTask(TaskBase* task) {
+#ifdef LTIO_WITH_LOOP_TRACE
+  LoopTracer* tracer = GetLoopTracer();
+  if (tracer) {
+    internal::ScopedTaskTrace trace(tracer, task->TaskLocation(),
+                                    task->PostTime());
+    return task->Run();
+  }
+#endif
+  task->Run();
+}
+
+#ifdef LTIO_WITH_LOOP_TRACE
+void MessageLoop::MaybeInstallLagProbe() {
+  LoopTracer* tracer = GetLoopTracer();
+  if (lag_probe_ || !tracer || tracer->GetOptions().lag_probe_ms == 0) {
+    return;
+  }
+  lag_probe_ = new TimeoutEvent(tracer->GetOptions().lag_probe_ms, true);
+  lag_probe_->InstallHandler(
+      NewClosure(std::bind(&MessageLoop::ProbeLoopLag, this)));
+  lag_probe_expect_us_ = time_us() + lag_probe_->IntervalMicroSecond();
+  pump_.AddTimeoutEvent(lag_probe_);
+}
+
+void MessageLoop::UninstallLagProbe() {
+  if (!lag_probe_) {
+    return;
+  }
+  pump_.RemoveTimeoutEvent(lag_probe_);
+  delete lag_probe_;
+  lag_probe_ = nullptr;
+}
+
+void MessageLoop::ProbeLoopLag() {
+  int64_t now = time_us();
+  LoopTracer* tracer = GetLoopTracer();
+  if (tracer) {
+    tracer->OnLoopLag(this, std::max(now - lag_probe_expect_us_, int64_t(0)));
+  }
+  lag_probe_expect_us_ = now + lag_probe_->IntervalMicroSecond();
+}
+#endif
+
+LoopStats MessageLoop::Stats() const {
+  LoopStats stats;
+  stats.name = loop_name_;
+  stats.loop_id = pump_.LoopID();
+  stats.iterations = iterations_.load(std::memory_order_relaxed);
+  stats.tasks_run = tasks_run_.load(std::memory_order_relaxed);
+  stats.queue_depth = scheduled_tasks_.size_approx();
+  stats.timers = pump_.TimerCount();
+  stats.last_busy_us = last_busy_us_.load(std::memory_order_relaxed);
+  stats.max_busy_us = max_busy_us_.load(std::memory_order_relaxed);
+
+  int64_t wakeup = pump_.WakeupTime();
+  if (wakeup > 0) {
+    stats.running_us = std::max(time_us() - wakeup, int64_t(0));
+  }
+  return stats;
+}
+
+// static
+std::vector<LoopStats> MessageLoop::AllLoopStats() {
+  std::vector<LoopStats> result;
+  LoopRegistry* registry = loop_registry();
+  std::lock_guard<std::mutex> guard(registry->lock);
+  for (const MessageLoop* loop : registry->loops) {
+    result.push_back(loop->Stats());
+  }
+  return result;
+}
+
 void MessageLoop::RunCommandTask(ScheduledTaskType type) {
   switch (type) {
     case ScheduledTaskType::TaskTypeDefault: {
@@ -26,6 +26,7 @@
 #include <queue>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "base/logging.h"
 #include "base/closure/closure_task.h"
@@ -35,12 +36,32 @@
 #include "base/queue/task_queue.h"
 #include "event_pump.h"
 #include "fd_event.h"
+#include "loop_tracer.h"
 #include "glog/logging.h"
 
 namespace base {
 
 enum LoopState { ST_STOPED = 0, ST_STARTED = 1 };
 
+/* runtime counters of a loop, see MessageLoop::Stats */
+struct LoopStats {
+  std::string name;
+  uint64_t loop_id = 0;
+  uint64_t iterations = 0;
+  uint64_t tasks_run = 0;
+  // tasks posted from other threads and not run yet
+  size_t queue_depth = 0;
+  // timeout events in time wheel
+  size_t timers = 0;
+  // busy(handle io/timer/tasks) time of a iteration in us,
+  // max_busy_us is the max one of last second
+  int64_t last_busy_us = 0;
+  int64_t max_busy_us = 0;
+  // running time of current iteration, 0 when waiting io;
+  // a big value means the loop is blocked by something
+  int64_t running_us = 0;
+};
+
 class MessageLoop;
 class PersistRunner {
 public:
@@ -134,6 +155,12 @@ public:
 
   EventPump* Pump() { return &pump_; }
 
+  // thread safe, counters are updated by loop thread per iteration
+  LoopStats Stats() const;
+
+  // stats of all alive loops
+  static std::vector<LoopStats> AllLoopStats();
+
 private:
   void ThreadMain();
   void SetThreadNativeName();
@@ -150,6 +177,18 @@ private:
 
   void RunScheduledTask();
 
+  void RecordIteration();
+
+  void RunTask(TaskBase* task);
+
+#ifdef LTIO_WITH_LOOP_TRACE
+  void MaybeInstallLagProbe();
+
+  void UninstallLagProbe();
+
+  void ProbeLoopLag();
+#endif
+
   int Notify(int fd, const void* data, size_t count);
 
   void HandleEvent(FdEvent* fdev, LtEv::Event ev) override;
@@ -181,6 +220,21 @@ private:
   RefFdEvent wakeup_event_;
 
   EventPump pump_;
+
+  // stats, written by loop thread only
+  std::atomic<uint64_t> iterations_ = {0};
+  std::atomic<uint64_t> tasks_run_ = {0};
+  std::atomic<int64_t> last_busy_us_ = {0};
+  std::atomic<int64_t> max_busy_us_ = {0};
+  uint64_t iteration_tasks_ = 0;
+  int64_t busy_window_start_ = 0;
+  int64_t busy_window_max_ = 0;
+
+#ifdef LTIO_WITH_LOOP_TRACE
+  TimeoutEvent* lag_probe_ = nullptr;
+  int64_t lag_probe_expect_us_ = 0;
+#endif
+
   DISALLOW_COPY_AND_ASSIGN(MessageLoop);
 };
 
@@ -17,6 +17,8 @@
 
 #include "timeout_event.h"
 
+#include "loop_tracer.h"
+
 namespace base {
 
 // static
@@ -49,9 +51,17 @@ void TimeoutEvent::InstallHandler(TaskBasePtr&& h) {
 }
 
 void TimeoutEvent::Invoke() {
-  if (handler_) {
-    handler_->Run();
+  if (!handler_) {
+    return;
+  }
+#ifdef LTIO_WITH_LOOP_TRACE
+  LoopTracer* tracer = GetLoopTracer();
+  if (tracer) {
+    internal::ScopedTaskTrace trace(tracer, handler_->TaskLocation(), 0);
+    return handler_->Run();
   }
+#endif
+  handler_->Run();
 }
 
 }  // namespace base
@@ -0,0 +1,19 @@
+#ifndef LT_SYS_THREAD_SLOT_H_
+#define LT_SYS_THREAD_SLOT_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace base {
+
+// a small process wide sequence id of current thread, assigned on first use;
+// used to pick a shard for per-thread striped counters
+inline uint32_t ThreadSlot() {
+  static std::atomic<uint32_t> seq(0);
+  static thread_local uint32_t slot = seq.fetch_add(1);
+  return slot;
+}
+
+}  // namespace base
+
+#endif
@@ -0,0 +1,474 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compressor.h"
+
+#include <endian.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <memory>
+
+#include "zlib.h"
+
+#ifdef LTIO_WITH_ZSTD
+#include <zstd.h>
+#endif
+
+#ifdef LTIO_WITH_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef LTIO_WITH_BROTLI
+#include <brotli/decode.h>
+#include <brotli/encode.h>
+#endif
+
+namespace base {
+
+namespace {
+
+const size_t kMinDecompressChunk = 4096;
+
+// grow `out` for at least `more` writable bytes after `used`
+char* reserve_more(std::string* out, size_t used, size_t more) {
+  if (out->size() < used + more) {
+    out->resize(std::max(used + more, out->size() * 2));
+  }
+  return &(*out)[used];
+}
+
+inline bool over_limit(size_t decoded, size_t max_size) {
+  return max_size > 0 && decoded > max_size;
+}
+
+/* zlib stream reused by thread, deflateInit2 allocate ~256k
+ * memory every time, reset a exist stream is far cheaper*/
+class DeflateStream {
+public:
+  DeflateStream(int window_bits) : window_bits_(window_bits) {
+    ::memset(&zs_, 0, sizeof(zs_));
+  }
+  ~DeflateStream() {
+    if (inited_) {
+      deflateEnd(&zs_);
+    }
+  }
+  z_stream* Acquire(int level) {
+    if (!inited_) {
+      inited_ = Z_OK == deflateInit2(&zs_, level, Z_DEFLATED, window_bits_, 8,
+                                     Z_DEFAULT_STRATEGY);
+      level_ = level;
+      return inited_ ? &zs_ : nullptr;
+    }
+    if (Z_OK != deflateReset(&zs_)) {
+      return nullptr;
+    }
+    if (level != level_ &&
+        Z_OK != deflateParams(&zs_, level, Z_DEFAULT_STRATEGY)) {
+      return nullptr;
+    }
+    level_ = level;
+    return &zs_;
+  }
+
+private:
+  z_stream zs_;
+  bool inited_ = false;
+  int level_ = 0;
+  const int window_bits_;
+};
+
+class InflateStream {
+public:
+  InflateStream(int window_bits) : window_bits_(window_bits) {
+    ::memset(&zs_, 0, sizeof(zs_));
+  }
+  ~InflateStream() {
+    if (inited_) {
+      inflateEnd(&zs_);
+    }
+  }
+  z_stream* Acquire() {
+    if (!inited_) {
+      inited_ = Z_OK == inflateInit2(&zs_, window_bits_);
+      return inited_ ? &zs_ : nullptr;
+    }
+    return Z_OK == inflateReset(&zs_) ? &zs_ : nullptr;
+  }
+
+private:
+  z_stream zs_;
+  bool inited_ = false;
+  const int window_bits_;
+};
+
+class ZlibCompressor : public Compressor {
+public:
+  // gzip: 15 + 16 for gzip wrapper; deflate: zlib wrapper, rfc7230 4.2.2
+  ZlibCompressor(Type id, const char* name, int window_bits)
+    : id_(id),
+      name_(name),
+      window_bits_(window_bits) {}
+
+  Type Id() const override { return id_; }
+  const char* Name() const override { return name_; }
+  // level above 4 cost much more cpu for little gain on text/json
+  int DefaultLevel() const override { return 4; }
+
+  bool Compress(const char* data,
+                size_t len,
+                std::string* out,
+                int level) const override {
+    thread_local DeflateStream gzip_stream(MAX_WBITS + 16);
+    thread_local DeflateStream zlib_stream(MAX_WBITS);
+
+    DeflateStream& stream = id_ == kGzip ? gzip_stream : zlib_stream;
+    z_stream* zs = stream.Acquire(level < 0 ? DefaultLevel() : level);
+    if (!zs) {
+      return false;
+    }
+    const size_t origin = out->size();
+    // Z_FINISH with deflateBound space complete in one pass
+    const size_t bound = deflateBound(zs, len);
+    out->resize(origin + bound);
+
+    zs->next_in = (Bytef*)data;
+    zs->avail_in = len;
+    zs->next_out = (Bytef*)(&(*out)[origin]);
+    zs->avail_out = bound;
+    if (Z_STREAM_END != deflate(zs, Z_FINISH)) {
+      out->resize(origin);
+      return false;
+    }
+    out->resize(origin + zs->total_out);
+    return true;
+  }
+
+  bool Decompress(const char* data,
+                  size_t len,
+                  std::string* out,
+                  size_t max_size) const override {
+    thread_local InflateStream gzip_stream(MAX_WBITS + 16);
+    thread_local InflateStream zlib_stream(MAX_WBITS);
+
+    InflateStream& stream = id_ == kGzip ? gzip_stream : zlib_stream;
+    z_stream* zs = stream.Acquire();
+    if (!zs) {
+      return false;
+    }
+    const size_t origin = out->size();
+    size_t used = origin;
+
+    zs->next_in = (Bytef*)data;
+    zs->avail_in = len;
+    int ret = Z_OK;
+    do {
+      size_t chunk = std::max(len * 2, kMinDecompressChunk);
+      char* dst = reserve_more(out, used, chunk);
+      zs->next_out = (Bytef*)dst;
+      zs->avail_out = out->size() - used;
+      size_t avail = zs->avail_out;
+      ret = inflate(zs, Z_NO_FLUSH);
+      used += avail - zs->avail_out;
+      if (over_limit(used - origin, max_size)) {
+        out->resize(origin);
+        return false;
+      }
+    } while (ret == Z_OK);
+
+    if (ret != Z_STREAM_END) {
+      out->resize(origin);
+      return false;
+    }
+    out->resize(used);
+    return true;
+  }
+
+private:
+  const Type id_;
+  const char* name_;
+  const int window_bits_;
+};
+
+#ifdef LTIO_WITH_ZSTD
+class ZstdCompressor : public Compressor {
+public:
+  Type Id() const override { return kZstd; }
+  const char* Name() const override { return "zstd"; }
+  int DefaultLevel() const override { return 1; }
+
+  bool Compress(const char* data,
+                size_t len,
+                std::string* out,
+                int level) const override {
+    thread_local std::unique_ptr<ZSTD_CCtx, size_t (*)(ZSTD_CCtx*)> cctx(
+        ZSTD_createCCtx(), ZSTD_freeCCtx);
+    if (!cctx) {
+      return false;
+    }
+    const size_t origin = out->size();
+    const size_t bound = ZSTD_compressBound(len);
+    out->resize(origin + bound);
+    size_t n = ZSTD_compressCCtx(cctx.get(), &(*out)[origin], bound, data, len,
+                                 level < 0 ? DefaultLevel() : level);
+    if (ZSTD_isError(n)) {
+      out->resize(origin);
+      return false;
+    }
+    out->resize(origin + n);
+    return true;
+  }
+
+  bool Decompress(const char* data,
+                  size_t len,
+                  std::string* out,
+                  size_t max_size) const override {
+    thread_local std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> dctx(
+        ZSTD_createDCtx(), ZSTD_freeDCtx);
+    if (!dctx) {
+      return false;
+    }
+    ZSTD_DCtx_reset(dctx.get(), ZSTD_reset_session_only);
+
+    const size_t origin = out->size();
+    size_t used = origin;
+    ZSTD_inBuffer input = {data, len, 0};
+    while (true) {
+      size_t chunk = std::max(len * 2, ZSTD_DStreamOutSize());
+      char* dst = reserve_more(out, used, chunk);
+      ZSTD_outBuffer output = {dst, out->size() - used, 0};
+      size_t ret = ZSTD_decompressStream(dctx.get(), &output, &input);
+      if (ZSTD_isError(ret)) {
+        out->resize(origin);
+        return false;
+      }
+      used += output.pos;
+      if (over_limit(used - origin, max_size)) {
+        out->resize(origin);
+        return false;
+      }
+      // frame done and all input consumed
+      if (ret == 0 && input.pos == input.size) {
+        break;
+      }
+      // input drained but frame not complete
+      if (input.pos == input.size && output.pos < output.size) {
+        out->resize(origin);
+        return false;
+      }
+    }
+    out->resize(used);
+    return true;
+  }
+};
+#endif
+
+#ifdef LTIO_WITH_LZ4
+/* lz4 block with 4 bytes little endian origin size prefix; not a http
+ * content-coding, for binary protocol(raw/rpc) payload;
+ * level means lz4 acceleration, larger is faster*/
+class Lz4Compressor : public Compressor {
+public:
+  Type Id() const override { return kLz4; }
+  const char* Name() const override { return "lz4"; }
+  int DefaultLevel() const override { return 1; }
+
+  bool Compress(const char* data,
+                size_t len,
+                std::string* out,
+                int level) const override {
+    if (len > LZ4_MAX_INPUT_SIZE) {
+      return false;
+    }
+    const size_t origin = out->size();
+    const int bound = LZ4_compressBound(len);
+    out->resize(origin + 4 + bound);
+
+    uint32_t size = htole32(uint32_t(len));
+    ::memcpy(&(*out)[origin], &size, 4);
+    int n = LZ4_compress_fast(data, &(*out)[origin + 4], len, bound,
+                              level < 0 ? DefaultLevel() : level);
+    if (n <= 0) {
+      out->resize(origin);
+      return false;
+    }
+    out->resize(origin + 4 + n);
+    return true;
+  }
+
+  bool Decompress(const char* data,
+                  size_t len,
+                  std::string* out,
+                  size_t max_size) const override {
+    uint32_t size = 0;
+    if (len < 4) {
+      return false;
+    }
+    ::memcpy(&size, data, 4);
+    size = le32toh(size);
+    // size prefix from peer, check before allocate
+    if (size > LZ4_MAX_INPUT_SIZE || over_limit(size, max_size)) {
+      return false;
+    }
+    const size_t origin = out->size();
+    out->resize(origin + size);
+    int n = LZ4_decompress_safe(data + 4, &(*out)[origin], len - 4, size);
+    if (n < 0 || uint32_t(n) != size) {
+      out->resize(origin);
+      return false;
+    }
+    return true;
+  }
+};
+#endif
+
+#ifdef LTIO_WITH_BROTLI
+class BrotliCompressor : public Compressor {
+public:
+  Type Id() const override { return kBrotli; }
+  const char* Name() const override { return "br"; }
+  int DefaultLevel() const override { return 4; }
+
+  bool Compress(const char* data,
+                size_t len,
+                std::string* out,
+                int level) const override {
+    size_t bound = BrotliEncoderMaxCompressedSize(len);
+    if (bound == 0) {
+      return false;
+    }
+    const size_t origin = out->size();
+    out->resize(origin + bound);
+    size_t encoded = bound;
+    if (BROTLI_TRUE != BrotliEncoderCompress(
+                           level < 0 ? DefaultLevel() : level,
+                           BROTLI_DEFAULT_WINDOW, BROTLI_MODE_GENERIC, len,
+                           (const uint8_t*)data, &encoded,
+                           (uint8_t*)(&(*out)[origin]))) {
+      out->resize(origin);
+      return false;
+    }
+    out->resize(origin + encoded);
+    return true;
+  }
+
+  bool Decompress(const char* data,
+                  size_t len,
+                  std::string* out,
+                  size_t max_size) const override {
+    std::unique_ptr<BrotliDecoderState, void (*)(BrotliDecoderState*)> state(
+        BrotliDecoderCreateInstance(nullptr, nullptr, nullptr),
+        BrotliDecoderDestroyInstance);
+    if (!state) {
+      return false;
+    }
+    const size_t origin = out->size();
+    size_t used = origin;
+
+    size_t avail_in = len;
+    const uint8_t* next_in = (const uint8_t*)data;
+    BrotliDecoderResult ret = BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT;
+    while (ret == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
+      size_t chunk = std::max(len * 2, kMinDecompressChunk);
+      uint8_t* next_out = (uint8_t*)reserve_more(out, used, chunk);
+      size_t avail_out = out->size() - used;
+      size_t before = avail_out;
+      ret = BrotliDecoderDecompressStream(state.get(), &avail_in, &next_in,
+                                          &avail_out, &next_out, nullptr);
+      used += before - avail_out;
+      if (over_limit(used - origin, max_size)) {
+        out->resize(origin);
+        return false;
+      }
+    }
+    if (ret != BROTLI_DECODER_RESULT_SUCCESS) {
+      out->resize(origin);
+      return false;
+    }
+    out->resize(used);
+    return true;
+  }
+};
+#endif
+
+const Compressor* const* all_compressors() {
+  static ZlibCompressor gzip(Compressor::kGzip, "gzip", MAX_WBITS + 16);
+  static ZlibCompressor deflate(Compressor::kDeflate, "deflate", MAX_WBITS);
+#ifdef LTIO_WITH_ZSTD
+  static ZstdCompressor zstd;
+#endif
+#ifdef LTIO_WITH_LZ4
+  static Lz4Compressor lz4;
+#endif
+#ifdef LTIO_WITH_BROTLI
+  static BrotliCompressor brotli;
+#endif
+  static const Compressor* compressors[] = {
+#ifdef LTIO_WITH_ZSTD
+      &zstd,
+#endif
+#ifdef LTIO_WITH_BROTLI
+      &brotli,
+#endif
+#ifdef LTIO_WITH_LZ4
+      &lz4,
+#endif
+      &gzip,
+      &deflate,
+      nullptr,
+  };
+  return compressors;
+}
+
+}  // namespace
+
+// static
+const Compressor* Compressor::Get(Type id) {
+  for (auto c = all_compressors(); *c; c++) {
+    if ((*c)->Id() == id) {
+      return *c;
+    }
+  }
+  return nullptr;
+}
+
+// static
+const Compressor* Compressor::Get(const std::string& name) {
+  const char* token = name.c_str();
+  // rfc7230 4.2.3 x-gzip should be treated as gzip
+  if (strcasecmp(token, "x-gzip") == 0) {
+    token = "gzip";
+  }
+  for (auto c = all_compressors(); *c; c++) {
+    if (strcasecmp((*c)->Name(), token) == 0) {
+      return *c;
+    }
+  }
+  return nullptr;
+}
+
+// static
+std::vector<std::string> Compressor::Supported() {
+  std::vector<std::string> names;
+  for (auto c = all_compressors(); *c; c++) {
+    names.push_back((*c)->Name());
+  }
+  return names;
+}
+
+}  // namespace base
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LT_BASE_COMPRESSOR_H_
+#define _LT_BASE_COMPRESSOR_H_
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+#include <base/ltio_config.h>
+
+namespace base {
+
+/**
+ * pluggable compression codec, stateless for caller and thread-safe;
+ * zlib/zstd contexts are cached per thread and reset between calls
+ * instead of init/destroy for every message.
+ *
+ * gzip/deflate always available, others depend on build options:
+ * LTIO_WITH_ZSTD/LTIO_WITH_LZ4/LTIO_WITH_BROTLI
+ * */
+class Compressor {
+public:
+  // stable id for binary protocol, never change the value
+  enum Type : uint8_t {
+    kNone = 0,
+    kGzip = 1,
+    kDeflate = 2,
+    kZstd = 3,
+    kLz4 = 4,
+    kBrotli = 5,
+  };
+
+  virtual ~Compressor() {}
+
+  virtual Type Id() const = 0;
+
+  // content-coding token, eg: gzip/deflate/zstd/br/lz4
+  virtual const char* Name() const = 0;
+
+  // cheap level for a online server, not the codec's own default
+  virtual int DefaultLevel() const = 0;
+
+  /* compress [data, data+len) and append to out, write directly into
+   * out's tail without temporary buffer; level < 0 means DefaultLevel()*/
+  virtual bool Compress(const char* data,
+                        size_t len,
+                        std::string* out,
+                        int level = -1) const = 0;
+
+  /* append decompressed data to out, fail when the output grow over
+   * max_size(0 for no limit), bound peer's input eg: a zip bomb*/
+  virtual bool Decompress(const char* data,
+                          size_t len,
+                          std::string* out,
+                          size_t max_size) const = 0;
+
+  bool Compress(const std::string& in, std::string* out, int level = -1) const {
+    return Compress(in.data(), in.size(), out, level);
+  }
+
+  bool Decompress(const char* data, size_t len, std::string* out) const {
+    return Decompress(data, len, out, 0);
+  }
+
+  bool Decompress(const std::string& in,
+                  std::string* out,
+                  size_t max_size = 0) const {
+    return Decompress(in.data(), in.size(), out, max_size);
+  }
+
+  // return nullptr if not support(not compiled in)
+  static const Compressor* Get(Type id);
+
+  static const Compressor* Get(const std::string& name);
+
+  // names of all compiled in codecs
+  static std::vector<std::string> Supported();
+};
+
+}  // namespace base
+#endif
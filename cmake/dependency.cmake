@@ -32,6 +32,38 @@ if (LTIO_WITH_OPENSSL)
   list(APPEND LtIO_INCLUDE_DIRS PUBLIC ${OPENSSL_INCLUDE_DIR})
 endif()
 
+# ---[ optional compression codecs
+if (LTIO_WITH_ZSTD)
+  find_path(ZSTD_INCLUDE_DIR zstd.h)
+  find_library(ZSTD_LIBRARY NAMES zstd)
+  if (NOT ZSTD_INCLUDE_DIR OR NOT ZSTD_LIBRARY)
+    message(FATAL_ERROR "zstd not found")
+  endif()
+  list(APPEND LtIO_LINKER_LIBS PUBLIC ${ZSTD_LIBRARY})
+  list(APPEND LtIO_INCLUDE_DIRS PUBLIC ${ZSTD_INCLUDE_DIR})
+endif()
+
+if (LTIO_WITH_LZ4)
+  find_path(LZ4_INCLUDE_DIR lz4.h)
+  find_library(LZ4_LIBRARY NAMES lz4)
+  if (NOT LZ4_INCLUDE_DIR OR NOT LZ4_LIBRARY)
+    message(FATAL_ERROR "lz4 not found")
+  endif()
+  list(APPEND LtIO_LINKER_LIBS PUBLIC ${LZ4_LIBRARY})
+  list(APPEND LtIO_INCLUDE_DIRS PUBLIC ${LZ4_INCLUDE_DIR})
+endif()
+
+if (LTIO_WITH_BROTLI)
+  find_path(BROTLI_INCLUDE_DIR brotli/encode.h)
+  find_library(BROTLI_ENC_LIBRARY NAMES brotlienc)
+  find_library(BROTLI_DEC_LIBRARY NAMES brotlidec)
+  if (NOT BROTLI_INCLUDE_DIR OR NOT BROTLI_ENC_LIBRARY OR NOT BROTLI_DEC_LIBRARY)
+    message(FATAL_ERROR "brotli not found")
+  endif()
+  list(APPEND LtIO_LINKER_LIBS PUBLIC ${BROTLI_ENC_LIBRARY} ${BROTLI_DEC_LIBRARY})
+  list(APPEND LtIO_INCLUDE_DIRS PUBLIC ${BROTLI_INCLUDE_DIR})
+endif()
+
 if (LTIO_WITH_HTTP2)
   if(LTIO_USE_SYS_NGHTTP2)
     find_package(NGHTTP2 REQUIRED)
@@ -0,0 +1,325 @@
+#include "blocked_bloom_filter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "glog/logging.h"
+#include "hash/murmurhash3.h"
+
+namespace component {
+
+namespace {
+
+const size_t kPrefetchDistance = 8;
+
+const char kFileMagic[8] = {'L', 'T', 'B', 'B', 'F', 0, 0, 0};
+const uint32_t kFileVersion = 1;
+
+// keep it 64 bytes, so blocks after header still cache line aligned
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t k;
+  uint64_t num_blocks;
+  uint8_t reserved[40];
+} FileHeader;
+static_assert(sizeof(FileHeader) == BlockedBloomFilter::kBlockBytes,
+              "header must be one block");
+
+// bit of lane i = top 5 bits of (h * salt[i]), all salts are odd; a plain
+// double hashing g(i) = h1 + i * h2 inside a 32bits lane makes keys with
+// nearby h1/h2 collide on every lane, the false rate is ~30x worse
+const uint32_t kLaneSalts[16] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+    0x52e6b439U, 0xf2a74de5U, 0x269e0d37U, 0x6513270fU,
+    0xa6a3a451U, 0x0c5c7fd1U, 0x128b2f33U, 0xd23f0825U};
+
+inline uint32_t LaneHash(uint64_t hash) {
+  return (uint32_t)hash;
+}
+
+#ifdef __AVX2__
+inline void MakeMaskAVX2(uint64_t hash,
+                         uint32_t k,
+                         __m256i* lo,
+                         __m256i* hi) {
+  const __m256i idx_lo = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i idx_hi = _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15);
+  const __m256i salt_lo = _mm256_loadu_si256((const __m256i*)kLaneSalts);
+  const __m256i salt_hi = _mm256_loadu_si256((const __m256i*)kLaneSalts + 1);
+  const __m256i ones = _mm256_set1_epi32(1);
+
+  __m256i h = _mm256_set1_epi32(LaneHash(hash));
+  __m256i kv = _mm256_set1_epi32(k);
+
+  __m256i g_lo = _mm256_mullo_epi32(h, salt_lo);
+  __m256i g_hi = _mm256_mullo_epi32(h, salt_hi);
+  __m256i bit_lo = _mm256_sllv_epi32(ones, _mm256_srli_epi32(g_lo, 27));
+  __m256i bit_hi = _mm256_sllv_epi32(ones, _mm256_srli_epi32(g_hi, 27));
+  // lane i enabled when i < k
+  *lo = _mm256_and_si256(bit_lo, _mm256_cmpgt_epi32(kv, idx_lo));
+  *hi = _mm256_and_si256(bit_hi, _mm256_cmpgt_epi32(kv, idx_hi));
+}
+#endif
+
+}  // namespace
+
+BlockedBloomFilter::BlockedBloomFilter(bool thread_safe)
+  : thread_safe_(thread_safe) {}
+
+BlockedBloomFilter::BlockedBloomFilter(uint64_t n, double p, bool thread_safe)
+  : thread_safe_(thread_safe) {
+  Init(n, p);
+}
+
+BlockedBloomFilter::~BlockedBloomFilter() {
+  if (mmap_addr_) {
+    munmap(mmap_addr_, mmap_size_);
+  } else if (blocks_) {
+    free(blocks_);
+  }
+  blocks_ = nullptr;
+  mmap_addr_ = nullptr;
+}
+
+// static
+double BlockedBloomFilter::EstimateFalseRate(uint64_t n,
+                                             uint64_t blocks,
+                                             uint32_t k) {
+  // keys per block is poisson(lambda), a block with x keys has
+  // 1 - (31/32)^x bits set in every lane
+  double lambda = double(n) / double(blocks);
+  uint64_t max_x = lambda + 12 * std::sqrt(lambda) + 32;
+
+  double rate = 0;
+  for (uint64_t x = 0; x <= max_x; x++) {
+    double log_pmf = -lambda + x * std::log(lambda) - std::lgamma(x + 1.0);
+    double lane = 1 - std::pow(31.0 / 32.0, double(x));
+    rate += std::exp(log_pmf) * std::pow(lane, double(k));
+  }
+  return rate;
+}
+
+void BlockedBloomFilter::Init(uint64_t n, double p) {
+  n = std::max<uint64_t>(n, 1);
+  p = std::min(std::max(p, 1e-12), 0.5);
+
+  // start from a standard bloom filter size, blocked layout needs a little
+  // more space for the same false rate, so grow until it's good enough
+  double m = -(double(n) * std::log(p)) / (std::log(2) * std::log(2));
+  uint64_t blocks = std::max<uint64_t>(1, std::ceil(m / (kBlockBytes * 8)));
+
+  uint32_t best_k = 1;
+  for (int round = 0; round < 64; round++) {
+    double best_rate = 1.0;
+    for (uint32_t k = 1; k <= kMaxHashes; k++) {
+      double rate = EstimateFalseRate(n, blocks, k);
+      if (rate < best_rate) {
+        best_rate = rate;
+        best_k = k;
+      }
+    }
+    if (best_rate <= p) {
+      break;
+    }
+    blocks += blocks / 20 + 1;
+  }
+  CHECK(blocks < (1ULL << 32)) << "too much blocks:" << blocks;
+
+  k_ = best_k;
+  num_blocks_ = blocks;
+
+  void* memory = nullptr;
+  CHECK(0 == posix_memalign(&memory, kBlockBytes, ByteSize()));
+  blocks_ = (uint8_t*)memory;
+  memset(blocks_, 0, ByteSize());
+}
+
+// static
+uint64_t BlockedBloomFilter::Hash(const void* data, size_t len) {
+  uint64_t result[2];
+  MurmurHash3_x64_128(data, len, 0x5bd1e995, result);
+  return result[0] ^ result[1];
+}
+
+void BlockedBloomFilter::MakeMask(uint64_t hash, uint32_t mask[16]) const {
+  uint32_t h = LaneHash(hash);
+  for (uint32_t i = 0; i < kMaxHashes; i++) {
+    mask[i] = i < k_ ? (1U << ((h * kLaneSalts[i]) >> 27)) : 0;
+  }
+}
+
+void BlockedBloomFilter::SetHash(uint64_t hash) {
+  uint32_t* block = BlockOf(hash);
+  if (thread_safe_) {
+    uint32_t mask[16];
+    MakeMask(hash, mask);
+    for (uint32_t i = 0; i < k_; i++) {
+      __atomic_fetch_or(block + i, mask[i], __ATOMIC_RELAXED);
+    }
+    return;
+  }
+#ifdef __AVX2__
+  __m256i lo, hi;
+  MakeMaskAVX2(hash, k_, &lo, &hi);
+  __m256i* b = (__m256i*)block;
+  _mm256_store_si256(b, _mm256_or_si256(_mm256_load_si256(b), lo));
+  _mm256_store_si256(b + 1, _mm256_or_si256(_mm256_load_si256(b + 1), hi));
+#else
+  uint32_t mask[16];
+  MakeMask(hash, mask);
+  for (uint32_t i = 0; i < k_; i++) {
+    block[i] |= mask[i];
+  }
+#endif
+}
+
+bool BlockedBloomFilter::TestHash(uint64_t hash) const {
+  const uint32_t* block = BlockOf(hash);
+#ifdef __AVX2__
+  __m256i lo, hi;
+  MakeMaskAVX2(hash, k_, &lo, &hi);
+  const __m256i* b = (const __m256i*)block;
+  // testc: (~block & mask) == 0
+  return _mm256_testc_si256(_mm256_load_si256(b), lo) &&
+         _mm256_testc_si256(_mm256_load_si256(b + 1), hi);
+#else
+  uint32_t mask[16];
+  MakeMask(hash, mask);
+  for (uint32_t i = 0; i < k_; i++) {
+    if ((block[i] & mask[i]) != mask[i])
+      return false;
+  }
+  return true;
+#endif
+}
+
+bool BlockedBloomFilter::TestAndSetHash(uint64_t hash) {
+  if (!thread_safe_) {
+    bool hit = TestHash(hash);
+    if (!hit) {
+      SetHash(hash);
+    }
+    return hit;
+  }
+  uint32_t* block = BlockOf(hash);
+  uint32_t mask[16];
+  MakeMask(hash, mask);
+
+  bool hit = true;
+  for (uint32_t i = 0; i < k_; i++) {
+    uint32_t old = __atomic_fetch_or(block + i, mask[i], __ATOMIC_RELAXED);
+    hit &= ((old & mask[i]) == mask[i]);
+  }
+  return hit;
+}
+
+void BlockedBloomFilter::SetMany(const uint64_t* hashes, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (i + kPrefetchDistance < count) {
+      __builtin_prefetch(BlockOf(hashes[i + kPrefetchDistance]), 1);
+    }
+    SetHash(hashes[i]);
+  }
+}
+
+size_t BlockedBloomFilter::ContainsMany(const uint64_t* hashes,
+                                        size_t count,
+                                        uint8_t* results) const {
+  size_t hit_count = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (i + kPrefetchDistance < count) {
+      __builtin_prefetch(BlockOf(hashes[i + kPrefetchDistance]), 0);
+    }
+    results[i] = TestHash(hashes[i]);
+    hit_count += results[i];
+  }
+  return hit_count;
+}
+
+bool BlockedBloomFilter::Save(const std::string& path) const {
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.version = kFileVersion;
+  header.k = k_;
+  header.num_blocks = num_blocks_;
+
+  // write to a temp file then rename, a reader never see a partial filter
+  std::string tmp_path = path + ".tmp";
+  FILE* fp = fopen(tmp_path.c_str(), "wb");
+  if (!fp) {
+    LOG(ERROR) << "open file failed:" << tmp_path << ", err:" << errno;
+    return false;
+  }
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+            fwrite(blocks_, ByteSize(), 1, fp) == 1;
+  ok = (fclose(fp) == 0) && ok;
+  if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(ERROR) << "write bloom filter failed:" << path << ", err:" << errno;
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// static
+std::unique_ptr<BlockedBloomFilter> BlockedBloomFilter::Open(
+    const std::string& path,
+    bool thread_safe) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG(ERROR) << "open bloom filter failed:" << path << ", err:" << errno;
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(FileHeader)) {
+    LOG(ERROR) << "bad bloom filter file:" << path;
+    ::close(fd);
+    return nullptr;
+  }
+
+  size_t size = st.st_size;
+  void* addr =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "mmap bloom filter failed:" << path << ", err:" << errno;
+    return nullptr;
+  }
+
+  const FileHeader* header = (const FileHeader*)addr;
+  if (memcmp(header->magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header->version != kFileVersion || header->k == 0 ||
+      header->k > kMaxHashes || header->num_blocks == 0 ||
+      header->num_blocks >= (1ULL << 32) ||
+      size != sizeof(FileHeader) + header->num_blocks * kBlockBytes) {
+    LOG(ERROR) << "bloom filter file corrupted:" << path;
+    munmap(addr, size);
+    return nullptr;
+  }
+
+  std::unique_ptr<BlockedBloomFilter> filter(
+      new BlockedBloomFilter(thread_safe));
+  filter->k_ = header->k;
+  filter->num_blocks_ = header->num_blocks;
+  filter->blocks_ = (uint8_t*)addr + sizeof(FileHeader);
+  filter->mmap_addr_ = addr;
+  filter->mmap_size_ = size;
+  return filter;
+}
+
+};  // namespace component
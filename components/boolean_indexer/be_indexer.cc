@@ -25,9 +25,12 @@ void BooleanIndexer::AddWildcardEntry(uint64_t conj_id) {
 }
 
 bool BooleanIndexer::CompleteIndex() {
-  if (!wildcard_list_.empty()) {
+  if (!std::is_sorted(wildcard_list_.begin(), wildcard_list_.end())) {
     std::sort(wildcard_list_.begin(), wildcard_list_.end());
   }
+  wildcard_entries_ = CompressedEntries(wildcard_list_);
+  Entries().swap(wildcard_list_);
+
   for (auto& field_container : containers_) {
     bool ok = field_container.second->CompileEntries();
     if (!ok) {
@@ -47,15 +50,23 @@ void BooleanIndexer::DumpIndex(std::ostringstream& oss) const {
 }
 
 FieldCursorPtr BooleanIndexer::GenWildcardCursor() const {
-  if (wildcard_list_.empty()) {
+  if (wildcard_entries_.Empty()) {
     return nullptr;
   }
 
   FieldCursorPtr wc_cursor(new FieldCursor());
-  wc_cursor->AddEntries(wildcard_attr, &wildcard_list_);
+  InitWildcardCursor(wc_cursor.get());
   return wc_cursor;
 }
 
+bool BooleanIndexer::InitWildcardCursor(FieldCursor* cursor) const {
+  if (wildcard_entries_.Empty()) {
+    return false;
+  }
+  cursor->AddEntries(wildcard_attr, &wildcard_entries_);
+  return true;
+}
+
 FieldMeta* BooleanIndexer::GetMeta(const std::string& field) const {
   auto iter = field_meta_.find(field);
   if (iter == field_meta_.end()) {
@@ -75,8 +86,23 @@ EntriesContainer* BooleanIndexer::GetContainer(const std::string field) const {
   if (iter != containers_.end()) {
     return iter->second.get();
   }
-  iter = containers_.find(default_field_key);
+  return DefaultContainer();
+}
+
+EntriesContainer* BooleanIndexer::DefaultContainer() const {
+  auto iter = containers_.find(default_field_key);
   return iter->second.get();
 }
 
+void BooleanIndexer::SetDefaultContainer(EntriesContainerPtr container) {
+  containers_[default_field_key] = std::move(container);
+}
+
+bool BooleanIndexer::SetContainer(const std::string& field,
+                                  EntriesContainerPtr container) {
+  auto it = containers_.insert(std::make_pair(field, std::move(container)));
+  LOG_IF(ERROR, !it.second) << "configure field container fail, field:" << field;
+  return it.second;
+}
+
 }  // namespace component
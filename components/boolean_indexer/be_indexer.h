@@ -16,6 +16,9 @@ namespace component {
 
 class IndexScanner;
 class BeIndexerBuilder;
+class ParallelIndexerBuilder;
+class IndexSegment;
+class IncrementalIndexer;
 
 class BooleanIndexer {
 public:
@@ -27,6 +30,9 @@ public:
 
   FieldCursorPtr GenWildcardCursor() const;
 
+  // add wildcard entries to cursor, false when no wildcard entries
+  bool InitWildcardCursor(FieldCursor* cursor) const;
+
   FieldMeta* GetMeta(const std::string& field) const;
 
   EntriesContainer* GetContainer(const std::string field) const;
@@ -34,6 +40,9 @@ public:
 private:
   friend IndexScanner;
   friend BeIndexerBuilder;
+  friend ParallelIndexerBuilder;
+  friend IndexSegment;
+  friend IncrementalIndexer;
 
   bool SetMeta(const std::string& field, FieldMetaPtr meta);
 
@@ -41,10 +50,18 @@ private:
 
   void AddWildcardEntry(const EntryId eid);
 
-private:
+  EntriesContainer* DefaultContainer() const;
+
+  void SetDefaultContainer(EntriesContainerPtr container);
 
+  bool SetContainer(const std::string& field, EntriesContainerPtr container);
+
+private:
+  // building, compiled into wildcard_entries_
   Entries wildcard_list_;
 
+  CompressedEntries wildcard_entries_;
+
   std::map<std::string, FieldMetaPtr> field_meta_;
 
   // here register a speical key: ___default___ as the
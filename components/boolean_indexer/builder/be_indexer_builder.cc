@@ -30,6 +30,18 @@ FieldMeta* BeIndexerBuilder::GetFieldMeta(const std::string& field) {
   return meta;
 }
 
+bool BeIndexerBuilder::ConfigureField(const std::string& field,
+                                      RefExprParser parser,
+                                      EntriesContainerPtr container) {
+  FieldMetaPtr meta(new FieldMeta());
+  meta->name = field;
+  meta->parser = parser;
+  if (!indexer_->SetMeta(field, std::move(meta))) {
+    return false;
+  }
+  return !container || indexer_->SetContainer(field, std::move(container));
+}
+
 void BeIndexerBuilder::AddDocument(Document&& doc) {
   for (Conjunction* conj : doc.conjunctions()) {
     uint64_t conj_id = conj->id();
@@ -16,6 +16,13 @@ public:
 
   FieldMeta* GetFieldMeta(const std::string& field);
 
+  // configure before documents added, container nullptr for the default
+  // eg: ConfigureField("age", std::make_shared<RangeParser>(),
+  //                    EntriesContainerPtr(new RangeContainer()));
+  bool ConfigureField(const std::string& field,
+                      RefExprParser parser,
+                      EntriesContainerPtr container = nullptr);
+
   void AddDocument(Document&& doc);
 
   RefBooleanIndexer BuildIndexer();
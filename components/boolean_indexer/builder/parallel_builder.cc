@@ -0,0 +1,325 @@
+#include "parallel_builder.h"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+#include <glog/logging.h>
+
+#include "base/time/time_utils.h"
+#include "components/boolean_indexer/id_generator.h"
+#include "fmt/format.h"
+
+namespace component {
+
+namespace {
+
+// merge sorted lists into out, lists are consumed
+void KWayMerge(const std::vector<Entries*>& lists, Entries* out) {
+  if (lists.size() == 1) {
+    *out = std::move(*lists[0]);
+    return;
+  }
+
+  size_t total = 0;
+  for (const Entries* list : lists) {
+    total += list->size();
+  }
+  out->reserve(total);
+
+  if (lists.size() == 2) {
+    std::merge(lists[0]->begin(), lists[0]->end(), lists[1]->begin(),
+               lists[1]->end(), std::back_inserter(*out));
+    return;
+  }
+
+  // <head entry, list index>
+  typedef std::pair<EntryId, size_t> Head;
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+  std::vector<size_t> offsets(lists.size(), 0);
+  for (size_t i = 0; i < lists.size(); i++) {
+    if (!lists[i]->empty()) {
+      heap.emplace(lists[i]->front(), i);
+    }
+  }
+  while (!heap.empty()) {
+    Head head = heap.top();
+    heap.pop();
+    out->push_back(head.first);
+
+    const Entries* list = lists[head.second];
+    size_t& offset = offsets[head.second];
+    if (++offset < list->size()) {
+      heap.emplace((*list)[offset], head.second);
+    }
+  }
+}
+
+}  // namespace
+
+std::string BuildStats::ToString() const {
+  return fmt::format(
+      "threads:{}, documents:{}, bad_documents:{}, conjunctions:{}, "
+      "attrs:{}, entries:{}, wildcards:{}, index_ms:{}, merge_ms:{}, "
+      "total_ms:{}",
+      threads, documents, bad_documents, conjunctions, attrs, entries,
+      wildcards, index_ms, merge_ms, total_ms);
+}
+
+ParallelIndexerBuilder::ParallelIndexerBuilder()
+  : ParallelIndexerBuilder(Options()) {}
+
+ParallelIndexerBuilder::ParallelIndexerBuilder(const Options& options)
+  : options_(options) {
+  if (options_.threads == 0) {
+    options_.threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  options_.batch_size = std::max(1u, options_.batch_size);
+  options_.max_pending_batches = std::max(1u, options_.max_pending_batches);
+
+  indexer_ = RefBooleanIndexer(new BooleanIndexer());
+  default_parser_ = std::make_shared<HasherParser>();
+
+  batch_.reserve(options_.batch_size);
+  for (uint32_t i = 0; i < options_.threads; i++) {
+    partitions_.emplace_back(new Partition());
+    workers_.emplace_back(&ParallelIndexerBuilder::WorkerMain, this,
+                          partitions_.back().get());
+  }
+}
+
+ParallelIndexerBuilder::~ParallelIndexerBuilder() {
+  StopWorkers();
+}
+
+FieldMeta* ParallelIndexerBuilder::GetFieldMeta(const std::string& field) {
+  std::lock_guard<std::mutex> lck(meta_mtx_);
+  auto meta = indexer_->GetMeta(field);
+  if (meta != nullptr) {
+    return meta;
+  }
+
+  FieldMetaPtr meta_ptr(new FieldMeta());
+  meta_ptr->name = field;
+  meta_ptr->parser = default_parser_;
+
+  meta = meta_ptr.get();
+  indexer_->SetMeta(field, std::move(meta_ptr));
+  return meta;
+}
+
+FieldMeta* ParallelIndexerBuilder::LocalFieldMeta(Partition* part,
+                                                  const std::string& field) {
+  auto iter = part->metas.find(field);
+  if (iter != part->metas.end()) {
+    return iter->second;
+  }
+  // meta never removed, the pointer keep valid
+  FieldMeta* meta = GetFieldMeta(field);
+  part->metas[field] = meta;
+  return meta;
+}
+
+void ParallelIndexerBuilder::AddDocument(Document&& doc) {
+  if (built_) {
+    LOG(ERROR) << "indexer has been built, document dropped:" << doc.doc_id();
+    return;
+  }
+  if (start_ms_ == 0) {
+    start_ms_ = base::time_ms();
+  }
+  batch_.emplace_back(std::move(doc));
+  if (batch_.size() >= options_.batch_size) {
+    DispatchBatch();
+  }
+}
+
+void ParallelIndexerBuilder::DispatchBatch() {
+  if (batch_.empty()) {
+    return;
+  }
+  Batch batch;
+  batch.reserve(options_.batch_size);
+  batch.swap(batch_);
+
+  std::unique_lock<std::mutex> lck(mtx_);
+  not_full_.wait(lck, [this]() {
+    return pending_.size() < options_.max_pending_batches;
+  });
+  pending_.emplace_back(std::move(batch));
+  lck.unlock();
+  not_empty_.notify_one();
+}
+
+void ParallelIndexerBuilder::WorkerMain(Partition* part) {
+  while (true) {
+    std::unique_lock<std::mutex> lck(mtx_);
+    not_empty_.wait(lck, [this]() { return closing_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      break;
+    }
+    Batch batch = std::move(pending_.front());
+    pending_.pop_front();
+    lck.unlock();
+    not_full_.notify_one();
+
+    for (const Document& doc : batch) {
+      IndexDocument(part, doc);
+    }
+  }
+  // sort in parallel, merge require sorted lists
+  for (auto& kv : part->container.values_) {
+    std::sort(kv.second.begin(), kv.second.end());
+  }
+  std::sort(part->wildcards.begin(), part->wildcards.end());
+}
+
+void ParallelIndexerBuilder::IndexDocument(Partition* part,
+                                           const Document& doc) {
+  part->documents++;
+  // same as BeIndexerBuilder::AddDocument
+  for (Conjunction* conj : doc.conjunctions()) {
+    part->conjunctions++;
+
+    if (conj->size() == 0) {
+      part->wildcards.push_back(EntryUtil::GenEntryID(conj->id(), false));
+    }
+
+    for (const auto& field_expr : conj->ExpressionAssigns()) {
+      const BooleanExpr& expr = field_expr.second;
+      const std::string& field = field_expr.first;
+
+      EntryId eid = EntryUtil::GenEntryID(conj->id(), expr.exclude());
+
+      FieldMeta* meta = LocalFieldMeta(part, field);
+
+      TokenPtr token = meta->parser->ParseIndexing(expr.Values());
+      if (token->BadToken()) {
+        LOG(ERROR) << "expression can't be parsed, field:" << field
+                   << ", values:"
+                   << fmt::format("{}", fmt::join(expr.Values(), ","));
+        part->bad_documents++;
+        return;
+      }
+      part->container.IndexingToken(meta, eid, token.get());
+    }
+  }
+}
+
+void ParallelIndexerBuilder::StopWorkers() {
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    closing_ = true;
+  }
+  not_empty_.notify_all();
+  for (std::thread& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+void ParallelIndexerBuilder::MergeShard(uint32_t shard,
+                                        uint32_t shards,
+                                        MergedEntries* out) {
+  pair_hash hasher;
+  std::vector<Entries*> lists;
+  for (size_t i = 0; i < partitions_.size(); i++) {
+    for (auto& kv : partitions_[i]->container.values_) {
+      const Attr& attr = kv.first;
+      if (hasher(attr) % shards != shard) {
+        continue;
+      }
+      // merged when meet it in the first partition has it
+      bool merged = false;
+      for (size_t j = 0; j < i && !merged; j++) {
+        merged = partitions_[j]->container.values_.count(attr) > 0;
+      }
+      if (merged) {
+        continue;
+      }
+
+      lists.clear();
+      lists.push_back(&kv.second);
+      for (size_t j = i + 1; j < partitions_.size(); j++) {
+        PostingList& values = partitions_[j]->container.values_;
+        auto iter = values.find(attr);
+        if (iter != values.end()) {
+          lists.push_back(&iter->second);
+        }
+      }
+      out->emplace_back(attr, Entries());
+      KWayMerge(lists, &out->back().second);
+    }
+  }
+}
+
+RefBooleanIndexer ParallelIndexerBuilder::BuildIndexer() {
+  if (built_) {
+    LOG(ERROR) << "indexer can only be built once";
+    return nullptr;
+  }
+  built_ = true;
+  if (start_ms_ == 0) {
+    start_ms_ = base::time_ms();
+  }
+
+  DispatchBatch();
+  StopWorkers();
+
+  int64_t merge_start_ms = base::time_ms();
+  stats_.threads = partitions_.size();
+  stats_.index_ms = merge_start_ms - start_ms_;
+
+  // partitions only read(and entries moved out) by shard owner
+  uint32_t shards = partitions_.size();
+  std::vector<MergedEntries> merged(shards);
+  std::vector<std::thread> mergers;
+  for (uint32_t i = 1; i < shards; i++) {
+    mergers.emplace_back(&ParallelIndexerBuilder::MergeShard, this, i, shards,
+                         &merged[i]);
+  }
+  MergeShard(0, shards, &merged[0]);
+  for (std::thread& merger : mergers) {
+    merger.join();
+  }
+
+  std::vector<Entries*> wildcards;
+  for (auto& part : partitions_) {
+    stats_.documents += part->documents;
+    stats_.conjunctions += part->conjunctions;
+    stats_.bad_documents += part->bad_documents;
+    wildcards.push_back(&part->wildcards);
+  }
+  KWayMerge(wildcards, &indexer_->wildcard_list_);
+  stats_.wildcards = indexer_->wildcard_list_.size();
+  partitions_.clear();
+
+  // all fields go to default container, see BooleanIndexer::GetContainer
+  CommonContainer* container =
+      static_cast<CommonContainer*>(indexer_->DefaultContainer());
+  size_t attrs = 0;
+  for (const MergedEntries& shard : merged) {
+    attrs += shard.size();
+  }
+  container->values_.reserve(attrs);
+  for (MergedEntries& shard : merged) {
+    for (auto& kv : shard) {
+      container->values_.emplace(std::move(kv.first), std::move(kv.second));
+    }
+    MergedEntries().swap(shard);
+  }
+  // lists are sorted already, compress only
+  if (!indexer_->CompleteIndex()) {
+    return nullptr;
+  }
+
+  stats_.attrs = container->Size();
+  stats_.entries = container->sum_len_;
+  stats_.merge_ms = base::delta_ms(merge_start_ms);
+  stats_.total_ms = base::delta_ms(start_ms_);
+  LOG(INFO) << "parallel indexer built, " << stats_.ToString();
+  return indexer_;
+}
+
+}  // namespace component
@@ -0,0 +1,167 @@
+#ifndef _LT_COMPONENT_BOOLEAN_INDEXER_PARALLEL_BUILDER_H_
+#define _LT_COMPONENT_BOOLEAN_INDEXER_PARALLEL_BUILDER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "base/lt_micro.h"
+#include "components/boolean_indexer/be_indexer.h"
+#include "components/boolean_indexer/common_container.h"
+#include "components/boolean_indexer/document.h"
+#include "components/boolean_indexer/parser/number_parser.h"
+
+namespace component {
+
+struct BuildStats {
+  size_t threads = 0;
+  uint64_t documents = 0;
+  uint64_t conjunctions = 0;
+  // documents dropped for unparsable expression
+  uint64_t bad_documents = 0;
+  // posting lists and total entries in them(wildcard list excluded)
+  uint64_t attrs = 0;
+  uint64_t entries = 0;
+  uint64_t wildcards = 0;
+  // first document added -> all documents indexed by workers
+  int64_t index_ms = 0;
+  // k-way merge of per-thread posting lists and compression
+  int64_t merge_ms = 0;
+  int64_t total_ms = 0;
+
+  std::string ToString() const;
+};
+
+/* multi thread version of BeIndexerBuilder for big index rebuild
+ *
+ * documents are batched and indexed by worker threads into their own
+ * posting lists while caller keep loading(pipelined), BuildIndexer
+ * sort those partitions and k-way merge them into the final indexer,
+ * attrs are sharded across threads when merging
+ *
+ * AddDocument/BuildIndexer must be called in one thread, field parsers
+ * must be thread safe(the default HasherParser is); a builder build
+ * only once, the result identical to BeIndexerBuilder with same input
+ *
+ * usage example:
+ * ParallelIndexerBuilder builder;
+ * for (...) builder.AddDocument(std::move(doc));
+ * holder.Publish(builder.BuildIndexer());
+ * */
+class ParallelIndexerBuilder {
+public:
+  struct Options {
+    // 0: std::thread::hardware_concurrency()
+    uint32_t threads = 0;
+    // documents per task handed to workers
+    uint32_t batch_size = 256;
+    // AddDocument blocked when so many batches not indexed yet
+    uint32_t max_pending_batches = 64;
+  };
+
+  ParallelIndexerBuilder();
+
+  explicit ParallelIndexerBuilder(const Options& options);
+
+  ~ParallelIndexerBuilder();
+
+  // configure field before documents of it added
+  FieldMeta* GetFieldMeta(const std::string& field);
+
+  void AddDocument(Document&& doc);
+
+  // return nullptr when called twice
+  RefBooleanIndexer BuildIndexer();
+
+  // valid after BuildIndexer
+  const BuildStats& Stats() const { return stats_; }
+
+private:
+  typedef std::vector<Document> Batch;
+
+  struct Partition {
+    CommonContainer container;
+    Entries wildcards;
+    // worker local cache of field meta
+    std::unordered_map<std::string, FieldMeta*> metas;
+    uint64_t documents = 0;
+    uint64_t conjunctions = 0;
+    uint64_t bad_documents = 0;
+  };
+
+  void WorkerMain(Partition* part);
+
+  void IndexDocument(Partition* part, const Document& doc);
+
+  FieldMeta* LocalFieldMeta(Partition* part, const std::string& field);
+
+  void DispatchBatch();
+
+  void StopWorkers();
+
+  typedef std::vector<std::pair<Attr, Entries>> MergedEntries;
+
+  void MergeShard(uint32_t shard, uint32_t shards, MergedEntries* out);
+
+  Options options_;
+
+  RefBooleanIndexer indexer_;
+
+  RefExprParser default_parser_;
+
+  std::mutex meta_mtx_;
+
+  Batch batch_;
+
+  std::mutex mtx_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<Batch> pending_;
+  bool closing_ = false;
+
+  std::vector<std::unique_ptr<Partition>> partitions_;
+
+  std::vector<std::thread> workers_;
+
+  bool built_ = false;
+
+  int64_t start_ms_ = 0;
+
+  BuildStats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelIndexerBuilder);
+};
+
+/* hold the online indexer for hot swap, readers keep the snapshot they
+ * got until done, the replaced one released with its last reader */
+class BooleanIndexerHolder {
+public:
+  BooleanIndexerHolder() {}
+
+  explicit BooleanIndexerHolder(RefBooleanIndexer indexer)
+    : indexer_(std::move(indexer)) {}
+
+  RefBooleanIndexer Get() const { return std::atomic_load(&indexer_); }
+
+  // return the replaced one; a nullptr(build failed) is ignored
+  RefBooleanIndexer Publish(RefBooleanIndexer indexer) {
+    if (!indexer) {
+      return nullptr;
+    }
+    return std::atomic_exchange(&indexer_, std::move(indexer));
+  }
+
+private:
+  RefBooleanIndexer indexer_;
+
+  DISALLOW_COPY_AND_ASSIGN(BooleanIndexerHolder);
+};
+
+}  // namespace component
+
+#endif
@@ -4,6 +4,7 @@
 #include <sstream>
 
 #include "fmt/format.h"
+#include "glog/logging.h"
 
 namespace component {
 
@@ -13,6 +14,10 @@ bool CommonContainer::IndexingToken(const FieldMeta* meta,
   if (token->BadToken()) {
     return false;
   }
+  if (compiled_) {
+    LOG(ERROR) << "container compiled, can't index more, field:" << meta->name;
+    return false;
+  }
 
   for (int64_t value : token->Int64()) {
     Attr attr = {meta->name, value};
@@ -26,33 +31,59 @@ EntriesList CommonContainer::RetrieveEntries(const FieldMeta* meta,
   EntriesList results;
   for (int64_t value : token->Int64()) {
     Attr attr(meta->name, value);
-    auto iter = values_.find(attr);
-    if (iter == values_.end()) {
+    const CompressedEntries* entries = postings_.Find(attr);
+    if (entries == nullptr) {
       continue;
     }
-    results.push_back(&(iter->second));
+    results.push_back(entries);
   }
   return results;
 }
 
 bool CommonContainer::CompileEntries() {
+  if (compiled_) {
+    return true;
+  }
+  postings_.Reserve(values_.size());
   for (auto& pair : values_) {
-    sum_len_ += pair.second.size();
-    if (max_len_ < pair.second.size()) {
-      max_len_ = pair.second.size();
+    Entries& entries = pair.second;
+    sum_len_ += entries.size();
+    max_len_ = std::max<int64_t>(max_len_, entries.size());
+    if (!std::is_sorted(entries.begin(), entries.end())) {
+      std::sort(entries.begin(), entries.end());
     }
-    std::sort(pair.second.begin(), pair.second.end());
+    postings_.Insert(pair.first, CompressedEntries(entries));
+    Entries().swap(entries);
   }
+  PostingList().swap(values_);
+  compiled_ = true;
   return true;
 };
 
+void CommonContainer::ForEachEntries(
+    const std::function<void(const Attr&, const CompressedEntries&)>& fn)
+    const {
+  for (const auto& kv : postings_) {
+    fn(kv.first, kv.second);
+  }
+}
+
+size_t CommonContainer::MemoryUsage() const {
+  size_t bytes = postings_.MemoryUsage();
+  for (const auto& kv : postings_) {
+    bytes += kv.second.MemoryUsage() - sizeof(kv.second);
+  }
+  return bytes;
+}
+
 void CommonContainer::DumpEntries(std::ostringstream& oss) const {
   oss << "+++++ start dump common container entries ++++++++++\n";
-  for (auto& kvs : values_) {
+  for (auto& kvs : postings_) {
     oss << "<" << kvs.first.first << "," << kvs.first.second << ">:";
     // fmt::format("{}", fmt::join(kvs.second, ","));
-    for (auto iter = kvs.second.begin(); iter != kvs.second.end(); iter++) {
-      if (iter != kvs.second.begin()) {
+    Entries entries = kvs.second.Decode();
+    for (auto iter = entries.begin(); iter != entries.end(); iter++) {
+      if (iter != entries.begin()) {
         oss << ",";
       }
       oss << EntryUtil::ToString(*iter);
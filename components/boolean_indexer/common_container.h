@@ -1,10 +1,15 @@
 #ifndef _LT_COMPONENT_BE_ENTRIES_COMMON_CONTAINER_H_
 #define _LT_COMPONENT_BE_ENTRIES_COMMON_CONTAINER_H_
 
+#include "flat_hash_map.h"
 #include "posting_list.h"
 
 namespace component {
 
+class ParallelIndexerBuilder;
+class IndexSegment;
+class IncrementalIndexer;
+
 class CommonContainer : public EntriesContainer {
 public:
   CommonContainer(){};
@@ -18,18 +23,35 @@ public:
 
   bool CompileEntries() override;
 
+  void ForEachEntries(
+      const std::function<void(const Attr&, const CompressedEntries&)>& fn)
+      const override;
+
   void DumpEntries(std::ostringstream& oss) const override;
 
-  int64_t Size() const { return values_.size(); }
+  int64_t Size() const {
+    return compiled_ ? postings_.Size() : values_.size();
+  }
 
   int64_t MaxEntriesLength() const { return max_len_; }
 
   int64_t AvgEntriesLength() const { return sum_len_ / Size(); }
 
+  // bytes of compiled posting lists(include the hash table)
+  size_t MemoryUsage() const;
+
 private:
-  int max_len_ = 0;
-  int sum_len_ = 0;
+  friend ParallelIndexerBuilder;
+  friend IndexSegment;
+  friend IncrementalIndexer;
+
+  bool compiled_ = false;
+  int64_t max_len_ = 0;
+  int64_t sum_len_ = 0;
+  // building
   PostingList values_;
+  // compiled from values_
+  FlatHashMap<Attr, CompressedEntries, pair_hash> postings_;
 };
 
 }  // namespace component
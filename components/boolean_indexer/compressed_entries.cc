@@ -0,0 +1,175 @@
+#include "compressed_entries.h"
+
+#include <algorithm>
+
+namespace component {
+
+namespace {
+
+const uint32_t kOffsetBits = 32;
+const uint32_t kWidthBits = 8;
+
+inline uint64_t header_meta(uint32_t offset, uint32_t bits, uint32_t count) {
+  return uint64_t(offset) | (uint64_t(bits) << kOffsetBits) |
+         (uint64_t(count - 1) << (kOffsetBits + kWidthBits));
+}
+
+inline uint32_t bit_width(uint64_t v) {
+  return v == 0 ? 0 : 64 - __builtin_clzll(v);
+}
+
+}  // namespace
+
+CompressedEntries::CompressedEntries(const Entries& entries)
+  : size_(entries.size()) {
+  blocks_ = (size_ + kBlockSize - 1) / kBlockSize;
+  std::vector<uint64_t>& words = storage_;
+  words.resize(blocks_ << 1, 0);
+
+  for (uint32_t block = 0; block < blocks_; block++) {
+    const EntryId* values = entries.data() + block * kBlockSize;
+    uint32_t count = std::min(kBlockSize, size_ - block * kBlockSize);
+
+    uint64_t max_delta = 0;
+    for (uint32_t i = 1; i < count; i++) {
+      max_delta |= values[i] - values[i - 1];
+    }
+    uint32_t bits = bit_width(max_delta);
+    uint32_t offset = words.size();
+    words.resize(offset + ((count - 1) * bits + 63) / 64, 0);
+
+    uint64_t* packed = words.data() + offset;
+    for (uint32_t i = 1; bits > 0 && i < count; i++) {
+      uint64_t delta = values[i] - values[i - 1];
+      uint32_t pos = (i - 1) * bits;
+      uint32_t shift = pos & 63;
+      packed[pos >> 6] |= delta << shift;
+      if (shift + bits > 64) {
+        packed[(pos >> 6) + 1] |= delta >> (64 - shift);
+      }
+    }
+    words[block << 1] = values[0];
+    words[(block << 1) + 1] = header_meta(offset, bits, count);
+  }
+  // decoder always read two words
+  words.push_back(0);
+  words.shrink_to_fit();
+  words_ = storage_.data();
+  word_count_ = storage_.size();
+}
+
+CompressedEntries::CompressedEntries(const CompressedEntries& other) {
+  *this = other;
+}
+
+CompressedEntries::CompressedEntries(CompressedEntries&& other) {
+  *this = std::move(other);
+}
+
+CompressedEntries& CompressedEntries::operator=(
+    const CompressedEntries& other) {
+  if (this == &other) {
+    return *this;
+  }
+  size_ = other.size_;
+  blocks_ = other.blocks_;
+  word_count_ = other.word_count_;
+  storage_ = other.storage_;
+  words_ = storage_.empty() ? other.words_ : storage_.data();
+  return *this;
+}
+
+CompressedEntries& CompressedEntries::operator=(CompressedEntries&& other) {
+  if (this == &other) {
+    return *this;
+  }
+  size_ = other.size_;
+  blocks_ = other.blocks_;
+  word_count_ = other.word_count_;
+  // the moved buffer keep its address
+  storage_ = std::move(other.storage_);
+  words_ = other.words_;
+
+  other.size_ = other.blocks_ = 0;
+  other.words_ = nullptr;
+  other.word_count_ = 0;
+  other.storage_.clear();
+  return *this;
+}
+
+bool CompressedEntries::Borrow(uint32_t size,
+                               const uint64_t* words,
+                               size_t word_count) {
+  uint32_t blocks = (uint64_t(size) + kBlockSize - 1) / kBlockSize;
+  // headers and the pad word at least
+  if (word_count < (size_t(blocks) << 1) + 1) {
+    return false;
+  }
+  for (uint32_t block = 0; block < blocks; block++) {
+    uint64_t meta = words[(block << 1) + 1];
+    uint32_t offset = meta & 0xFFFFFFFF;
+    uint32_t bits = (meta >> kOffsetBits) & 0xFF;
+    uint32_t count = ((meta >> (kOffsetBits + kWidthBits)) & 0xFF) + 1;
+    uint32_t expect = std::min(kBlockSize, size - block * kBlockSize);
+    if (bits > 64 || count != expect ||
+        offset + ((count - 1) * uint64_t(bits) + 63) / 64 >= word_count) {
+      return false;
+    }
+  }
+  std::vector<uint64_t>().swap(storage_);
+  size_ = size;
+  blocks_ = blocks;
+  words_ = words;
+  word_count_ = word_count;
+  return true;
+}
+
+size_t CompressedEntries::LowerBoundBlock(size_t from, EntryId id) const {
+  size_t left = from, right = blocks_;
+  while (left < right) {
+    size_t mid = (left + right) >> 1;
+    if (BlockFirst(mid) < id) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+uint32_t CompressedEntries::DecodeBlock(size_t block, EntryId* out) const {
+  EntryId value = words_[block << 1];
+  uint64_t meta = words_[(block << 1) + 1];
+  uint32_t offset = meta & 0xFFFFFFFF;
+  uint32_t bits = (meta >> kOffsetBits) & 0xFF;
+  uint32_t count = ((meta >> (kOffsetBits + kWidthBits)) & 0xFF) + 1;
+
+  out[0] = value;
+  if (bits == 0) {
+    std::fill(out + 1, out + count, value);
+    return count;
+  }
+
+  const uint64_t* packed = words_ + offset;
+  const uint64_t mask = bits == 64 ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+  // branch free: a delta always in the two words from pos/64
+  for (uint32_t i = 1, pos = 0; i < count; i++, pos += bits) {
+    const uint64_t* w = packed + (pos >> 6);
+    unsigned __int128 pair = (unsigned __int128)(w[1]) << 64 | w[0];
+    value += uint64_t(pair >> (pos & 63)) & mask;
+    out[i] = value;
+  }
+  return count;
+}
+
+Entries CompressedEntries::Decode() const {
+  Entries entries(size_ + kBlockSize);
+  size_t count = 0;
+  for (size_t block = 0; block < blocks_; block++) {
+    count += DecodeBlock(block, entries.data() + count);
+  }
+  entries.resize(count);
+  return entries;
+}
+
+}  // namespace component
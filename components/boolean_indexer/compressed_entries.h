@@ -0,0 +1,81 @@
+#ifndef _LT_COMPONENT_BE_COMPRESSED_ENTRIES_H_
+#define _LT_COMPONENT_BE_COMPRESSED_ENTRIES_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "id_generator.h"
+
+namespace component {
+
+/* immutable sorted entries, stored in blocks of kBlockSize entries;
+ * a block keep its first entry in header, the following deltas are
+ * bit-packed with the block's max delta width
+ *
+ * all block headers(skip pointers) placed at the front, so a SkipTo
+ * across blocks only touch the headers and the target block
+ *
+ * words: |--header x blocks--|--packed deltas--|pad|
+ * header: |--first(64)--| |--count-1(8)--|--bits(8)--|--offset(32)--|
+ *
+ * words are owned, or borrowed from a mapped IndexSegment(see Borrow)
+ * */
+class CompressedEntries {
+public:
+  static const uint32_t kBlockSize = 128;
+
+  CompressedEntries() {}
+
+  // entries must be sorted
+  explicit CompressedEntries(const Entries& entries);
+
+  CompressedEntries(const CompressedEntries& other);
+  CompressedEntries(CompressedEntries&& other);
+  CompressedEntries& operator=(const CompressedEntries& other);
+  CompressedEntries& operator=(CompressedEntries&& other);
+
+  // borrow words of entries encoded before(Words/WordCount), false
+  // when words not a valid encoding of size entries; words must outlive it
+  bool Borrow(uint32_t size, const uint64_t* words, size_t word_count);
+
+  size_t Size() const { return size_; }
+
+  bool Empty() const { return size_ == 0; }
+
+  size_t BlockCount() const { return blocks_; }
+
+  EntryId BlockFirst(size_t block) const { return words_[block << 1]; }
+
+  // first block in [from, BlockCount()) with first entry >= id,
+  // BlockCount() if none
+  size_t LowerBoundBlock(size_t from, EntryId id) const;
+
+  // decode a block into out(kBlockSize at least), return entries count
+  uint32_t DecodeBlock(size_t block, EntryId* out) const;
+
+  Entries Decode() const;
+
+  const uint64_t* Words() const { return words_; }
+
+  size_t WordCount() const { return word_count_; }
+
+  // owned bytes only
+  size_t MemoryUsage() const {
+    return sizeof(*this) + storage_.capacity() * sizeof(uint64_t);
+  }
+
+private:
+  uint32_t size_ = 0;
+
+  uint32_t blocks_ = 0;
+
+  // storage_.data() or borrowed
+  const uint64_t* words_ = nullptr;
+
+  size_t word_count_ = 0;
+
+  std::vector<uint64_t> storage_;
+};
+
+}  // namespace component
+#endif
@@ -0,0 +1,130 @@
+#ifndef _LT_COMPONENT_BE_FLAT_HASH_MAP_H_
+#define _LT_COMPONENT_BE_FLAT_HASH_MAP_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace component {
+
+/* open addressing(linear probing) map for build once, read mostly data
+ *
+ * slots only keep a hash tag and the index into a dense key-value
+ * array, a lookup scan adjacent slots in one or two cache lines and
+ * touch the key-value it hit; no erase
+ * */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class FlatHashMap {
+public:
+  typedef std::pair<Key, Value> KeyValue;
+  typedef typename std::vector<KeyValue>::const_iterator const_iterator;
+
+  FlatHashMap() {}
+
+  void Reserve(size_t count) {
+    items_.reserve(count);
+    if (count * 2 > slots_.size()) {
+      Rehash(count * 2);
+    }
+  }
+
+  // return false when key exist
+  bool Insert(Key key, Value value) {
+    if ((items_.size() + 1) * 2 > slots_.size()) {
+      Rehash(std::max<size_t>(16, slots_.size() * 2));
+    }
+    uint64_t hash = Mix(hasher_(key));
+    size_t pos = hash & mask_;
+    for (; slots_[pos].index != 0; pos = (pos + 1) & mask_) {
+      const Slot& slot = slots_[pos];
+      if (slot.tag == Tag(hash) && items_[slot.index - 1].first == key) {
+        return false;
+      }
+    }
+    items_.emplace_back(std::move(key), std::move(value));
+    slots_[pos] = {Tag(hash), uint32_t(items_.size())};
+    return true;
+  }
+
+  const Value* Find(const Key& key) const {
+    if (items_.empty()) {
+      return nullptr;
+    }
+    uint64_t hash = Mix(hasher_(key));
+    for (size_t pos = hash & mask_; slots_[pos].index != 0;
+         pos = (pos + 1) & mask_) {
+      const Slot& slot = slots_[pos];
+      if (slot.tag == Tag(hash) && items_[slot.index - 1].first == key) {
+        return &items_[slot.index - 1].second;
+      }
+    }
+    return nullptr;
+  }
+
+  size_t Size() const { return items_.size(); }
+
+  bool Empty() const { return items_.empty(); }
+
+  const_iterator begin() const { return items_.begin(); }
+  const_iterator end() const { return items_.end(); }
+
+  void Clear() {
+    std::vector<Slot>().swap(slots_);
+    std::vector<KeyValue>().swap(items_);
+    mask_ = 0;
+  }
+
+  size_t MemoryUsage() const {
+    return slots_.capacity() * sizeof(Slot) +
+           items_.capacity() * sizeof(KeyValue);
+  }
+
+private:
+  struct Slot {
+    uint32_t tag;
+    // 1 based index of items_, 0: empty
+    uint32_t index;
+  };
+
+  // murmur3 finalizer, spread a weak hash(eg: identity of integer)
+  static uint64_t Mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+  }
+
+  static uint32_t Tag(uint64_t hash) { return hash >> 32; }
+
+  void Rehash(size_t count) {
+    size_t capacity = 16;
+    while (capacity < count) {
+      capacity <<= 1;
+    }
+    slots_.assign(capacity, Slot{0, 0});
+    mask_ = capacity - 1;
+    for (size_t i = 0; i < items_.size(); i++) {
+      uint64_t hash = Mix(hasher_(items_[i].first));
+      size_t pos = hash & mask_;
+      while (slots_[pos].index != 0) {
+        pos = (pos + 1) & mask_;
+      }
+      slots_[pos] = {Tag(hash), uint32_t(i + 1)};
+    }
+  }
+
+  Hash hasher_;
+
+  size_t mask_ = 0;
+
+  std::vector<Slot> slots_;
+
+  std::vector<KeyValue> items_;
+};
+
+}  // namespace component
+#endif
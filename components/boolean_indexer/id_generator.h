@@ -10,9 +10,11 @@ namespace component {
 
 #define NULLENTRY 0xFFFFFFFFFFFFFFFF
 
+class CompressedEntries;
+
 typedef uint64_t EntryId;
 typedef std::vector<EntryId> Entries;
-typedef std::vector<const Entries*> EntriesList;
+typedef std::vector<const CompressedEntries*> EntriesList;
 
 typedef int64_t ValueID;
 typedef std::vector<ValueID> ValueList;
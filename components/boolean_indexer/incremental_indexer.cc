@@ -0,0 +1,297 @@
+#include "incremental_indexer.h"
+
+#include <glog/logging.h>
+
+#include "base/time/time_utils.h"
+#include "common_container.h"
+#include "fmt/format.h"
+#include "parser/number_parser.h"
+
+namespace component {
+
+IndexSnapshot::IndexSnapshot(RefBooleanIndexer base,
+                             RefBooleanIndexer delta,
+                             std::shared_ptr<const RoaringBitmap> tombstones,
+                             uint64_t version)
+  : base_(base), delta_(delta), tombstones_(tombstones), version_(version) {}
+
+IndexScanner::Result IndexSnapshot::Retrieve(
+    const QueryAssigns& queries,
+    const IndexScanner::Option* opt,
+    IndexScanner::Context* ctx) const {
+  IndexScanner::Context local_ctx;
+  if (nullptr == ctx) {
+    ctx = &local_ctx;
+  }
+  IndexScanner::Option option = opt ? *opt : IndexScanner::DefaultOption();
+  IndexScanner::Option base_option = option;
+  if (!tombstones_->Empty()) {
+    base_option.tombstones = tombstones_.get();
+  }
+  IndexScanner::Result result =
+      IndexScanner(base_.get()).Retrieve(queries, &base_option, ctx);
+  if (!delta_) {
+    return result;
+  }
+
+  if (option.limit > 0) {
+    if (result.result.size() >= option.limit) {
+      return result;
+    }
+    option.limit -= result.result.size();
+  }
+  IndexScanner::Result delta =
+      IndexScanner(delta_.get()).Retrieve(queries, &option, ctx);
+  result.result.insert(result.result.end(), delta.result.begin(),
+                       delta.result.end());
+  return result;
+}
+
+IncrementalIndexer::IncrementalIndexer(RefBooleanIndexer base)
+  : IncrementalIndexer(base, Options()) {}
+
+IncrementalIndexer::IncrementalIndexer(RefBooleanIndexer base,
+                                       const Options& options)
+  : options_(options), base_(base) {
+  default_parser_ = std::make_shared<HasherParser>();
+  if (!base_) {
+    base_ = BuildIndexer(nullptr, DocChanges(), parsers_);
+  }
+  // posting lists of field containers(eg: RangeContainer) not attr keyed
+  CHECK(base_->containers_.size() == 1)
+      << "only indexer with the default container supported";
+  for (const auto& kv : base_->field_meta_) {
+    parsers_[kv.first] = kv.second->parser;
+  }
+  Commit();
+  if (options_.compact_threshold > 0) {
+    compactor_ = std::thread(&IncrementalIndexer::CompactMain, this);
+  }
+}
+
+IncrementalIndexer::~IncrementalIndexer() {
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    closing_ = true;
+  }
+  compact_cv_.notify_all();
+  if (compactor_.joinable()) {
+    compactor_.join();
+  }
+}
+
+const RefExprParser& IncrementalIndexer::GetParser(const std::string& field) {
+  RefExprParser& parser = parsers_[field];
+  if (!parser) {
+    parser = default_parser_;
+  }
+  return parser;
+}
+
+bool IncrementalIndexer::Upsert(Document&& doc) {
+  std::lock_guard<std::mutex> lck(mtx_);
+
+  std::shared_ptr<DocChange> change(new DocChange());
+  // same as BeIndexerBuilder::AddDocument
+  for (Conjunction* conj : doc.conjunctions()) {
+    if (conj->size() == 0) {
+      change->wildcards.push_back(EntryUtil::GenEntryID(conj->id(), false));
+    }
+    for (const auto& field_expr : conj->ExpressionAssigns()) {
+      const std::string& field = field_expr.first;
+      const BooleanExpr& expr = field_expr.second;
+
+      EntryId eid = EntryUtil::GenEntryID(conj->id(), expr.exclude());
+      TokenPtr token = GetParser(field)->ParseIndexing(expr.Values());
+      if (token->BadToken()) {
+        LOG(ERROR) << "expression can't be parsed, doc:" << doc.doc_id()
+                   << ", field:" << field << ", values:"
+                   << fmt::format("{}", fmt::join(expr.Values(), ","));
+        return false;
+      }
+      for (int64_t value : token->Int64()) {
+        change->entries.emplace_back(Attr(field, value), eid);
+      }
+    }
+  }
+  change->seq = ++seq_;
+  changes_[doc.doc_id()] = std::move(change);
+  return true;
+}
+
+void IncrementalIndexer::Remove(int32_t doc_id) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  std::shared_ptr<DocChange> change(new DocChange());
+  change->seq = ++seq_;
+  change->removed = true;
+  changes_[doc_id] = std::move(change);
+}
+
+RefIndexSnapshot IncrementalIndexer::Commit() {
+  std::lock_guard<std::mutex> commit_lck(commit_mtx_);
+
+  RefBooleanIndexer base;
+  DocChanges changes;
+  FieldParsers parsers;
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    base = base_;
+    changes = changes_;
+    parsers = parsers_;
+    if (options_.compact_threshold > 0 &&
+        changes_.size() >= options_.compact_threshold) {
+      compact_pending_ = true;
+      compact_cv_.notify_one();
+    }
+  }
+
+  // built out of mtx_, not to block Upsert/Remove
+  RefBooleanIndexer delta;
+  std::shared_ptr<RoaringBitmap> tombstones(new RoaringBitmap());
+  bool has_upsert = false;
+  for (const auto& kv : changes) {
+    tombstones->Add(kv.first);
+    has_upsert = has_upsert || !kv.second->removed;
+  }
+  tombstones->Optimize();
+  if (has_upsert) {
+    delta = BuildIndexer(nullptr, changes, parsers);
+  }
+
+  RefIndexSnapshot snapshot(
+      new IndexSnapshot(base, delta, tombstones, ++version_));
+  std::atomic_store(&snapshot_, snapshot);
+  return snapshot;
+}
+
+RefIndexSnapshot IncrementalIndexer::Snapshot() const {
+  return std::atomic_load(&snapshot_);
+}
+
+size_t IncrementalIndexer::DeltaSize() const {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return changes_.size();
+}
+
+// static
+RefBooleanIndexer IncrementalIndexer::BuildIndexer(
+    const BooleanIndexer* base,
+    const DocChanges& changes,
+    const FieldParsers& parsers) {
+  RefBooleanIndexer indexer(new BooleanIndexer());
+  for (const auto& kv : parsers) {
+    FieldMetaPtr meta(new FieldMeta());
+    meta->name = kv.first;
+    meta->parser = kv.second;
+    indexer->SetMeta(kv.first, std::move(meta));
+  }
+  CommonContainer* container =
+      static_cast<CommonContainer*>(indexer->DefaultContainer());
+  PostingList& values = container->values_;
+
+  if (base != nullptr) {
+    RoaringBitmap changed;
+    for (const auto& kv : changes) {
+      changed.Add(kv.first);
+    }
+    auto alive = [&changed](EntryId eid) {
+      return !changed.Contains(EntryUtil::GetDocID(eid));
+    };
+    // sorted already, filtered entries keep the order
+    base->DefaultContainer()->ForEachEntries(
+        [&](const Attr& attr, const CompressedEntries& entries) {
+          Entries kept;
+          for (EntryId eid : entries.Decode()) {
+            if (alive(eid)) {
+              kept.push_back(eid);
+            }
+          }
+          if (!kept.empty()) {
+            values[attr] = std::move(kept);
+          }
+        });
+    for (EntryId eid : base->wildcard_entries_.Decode()) {
+      if (alive(eid)) {
+        indexer->wildcard_list_.push_back(eid);
+      }
+    }
+  }
+
+  for (const auto& kv : changes) {
+    const DocChange& change = *kv.second;
+    if (change.removed) {
+      continue;
+    }
+    for (const auto& attr_entry : change.entries) {
+      values[attr_entry.first].push_back(attr_entry.second);
+    }
+    indexer->wildcard_list_.insert(indexer->wildcard_list_.end(),
+                                   change.wildcards.begin(),
+                                   change.wildcards.end());
+  }
+
+  if (!indexer->CompleteIndex()) {
+    return nullptr;
+  }
+  return indexer;
+}
+
+bool IncrementalIndexer::Compact() {
+  std::lock_guard<std::mutex> compact_lck(compact_mtx_);
+
+  RefBooleanIndexer base;
+  DocChanges changes;
+  FieldParsers parsers;
+  uint64_t seq = 0;
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    if (changes_.empty()) {
+      return true;
+    }
+    base = base_;
+    changes = changes_;
+    parsers = parsers_;
+    seq = seq_;
+  }
+
+  // changes after here keep in delta, and apply to the new base
+  int64_t start_ms = base::time_ms();
+  RefBooleanIndexer new_base = BuildIndexer(base.get(), changes, parsers);
+  if (!new_base) {
+    LOG(ERROR) << "compact delta into base failed";
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    base_ = new_base;
+    for (auto iter = changes_.begin(); iter != changes_.end();) {
+      if (iter->second->seq <= seq) {
+        iter = changes_.erase(iter);
+      } else {
+        iter++;
+      }
+    }
+  }
+  Commit();
+  LOG(INFO) << "compacted " << changes.size()
+            << " changed documents into base, spend:"
+            << base::delta_ms(start_ms) << "(ms)";
+  return true;
+}
+
+void IncrementalIndexer::CompactMain() {
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lck(mtx_);
+      compact_cv_.wait(lck, [this]() { return closing_ || compact_pending_; });
+      if (closing_) {
+        break;
+      }
+      compact_pending_ = false;
+    }
+    Compact();
+  }
+}
+
+}  // namespace component
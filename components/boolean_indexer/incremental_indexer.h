@@ -0,0 +1,152 @@
+#ifndef _LT_COMPONENT_BE_INCREMENTAL_INDEXER_H_
+#define _LT_COMPONENT_BE_INCREMENTAL_INDEXER_H_
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "base/lt_micro.h"
+#include "components/inverted_indexer/posting_field/roaring_bitmap.h"
+#include "be_indexer.h"
+#include "index_scanner.h"
+
+namespace component {
+
+/* a consistent view of base + delta, keep it for a whole query(or a
+ * batch of), later changes never visible to it */
+class IndexSnapshot {
+public:
+  IndexSnapshot(RefBooleanIndexer base,
+                RefBooleanIndexer delta,
+                std::shared_ptr<const RoaringBitmap> tombstones,
+                uint64_t version);
+
+  // documents of base filtered by tombstones, then the delta
+  IndexScanner::Result Retrieve(const QueryAssigns& queries,
+                                const IndexScanner::Option* opt = nullptr,
+                                IndexScanner::Context* ctx = nullptr) const;
+
+  const RefBooleanIndexer& Base() const { return base_; }
+
+  // nullptr when no documents changed since the base built
+  const RefBooleanIndexer& Delta() const { return delta_; }
+
+  uint64_t Version() const { return version_; }
+
+private:
+  RefBooleanIndexer base_;
+
+  RefBooleanIndexer delta_;
+
+  // documents in base removed or replaced by the delta
+  std::shared_ptr<const RoaringBitmap> tombstones_;
+
+  uint64_t version_ = 0;
+};
+using RefIndexSnapshot = std::shared_ptr<const IndexSnapshot>;
+
+/* base + delta boolean indexer for online document changes
+ *
+ * Upsert/Remove only record the change into the delta, Commit build a
+ * new(small) delta indexer and publish a snapshot, call it at the pace
+ * changes should take effect(eg: every second).
+ * compaction fold the delta into a new base by merging posting lists,
+ * the documents of base never needed again; it run in background when
+ * the delta grows over compact_threshold, or by Compact() */
+class IncrementalIndexer {
+public:
+  struct Options {
+    // changed documents that trigger a background compaction, 0: never
+    size_t compact_threshold = 10000;
+  };
+
+  explicit IncrementalIndexer(RefBooleanIndexer base);
+
+  IncrementalIndexer(RefBooleanIndexer base, const Options& options);
+
+  ~IncrementalIndexer();
+
+  // add a new document or replace the one with same doc id,
+  // false when a expression of it can't be parsed
+  bool Upsert(Document&& doc);
+
+  void Remove(int32_t doc_id);
+
+  // make changes visible, return the new snapshot
+  RefIndexSnapshot Commit();
+
+  RefIndexSnapshot Snapshot() const;
+
+  // fold the delta into a new base and commit, blocking
+  bool Compact();
+
+  // changed documents not compacted
+  size_t DeltaSize() const;
+
+private:
+  struct DocChange {
+    // seq of the last change, compaction fold those <= its seq
+    uint64_t seq = 0;
+    bool removed = false;
+    std::vector<std::pair<Attr, EntryId>> entries;
+    Entries wildcards;
+  };
+  // immutable once recorded, copied cheaply out of mtx_ for building
+  typedef std::map<int32_t, std::shared_ptr<const DocChange>> DocChanges;
+
+  typedef std::map<std::string, RefExprParser> FieldParsers;
+
+  // under mtx_
+  const RefExprParser& GetParser(const std::string& field);
+
+  // new indexer of base(changed documents filtered) + changes,
+  // base nullptr for the delta
+  static RefBooleanIndexer BuildIndexer(const BooleanIndexer* base,
+                                        const DocChanges& changes,
+                                        const FieldParsers& parsers);
+
+
+  void CompactMain();
+
+  Options options_;
+
+  RefExprParser default_parser_;
+
+  mutable std::mutex mtx_;
+
+  // serialize Commit, snapshots published in order; before mtx_
+  std::mutex commit_mtx_;
+
+  RefBooleanIndexer base_;
+
+  // parsers of all fields, shared by base and delta
+  FieldParsers parsers_;
+
+  DocChanges changes_;
+
+  uint64_t seq_ = 0;
+
+  // under commit_mtx_
+  uint64_t version_ = 0;
+
+  RefIndexSnapshot snapshot_;
+
+  // only one compaction at a time
+  std::mutex compact_mtx_;
+
+  // with mtx_, wake the compactor
+  std::condition_variable compact_cv_;
+
+  bool compact_pending_ = false;
+
+  bool closing_ = false;
+
+  std::thread compactor_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncrementalIndexer);
+};
+
+}  // namespace component
+#endif
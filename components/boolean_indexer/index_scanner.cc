@@ -1,12 +1,14 @@
 #include "index_scanner.h"
 #include <unistd.h>
+#include <algorithm>
 #include <vector>
 
+#include "components/inverted_indexer/posting_field/roaring_bitmap.h"
 #include "glog/logging.h"
 
 namespace component {
 
-static const IndexScanner::Option default_option = {.dump_detail = false};
+static const IndexScanner::Option default_option;
 
 std::string IndexScanner::Result::to_string() const {
   std::ostringstream oss;
@@ -20,110 +22,205 @@ std::string IndexScanner::Result::to_string() const {
 
 IndexScanner::IndexScanner(BooleanIndexer* index) : index_(index) {}
 
+FieldCursor* IndexScanner::Context::NewFieldCursor() {
+  if (used_ == pool_.size()) {
+    pool_.emplace_back(new FieldCursor());
+  }
+  FieldCursor* cursor = pool_[used_++].get();
+  cursor->Reset();
+  return cursor;
+}
+
+void IndexScanner::Context::Reset() {
+  used_ = 0;
+  cursors_.clear();
+}
+
 const IndexScanner::Option& IndexScanner::DefaultOption() {
   return default_option;
 }
 
-FieldCursors IndexScanner::init_cursors(const QueryAssigns& queries,
-                                        const Option* opt) const {
-  FieldCursors field_cursors;
-  for (auto& field_assign : queries) {
-    const std::string& field = field_assign.name();
-    FieldMeta* meta = index_->GetMeta(field);
-    ExprParser* parser = meta->parser.get();
-    if (meta == nullptr || parser == nullptr) {
-      continue;
+const EntriesList* IndexScanner::retrieve_entries(const AttrValues& assign,
+                                                  bool share_assigns,
+                                                  EntriesList* entries,
+                                                  Context* ctx) const {
+  const std::string& field = assign.name();
+  std::string key;
+  if (share_assigns) {
+    key = field;
+    for (const auto& value : assign.Values()) {
+      key.append(1, '\x01').append(value);
     }
-    EntriesContainer* container = index_->GetContainer(field);
-    if (meta == nullptr) {
-      continue;
+    auto iter = ctx->assign_entries_.find(key);
+    if (iter != ctx->assign_entries_.end()) {
+      return &iter->second;
     }
-    TokenPtr token = parser->ParseQueryAssign(field_assign.Values());
-    if (!token || token->BadToken()) {
-      LOG(ERROR) << "query assign parse fail:" << token->FailReason();
+  }
+
+  FieldMeta* meta = index_->GetMeta(field);
+  if (meta == nullptr || meta->parser == nullptr) {
+    return nullptr;
+  }
+  EntriesContainer* container = index_->GetContainer(field);
+  TokenPtr token = meta->parser->ParseQueryAssign(assign.Values());
+  if (!token || token->BadToken()) {
+    LOG(ERROR) << "query assign parse fail:"
+               << (token ? token->FailReason() : field);
+    return nullptr;
+  }
+  *entries = container->RetrieveEntries(meta, token.get());
+  if (!share_assigns) {
+    return entries;
+  }
+  return &(ctx->assign_entries_[key] = std::move(*entries));
+}
+
+void IndexScanner::init_cursors(const QueryAssigns& queries,
+                                bool share_assigns,
+                                Context* ctx) const {
+  ctx->Reset();
+  EntriesList entries;
+  for (auto& field_assign : queries) {
+    const EntriesList* entries_list =
+        retrieve_entries(field_assign, share_assigns, &entries, ctx);
+    if (entries_list == nullptr || entries_list->empty()) {
       continue;
     }
-    auto entries_list = container->RetrieveEntries(meta, token.get());
-    FieldCursorPtr field_cursor(new FieldCursor());
-    for (auto& entries : entries_list) {
-      Attr attr = std::make_pair(field, 0);
+    FieldCursor* field_cursor = ctx->NewFieldCursor();
+    Attr attr = std::make_pair(field_assign.name(), 0);
+    for (const CompressedEntries* entries : *entries_list) {
       field_cursor->AddEntries(attr, entries);
     }
-    if (field_cursor->Size() > 0) {
-      field_cursor->Initialize();
-      field_cursors.push_back(std::move(field_cursor));
-    }
+    field_cursor->Initialize();
+    ctx->cursors_.push_back(field_cursor);
   }
-  auto wc_cursor = index_->GenWildcardCursor();
-  if (wc_cursor) {
+  FieldCursor* wc_cursor = ctx->NewFieldCursor();
+  if (index_->InitWildcardCursor(wc_cursor)) {
     wc_cursor->Initialize();
-    field_cursors.push_back(std::move(wc_cursor));
+    ctx->cursors_.push_back(wc_cursor);
+  } else {
+    ctx->used_--;
   }
-  return field_cursors;
 }
 
 IndexScanner::Result IndexScanner::Retrieve(const QueryAssigns& queries,
                                             const Option* opt) const {
+  Context ctx;
+  return Retrieve(queries, opt, &ctx);
+}
+
+IndexScanner::Result IndexScanner::Retrieve(const QueryAssigns& queries,
+                                            const Option* opt,
+                                            Context* ctx) const {
   if (nullptr == opt) {
     opt = &default_option;
   }
   IndexScanner::Result result;
+  init_cursors(queries, false, ctx);
+  scan(opt, ctx, &result);
+  return result;
+}
 
-  FieldCursors field_cursors = init_cursors(queries, opt);
-
-LOOP:
-  do {
-    std::sort(field_cursors.begin(),
-              field_cursors.end(),
-              [](FieldCursorPtr& l, FieldCursorPtr& r) -> bool {
-                return l->GetCurEntryID() < r->GetCurEntryID();
-              });
-    // remove those entries that have already reached end;
-		// the end-up cursor will in the end of slice after sorting
-    int idx = field_cursors.size() - 1;
-    while (!field_cursors.empty() && field_cursors.back()->ReachEnd()) {
-      field_cursors.pop_back();
-    }
+std::vector<IndexScanner::Result> IndexScanner::BatchRetrieve(
+    const std::vector<QueryAssigns>& queries,
+    const Option* opt,
+    Context* ctx) const {
+  if (nullptr == opt) {
+    opt = &default_option;
+  }
+  Context local_ctx;
+  if (nullptr == ctx) {
+    ctx = &local_ctx;
+  }
+  std::vector<Result> results(queries.size());
+  for (size_t i = 0; i < queries.size(); i++) {
+    init_cursors(queries[i], true, ctx);
+    scan(opt, ctx, &results[i]);
+  }
+  // entries pointers only valid for this indexer
+  ctx->assign_entries_.clear();
+  return results;
+}
 
-    if (field_cursors.empty()) {
-      return result;
+/* cursors kept ordered by current entry, entry ids order by conjunction
+ * size first, so when the size of smallest conjunction large than cursors
+ * count, nothing can be matched more.
+ * only the cursors advanced in a round re-ordered(insert into the ordered
+ * rest), the full sort only happened once */
+void IndexScanner::scan(const Option* opt,
+                        Context* ctx,
+                        Result* result) const {
+  std::vector<FieldCursor*>& cursors = ctx->cursors_;
+  auto entry_less = [](const FieldCursor* l, const FieldCursor* r) -> bool {
+    return l->GetCurEntryID() < r->GetCurEntryID();
+  };
+  std::sort(cursors.begin(), cursors.end(), entry_less);
+
+  while (true) {
+    // those reached end are in the tail after ordered
+    while (!cursors.empty() && cursors.back()->ReachEnd()) {
+      cursors.pop_back();
     }
-
-    EntryId eid = field_cursors[0]->GetCurEntryID();
-    uint64_t conj_id = EntryUtil::GetConjunctionId(eid);
-
-    size_t k = ConjUtil::GetConjunctionSize(conj_id);
-    if (0 == k) {
-      k = 1;
+    if (cursors.empty()) {
+      break;
     }
 
-    if (k > field_cursors.size()) {
+    EntryId eid = cursors[0]->GetCurEntryID();
+    uint64_t conj_id = EntryUtil::GetConjunctionId(eid);
+    size_t k = std::max<size_t>(ConjUtil::GetConjunctionSize(conj_id), 1);
+    if (k > cursors.size()) {
       break;
     }
 
-    EntryId end_eid = field_cursors[k-1]->GetCurEntryID();
-    uint64_t end_conj_id = EntryUtil::GetConjunctionId(eid);
-    EntryId next_eid = EntryUtil::GenEntryID(EntryUtil::GetConjunctionId(end_eid), true);
+    EntryId end_eid = cursors[k - 1]->GetCurEntryID();
+    uint64_t end_conj_id = EntryUtil::GetConjunctionId(end_eid);
+
+    EntryId next_eid;
+    size_t advanced = k;
     if (end_conj_id == conj_id) {
-      next_eid = end_eid + 1;
+      // first entry of next conjunction
+      next_eid = EntryUtil::GenEntryID(conj_id + 1, true);
       if (EntryUtil::IsInclude(eid)) {
-        result.result.push_back(EntryUtil::GetDocID(eid));
+        int64_t doc = EntryUtil::GetDocID(eid);
+        if (opt->tombstones == nullptr || !opt->tombstones->Contains(doc)) {
+          result->result.push_back(doc);
+        }
+        if (opt->limit > 0 && result->result.size() >= opt->limit) {
+          break;
+        }
       } else {
-        for (size_t j = k; j < field_cursors.size(); j++) {
-          if (conj_id != field_cursors[j]->GetCurConjID()) {
-            break;
-          }
-          field_cursors[j]->Skip(next_eid);
+        // excluded(exclude entry order before include), skip all on it
+        while (advanced < cursors.size() &&
+               cursors[advanced]->GetCurConjID() == conj_id) {
+          advanced++;
         }
       }
+    } else {
+      // less than k cursors on conj_id, skip to conjunction of k-1 th
+      next_eid = EntryUtil::GenEntryID(end_conj_id, true);
+      advanced = k - 1;
     }
 
-    for (size_t i = 0; i < k; i++) {
-      field_cursors[i]->SkipTo(next_eid);
+    for (size_t i = 0; i < advanced; i++) {
+      cursors[i]->SkipTo(next_eid);
     }
-  } while(1);
-
-  return result;
+    // insert advanced ones back into the ordered rest
+    for (size_t i = advanced; i-- > 0;) {
+      FieldCursor* cursor = cursors[i];
+      size_t j = i;
+      for (; j + 1 < cursors.size() && entry_less(cursors[j + 1], cursor); j++) {
+        cursors[j] = cursors[j + 1];
+      }
+      cursors[j] = cursor;
+    }
+  }
+  if (opt->dump_detail) {
+    std::ostringstream oss;
+    for (const FieldCursor* cursor : cursors) {
+      cursor->DumpEntries(oss);
+    }
+    LOG(INFO) << "scan end, cursors:\n" << oss.str() << result->to_string();
+  }
 }
 
 }  // namespace component
@@ -1,17 +1,24 @@
 #ifndef _LT_COMPONENT_BE_INDEXER_H_
 #define _LT_COMPONENT_BE_INDEXER_H_
 
+#include <unordered_map>
 #include <vector>
 #include "be_indexer.h"
 
 namespace component {
 
+class RoaringBitmap;
+
 using FieldCursors = std::vector<FieldCursorPtr>;
 
 class IndexScanner {
 public:
   struct Option {
-    bool dump_detail;
+    bool dump_detail = false;
+    // stop when so many documents found, 0: no limit
+    size_t limit = 0;
+    // documents removed or replaced, never in result(see IncrementalIndexer)
+    const RoaringBitmap* tombstones = nullptr;
   };
   struct Result {
     std::string to_string() const;
@@ -19,15 +26,54 @@ public:
     std::vector<int64_t> result;
   };
 
+  /* cursors storage reused across queries, keep one per thread
+   * and pass it to Retrieve avoid allocations in hot path */
+  class Context {
+  public:
+    Context() {}
+
+  private:
+    friend IndexScanner;
+
+    FieldCursor* NewFieldCursor();
+
+    void Reset();
+
+    size_t used_ = 0;
+    FieldCursors pool_;
+    // cursors of current query, ordered by current entry
+    std::vector<FieldCursor*> cursors_;
+    // BatchRetrieve: entries of a field assign shared by queries
+    std::unordered_map<std::string, EntriesList> assign_entries_;
+  };
+
   IndexScanner(BooleanIndexer* index);
 
   static const Option& DefaultOption();
 
   Result Retrieve(const QueryAssigns& queries,
                   const Option* opt = nullptr) const;
+
+  Result Retrieve(const QueryAssigns& queries,
+                  const Option* opt,
+                  Context* ctx) const;
+
+  // cursors storage and entries of same field assign shared in batch
+  std::vector<Result> BatchRetrieve(const std::vector<QueryAssigns>& queries,
+                                    const Option* opt = nullptr,
+                                    Context* ctx = nullptr) const;
+
 private:
-  FieldCursors init_cursors(const QueryAssigns& queries,
-                            const Option* opt) const;
+  void init_cursors(const QueryAssigns& queries,
+                    bool share_assigns,
+                    Context* ctx) const;
+
+  const EntriesList* retrieve_entries(const AttrValues& assign,
+                                      bool share_assigns,
+                                      EntriesList* entries,
+                                      Context* ctx) const;
+
+  void scan(const Option* opt, Context* ctx, Result* result) const;
 
 private:
   BooleanIndexer* index_;
@@ -0,0 +1,458 @@
+#include "index_segment.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+#include <unordered_map>
+
+#include "common_container.h"
+#include "glog/logging.h"
+#include "hash/crc.h"
+#include "parser/number_parser.h"
+
+namespace component {
+
+namespace {
+
+const char kSegmentMagic[8] = {'L', 'T', 'B', 'E', 'S', 'E', 'G', 0};
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  uint64_t file_size;
+  // sections, offsets from file begin and 8 bytes aligned
+  uint64_t field_count;
+  uint64_t fields_offset;
+  uint64_t attr_count;
+  uint64_t attrs_offset;
+  uint64_t slot_count;
+  uint64_t slots_offset;
+  uint64_t word_count;
+  uint64_t words_offset;
+  // wildcard entries, words in words section
+  uint64_t wildcard_words;
+  uint64_t wildcard_word_count;
+  uint32_t wildcard_size;
+  uint32_t reserved;
+  // crc64 of [header_size, file_size)
+  uint64_t payload_crc;
+  // crc64 of header with this field zero
+  uint64_t header_crc;
+} SegmentHeader;
+static_assert(sizeof(SegmentHeader) == 128, "segment header must be 128 bytes");
+
+typedef struct {
+  int64_t value;
+  uint32_t field;
+  uint32_t size;
+  // entries words in words section
+  uint64_t words;
+  uint64_t word_count;
+} AttrRecord;
+static_assert(sizeof(AttrRecord) == 32, "attr record must be 32 bytes");
+
+// stable across processes, unlike std::hash
+uint64_t attr_hash(uint32_t field, int64_t value) {
+  uint64_t h = uint64_t(value) ^ (uint64_t(field) * 0x9E3779B97F4A7C15ULL);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+uint64_t header_checksum(const SegmentHeader& header) {
+  SegmentHeader copy = header;
+  copy.header_crc = 0;
+  return crc64(0, (const unsigned char*)&copy, sizeof(copy));
+}
+
+uint64_t align8(uint64_t n) {
+  return (n + 7) & ~uint64_t(7);
+}
+
+class MappedFile {
+public:
+  MappedFile(void* addr, size_t size) : addr_(addr), size_(size) {}
+  ~MappedFile() { munmap(addr_, size_); }
+
+  const uint8_t* Data() const { return (const uint8_t*)addr_; }
+
+  size_t Size() const { return size_; }
+
+private:
+  void* addr_;
+  size_t size_;
+};
+
+// read only container serving posting lists from a mapped segment
+class MappedContainer : public EntriesContainer {
+public:
+  MappedContainer(std::shared_ptr<MappedFile> file,
+                  const SegmentHeader* header)
+    : file_(file) {
+    const uint8_t* base = file_->Data();
+    records_ = (const AttrRecord*)(base + header->attrs_offset);
+    slots_ = (const uint32_t*)(base + header->slots_offset);
+    slot_mask_ = header->slot_count - 1;
+  }
+
+  // false when records point out of the words section
+  bool Init(const SegmentHeader* header,
+            const std::vector<std::string>& fields) {
+    for (uint32_t i = 0; i < fields.size(); i++) {
+      field_ids_[fields[i]] = i;
+    }
+    fields_ = fields;
+
+    const uint64_t* words =
+        (const uint64_t*)(file_->Data() + header->words_offset);
+    entries_.resize(header->attr_count);
+    for (size_t i = 0; i < entries_.size(); i++) {
+      const AttrRecord& record = records_[i];
+      if (record.field >= fields.size() ||
+          record.words > header->word_count ||
+          record.word_count > header->word_count - record.words ||
+          !entries_[i].Borrow(record.size, words + record.words,
+                              record.word_count)) {
+        return false;
+      }
+    }
+    // every record takes exactly one slot, with slot_count > attr_count
+    // a probe always meets an empty slot and ends
+    uint64_t used = 0;
+    for (uint64_t i = 0; i <= slot_mask_; i++) {
+      if (slots_[i] > entries_.size()) {
+        return false;
+      }
+      used += slots_[i] != 0;
+    }
+    return used == entries_.size();
+  }
+
+  bool IndexingToken(const FieldMeta* meta,
+                     const EntryId eid,
+                     const Token* token) override {
+    LOG(ERROR) << "mapped segment is read only, field:" << meta->name;
+    return false;
+  }
+
+  EntriesList RetrieveEntries(const FieldMeta* meta,
+                              const Token* token) const override {
+    EntriesList results;
+    auto iter = field_ids_.find(meta->name);
+    if (iter == field_ids_.end()) {
+      return results;
+    }
+    const uint32_t field = iter->second;
+    for (int64_t value : token->Int64()) {
+      uint64_t pos = attr_hash(field, value) & slot_mask_;
+      for (; slots_[pos] != 0; pos = (pos + 1) & slot_mask_) {
+        const AttrRecord& record = records_[slots_[pos] - 1];
+        if (record.field == field && record.value == value) {
+          results.push_back(&entries_[slots_[pos] - 1]);
+          break;
+        }
+      }
+    }
+    return results;
+  }
+
+  bool CompileEntries() override { return true; }
+
+  void ForEachEntries(
+      const std::function<void(const Attr&, const CompressedEntries&)>& fn)
+      const override {
+    for (size_t i = 0; i < entries_.size(); i++) {
+      fn(Attr(fields_[records_[i].field], records_[i].value), entries_[i]);
+    }
+  }
+
+  void DumpEntries(std::ostringstream& oss) const override {
+    oss << "+++++ start dump mapped container entries ++++++++++\n";
+    for (size_t i = 0; i < entries_.size(); i++) {
+      oss << "<" << fields_[records_[i].field] << "," << records_[i].value
+          << ">:";
+      Entries entries = entries_[i].Decode();
+      for (auto iter = entries.begin(); iter != entries.end(); iter++) {
+        if (iter != entries.begin()) {
+          oss << ",";
+        }
+        oss << EntryUtil::ToString(*iter);
+      }
+      oss << "\n";
+    }
+    oss << "++++++++++++++++ end all entries +++++++++++++++++++\n";
+  }
+
+private:
+  std::shared_ptr<MappedFile> file_;
+
+  const AttrRecord* records_ = nullptr;
+
+  const uint32_t* slots_ = nullptr;
+
+  uint64_t slot_mask_ = 0;
+
+  std::vector<std::string> fields_;
+
+  std::unordered_map<std::string, uint32_t> field_ids_;
+
+  // views of mapped words, one per record
+  std::vector<CompressedEntries> entries_;
+};
+
+bool section_in_file(uint64_t offset,
+                     uint64_t count,
+                     uint64_t elem_size,
+                     uint64_t file_size) {
+  return offset % 8 == 0 && offset <= file_size &&
+         count <= (file_size - offset) / elem_size;
+}
+
+bool write_all(FILE* fp, const void* data, size_t size, uint64_t* crc) {
+  if (size == 0) {
+    return true;
+  }
+  *crc = crc64(*crc, (const unsigned char*)data, size);
+  return fwrite(data, size, 1, fp) == 1;
+}
+
+}  // namespace
+
+// static
+bool IndexSegment::Save(const BooleanIndexer* indexer,
+                        const std::string& path) {
+  const CommonContainer* container =
+      dynamic_cast<const CommonContainer*>(indexer->DefaultContainer());
+  if (indexer->containers_.size() != 1 || container == nullptr ||
+      !container->compiled_) {
+    LOG(ERROR) << "only a built indexer with common container can be saved";
+    return false;
+  }
+
+  std::map<std::string, uint32_t> field_ids;
+  for (const auto& kv : indexer->field_meta_) {
+    field_ids[kv.first] = 0;
+  }
+  for (const auto& kv : container->postings_) {
+    field_ids[kv.first.first] = 0;
+  }
+  std::string fields;
+  uint32_t field_id = 0;
+  for (auto& kv : field_ids) {
+    kv.second = field_id++;
+    uint32_t len = kv.first.size();
+    fields.append((const char*)&len, sizeof(len));
+    fields.append(kv.first);
+  }
+  fields.resize(align8(fields.size()), 0);
+
+  // sorted by <field, value>, same indexer always saved into same bytes
+  typedef std::pair<Attr, CompressedEntries> Posting;
+  std::vector<const Posting*> postings;
+  postings.reserve(container->postings_.Size());
+  for (const auto& kv : container->postings_) {
+    postings.push_back(&kv);
+  }
+  std::sort(postings.begin(), postings.end(),
+            [&field_ids](const Posting* l, const Posting* r) {
+              uint32_t lf = field_ids[l->first.first];
+              uint32_t rf = field_ids[r->first.first];
+              return lf != rf ? lf < rf : l->first.second < r->first.second;
+            });
+
+  const CompressedEntries& wildcards = indexer->wildcard_entries_;
+  uint64_t word_count = wildcards.WordCount();
+  std::vector<AttrRecord> records(postings.size());
+  for (size_t i = 0; i < postings.size(); i++) {
+    const CompressedEntries& entries = postings[i]->second;
+    records[i].value = postings[i]->first.second;
+    records[i].field = field_ids[postings[i]->first.first];
+    records[i].size = entries.Size();
+    records[i].words = word_count;
+    records[i].word_count = entries.WordCount();
+    word_count += entries.WordCount();
+  }
+
+  uint64_t slot_count = 16;
+  while (slot_count < records.size() * 2) {
+    slot_count <<= 1;
+  }
+  std::vector<uint32_t> slots(slot_count, 0);
+  for (size_t i = 0; i < records.size(); i++) {
+    uint64_t pos = attr_hash(records[i].field, records[i].value);
+    for (pos &= slot_count - 1; slots[pos] != 0;
+         pos = (pos + 1) & (slot_count - 1)) {
+    }
+    slots[pos] = i + 1;
+  }
+
+  SegmentHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kSegmentMagic, sizeof(kSegmentMagic));
+  header.version = kVersion;
+  header.header_size = sizeof(header);
+  header.field_count = field_ids.size();
+  header.fields_offset = sizeof(header);
+  header.attr_count = records.size();
+  header.attrs_offset = header.fields_offset + fields.size();
+  header.slot_count = slot_count;
+  header.slots_offset = header.attrs_offset + records.size() * sizeof(AttrRecord);
+  header.word_count = word_count;
+  header.words_offset = header.slots_offset + slot_count * sizeof(uint32_t);
+  header.wildcard_words = 0;
+  header.wildcard_word_count = wildcards.WordCount();
+  header.wildcard_size = wildcards.Size();
+  header.file_size = header.words_offset + word_count * sizeof(uint64_t);
+
+  std::string tmp_path = path + ".tmp";
+  FILE* fp = fopen(tmp_path.c_str(), "wb");
+  if (!fp) {
+    LOG(ERROR) << "open file failed:" << tmp_path << ", err:" << errno;
+    return false;
+  }
+  uint64_t crc = 0;
+  bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+            write_all(fp, fields.data(), fields.size(), &crc) &&
+            write_all(fp, records.data(), records.size() * sizeof(AttrRecord),
+                      &crc) &&
+            write_all(fp, slots.data(), slots.size() * sizeof(uint32_t), &crc) &&
+            write_all(fp, wildcards.Words(),
+                      wildcards.WordCount() * sizeof(uint64_t), &crc);
+  for (size_t i = 0; ok && i < postings.size(); i++) {
+    const CompressedEntries& entries = postings[i]->second;
+    ok = write_all(fp, entries.Words(), entries.WordCount() * sizeof(uint64_t),
+                   &crc);
+  }
+  // header with checksums at last
+  header.payload_crc = crc;
+  header.header_crc = header_checksum(header);
+  ok = ok && fseek(fp, 0, SEEK_SET) == 0 &&
+       fwrite(&header, sizeof(header), 1, fp) == 1;
+  ok = (fclose(fp) == 0) && ok;
+  if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(ERROR) << "write index segment failed:" << path << ", err:" << errno;
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// static
+RefBooleanIndexer IndexSegment::Open(const std::string& path,
+                                     const Options& options) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG(ERROR) << "open index segment failed:" << path << ", err:" << errno;
+    return nullptr;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(SegmentHeader)) {
+    LOG(ERROR) << "bad index segment file:" << path;
+    ::close(fd);
+    return nullptr;
+  }
+
+  size_t size = st.st_size;
+  int flags = MAP_SHARED | (options.populate ? MAP_POPULATE : 0);
+  void* addr = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << "mmap index segment failed:" << path << ", err:" << errno;
+    return nullptr;
+  }
+  std::shared_ptr<MappedFile> file(new MappedFile(addr, size));
+
+  const SegmentHeader* header = (const SegmentHeader*)addr;
+  if (memcmp(header->magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0 ||
+      header->header_crc != header_checksum(*header)) {
+    LOG(ERROR) << "index segment header corrupted:" << path;
+    return nullptr;
+  }
+  if (header->version != kVersion) {
+    LOG(ERROR) << "index segment version:" << header->version
+               << " not supported, expect:" << kVersion << ", " << path;
+    return nullptr;
+  }
+  if (header->header_size != sizeof(SegmentHeader) ||
+      header->file_size != size ||
+      !section_in_file(header->fields_offset, 0, 1, size) ||
+      !section_in_file(header->attrs_offset, header->attr_count,
+                       sizeof(AttrRecord), size) ||
+      !section_in_file(header->slots_offset, header->slot_count,
+                       sizeof(uint32_t), size) ||
+      !section_in_file(header->words_offset, header->word_count,
+                       sizeof(uint64_t), size) ||
+      header->slot_count == 0 ||
+      (header->slot_count & (header->slot_count - 1)) != 0 ||
+      header->slot_count <= header->attr_count ||
+      header->wildcard_words > header->word_count ||
+      header->wildcard_word_count >
+          header->word_count - header->wildcard_words) {
+    LOG(ERROR) << "index segment layout corrupted:" << path;
+    return nullptr;
+  }
+  if (options.verify_checksum &&
+      header->payload_crc != crc64(0, file->Data() + header->header_size,
+                                   size - header->header_size)) {
+    LOG(ERROR) << "index segment checksum mismatch:" << path;
+    return nullptr;
+  }
+
+  std::vector<std::string> fields;
+  const uint8_t* cursor = file->Data() + header->fields_offset;
+  const uint8_t* fields_end = file->Data() + header->attrs_offset;
+  for (uint64_t i = 0; i < header->field_count; i++) {
+    uint32_t len = 0;
+    if (fields_end - cursor < (int64_t)sizeof(len)) {
+      break;
+    }
+    memcpy(&len, cursor, sizeof(len));
+    cursor += sizeof(len);
+    if (fields_end - cursor < (int64_t)len) {
+      break;
+    }
+    fields.emplace_back((const char*)cursor, len);
+    cursor += len;
+  }
+
+  RefBooleanIndexer indexer(new BooleanIndexer());
+  std::unique_ptr<MappedContainer> container(new MappedContainer(file, header));
+  const uint64_t* words =
+      (const uint64_t*)(file->Data() + header->words_offset);
+  if (fields.size() != header->field_count ||
+      !container->Init(header, fields) ||
+      (header->wildcard_word_count > 0 &&
+       !indexer->wildcard_entries_.Borrow(header->wildcard_size,
+                                          words + header->wildcard_words,
+                                          header->wildcard_word_count))) {
+    LOG(ERROR) << "index segment entries corrupted:" << path;
+    return nullptr;
+  }
+
+  RefExprParser default_parser = options.default_parser;
+  if (!default_parser) {
+    default_parser = std::make_shared<HasherParser>();
+  }
+  for (const std::string& field : fields) {
+    FieldMetaPtr meta(new FieldMeta());
+    meta->name = field;
+    auto iter = options.parsers.find(field);
+    meta->parser =
+        iter != options.parsers.end() ? iter->second : default_parser;
+    indexer->SetMeta(field, std::move(meta));
+  }
+  indexer->SetDefaultContainer(std::move(container));
+  return indexer;
+}
+
+}  // namespace component
@@ -0,0 +1,52 @@
+#ifndef _LT_COMPONENT_BE_INDEX_SEGMENT_H_
+#define _LT_COMPONENT_BE_INDEX_SEGMENT_H_
+
+#include <map>
+#include <string>
+
+#include "be_indexer.h"
+
+namespace component {
+
+/* immutable on-disk segment of a built BooleanIndexer
+ *
+ * posting lists are kept in the CompressedEntries encoding, together with
+ * field names and a open addressing table of <field, value> -> list, all
+ * laid out for direct use from a read only shared mapping; Open only
+ * validates the file and points cursors at the mapped words, no entry is
+ * decoded or copied. processes mapping the same segment share page cache.
+ *
+ * file: |--header(128)--|--fields--|--attrs--|--slots--|--words--|
+ *  header carry magic, version, section offsets and crc64 of itself
+ *  and of the payload; integers in host byte order(little endian)
+ * */
+class IndexSegment {
+public:
+  static const uint32_t kVersion = 1;
+
+  struct Options {
+    // crc64 over the whole payload, touch every page of the file
+    bool verify_checksum = true;
+    // MAP_POPULATE, fault in all pages when open
+    bool populate = false;
+    // query parser of fields, fields not listed use default_parser
+    std::map<std::string, RefExprParser> parsers;
+    // nullptr: HasherParser, same as the builders' default
+    RefExprParser default_parser;
+  };
+
+  // save a indexer built by BeIndexerBuilder/ParallelIndexerBuilder, write
+  // into a temp file then rename, a reader never see a partial segment
+  static bool Save(const BooleanIndexer* indexer, const std::string& path);
+
+  // nullptr when the file missing, corrupted or of other version
+  static RefBooleanIndexer Open(const std::string& path,
+                                const Options& options);
+
+  static RefBooleanIndexer Open(const std::string& path) {
+    return Open(path, Options());
+  }
+};
+
+}  // namespace component
+#endif
@@ -0,0 +1,110 @@
+#include "geo_parser.h"
+
+#include <stdlib.h>
+
+#include "base/utils/string/str_utils.h"
+#include "components/geo_utils/geohash.h"
+#include "fmt/format.h"
+
+namespace component {
+
+namespace {
+
+bool ParseDoubles(const std::string& value, std::vector<double>* out) {
+  for (const auto& item : base::StrUtil::Split(value, ',')) {
+    char* end = nullptr;
+    double v = ::strtod(item.c_str(), &end);
+    if (item.empty() || end != item.c_str() + item.size()) {
+      return false;
+    }
+    out->push_back(v);
+  }
+  return true;
+}
+
+bool ValidLocation(double lat, double lng) {
+  return lat >= -90 && lat <= 90 && lng >= -180 && lng <= 180;
+}
+
+}  // namespace
+
+// static
+bool GeoCellParser::CellId(const std::string& geohash, int64_t* id) {
+  if (geohash.empty() || (int)geohash.size() > geo::GeoHash::kMaxPrecision) {
+    return false;
+  }
+  // 12 chars take all 64 bits, shift unsigned
+  uint64_t bits = 0;
+  for (char c : geohash) {
+    int v = geo::GeoHash::CharValue(c);
+    if (v < 0) {
+      return false;
+    }
+    bits = (bits << 5) | uint64_t(v);
+  }
+  *id = static_cast<int64_t>((bits << 4) | geohash.size());
+  return true;
+}
+
+TokenPtr GeoCellParser::ParseIndexing(const AttrValues::ValueContainer& vs) {
+  TokenI64* results = new TokenI64();
+  for (auto& v : vs) {
+    if (v.empty()) {
+      continue;
+    }
+    std::vector<std::string> cells;
+    if (v.find(',') == std::string::npos) {
+      cells.push_back(v);
+    } else {
+      std::vector<double> circle;
+      if (!ParseDoubles(v, &circle) || circle.size() != 3 ||
+          !ValidLocation(circle[0], circle[1]) || circle[2] <= 0) {
+        results->SetFail(fmt::format("{} not valid circle", v));
+        return TokenPtr(results);
+      }
+      cells = geo::GeoHash::CircleCover(circle[0], circle[1], circle[2],
+                                        max_cover_cells_);
+    }
+    for (const auto& cell : cells) {
+      int64_t id = 0;
+      if (!CellId(cell, &id)) {
+        results->SetFail(fmt::format("{} not valid geohash", cell));
+        return TokenPtr(results);
+      }
+      results->values_.push_back(id);
+    }
+  }
+  return TokenPtr(results);
+}
+
+TokenPtr GeoCellParser::ParseQueryAssign(const AttrValues::ValueContainer& vs) const {
+  TokenI64* results = new TokenI64();
+  for (auto& v : vs) {
+    if (v.empty()) {
+      continue;
+    }
+    std::string hash = v;
+    int64_t id = 0;
+    if (v.find(',') != std::string::npos) {
+      std::vector<double> location;
+      if (!ParseDoubles(v, &location) || location.size() != 2 ||
+          !ValidLocation(location[0], location[1])) {
+        results->SetFail(fmt::format("{} not valid location", v));
+        return TokenPtr(results);
+      }
+      hash = geo::GeoHash::Encode(location[0], location[1],
+                                  geo::GeoHash::kMaxPrecision);
+    } else if (!CellId(hash, &id)) {
+      results->SetFail(fmt::format("{} not valid geohash", v));
+      return TokenPtr(results);
+    }
+    // all cells containing the location
+    for (size_t len = 1; len <= hash.size(); len++) {
+      CellId(hash.substr(0, len), &id);
+      results->values_.push_back(id);
+    }
+  }
+  return TokenPtr(results);
+}
+
+}  // namespace component
@@ -0,0 +1,35 @@
+#ifndef _LT_COMPONENT_BOOLEAN_INDEXER_GEO_PARSER_H_
+#define _LT_COMPONENT_BOOLEAN_INDEXER_GEO_PARSER_H_
+
+#include "parser.h"
+
+namespace component {
+
+/* geo targeting by geohash cells, see components/geo_utils/geohash.h
+ * indexing values: geohash cells("wx4g0") or a circle "lat,lng,radius"
+ * (radius in meters, covered by cells); token Int64() is cell ids
+ * query values: locations "lat,lng"(or a geohash), hit all cells
+ * containing it, so the default common container serves it by exact
+ * lookup, a location retrieve 12(precisions) posting lists at most
+ * */
+class GeoCellParser : public ExprParser {
+public:
+  ~GeoCellParser() {};
+
+  TokenPtr ParseIndexing(const AttrValues::ValueContainer& values) override ;
+
+  TokenPtr ParseQueryAssign(const AttrValues::ValueContainer& values) const override;
+
+  // cells of a circle indexing value, less cells more precise
+  void SetMaxCoverCells(size_t cells) { max_cover_cells_ = cells; }
+
+  // (bits << 4) | precision packed in 64 bits, a 12 chars cell may
+  // be negative as int64; false when not a valid geohash
+  static bool CellId(const std::string& geohash, int64_t* id);
+
+private:
+  size_t max_cover_cells_ = 16;
+};
+
+} // end namespace
+#endif
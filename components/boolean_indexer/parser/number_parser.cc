@@ -1,6 +1,8 @@
 
 #include "number_parser.h"
 
+#include <limits>
+
 #include "base/utils/string/str_utils.h"
 #include "fmt/format.h"
 
@@ -46,4 +48,46 @@ TokenPtr HasherParser::ParseQueryAssign(const AttrValues::ValueContainer& vs) co
   return TokenPtr(results);
 }
 
+TokenPtr RangeParser::ParseIndexing(const AttrValues::ValueContainer& vs) {
+  TokenI64* results = new TokenI64();
+  const int64_t kMin = std::numeric_limits<int64_t>::min();
+  const int64_t kMax = std::numeric_limits<int64_t>::max();
+  for (auto& v : vs) {
+    if (v.empty()) {
+      continue;
+    }
+    int64_t min = kMin, max = kMax, value = 0;
+    bool ok = true;
+    size_t sep = v.find('~');
+    if (sep != std::string::npos) {
+      ok = base::StrUtil::ToInt64(v.substr(0, sep), &min) &&
+           base::StrUtil::ToInt64(v.substr(sep + 1), &max);
+    } else if (v.compare(0, 2, ">=") == 0) {
+      ok = base::StrUtil::ToInt64(v.substr(2), &min);
+    } else if (v.compare(0, 2, "<=") == 0) {
+      ok = base::StrUtil::ToInt64(v.substr(2), &max);
+    } else if (v[0] == '>') {
+      ok = base::StrUtil::ToInt64(v.substr(1), &value) && value < kMax;
+      min = value + 1;
+    } else if (v[0] == '<') {
+      ok = base::StrUtil::ToInt64(v.substr(1), &value) && value > kMin;
+      max = value - 1;
+    } else {
+      ok = base::StrUtil::ToInt64(v, &value);
+      min = max = value;
+    }
+    if (!ok || min > max) {
+      results->SetFail(fmt::format("{} not valid range", v));
+      return TokenPtr(results);
+    }
+    results->values_.push_back(min);
+    results->values_.push_back(max);
+  }
+  return TokenPtr(results);
+}
+
+TokenPtr RangeParser::ParseQueryAssign(const AttrValues::ValueContainer& vs) const {
+  return number_parser_.ParseQueryAssign(vs);
+}
+
 }  // namespace component
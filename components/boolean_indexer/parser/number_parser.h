@@ -27,6 +27,21 @@ private:
   std::hash<std::string> hasher_;
 };
 
+/* numeric ranges of a RangeContainer field
+ * indexing values: "18~65"(between, inclusive), ">18", ">=18", "<65",
+ * "<=65" or a number; token Int64() is [min, max] pairs
+ * query values: numbers, same as NumberParser */
+class RangeParser : public ExprParser {
+public:
+  ~RangeParser() {};
+
+  TokenPtr ParseIndexing(const AttrValues::ValueContainer& values) override ;
+
+  TokenPtr ParseQueryAssign(const AttrValues::ValueContainer& values) const override;
+private:
+  NumberParser number_parser_;
+};
+
 } // end namespace
 
 #endif
@@ -1,8 +1,10 @@
 #ifndef _LT_COMPONENT_BOOLEAN_INDEX_PL_H_
 #define _LT_COMPONENT_BOOLEAN_INDEX_PL_H_
 
+#include <functional>
 #include <unordered_map>
 
+#include "compressed_entries.h"
 #include "document.h"
 #include "id_generator.h"
 #include "parser/parser.h"
@@ -16,6 +18,7 @@ struct pair_hash {
   }
 };
 
+// used when building, compiled into CompressedEntries for retrieving
 typedef std::unordered_map<Attr, Entries, pair_hash> PostingList;
 
 class FieldMeta {
@@ -42,6 +45,11 @@ public:
 
   virtual bool CompileEntries() = 0;
 
+  // all compiled posting lists, used by compaction(see IncrementalIndexer)
+  virtual void ForEachEntries(
+      const std::function<void(const Attr&, const CompressedEntries&)>& fn)
+      const = 0;
+
   virtual void DumpEntries(std::ostringstream& oss) const = 0;
 };
 // why here: perfer client/dever use it like this
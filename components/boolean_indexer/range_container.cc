@@ -0,0 +1,185 @@
+#include "range_container.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+#include "glog/logging.h"
+
+namespace component {
+
+bool RangeContainer::IndexingToken(const FieldMeta* meta,
+                                   const EntryId eid,
+                                   const Token* token) {
+  if (token->BadToken()) {
+    return false;
+  }
+  if (compiled_) {
+    LOG(ERROR) << "container compiled, can't index more, field:" << meta->name;
+    return false;
+  }
+  field_ = meta->name;
+
+  std::vector<int64_t> values = token->Int64();
+  if (values.size() % 2 != 0) {
+    LOG(ERROR) << "range token not in [min, max] pairs, field:" << meta->name;
+    return false;
+  }
+  std::vector<std::pair<int64_t, int64_t>> ranges;
+  for (size_t i = 0; i < values.size(); i += 2) {
+    ranges.emplace_back(values[i], values[i + 1]);
+  }
+  std::sort(ranges.begin(), ranges.end());
+
+  // merge overlapped/adjacent ranges, then a value hit one range at most
+  size_t count = 0;
+  for (const auto& range : ranges) {
+    if (count > 0) {
+      auto& last = ranges[count - 1];
+      if (last.second == std::numeric_limits<int64_t>::max() ||
+          range.first <= last.second + 1) {
+        last.second = std::max(last.second, range.second);
+        continue;
+      }
+    }
+    ranges[count++] = range;
+  }
+  for (size_t i = 0; i < count; i++) {
+    ranges_.push_back({ranges[i].first, ranges[i].second, eid});
+  }
+  return true;
+}
+
+int64_t RangeContainer::ValueUnit(int64_t value) const {
+  auto iter = std::lower_bound(points_.begin(), points_.end(), value);
+  if (iter == points_.end()) {
+    return -1;
+  }
+  int64_t index = iter - points_.begin();
+  if (*iter == value) {
+    return 2 * index;
+  }
+  return index == 0 ? -1 : 2 * index - 1;
+}
+
+EntriesList RangeContainer::RetrieveEntries(const FieldMeta* meta,
+                                            const Token* token) const {
+  EntriesList results;
+  for (int64_t value : token->Int64()) {
+    int64_t unit = ValueUnit(value);
+    if (unit < 0) {
+      continue;
+    }
+    for (size_t node = leaves_ + unit; node > 0; node >>= 1) {
+      if (node_lists_[node] >= 0) {
+        results.push_back(&lists_[node_lists_[node]]);
+      }
+    }
+  }
+  if (token->Int64().size() > 1) {
+    std::sort(results.begin(), results.end());
+    results.erase(std::unique(results.begin(), results.end()), results.end());
+  }
+  return results;
+}
+
+bool RangeContainer::CompileEntries() {
+  if (compiled_) {
+    return true;
+  }
+  for (const auto& range : ranges_) {
+    points_.push_back(range.min);
+    points_.push_back(range.max);
+  }
+  std::sort(points_.begin(), points_.end());
+  points_.erase(std::unique(points_.begin(), points_.end()), points_.end());
+
+  size_t units = points_.empty() ? 0 : 2 * points_.size() - 1;
+  leaves_ = 1;
+  while (leaves_ < units) {
+    leaves_ <<= 1;
+  }
+
+  std::vector<Entries> nodes(2 * leaves_);
+  for (const auto& range : ranges_) {
+    size_t l = 2 * (std::lower_bound(points_.begin(), points_.end(),
+                                     range.min) - points_.begin());
+    size_t r = 2 * (std::lower_bound(points_.begin(), points_.end(),
+                                     range.max) - points_.begin());
+    // canonical nodes of units [l, r]
+    for (l += leaves_, r += leaves_ + 1; l < r; l >>= 1, r >>= 1) {
+      if (l & 1) {
+        nodes[l++].push_back(range.eid);
+      }
+      if (r & 1) {
+        nodes[--r].push_back(range.eid);
+      }
+    }
+  }
+  std::vector<Range>().swap(ranges_);
+
+  node_lists_.assign(nodes.size(), -1);
+  for (size_t node = 0; node < nodes.size(); node++) {
+    Entries& entries = nodes[node];
+    if (entries.empty()) {
+      continue;
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+    node_lists_[node] = lists_.size();
+    lists_.emplace_back(entries);
+    Entries().swap(entries);
+  }
+  compiled_ = true;
+  return true;
+}
+
+void RangeContainer::ForEachEntries(
+    const std::function<void(const Attr&, const CompressedEntries&)>& fn)
+    const {
+  for (size_t node = 0; node < node_lists_.size(); node++) {
+    if (node_lists_[node] >= 0) {
+      fn(Attr(field_, node), lists_[node_lists_[node]]);
+    }
+  }
+}
+
+size_t RangeContainer::MemoryUsage() const {
+  size_t bytes = sizeof(*this) + points_.capacity() * sizeof(int64_t) +
+                 node_lists_.capacity() * sizeof(int32_t);
+  for (const auto& entries : lists_) {
+    bytes += entries.MemoryUsage();
+  }
+  return bytes;
+}
+
+void RangeContainer::DumpEntries(std::ostringstream& oss) const {
+  oss << "+++++ start dump range container entries ++++++++++\n";
+  for (size_t node = 1; node < node_lists_.size(); node++) {
+    if (node_lists_[node] < 0) {
+      continue;
+    }
+    // units covered by node
+    size_t first = node, last = node;
+    while (first < leaves_) {
+      first <<= 1;
+      last = (last << 1) | 1;
+    }
+    first -= leaves_;
+    last = std::min(last - leaves_, 2 * points_.size() - 2);
+    oss << "<" << field_ << "," << (first % 2 ? "(" : "[")
+        << points_[first / 2] << "," << points_[(last + 1) / 2]
+        << (last % 2 ? ")" : "]") << ">:";
+    Entries entries = lists_[node_lists_[node]].Decode();
+    for (auto iter = entries.begin(); iter != entries.end(); iter++) {
+      if (iter != entries.begin()) {
+        oss << ",";
+      }
+      oss << EntryUtil::ToString(*iter);
+    }
+    oss << "\n";
+  }
+  oss << "++++++++++++++++ end all entries +++++++++++++++++++\n";
+}
+
+}  // namespace component
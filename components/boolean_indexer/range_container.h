@@ -0,0 +1,72 @@
+#ifndef _LT_COMPONENT_BE_ENTRIES_RANGE_CONTAINER_H_
+#define _LT_COMPONENT_BE_ENTRIES_RANGE_CONTAINER_H_
+
+#include "posting_list.h"
+
+namespace component {
+
+/* container of a numeric range field(eg: age, price), parsed by RangeParser
+ *
+ * sorted distinct endpoints of all ranges split the values into
+ * units: the endpoints themself and the open gaps between them;
+ * a segment tree built over units, each range stored in the O(logN)
+ * canonical nodes covering it, so a query value retrieve at most
+ * log(units) posting lists(leaf to root), no matter how many distinct
+ * values the field has or how wide the ranges are
+ * */
+class RangeContainer : public EntriesContainer {
+public:
+  RangeContainer(){};
+
+  bool IndexingToken(const FieldMeta* meta,
+                     const EntryId eid,
+                     const Token* token) override;
+
+  EntriesList RetrieveEntries(const FieldMeta* meta,
+                              const Token* token) const override;
+
+  bool CompileEntries() override;
+
+  // attr value is the tree node of posting list
+  void ForEachEntries(
+      const std::function<void(const Attr&, const CompressedEntries&)>& fn)
+      const override;
+
+  void DumpEntries(std::ostringstream& oss) const override;
+
+  // compiled posting lists
+  int64_t Size() const { return lists_.size(); }
+
+  size_t MemoryUsage() const;
+
+private:
+  struct Range {
+    int64_t min;
+    int64_t max;
+    EntryId eid;
+  };
+
+  // unit of value, -1 when out of all ranges
+  int64_t ValueUnit(int64_t value) const;
+
+  bool compiled_ = false;
+
+  std::string field_;
+
+  // building
+  std::vector<Range> ranges_;
+
+  // sorted distinct endpoints
+  std::vector<int64_t> points_;
+
+  // leaves of tree, power of 2
+  size_t leaves_ = 0;
+
+  // index of lists_ for each tree node, -1: no entries
+  std::vector<int32_t> node_lists_;
+
+  std::vector<CompressedEntries> lists_;
+};
+
+}  // namespace component
+#endif
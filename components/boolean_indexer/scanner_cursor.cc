@@ -1,60 +1,79 @@
 #include "scanner_cursor.h"
 
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
 namespace component {
-namespace {
-static const int linear_skip_distance = 64;
+
+EntriesCursor::EntriesCursor(const Attr& a, const CompressedEntries* entries)
+  : attr_(a), entries_(entries) {
+  LoadBlock(0);
 }
 
-EntriesCursor::EntriesCursor(const Attr& a, const Entries& ids)
-  : attr_(a), index_(0), size_(ids.size()), id_list_(ids) {}
+void EntriesCursor::LoadBlock(size_t block) {
+  block_ = block;
+  index_ = 0;
+  if (block >= entries_->BlockCount()) {
+    count_ = 0;
+    current_ = NULLENTRY;
+    return;
+  }
+  count_ = entries_->DecodeBlock(block, buffer_);
+  current_ = buffer_[0];
+}
 
-EntryId EntriesCursor::Skip(const EntryId id) {
-  int right_idx = size_;
-  int mid;
-  while (index_ < right_idx) {
-    if (right_idx - index_ < linear_skip_distance) {
-      return LinearSkip(id);
+uint32_t EntriesCursor::SearchBlock(const EntryId id) const {
+  uint32_t index = index_;
+#ifdef __AVX2__
+  // unsigned compare by flip sign bit, count entries < id in each 4 lanes
+  const __m256i sign = _mm256_set1_epi64x(0x8000000000000000LL);
+  const __m256i target = _mm256_xor_si256(_mm256_set1_epi64x(id), sign);
+  for (; index + 4 <= count_; index += 4) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(buffer_ + index));
+    __m256i lt = _mm256_cmpgt_epi64(target, _mm256_xor_si256(v, sign));
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(lt));
+    if (mask != 0xF) {
+      return index + __builtin_popcount(mask);
     }
-    mid = (index_ + right_idx) >> 1;
+  }
+#endif
+  return std::lower_bound(buffer_ + index, buffer_ + count_, id) - buffer_;
+}
 
-    if (id_list_[mid] <= id) {
-      index_ = mid + 1;
-    } else {
-      right_idx = mid;
-    }
-    if (index_ >= size_ || id_list_[index_] > id) {
-      break;
+EntryId EntriesCursor::SkipForward(const EntryId id) {
+  if (id <= buffer_[count_ - 1]) {
+    index_ = SearchBlock(id);
+    return current_ = buffer_[index_];
+  }
+  // the last block start before id may still contain it
+  size_t next = entries_->LowerBoundBlock(block_ + 1, id);
+  if (next - 1 > block_) {
+    LoadBlock(next - 1);
+    if (id <= buffer_[count_ - 1]) {
+      index_ = SearchBlock(id);
+      return current_ = buffer_[index_];
     }
   }
-  return GetCurEntryID();
+  LoadBlock(next);
+  return current_;
 }
 
-EntryId EntriesCursor::SkipTo(const EntryId id) {
-  int right_idx = size_;
-
-  int mid;
-  while (index_ < right_idx) {
-    if (right_idx - index_ < linear_skip_distance) {
-      return LinearSkipTo(id);
-    }
-    mid = (index_ + right_idx) >> 1;
-    if ((id_list_)[mid] >= id) {
-      right_idx = mid;
-    } else {
-      index_ = mid + 1;
-    }
-    if (index_ >= size_ || (id_list_)[index_] >= id) {
-      break;
-    }
+EntryId EntriesCursor::Skip(const EntryId id) {
+  if (id == NULLENTRY) {
+    LoadBlock(entries_->BlockCount());
+    return current_;
   }
-  return GetCurEntryID();
+  return SkipTo(id + 1);
 }
 
-void FieldCursor::AddEntries(const Attr& attr, const Entries* entrylist) {
-  if (nullptr == entrylist) {
+void FieldCursor::AddEntries(const Attr& attr,
+                             const CompressedEntries* entries) {
+  if (nullptr == entries) {
     return;
   }
-  cursors_.emplace_back(attr, *entrylist);
+  cursors_.emplace_back(attr, entries);
 }
 
 void FieldCursor::Initialize() {
@@ -69,6 +88,12 @@ void FieldCursor::Initialize() {
   }
 }
 
+void FieldCursor::Reset() {
+  cursors_.clear();
+  current_ = nullptr;
+  current_id_ = 0;
+}
+
 uint64_t FieldCursor::GetCurConjID() const {
   return EntryUtil::GetConjunctionId(current_id_);
 }
@@ -100,7 +125,7 @@ EntryId FieldCursor::SkipTo(const EntryId id) {
 void EntriesCursor::DumpEntries(std::ostringstream& oss) const {
   oss << "atrr:" << EntryUtil::ToString(attr_)
       << ", cur:" << EntryUtil::ToString(GetCurEntryID()) << ", eids:[";
-  for (const EntryId id : id_list_) {
+  for (const EntryId id : entries_->Decode()) {
     oss << EntryUtil::ToString(id) << ",";
   }
   oss << "]\n";
@@ -1,6 +1,7 @@
 #ifndef _LT_COMPONENT_BE_INDEXER_CURSOR_H_
 #define _LT_COMPONENT_BE_INDEXER_CURSOR_H_
 
+#include "compressed_entries.h"
 #include "id_generator.h"
 
 #include <iostream>
@@ -9,47 +10,58 @@
 
 namespace component {
 
-/* a iterator access entries */
+/* a iterator access compressed entries, the current block is decoded
+ * into a local buffer; SkipTo in current block search the buffer(AVX2
+ * when available), otherwise jump by block headers and decode the target
+ * block only */
 class EntriesCursor {
 public:
-  EntriesCursor(const Attr&, const Entries&);
+  EntriesCursor(const Attr&, const CompressedEntries*);
 
-  bool ReachEnd() const { return size_ <= index_; }
+  bool ReachEnd() const { return current_ == NULLENTRY; }
 
-  EntryId GetCurEntryID() const {
-    return size_ > index_ ? id_list_[index_] : NULLENTRY;
-  }
+  EntryId GetCurEntryID() const { return current_; }
 
-  EntryId LinearSkipTo(EntryId id) {
-    while (index_ < size_ && id_list_[index_] < id) {
-      index_++;
-    }
-    return GetCurEntryID();
-  }
+  // move to first entry > id
+  EntryId Skip(const EntryId id);
 
-  EntryId LinearSkip(EntryId id) {
-    while (index_ < size_ && id_list_[index_] <= id) {
-      index_++;
+  // move to first entry >= id
+  EntryId SkipTo(const EntryId id) {
+    if (current_ >= id) {
+      return current_;
     }
-    return GetCurEntryID();
+    // most skips in scanning just move to the next one
+    if (index_ + 1 < count_ && buffer_[index_ + 1] >= id) {
+      return current_ = buffer_[++index_];
+    }
+    return SkipForward(id);
   }
 
-  EntryId Skip(const EntryId id);
-
-  EntryId SkipTo(const EntryId id);
-
-  size_t Size() const { return size_; }
+  size_t Size() const { return entries_->Size(); }
 
   void DumpEntries(std::ostringstream& oss) const;
 
 private:
+  EntryId SkipForward(const EntryId id);
+
+  void LoadBlock(size_t block);
+
+  // index of first entry >= id in buffer, id <= last one of buffer
+  uint32_t SearchBlock(EntryId id) const;
+
   Attr attr_;  // eg: <age, 15>
 
-  int index_ = 0;  // current cur index
+  const CompressedEntries* entries_;
 
-  const size_t size_;
+  EntryId current_ = NULLENTRY;
 
-  const Entries& id_list_;  // [conj1, conj2, conj3]
+  size_t block_ = 0;  // current decoded block
+
+  uint32_t index_ = 0;  // index of current entry in buffer
+
+  uint32_t count_ = 0;  // entries in buffer
+
+  EntryId buffer_[CompressedEntries::kBlockSize];
 };
 
 class FieldCursor {
@@ -58,7 +70,10 @@ public:
 
   void Initialize();
 
-  void AddEntries(const Attr& attr, const Entries* entrylist);
+  // clear cursors and keep storage for reuse
+  void Reset();
+
+  void AddEntries(const Attr& attr, const CompressedEntries* entries);
 
   EntryId GetCurEntryID() const { return current_id_; }
 
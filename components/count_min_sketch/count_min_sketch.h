@@ -2,6 +2,7 @@
 #define COMPONENT_COUNT_MIN_SKETCH_H_
 
 #include <inttypes.h>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
@@ -29,7 +30,7 @@ public:
   const uint64_t Depth() const { return depth_; };
   const uint64_t Certainty() const { return certainty_; };
   const uint64_t ErrorRate() const { return error_rate_; };
-  const uint64_t DistinctCount() const { return distinct_count_; };
+  const uint64_t DistinctCount() const { return distinct_count_.load(); };
 
 private:
   double certainty_;
@@ -38,7 +39,7 @@ private:
   uint64_t width_;
   uint64_t depth_;
 
-  uint64_t distinct_count_;
+  std::atomic<uint64_t> distinct_count_;
   std::vector<CountType*> matrix_;
 };
 
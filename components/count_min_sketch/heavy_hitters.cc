@@ -0,0 +1,69 @@
+#include "heavy_hitters.h"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace component {
+
+HeavyHitters::HeavyHitters(ShardedCountMinSketch* sketch, size_t k)
+  : sketch_(sketch), k_(k), threshold_(0) {
+  CHECK(sketch_ && k_ > 0);
+}
+
+uint64_t HeavyHitters::Increase(const std::string& key, uint32_t count) {
+  uint64_t estimate = sketch_->Increase(key, count);
+  if (estimate <= threshold_.load(std::memory_order_relaxed)) {
+    return estimate;
+  }
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  uint64_t& value = items_[key];
+  value = std::max(value, estimate);
+  Shrink();
+  return estimate;
+}
+
+void HeavyHitters::Refresh() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto iter = items_.begin(); iter != items_.end();) {
+    iter->second = sketch_->Estimate(iter->first);
+    if (iter->second == 0) {
+      iter = items_.erase(iter);
+    } else {
+      iter++;
+    }
+  }
+  Shrink();
+}
+
+void HeavyHitters::Shrink() {
+  if (items_.size() > k_) {
+    auto smallest = std::min_element(
+        items_.begin(), items_.end(),
+        [](const auto& l, const auto& r) { return l.second < r.second; });
+    items_.erase(smallest);
+  }
+
+  uint64_t threshold = 0;
+  if (items_.size() >= k_) {
+    threshold = UINT64_MAX;
+    for (const auto& item : items_) {
+      threshold = std::min(threshold, item.second);
+    }
+  }
+  threshold_.store(threshold, std::memory_order_relaxed);
+}
+
+std::vector<HeavyHitters::Item> HeavyHitters::TopK() const {
+  std::vector<Item> result;
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    result.assign(items_.begin(), items_.end());
+  }
+  std::sort(result.begin(), result.end(),
+            [](const Item& l, const Item& r) { return l.second > r.second; });
+  return result;
+}
+
+}  // namespace component
@@ -0,0 +1,53 @@
+#ifndef COMPONENT_HEAVY_HITTERS_H_
+#define COMPONENT_HEAVY_HITTERS_H_
+
+#include <inttypes.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "sharded_count_min_sketch.h"
+
+namespace component {
+
+/**
+ * top-k keys tracker on a ShardedCountMinSketch
+ *
+ * Increase count the key in sketch, only when the estimate beat the smallest
+ * tracked one the lock is taken, so it's almost free for long tail keys.
+ * call Refresh after sketch Tick, decayed keys will be re-estimated and those
+ * fell to zero are dropped.
+ * */
+class HeavyHitters {
+public:
+  typedef std::pair<std::string, uint64_t> Item;
+
+  HeavyHitters(ShardedCountMinSketch* sketch, size_t k);
+
+  // return the estimate of key after increase
+  uint64_t Increase(const std::string& key, uint32_t count = 1);
+
+  void Refresh();
+
+  // sorted by count desc
+  std::vector<Item> TopK() const;
+
+private:
+  // recalculate threshold_ and drop the smallest one when overflow
+  void Shrink();
+
+  ShardedCountMinSketch* sketch_;
+  const size_t k_;
+
+  // the smallest count in top-k, 0 when not full yet
+  std::atomic<uint64_t> threshold_;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, uint64_t> items_;
+};
+
+}  // end namespace component
+#endif
@@ -0,0 +1,327 @@
+#include "sharded_count_min_sketch.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+
+#include "base/sys/thread_slot.h"
+#include "glog/logging.h"
+#include "hash/murmurhash3.h"
+
+namespace component {
+
+namespace {
+
+const char kMagic[8] = {'L', 'T', 'C', 'M', 'S', 0, 0, 0};
+const uint32_t kVersion = 1;
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t decay;
+  uint64_t width;
+  uint64_t depth;
+  uint32_t seed;
+  uint32_t buckets;
+} SketchHeader;
+
+}  // namespace
+
+ShardedCountMinSketch::ShardedCountMinSketch(const Options& options)
+  : options_(options) {
+  width_ = options.width;
+  if (width_ == 0) {
+    width_ = static_cast<uint64_t>(std::ceil(2.0 / options.error));
+  }
+  depth_ = options.depth;
+  if (depth_ == 0) {
+    depth_ = static_cast<uint64_t>(
+        std::ceil(std::log(1.0 - options.certainty) / std::log(1.0 / 2.0)));
+  }
+  depth_ = std::min<uint64_t>(std::max<uint64_t>(depth_, 1), kMaxDepth);
+  CHECK(width_ > 0);
+
+  shard_count_ = options.shards;
+  if (shard_count_ == 0) {
+    shard_count_ = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (uint32_t i = 0; i < shard_count_; i++) {
+    shards_.push_back(NewTable());
+  }
+
+  total_ = NewTable();
+  if (options_.decay == kSlidingWindow) {
+    CHECK(options_.window_buckets > 0);
+    for (uint32_t i = 0; i < options_.window_buckets; i++) {
+      buckets_.push_back(NewTable());
+    }
+  }
+}
+
+ShardedCountMinSketch::~ShardedCountMinSketch() {}
+
+ShardedCountMinSketch::Table ShardedCountMinSketch::NewTable() const {
+  uint64_t size = width_ * depth_;
+  Table table(new Counter[size]);
+  for (uint64_t i = 0; i < size; i++) {
+    table[i].store(0, std::memory_order_relaxed);
+  }
+  return table;
+}
+
+void ShardedCountMinSketch::Indexes(const void* data,
+                                    size_t len,
+                                    uint64_t* indexes) const {
+  // one hash, rows by double hashing: h0 + i * h1
+  uint64_t hash[2];
+  MurmurHash3_x64_128(data, len, options_.seed, hash);
+  for (uint64_t i = 0; i < depth_; i++) {
+    indexes[i] = i * width_ + (hash[0] + i * hash[1]) % width_;
+  }
+}
+
+ShardedCountMinSketch::Counter* ShardedCountMinSketch::MyShard() const {
+  return shards_[base::ThreadSlot() % shard_count_].get();
+}
+
+uint64_t ShardedCountMinSketch::MergedAt(uint64_t index) const {
+  return total_[index].load(std::memory_order_relaxed);
+}
+
+uint64_t ShardedCountMinSketch::Increase(const std::string& key,
+                                         uint32_t count) {
+  return Increase(key.data(), key.size(), count);
+}
+
+uint64_t ShardedCountMinSketch::Increase(const void* data,
+                                         size_t len,
+                                         uint32_t count) {
+  uint64_t indexes[kMaxDepth];
+  Indexes(data, len, indexes);
+
+  Counter* shard = MyShard();
+  uint64_t result = UINT64_MAX;
+  if (!options_.conservative) {
+    for (uint64_t i = 0; i < depth_; i++) {
+      uint64_t merged = MergedAt(indexes[i]);
+      uint64_t local =
+          shard[indexes[i]].fetch_add(count, std::memory_order_relaxed);
+      result = std::min(result, merged + local + count);
+    }
+    return result;
+  }
+
+  // read merged before shard, Merge move counts from shard to merged table,
+  // so a row is under read at worst, that make it raise more, never less
+  uint64_t rows[kMaxDepth];
+  for (uint64_t i = 0; i < depth_; i++) {
+    rows[i] = MergedAt(indexes[i]) +
+              shard[indexes[i]].load(std::memory_order_relaxed);
+    result = std::min(result, rows[i]);
+  }
+  uint64_t target = result + count;
+  for (uint64_t i = 0; i < depth_; i++) {
+    if (rows[i] < target) {
+      shard[indexes[i]].fetch_add(target - rows[i], std::memory_order_relaxed);
+    }
+  }
+  return target;
+}
+
+uint64_t ShardedCountMinSketch::Estimate(const std::string& key) const {
+  return Estimate(key.data(), key.size());
+}
+
+uint64_t ShardedCountMinSketch::Estimate(const void* data, size_t len) const {
+  uint64_t indexes[kMaxDepth];
+  Indexes(data, len, indexes);
+
+  Counter* shard = MyShard();
+  uint64_t result = UINT64_MAX;
+  for (uint64_t i = 0; i < depth_; i++) {
+    uint64_t merged = MergedAt(indexes[i]);
+    result = std::min(
+        result, merged + shard[indexes[i]].load(std::memory_order_relaxed));
+  }
+  return result;
+}
+
+void ShardedCountMinSketch::Merge() {
+  std::lock_guard<std::mutex> guard(merge_lock_);
+  MergeLocked();
+}
+
+void ShardedCountMinSketch::MergeLocked() {
+  uint64_t size = width_ * depth_;
+  Counter* bucket = buckets_.empty() ? nullptr : buckets_[current_].get();
+  for (auto& shard : shards_) {
+    for (uint64_t i = 0; i < size; i++) {
+      uint32_t v = shard[i].load(std::memory_order_relaxed);
+      if (v == 0) {
+        continue;
+      }
+      // take from shard first, see Increase
+      shard[i].fetch_sub(v, std::memory_order_relaxed);
+      total_[i].fetch_add(v, std::memory_order_relaxed);
+      if (bucket) {
+        bucket[i].fetch_add(v, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+void ShardedCountMinSketch::Tick() {
+  std::lock_guard<std::mutex> guard(merge_lock_);
+  MergeLocked();
+
+  uint64_t size = width_ * depth_;
+  switch (options_.decay) {
+    case kSlidingWindow: {
+      // the oldest bucket slide out of window and become the newest one
+      uint32_t next = (current_ + 1) % buckets_.size();
+      Counter* oldest = buckets_[next].get();
+      for (uint64_t i = 0; i < size; i++) {
+        uint32_t v = oldest[i].exchange(0, std::memory_order_relaxed);
+        if (v) {
+          total_[i].fetch_sub(v, std::memory_order_relaxed);
+        }
+      }
+      current_ = next;
+    } break;
+    case kExponential: {
+      for (uint64_t i = 0; i < size; i++) {
+        uint32_t v = total_[i].load(std::memory_order_relaxed);
+        if (v) {
+          total_[i].store(uint32_t(v * options_.decay_factor),
+                          std::memory_order_relaxed);
+        }
+      }
+    } break;
+    default:
+      break;
+  }
+}
+
+std::string ShardedCountMinSketch::Serialize() {
+  std::lock_guard<std::mutex> guard(merge_lock_);
+  MergeLocked();
+
+  SketchHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.decay = options_.decay;
+  header.width = width_;
+  header.depth = depth_;
+  header.seed = options_.seed;
+  header.buckets = buckets_.empty() ? 1 : buckets_.size();
+
+  uint64_t size = width_ * depth_;
+  std::string data;
+  data.reserve(sizeof(header) + header.buckets * size * sizeof(uint32_t));
+  data.append((const char*)&header, sizeof(header));
+
+  auto append_table = [&](const Counter* table) {
+    for (uint64_t i = 0; i < size; i++) {
+      uint32_t v = table[i].load(std::memory_order_relaxed);
+      data.append((const char*)&v, sizeof(v));
+    }
+  };
+  if (buckets_.empty()) {
+    append_table(total_.get());
+    return data;
+  }
+  // from oldest to newest, so window of two sketches align by age
+  for (uint32_t i = 1; i <= buckets_.size(); i++) {
+    append_table(buckets_[(current_ + i) % buckets_.size()].get());
+  }
+  return data;
+}
+
+bool ShardedCountMinSketch::MergeFrom(const std::string& data) {
+  SketchHeader header;
+  if (data.size() < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, data.data(), sizeof(header));
+
+  uint32_t buckets = buckets_.empty() ? 1 : buckets_.size();
+  uint64_t size = width_ * depth_;
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.decay != uint32_t(options_.decay) ||
+      header.width != width_ || header.depth != depth_ ||
+      header.seed != options_.seed || header.buckets != buckets ||
+      data.size() != sizeof(header) + buckets * size * sizeof(uint32_t)) {
+    LOG(ERROR) << "sketch shape mismatch, width:" << header.width
+               << ", depth:" << header.depth << ", buckets:" << header.buckets;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(merge_lock_);
+  const char* p = data.data() + sizeof(header);
+  for (uint32_t b = 1; b <= buckets; b++) {
+    Counter* bucket = buckets_.empty()
+                          ? nullptr
+                          : buckets_[(current_ + b) % buckets_.size()].get();
+    for (uint64_t i = 0; i < size; i++, p += sizeof(uint32_t)) {
+      uint32_t v;
+      memcpy(&v, p, sizeof(v));
+      if (v == 0) {
+        continue;
+      }
+      total_[i].fetch_add(v, std::memory_order_relaxed);
+      if (bucket) {
+        bucket[i].fetch_add(v, std::memory_order_relaxed);
+      }
+    }
+  }
+  return true;
+}
+
+// static
+std::unique_ptr<ShardedCountMinSketch> ShardedCountMinSketch::Deserialize(
+    const std::string& data,
+    uint32_t shards) {
+  SketchHeader header;
+  if (data.size() < sizeof(header)) {
+    return nullptr;
+  }
+  memcpy(&header, data.data(), sizeof(header));
+  if (memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || header.width == 0 || header.depth == 0 ||
+      header.depth > kMaxDepth || header.buckets == 0 ||
+      header.decay > kExponential ||
+      (header.decay != kSlidingWindow && header.buckets != 1)) {
+    return nullptr;
+  }
+  // the payload must hold exactly width*depth counters per bucket, check it
+  // before allocating tables sized by the untrusted header
+  uint64_t counters = (data.size() - sizeof(header)) / sizeof(uint32_t);
+  if ((data.size() - sizeof(header)) % sizeof(uint32_t) != 0 ||
+      header.width > counters / header.depth ||
+      header.width * header.depth > counters / header.buckets ||
+      header.width * header.depth * header.buckets != counters) {
+    LOG(ERROR) << "sketch size mismatch, width:" << header.width
+               << ", depth:" << header.depth << ", buckets:" << header.buckets
+               << ", payload:" << data.size() - sizeof(header);
+    return nullptr;
+  }
+
+  Options options;
+  options.width = header.width;
+  options.depth = header.depth;
+  options.seed = header.seed;
+  options.shards = shards;
+  options.decay = DecayPolicy(header.decay);
+  options.window_buckets = header.buckets;
+
+  std::unique_ptr<ShardedCountMinSketch> sketch(
+      new ShardedCountMinSketch(options));
+  if (!sketch->MergeFrom(data)) {
+    return nullptr;
+  }
+  return sketch;
+}
+
+}  // namespace component
@@ -0,0 +1,122 @@
+#ifndef COMPONENT_SHARDED_COUNT_MIN_SKETCH_H_
+#define COMPONENT_SHARDED_COUNT_MIN_SKETCH_H_
+
+#include <inttypes.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace component {
+
+/**
+ * concurrent count-min sketch for counting on hot path
+ *
+ * writers add into a per-thread shard(no shared cache line bouncing), Merge
+ * fold all shards into the merged table; Estimate = merged + caller's own
+ * shard, so a thread always see its own increase, and others' increase is
+ * visible after next Merge.
+ *
+ * decay, driven by Tick(usually from a repeating timer):
+ *  kSlidingWindow: count of last `window_buckets` ticks, eg: window 60s with
+ *                  6 buckets => Tick every 10s
+ *  kExponential:   counters *= decay_factor every tick
+ *
+ * conservative: only raise rows to (min + count), much less over estimate
+ * for skewed stream; never under estimate while every writer thread own a
+ * shard(threads <= shards)
+ *
+ * Serialize/MergeFrom: sketches with same shape(width/depth/seed/decay) can be
+ * combined across processes
+ * */
+class ShardedCountMinSketch {
+public:
+  enum DecayPolicy {
+    kNoDecay = 0,
+    kSlidingWindow = 1,
+    kExponential = 2,
+  };
+
+  struct Options {
+    // width = ceil(2 / error), depth = ceil(log(1 - certainty) / log(1/2))
+    double error = 0.0001;
+    double certainty = 0.999;
+    // none zero to override width/depth calculated above
+    uint64_t width = 0;
+    uint32_t depth = 0;
+    // 0: hardware_concurrency
+    uint32_t shards = 0;
+    bool conservative = false;
+    DecayPolicy decay = kNoDecay;
+    uint32_t window_buckets = 6;
+    double decay_factor = 0.5;
+    // must be same for sketches to merge
+    uint32_t seed = 0;
+  };
+
+  explicit ShardedCountMinSketch(const Options& options);
+  ~ShardedCountMinSketch();
+
+  // return the estimate after increase, eg: rate cap check
+  uint64_t Increase(const std::string& key, uint32_t count = 1);
+  uint64_t Increase(const void* data, size_t len, uint32_t count);
+
+  uint64_t Estimate(const std::string& key) const;
+  uint64_t Estimate(const void* data, size_t len) const;
+
+  // fold all shards into merged table
+  void Merge();
+
+  // Merge, then slide window by one bucket or decay counters once
+  void Tick();
+
+  // snapshot of merged counters(Merge first)
+  std::string Serialize();
+  // add counters from a serialized sketch, false when shape mismatch
+  bool MergeFrom(const std::string& data);
+  static std::unique_ptr<ShardedCountMinSketch> Deserialize(
+      const std::string& data,
+      uint32_t shards = 0);
+
+  uint64_t Width() const { return width_; }
+  uint64_t Depth() const { return depth_; }
+  uint32_t ShardCount() const { return shard_count_; }
+  const Options& GetOptions() const { return options_; }
+
+private:
+  static const uint32_t kMaxDepth = 32;
+
+  typedef std::atomic<uint32_t> Counter;
+  typedef std::unique_ptr<Counter[]> Table;
+
+  Table NewTable() const;
+
+  void Indexes(const void* data, size_t len, uint64_t* indexes) const;
+
+  Counter* MyShard() const;
+
+  // merged counters of a row
+  uint64_t MergedAt(uint64_t index) const;
+
+  void MergeLocked();
+
+  const Options options_;
+  uint64_t width_ = 0;
+  uint64_t depth_ = 0;
+  uint32_t shard_count_ = 0;
+
+  std::vector<Table> shards_;
+
+  // kSlidingWindow: buckets_[current_] receive merged increase, total_ is
+  // sum of all buckets; otherwise only total_ is used
+  Table total_;
+  std::vector<Table> buckets_;
+  uint32_t current_ = 0;
+
+  // Merge/Tick/Serialize/MergeFrom
+  std::mutex merge_lock_;
+};
+
+}  // end namespace component
+#endif
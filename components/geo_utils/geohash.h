@@ -0,0 +1,138 @@
+/**
+ * geohash encode/decode and cells cover of a circle
+ * https://en.wikipedia.org/wiki/Geohash
+ */
+#ifndef _COMPONENT_GEOUTILS_GEOHASH_H_H
+#define _COMPONENT_GEOUTILS_GEOHASH_H_H
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace geo {
+
+typedef struct GeoBox {
+  double lat_min;
+  double lat_max;
+  double lng_min;
+  double lng_max;
+} GeoBox;
+
+class GeoHash {
+public:
+  static const int kMaxPrecision = 12;
+
+  static const char* Base32() { return "0123456789bcdefghjkmnpqrstuvwxyz"; }
+
+  /**
+   * @param precision 编码长度, [1, 12]
+   */
+  static std::string Encode(double lat, double lng, int precision) {
+    if (precision > kMaxPrecision) {
+      precision = kMaxPrecision;
+    }
+    precision = precision < 1 ? 1 : precision;
+    GeoBox box = {-90, 90, -180, 180};
+    std::string hash;
+    int bits = 0, ch = 0;
+    bool even = true;  // 偶数位编码经度
+    while ((int)hash.size() < precision) {
+      double& min = even ? box.lng_min : box.lat_min;
+      double& max = even ? box.lng_max : box.lat_max;
+      double value = even ? lng : lat;
+      double mid = (min + max) / 2;
+      ch <<= 1;
+      if (value >= mid) {
+        ch |= 1;
+        min = mid;
+      } else {
+        max = mid;
+      }
+      even = !even;
+      if (++bits == 5) {
+        hash.push_back(Base32()[ch]);
+        bits = ch = 0;
+      }
+    }
+    return hash;
+  }
+
+  /**
+   * 编码的区域, 非法字符返回false
+   */
+  static bool Decode(const std::string& hash, GeoBox* box) {
+    *box = {-90, 90, -180, 180};
+    if (hash.empty() || (int)hash.size() > kMaxPrecision) {
+      return false;
+    }
+    bool even = true;
+    for (char c : hash) {
+      int v = CharValue(c);
+      if (v < 0) {
+        return false;
+      }
+      for (int bit = 4; bit >= 0; bit--) {
+        double& min = even ? box->lng_min : box->lat_min;
+        double& max = even ? box->lng_max : box->lat_max;
+        double mid = (min + max) / 2;
+        ((v >> bit) & 1) ? min = mid : max = mid;
+        even = !even;
+      }
+    }
+    return true;
+  }
+
+  static int CharValue(char c) {
+    const char* table = Base32();
+    for (int i = 0; i < 32; i++) {
+      if (table[i] == c) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * 覆盖圆形区域(外接矩形)的cell, 选不超过max_cells个cell的最大精度
+   * @param radius 半径, 米
+   */
+  static std::vector<std::string> CircleCover(double lat,
+                                              double lng,
+                                              double radius,
+                                              size_t max_cells = 16) {
+    const double meters_per_degree = 111320.0;
+    double dlat = radius / meters_per_degree;
+    double dlng = dlat / std::max(::cos(lat * M_PI / 180), 0.01);
+    GeoBox box = {std::max(lat - dlat, -90.0), std::min(lat + dlat, 90.0),
+                  std::max(lng - dlng, -180.0), std::min(lng + dlng, 180.0)};
+
+    for (int precision = kMaxPrecision; precision >= 1; precision--) {
+      int lng_bits = (5 * precision + 1) / 2;
+      int lat_bits = 5 * precision / 2;
+      double width = 360.0 / (1ULL << lng_bits);
+      double height = 180.0 / (1ULL << lat_bits);
+      int64_t x0 = (box.lng_min + 180) / width, x1 = (box.lng_max + 180) / width;
+      int64_t y0 = (box.lat_min + 90) / height, y1 = (box.lat_max + 90) / height;
+      if (precision > 1 && size_t((x1 - x0 + 1) * (y1 - y0 + 1)) > max_cells) {
+        continue;
+      }
+      std::vector<std::string> cells;
+      for (int64_t y = y0; y <= y1; y++) {
+        for (int64_t x = x0; x <= x1; x++) {
+          double cell_lat = std::min(-90 + (y + 0.5) * height, 90.0);
+          double cell_lng = std::min(-180 + (x + 0.5) * width, 180.0);
+          cells.push_back(Encode(cell_lat, cell_lng, precision));
+        }
+      }
+      std::sort(cells.begin(), cells.end());
+      cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+      return cells;
+    }
+    return {};
+  }
+};
+
+}  // namespace geo
+#endif
@@ -1,43 +1,110 @@
 #include "bitmap_merger.h"
-#include <iostream>
-#include "posting_field/posting_list_manager.h"
+
+#include <algorithm>
 
 namespace component {
 
-BitMapMerger::BitMapMerger(PostingListManager* m) : bitmap_manager_(m) {}
+namespace {
+
+// drop null and duplicated lists, a list may shared by values
+void unique_lists(std::vector<const BitMapPostingList*>* lists) {
+  lists->erase(std::remove(lists->begin(), lists->end(), nullptr),
+               lists->end());
+  std::sort(lists->begin(), lists->end());
+  lists->erase(std::unique(lists->begin(), lists->end()), lists->end());
+}
 
-void BitMapMerger::StartMerger() {
-  result_pl_ = std::move(bitmap_manager_->CreateMergePostingList());
-  group_result_pl_ = std::move(bitmap_manager_->CreateMergePostingList());
+}  // namespace
+
+std::set<int64_t> MergeResult::ToSet() const {
+  std::set<int64_t> ids;
+  ForEach([&ids](int64_t id) { ids.insert(ids.end(), id); });
+  return ids;
 }
 
-std::set<int64_t> BitMapMerger::EndMerger() {
-  return bitmap_manager_->GetIdsFromPostingList(result_pl_.get());
+BitMapMerger::BitMapMerger(PostingListManager* m) : bitmap_manager_(m) {}
+
+void BitMapMerger::AddMergerGroup(MergerGroup&& group) {
+  PlannedGroup planned;
+  planned.unions = std::move(group.includes_);
+  planned.unions.insert(planned.unions.end(), group.wildcards_.begin(),
+                        group.wildcards_.end());
+  planned.excludes = std::move(group.excludes_);
+  unique_lists(&planned.unions);
+  unique_lists(&planned.excludes);
+
+  for (const BitMapPostingList* pl : planned.unions) {
+    planned.estimate += pl->Cardinality();
+  }
+  groups_.push_back(std::move(planned));
 }
 
-bool BitMapMerger::CalculateMergerGroup(MergerGroup& group) {
-  group_result_pl_->ResetBits();
+void BitMapMerger::CalculateGroup(const PlannedGroup& group,
+                                  BitMapPostingList* out) {
+  // union the bigger lists first, small ones mostly hit existing containers
+  std::vector<const BitMapPostingList*> unions = group.unions;
+  std::sort(unions.begin(), unions.end(),
+            [](const BitMapPostingList* l, const BitMapPostingList* r) {
+              return l->Cardinality() > r->Cardinality();
+            });
+  for (const BitMapPostingList* pl : unions) {
+    out->Union(pl);
+  }
+  for (const BitMapPostingList* pl : group.excludes) {
+    if (out->Empty()) {
+      break;
+    }
+    out->Substract(pl);
+  }
+}
 
-  for (const auto& include_pl : group.includes_) {
-    group_result_pl_->Union(include_pl);
+void BitMapMerger::IntersectGroup(const PlannedGroup& group,
+                                  BitMapPostingList* result) {
+  if (group.unions.size() == 1) {
+    result->Intersect(group.unions.front());
+  } else {
+    // result ∩ (a ∪ b) == (result ∩ a) ∪ (result ∩ b), result is the
+    // smaller side, never touch the containers out of it
+    BitMapPostingList matched(result->BitCount(), 0);
+    for (const BitMapPostingList* pl : group.unions) {
+      BitMapPostingList part(*result);
+      part.Intersect(pl);
+      matched.Union(&part);
+    }
+    *result = std::move(matched);
   }
-  Json o = bitmap_manager_->GetIdsFromPostingList(group_result_pl_.get());
-  std::cout << "\t >>> grp after union includes:\t" << o << std::endl;
+  for (const BitMapPostingList* pl : group.excludes) {
+    if (result->Empty()) {
+      break;
+    }
+    result->Substract(pl);
+  }
+}
 
-  for (const auto& wildcard : group.wildcards_) {
-    group_result_pl_->Union(wildcard);
+MergeResult BitMapMerger::EndMerger() {
+  const uint64_t doc_count = bitmap_manager_->DocCount();
+  if (groups_.empty()) {
+    return MergeResult(bitmap_manager_->CreateMergePostingList(),
+                       bitmap_manager_);
   }
-  o = bitmap_manager_->GetIdsFromPostingList(group_result_pl_.get());
-  std::cout << "\t >>> grp after union wildcard:\t" << o << std::endl;
 
-  for (const auto& exclude_pl : group.excludes_) {
-    group_result_pl_->Substract(exclude_pl);
+  std::sort(groups_.begin(), groups_.end(),
+            [](const PlannedGroup& l, const PlannedGroup& r) {
+              return l.estimate < r.estimate;
+            });
+
+  BitMapPlPtr result(new BitMapPostingList(doc_count, 0));
+  if (groups_.front().estimate == 0) {
+    groups_.clear();
+    return MergeResult(std::move(result), bitmap_manager_);
   }
-  o = bitmap_manager_->GetIdsFromPostingList(group_result_pl_.get());
-  std::cout << "\t >>> grp after substract excludes:\t" << o << std::endl;
+  CalculateGroup(groups_.front(), result.get());
 
-  result_pl_->Intersect(group_result_pl_.get());
-  return true;
+  for (size_t i = 1; i < groups_.size() && !result->Empty(); i++) {
+    IntersectGroup(groups_[i], result.get());
+  }
+  groups_.clear();
+  return MergeResult(std::move(result), bitmap_manager_);
 }
 
 }  // namespace component
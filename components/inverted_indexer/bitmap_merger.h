@@ -2,41 +2,87 @@
 #define _LT_COMPONENT_BITMAP_MERGER_H_
 
 #include <set>
+#include <vector>
 #include "expression.h"
 #include "posting_field/bitmap_posting_list.h"
 #include "posting_field/general_str_field.h"
+#include "posting_field/posting_list_manager.h"
 
 namespace component {
 
-class PostingListManager;
+/* matched doc ids of a query, ascending order; iterate it directly
+ * instead of building a std::set when only walk through the result */
+class MergeResult {
+public:
+  class Iterator {
+  public:
+    bool Valid() const { return iter_.Valid(); }
+    int64_t Value() const { return manager_->DocIdAt(iter_.Value()); }
+    void Next() { iter_.Next(); }
+
+  private:
+    friend class MergeResult;
+    Iterator(const RoaringBitmap* bits, const PostingListManager* m)
+      : iter_(bits), manager_(m) {}
+
+    RoaringBitmap::Iterator iter_;
+    const PostingListManager* manager_;
+  };
+
+  MergeResult(BitMapPlPtr pl, const PostingListManager* m)
+    : pl_(std::move(pl)), manager_(m) {}
+
+  uint64_t Count() const { return pl_->Cardinality(); }
+  bool Empty() const { return pl_->Empty(); }
+
+  Iterator Begin() const { return Iterator(&pl_->Bits(), manager_); }
 
+  template <typename Fn>
+  void ForEach(Fn fn) const {
+    pl_->Bits().ForEach([&](uint32_t idx) { fn(manager_->DocIdAt(idx)); });
+  }
+
+  std::set<int64_t> ToSet() const;
+
+private:
+  BitMapPlPtr pl_;
+  const PostingListManager* manager_;
+};
+
+/* result = ∩ group, group = (∪ includes ∪ wildcards) - ∪ excludes
+ *
+ * groups are planned by the upper bound of their size, the smallest
+ * one computed first and the others intersect into it, stop as soon
+ * as the result becomes empty */
 class BitMapMerger {
 public:
   struct MergerGroup {
-    std::set<const BitMapPostingList*> includes_;   //并
-    std::set<const BitMapPostingList*> excludes_;   //交
-    std::set<const BitMapPostingList*> wildcards_;  //差
+    std::vector<const BitMapPostingList*> includes_;   //并
+    std::vector<const BitMapPostingList*> excludes_;   //差
+    std::vector<const BitMapPostingList*> wildcards_;  //并
   };
 
   BitMapMerger(PostingListManager* m);
-  // operator new() = delete;
-  void StartMerger();
-  std::set<int64_t> EndMerger();
 
-  bool CalculateMergerGroup(MergerGroup& group);
+  void AddMergerGroup(MergerGroup&& group);
 
-  bool IsFinished() const { return is_done_; }
+  MergeResult EndMerger();
 
 private:
-  void Calculate();
+  struct PlannedGroup {
+    // upper bound of the group result size
+    uint64_t estimate = 0;
+    std::vector<const BitMapPostingList*> unions;
+    std::vector<const BitMapPostingList*> excludes;
+  };
+
+  // group result into out, out must be empty
+  void CalculateGroup(const PlannedGroup& group, BitMapPostingList* out);
 
-  bool is_done_ = false;
-  BitMapPlPtr result_pl_;
-  BitMapPlPtr group_result_pl_;
+  // result = result ∩ group
+  void IntersectGroup(const PlannedGroup& group, BitMapPostingList* result);
 
-  std::set<const BitMapPostingList*> union_set_;      //并
-  std::set<const BitMapPostingList*> intersect_set_;  //交
-  std::set<const BitMapPostingList*> substract_set_;  //差
+  std::vector<PlannedGroup> groups_;
 
   PostingListManager* bitmap_manager_;
 };
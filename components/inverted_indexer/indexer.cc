@@ -10,62 +10,39 @@ Indexer::Indexer(Delegate* d)
     entitys_meta_(new EntitysMeta),
     pl_manager_(new PostingListManager) {}
 
-std::set<int64_t> Indexer::UnifyQuery(const IndexerQuerys& query) {
+MergeResult Indexer::Query(const IndexerQuerys& query) {
   BitMapMerger merger(pl_manager_.get());
 
-  merger.StartMerger();
-
-  Json out = merger.EndMerger();
-  std::cout << "after start merge result:" << out << std::endl;
-
   for (auto& field_pair : indexer_table_) {
     BitMapMerger::MergerGroup grp;
 
     Field* field_ptr = field_pair.second.get();
+    grp.wildcards_.push_back(field_ptr->WildcardsBitMap());
 
     const auto& query_iter = query.find(field_pair.first);
     if (query_iter == query.end()) {
-      grp.wildcards_.insert(field_ptr->WildcardsBitMap());
-      merger.CalculateMergerGroup(grp);
-      Json out = merger.EndMerger();
-      std::cout << " field:" << field_pair.first << "\t result:" << out
-                << std::endl;
+      merger.AddMergerGroup(std::move(grp));
       continue;
     }
 
-    const auto& query_values = query_iter->second;
-    for (const std::string& v : query_values) {
+    for (const std::string& v : query_iter->second) {
       auto includes = field_ptr->GetIncludeBitmap(v);
-      for (auto& pl : includes) {
-        Json j_include = pl_manager_->GetIdsFromPostingList(pl);
-        std::cout << " field:" << field_pair.first << "'s value:" << v
-                  << " include ids:" << j_include << std::endl;
-      }
-      grp.includes_.insert(includes.begin(), includes.end());
+      grp.includes_.insert(grp.includes_.end(), includes.begin(),
+                           includes.end());
 
       auto excludes = field_ptr->GetExcludeBitmap(v);
-      for (auto& pl : excludes) {
-        Json j_exclude = pl_manager_->GetIdsFromPostingList(pl);
-        std::cout << " field:" << field_pair.first << "'s value:" << v
-                  << " exclude ids:" << j_exclude << std::endl;
-      }
-      grp.excludes_.insert(excludes.begin(), excludes.end());
+      grp.excludes_.insert(grp.excludes_.end(), excludes.begin(),
+                           excludes.end());
     }
-    grp.wildcards_.insert(field_ptr->WildcardsBitMap());
-    out = pl_manager_->GetIdsFromPostingList(field_ptr->WildcardsBitMap());
-    std::cout << " field:" << field_pair.first << "'s wildcards ids:" << out
-              << std::endl;
-
-    merger.CalculateMergerGroup(grp);
-
-    out = merger.EndMerger();
-    std::cout << " field:" << field_pair.first << "\t result:" << out
-              << std::endl;
+    merger.AddMergerGroup(std::move(grp));
   }
-
   return merger.EndMerger();
 }
 
+std::set<int64_t> Indexer::UnifyQuery(const IndexerQuerys& query) {
+  return Query(query).ToSet();
+}
+
 void Indexer::DebugDumpField(const std::string& field,
                              std::ostringstream& oss) {
   auto pair = entitys_meta_->field_entitys_.find(field);
@@ -1,6 +1,7 @@
 #ifndef _LT_COMPONENT_INVERTED_INDEX_INDEXER_H_
 #define _LT_COMPONENT_INVERTED_INDEX_INDEXER_H_
 
+#include "bitmap_merger.h"
 #include "expression.h"
 #include "posting_field/general_str_field.h"
 #include "posting_field/posting_list_manager.h"
@@ -32,6 +33,9 @@ public:
 public:
   Indexer(Delegate* d);
 
+  // matched doc ids, iterate it without building a set
+  MergeResult Query(const IndexerQuerys& query);
+
   std::set<int64_t> UnifyQuery(const IndexerQuerys& query);
 
   void AddDocument(const RefDocument&& document);
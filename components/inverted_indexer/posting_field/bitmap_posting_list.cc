@@ -1,59 +1,52 @@
 #include "bitmap_posting_list.h"
 
+#include <bitset>
+
 namespace component {
 
 void BitMapPostingList::ResetBits() {
-  memset(&ids_bitmap_[0], 0, ids_bitmap_.size() * sizeof(uint64_t));
+  bits_.Clear();
 }
 
 void BitMapPostingList::SetBit(uint64_t idx) {
-  CHECK(idx < ids_bitmap_.size() * 64);
-  int64_t bytes = idx / 64;
-  int16_t bits = idx % 64;
-  ids_bitmap_[bytes] |= (1ul << (63 - bits));
+  CHECK(idx < bit_count_);
+  bits_.Add(idx);
 }
 
 void BitMapPostingList::ClearBit(uint64_t idx) {
-  CHECK(idx < ids_bitmap_.size() * 64);
-  int64_t bytes = idx / 64;
-  int16_t bits = idx % 64;
-  ids_bitmap_[bytes] &= ~(1ul << (63 - bits));
+  CHECK(idx < bit_count_);
+  bits_.Remove(idx);
 }
 
 bool BitMapPostingList::IsBitSet(uint64_t idx) const {
-  CHECK(idx < ids_bitmap_.size() * 64);
-  return (ids_bitmap_[idx / 64] & (1ul << (63 - (idx % 64)))) != 0;
+  CHECK(idx < bit_count_);
+  return bits_.Contains(idx);
 }
 
 void BitMapPostingList::Union(const BitMapPostingList* other) {
-  uint64_t i = 0;
-  for (; i < ids_bitmap_.size() && i < other->ids_bitmap_.size(); i++) {
-    ids_bitmap_[i] |= other->ids_bitmap_[i];
-  }
+  bits_.UnionWith(other->bits_);
 }
 
 void BitMapPostingList::Intersect(const BitMapPostingList* other) {
-  uint64_t i = 0;
-  for (; i < ids_bitmap_.size() && i < other->ids_bitmap_.size(); i++) {
-    ids_bitmap_[i] &= other->ids_bitmap_[i];
-  }
-  if (i < ids_bitmap_.size()) {
-    memset(&ids_bitmap_[i], 0, ids_bitmap_.size() - i);
-  }
+  bits_.IntersectWith(other->bits_);
 }
 
 void BitMapPostingList::Substract(const BitMapPostingList* other) {
-  uint64_t i = 0;
-  for (; i < ids_bitmap_.size() && i < other->ids_bitmap_.size(); i++) {
-    ids_bitmap_[i] &= ~(other->ids_bitmap_[i]);
-  }
+  bits_.SubtractWith(other->bits_);
 }
 
 std::string BitMapPostingList::DumpBits() {
+  // 64 bits a group, most significant bit first
+  std::vector<uint64_t> words((bit_count_ + 63) / 64, 0);
+  bits_.ForEach([&words](uint32_t idx) {
+    if (idx / 64 < words.size()) {
+      words[idx / 64] |= (1ul << (63 - (idx % 64)));
+    }
+  });
   std::ostringstream oss;
-  for (size_t i = 0; i < ids_bitmap_.size(); i++) {
-    oss << std::bitset<64>(ids_bitmap_[i]);
-    if (i < ids_bitmap_.size() - 1) {
+  for (size_t i = 0; i < words.size(); i++) {
+    oss << std::bitset<64>(words[i]);
+    if (i < words.size() - 1) {
       oss << "-";
     }
   }
@@ -1,7 +1,6 @@
 #ifndef LIGHTINGIO_BITMAP_POSTING_LIST_H
 #define LIGHTINGIO_BITMAP_POSTING_LIST_H
 
-#include <bitset>
 #include <memory>
 #include <set>
 #include <sstream>
@@ -9,14 +8,20 @@
 #include <unordered_map>
 #include <vector>
 #include "glog/logging.h"
+#include "roaring_bitmap.h"
 
 namespace component {
 
+/* bit idx is the index of a doc in PostingListManager's sorted ids,
+ * bits kept in a roaring bitmap, sparse values cost a few bytes only */
 class BitMapPostingList {
 public:
+  // value != 0: all bits in [0, bit_count) set
   BitMapPostingList(int64_t bit_count, int64_t id_count, uint64_t value = 0)
     : id_count_(id_count), bit_count_(bit_count) {
-    ids_bitmap_.resize((bit_count + 63) / 64, value);
+    if (value != 0) {
+      bits_.AddRange(0, bit_count);
+    }
   }
   void ResetBits();
   void SetBit(uint64_t idx);
@@ -24,17 +29,26 @@ public:
   bool IsBitSet(uint64_t idx) const;
   uint64_t IdCount() const { return id_count_; };
   uint64_t BitCount() const { return bit_count_; };
+  // count of bits set
+  uint64_t Cardinality() const { return bits_.Cardinality(); }
+  bool Empty() const { return bits_.Empty(); }
 
   void Union(const BitMapPostingList* other);
   void Intersect(const BitMapPostingList* other);
   void Substract(const BitMapPostingList* other);
 
+  // compact containers after build
+  void Optimize() { bits_.Optimize(); }
+  size_t MemoryUsage() const { return bits_.MemoryUsage(); }
+
+  const RoaringBitmap& Bits() const { return bits_; }
+
   std::string DumpBits();
 
 private:
   uint64_t id_count_ = 0;
   uint64_t bit_count_ = 0;
-  std::vector<uint64_t> ids_bitmap_;
+  RoaringBitmap bits_;
 };
 typedef std::unique_ptr<BitMapPostingList> BitMapPlPtr;
 
@@ -3,7 +3,6 @@
 //
 
 #include <algorithm>
-#include <iostream>
 #include "hash/crc.h"
 
 #include "posting_list_manager.h"
@@ -44,6 +43,7 @@ BitMapPostingList* PostingListManager::BuildBitMapPostingListForIds(
     CHECK(iter != doc_id_to_bit_idx_.end());
     new_ids_bitmap->SetBit(iter->second);
   }
+  new_ids_bitmap->Optimize();
 
   BitMapPostingList* bitmap_pl = new_ids_bitmap.get();
   ids_table_[crc_code] = std::move(new_ids_bitmap);
@@ -68,11 +68,11 @@ std::set<int64_t> PostingListManager::GetIdsFromPostingList(
     return result;
   }
 
-  for (uint64_t i = 0; i <= pl->BitCount(); i++) {
-    if (pl->IsBitSet(i) && i < sorted_doc_ids_.size()) {
-      result.insert(sorted_doc_ids_[i]);
+  pl->Bits().ForEach([&](uint32_t idx) {
+    if (idx < sorted_doc_ids_.size()) {
+      result.insert(result.end(), sorted_doc_ids_[idx]);
     }
-  }
+  });
   return result;
 }
 
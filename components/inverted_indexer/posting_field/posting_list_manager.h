@@ -23,6 +23,10 @@ public:
   BitMapPlPtr CreateMergePostingList();
   std::set<int64_t> GetIdsFromPostingList(const BitMapPostingList* pl);
 
+  // doc id of a bit idx
+  int64_t DocIdAt(uint64_t idx) const { return sorted_doc_ids_[idx]; }
+  uint64_t DocCount() const { return sorted_doc_ids_.size(); }
+
 private:
   // vector's hashvalue to vector
   std::vector<int64_t> sorted_doc_ids_;
@@ -0,0 +1,570 @@
+#include "roaring_bitmap.h"
+
+#include <algorithm>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace component {
+
+namespace {
+
+const uint32_t kContainerRange = 1 << 16;
+
+enum WordsOp { kAnd, kOr, kAndNot };
+
+// a = a op b, return cardinality of a
+uint32_t words_op(uint64_t* a, const uint64_t* b, WordsOp op) {
+  uint32_t i = 0;
+#ifdef __AVX2__
+  for (; i + 4 <= RoaringBitmap::kBitmapWords; i += 4) {
+    __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+    __m256i r = op == kAnd ? _mm256_and_si256(va, vb)
+                           : (op == kOr ? _mm256_or_si256(va, vb)
+                                        : _mm256_andnot_si256(vb, va));
+    _mm256_storeu_si256((__m256i*)(a + i), r);
+  }
+#endif
+  for (; i < RoaringBitmap::kBitmapWords; i++) {
+    a[i] = op == kAnd ? (a[i] & b[i])
+                      : (op == kOr ? (a[i] | b[i]) : (a[i] & ~b[i]));
+  }
+  uint32_t count = 0;
+  for (i = 0; i < RoaringBitmap::kBitmapWords; i++) {
+    count += __builtin_popcountll(a[i]);
+  }
+  return count;
+}
+
+inline bool test_bit(const std::vector<uint64_t>& words, uint16_t low) {
+  return (words[low >> 6] >> (low & 63)) & 1;
+}
+
+// runs: [start, length - 1] pairs, return index of the first run ends at
+// or after low, runs.size() if none; binary search over run starts
+size_t run_lower_bound(const std::vector<uint16_t>& runs, uint32_t low) {
+  size_t lo = 0, hi = runs.size() / 2;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (runs[2 * mid] <= low) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  // lo: first run starts after low, the one before may cover it
+  if (lo > 0 && low <= uint32_t(runs[2 * lo - 2]) + runs[2 * lo - 1]) {
+    lo--;
+  }
+  return 2 * lo;
+}
+
+}  // namespace
+
+/* container level operations, a run container is expanded into
+ * array/bitmap before combined with others */
+struct ContainerOps {
+  typedef RoaringBitmap::Container Container;
+
+  static bool IsFull(const Container& c) {
+    return c.cardinality == kContainerRange;
+  }
+
+  static void ToBitmap(Container* c) {
+    if (c->type == RoaringBitmap::kBitmap) {
+      return;
+    }
+    std::vector<uint64_t> words(RoaringBitmap::kBitmapWords, 0);
+    if (c->type == RoaringBitmap::kArray) {
+      for (uint16_t v : c->values) {
+        words[v >> 6] |= uint64_t(1) << (v & 63);
+      }
+    } else {
+      for (size_t r = 0; r < c->values.size(); r += 2) {
+        uint32_t last = uint32_t(c->values[r]) + c->values[r + 1];
+        for (uint32_t v = c->values[r]; v <= last; v++) {
+          words[v >> 6] |= uint64_t(1) << (v & 63);
+        }
+      }
+    }
+    c->type = RoaringBitmap::kBitmap;
+    c->words.swap(words);
+    std::vector<uint16_t>().swap(c->values);
+  }
+
+  static void ToArray(Container* c) {
+    if (c->type == RoaringBitmap::kArray) {
+      return;
+    }
+    std::vector<uint16_t> values;
+    values.reserve(c->cardinality);
+    if (c->type == RoaringBitmap::kBitmap) {
+      for (uint32_t w = 0; w < RoaringBitmap::kBitmapWords; w++) {
+        for (uint64_t word = c->words[w]; word != 0; word &= word - 1) {
+          values.push_back((w << 6) | __builtin_ctzll(word));
+        }
+      }
+    } else {
+      for (size_t r = 0; r < c->values.size(); r += 2) {
+        uint32_t last = uint32_t(c->values[r]) + c->values[r + 1];
+        for (uint32_t v = c->values[r]; v <= last; v++) {
+          values.push_back(v);
+        }
+      }
+    }
+    c->type = RoaringBitmap::kArray;
+    c->values.swap(values);
+    std::vector<uint64_t>().swap(c->words);
+  }
+
+  // array or bitmap by cardinality
+  static void Normalize(Container* c) {
+    if (c->cardinality <= RoaringBitmap::kArrayMaxSize) {
+      ToArray(c);
+    } else {
+      ToBitmap(c);
+    }
+  }
+
+  static uint32_t CountRuns(const Container& c) {
+    if (c.type == RoaringBitmap::kRun) {
+      return c.values.size() / 2;
+    }
+    uint32_t runs = 0;
+    if (c.type == RoaringBitmap::kArray) {
+      for (size_t i = 0; i < c.values.size(); i++) {
+        runs += (i == 0 || c.values[i] != c.values[i - 1] + 1) ? 1 : 0;
+      }
+      return runs;
+    }
+    for (uint32_t w = 0; w < RoaringBitmap::kBitmapWords; w++) {
+      uint64_t word = c.words[w];
+      uint64_t prev_high =
+          w == 0 ? 0 : (c.words[w - 1] >> 63);
+      // run starts: bit set and previous bit not set
+      uint64_t starts = word & ~((word << 1) | prev_high);
+      runs += __builtin_popcountll(starts);
+    }
+    return runs;
+  }
+
+  static void ToRun(Container* c) {
+    ToArray(c);
+    std::vector<uint16_t> runs;
+    for (size_t i = 0; i < c->values.size();) {
+      size_t j = i;
+      while (j + 1 < c->values.size() && c->values[j + 1] == c->values[j] + 1) {
+        j++;
+      }
+      runs.push_back(c->values[i]);
+      runs.push_back(c->values[j] - c->values[i]);
+      i = j + 1;
+    }
+    c->type = RoaringBitmap::kRun;
+    c->values.swap(runs);
+  }
+
+  static void Optimize(Container* c) {
+    size_t run_bytes = CountRuns(*c) * 4;
+    size_t array_bytes = c->cardinality * 2;
+    size_t bitmap_bytes = RoaringBitmap::kBitmapWords * 8;
+    if (run_bytes < std::min(array_bytes, bitmap_bytes)) {
+      if (c->type != RoaringBitmap::kRun) {
+        ToRun(c);
+      }
+    } else {
+      Normalize(c);
+    }
+    c->values.shrink_to_fit();
+  }
+
+  // run container expanded into holder, others returned as is
+  static const Container& Expand(const Container& c, Container* holder) {
+    if (c.type != RoaringBitmap::kRun) {
+      return c;
+    }
+    *holder = c;
+    Normalize(holder);
+    return *holder;
+  }
+
+  static void Intersect(Container* a, const Container& other) {
+    if (IsFull(other)) {
+      return;
+    }
+    if (IsFull(*a)) {
+      *a = other;
+      return;
+    }
+    if (a->type == RoaringBitmap::kRun) {
+      Normalize(a);
+    }
+    Container expanded;
+    const Container& b = Expand(other, &expanded);
+
+    if (a->type == RoaringBitmap::kBitmap && b.type == RoaringBitmap::kBitmap) {
+      a->cardinality = words_op(a->words.data(), b.words.data(), kAnd);
+      Normalize(a);
+      return;
+    }
+    if (a->type == RoaringBitmap::kBitmap) {
+      // bitmap & array -> array
+      std::vector<uint16_t> values;
+      values.reserve(b.values.size());
+      for (uint16_t v : b.values) {
+        if (test_bit(a->words, v)) {
+          values.push_back(v);
+        }
+      }
+      a->type = RoaringBitmap::kArray;
+      a->values.swap(values);
+      std::vector<uint64_t>().swap(a->words);
+    } else if (b.type == RoaringBitmap::kBitmap) {
+      auto end = std::remove_if(a->values.begin(), a->values.end(),
+                                [&b](uint16_t v) { return !test_bit(b.words, v); });
+      a->values.erase(end, a->values.end());
+    } else {
+      std::vector<uint16_t> values;
+      values.reserve(std::min(a->values.size(), b.values.size()));
+      std::set_intersection(a->values.begin(), a->values.end(),
+                            b.values.begin(), b.values.end(),
+                            std::back_inserter(values));
+      a->values.swap(values);
+    }
+    a->cardinality = a->values.size();
+  }
+
+  static void Union(Container* a, const Container& other) {
+    if (IsFull(*a)) {
+      return;
+    }
+    if (IsFull(other)) {
+      *a = other;
+      return;
+    }
+    if (a->type == RoaringBitmap::kRun) {
+      Normalize(a);
+    }
+    Container expanded;
+    const Container& b = Expand(other, &expanded);
+
+    if (a->type == RoaringBitmap::kArray && b.type == RoaringBitmap::kArray &&
+        a->values.size() + b.values.size() <= RoaringBitmap::kArrayMaxSize) {
+      std::vector<uint16_t> values;
+      values.reserve(a->values.size() + b.values.size());
+      std::set_union(a->values.begin(), a->values.end(), b.values.begin(),
+                     b.values.end(), std::back_inserter(values));
+      a->values.swap(values);
+      a->cardinality = a->values.size();
+      return;
+    }
+    ToBitmap(a);
+    if (b.type == RoaringBitmap::kBitmap) {
+      a->cardinality = words_op(a->words.data(), b.words.data(), kOr);
+      return;
+    }
+    for (uint16_t v : b.values) {
+      uint64_t bit = uint64_t(1) << (v & 63);
+      a->cardinality += (a->words[v >> 6] & bit) ? 0 : 1;
+      a->words[v >> 6] |= bit;
+    }
+  }
+
+  static void Subtract(Container* a, const Container& other) {
+    if (IsFull(other)) {
+      a->values.clear();
+      a->words.clear();
+      a->type = RoaringBitmap::kArray;
+      a->cardinality = 0;
+      return;
+    }
+    if (a->type == RoaringBitmap::kRun) {
+      Normalize(a);
+    }
+    Container expanded;
+    const Container& b = Expand(other, &expanded);
+
+    if (a->type == RoaringBitmap::kBitmap) {
+      if (b.type == RoaringBitmap::kBitmap) {
+        a->cardinality = words_op(a->words.data(), b.words.data(), kAndNot);
+      } else {
+        for (uint16_t v : b.values) {
+          uint64_t bit = uint64_t(1) << (v & 63);
+          a->cardinality -= (a->words[v >> 6] & bit) ? 1 : 0;
+          a->words[v >> 6] &= ~bit;
+        }
+      }
+      Normalize(a);
+      return;
+    }
+    if (b.type == RoaringBitmap::kBitmap) {
+      auto end = std::remove_if(a->values.begin(), a->values.end(),
+                                [&b](uint16_t v) { return test_bit(b.words, v); });
+      a->values.erase(end, a->values.end());
+    } else {
+      std::vector<uint16_t> values;
+      values.reserve(a->values.size());
+      std::set_difference(a->values.begin(), a->values.end(),
+                          b.values.begin(), b.values.end(),
+                          std::back_inserter(values));
+      a->values.swap(values);
+    }
+    a->cardinality = a->values.size();
+  }
+};
+
+int RoaringBitmap::IndexOf(uint16_t key) const {
+  auto iter = std::lower_bound(keys_.begin(), keys_.end(), key);
+  if (iter == keys_.end() || *iter != key) {
+    return -1;
+  }
+  return iter - keys_.begin();
+}
+
+RoaringBitmap::Container* RoaringBitmap::GetOrCreate(uint16_t key) {
+  auto iter = std::lower_bound(keys_.begin(), keys_.end(), key);
+  size_t index = iter - keys_.begin();
+  if (iter == keys_.end() || *iter != key) {
+    keys_.insert(iter, key);
+    containers_.insert(containers_.begin() + index, Container());
+  }
+  return &containers_[index];
+}
+
+void RoaringBitmap::Add(uint32_t value) {
+  Container* c = GetOrCreate(value >> 16);
+  uint16_t low = value & 0xFFFF;
+  if (c->type == kRun) {
+    ContainerOps::Normalize(c);
+  }
+  if (c->type == kBitmap) {
+    uint64_t bit = uint64_t(1) << (low & 63);
+    c->cardinality += (c->words[low >> 6] & bit) ? 0 : 1;
+    c->words[low >> 6] |= bit;
+    return;
+  }
+  auto iter = std::lower_bound(c->values.begin(), c->values.end(), low);
+  if (iter != c->values.end() && *iter == low) {
+    return;
+  }
+  c->values.insert(iter, low);
+  c->cardinality++;
+  if (c->cardinality > kArrayMaxSize) {
+    ContainerOps::ToBitmap(c);
+  }
+}
+
+void RoaringBitmap::Remove(uint32_t value) {
+  int index = IndexOf(value >> 16);
+  if (index < 0) {
+    return;
+  }
+  Container* c = &containers_[index];
+  uint16_t low = value & 0xFFFF;
+  if (c->type == kRun) {
+    ContainerOps::Normalize(c);
+  }
+  if (c->type == kBitmap) {
+    uint64_t bit = uint64_t(1) << (low & 63);
+    c->cardinality -= (c->words[low >> 6] & bit) ? 1 : 0;
+    c->words[low >> 6] &= ~bit;
+    ContainerOps::Normalize(c);
+  } else {
+    auto iter = std::lower_bound(c->values.begin(), c->values.end(), low);
+    if (iter != c->values.end() && *iter == low) {
+      c->values.erase(iter);
+      c->cardinality--;
+    }
+  }
+  if (c->cardinality == 0) {
+    keys_.erase(keys_.begin() + index);
+    containers_.erase(containers_.begin() + index);
+  }
+}
+
+bool RoaringBitmap::Contains(uint32_t value) const {
+  int index = IndexOf(value >> 16);
+  if (index < 0) {
+    return false;
+  }
+  const Container& c = containers_[index];
+  uint16_t low = value & 0xFFFF;
+  if (c.type == kBitmap) {
+    return test_bit(c.words, low);
+  }
+  if (c.type == kArray) {
+    return std::binary_search(c.values.begin(), c.values.end(), low);
+  }
+  size_t r = run_lower_bound(c.values, low);
+  return r < c.values.size() && low >= c.values[r];
+}
+
+void RoaringBitmap::AddRange(uint32_t begin, uint32_t end) {
+  while (begin < end) {
+    uint32_t key = begin >> 16;
+    uint32_t low_begin = begin & 0xFFFF;
+    uint32_t low_end = std::min<uint64_t>(end - (key << 16), kContainerRange);
+
+    Container range;
+    range.type = kRun;
+    range.cardinality = low_end - low_begin;
+    range.values = {uint16_t(low_begin), uint16_t(low_end - low_begin - 1)};
+    ContainerOps::Union(GetOrCreate(key), range);
+
+    if (low_end == kContainerRange && key == 0xFFFF) {
+      break;
+    }
+    begin = (key << 16) + low_end;
+  }
+}
+
+uint64_t RoaringBitmap::Cardinality() const {
+  uint64_t count = 0;
+  for (const Container& c : containers_) {
+    count += c.cardinality;
+  }
+  return count;
+}
+
+void RoaringBitmap::Clear() {
+  std::vector<uint16_t>().swap(keys_);
+  std::vector<Container>().swap(containers_);
+}
+
+void RoaringBitmap::Optimize() {
+  for (Container& c : containers_) {
+    ContainerOps::Optimize(&c);
+  }
+  keys_.shrink_to_fit();
+  containers_.shrink_to_fit();
+}
+
+void RoaringBitmap::UnionWith(const RoaringBitmap& other) {
+  for (size_t i = 0; i < other.keys_.size(); i++) {
+    ContainerOps::Union(GetOrCreate(other.keys_[i]), other.containers_[i]);
+  }
+}
+
+void RoaringBitmap::IntersectWith(const RoaringBitmap& other) {
+  size_t kept = 0;
+  for (size_t i = 0, j = 0; i < keys_.size(); i++) {
+    while (j < other.keys_.size() && other.keys_[j] < keys_[i]) {
+      j++;
+    }
+    if (j == other.keys_.size() || other.keys_[j] != keys_[i]) {
+      continue;
+    }
+    ContainerOps::Intersect(&containers_[i], other.containers_[j]);
+    if (containers_[i].cardinality == 0) {
+      continue;
+    }
+    keys_[kept] = keys_[i];
+    if (kept != i) {
+      containers_[kept] = std::move(containers_[i]);
+    }
+    kept++;
+  }
+  keys_.resize(kept);
+  containers_.resize(kept);
+}
+
+void RoaringBitmap::SubtractWith(const RoaringBitmap& other) {
+  size_t kept = 0;
+  for (size_t i = 0, j = 0; i < keys_.size(); i++) {
+    while (j < other.keys_.size() && other.keys_[j] < keys_[i]) {
+      j++;
+    }
+    if (j < other.keys_.size() && other.keys_[j] == keys_[i]) {
+      ContainerOps::Subtract(&containers_[i], other.containers_[j]);
+    }
+    if (containers_[i].cardinality == 0) {
+      continue;
+    }
+    keys_[kept] = keys_[i];
+    if (kept != i) {
+      containers_[kept] = std::move(containers_[i]);
+    }
+    kept++;
+  }
+  keys_.resize(kept);
+  containers_.resize(kept);
+}
+
+size_t RoaringBitmap::MemoryUsage() const {
+  size_t bytes = sizeof(*this) + keys_.capacity() * sizeof(uint16_t) +
+                 containers_.capacity() * sizeof(Container);
+  for (const Container& c : containers_) {
+    bytes += c.values.capacity() * sizeof(uint16_t) +
+             c.words.capacity() * sizeof(uint64_t);
+  }
+  return bytes;
+}
+
+RoaringBitmap::Iterator RoaringBitmap::Begin() const {
+  return Iterator(this);
+}
+
+RoaringBitmap::Iterator::Iterator(const RoaringBitmap* bitmap)
+  : bitmap_(bitmap) {
+  for (; container_ < bitmap_->containers_.size(); container_++) {
+    if (Seek(0)) {
+      return;
+    }
+  }
+}
+
+void RoaringBitmap::Iterator::Next() {
+  if (!valid_) {
+    return;
+  }
+  uint32_t low = (value_ & 0xFFFF) + 1;
+  if (low < kContainerRange && Seek(low)) {
+    return;
+  }
+  for (container_++; container_ < bitmap_->containers_.size(); container_++) {
+    if (Seek(0)) {
+      return;
+    }
+  }
+  valid_ = false;
+}
+
+bool RoaringBitmap::Iterator::Seek(uint32_t low) {
+  const Container& c = bitmap_->containers_[container_];
+  uint32_t high = uint32_t(bitmap_->keys_[container_]) << 16;
+  valid_ = false;
+  if (c.type == kArray) {
+    auto iter = std::lower_bound(c.values.begin(), c.values.end(), low);
+    if (iter != c.values.end()) {
+      value_ = high | *iter;
+      valid_ = true;
+    }
+  } else if (c.type == kRun) {
+    // Next seeks forward in the same container, resume from current run
+    if (low == 0 || run_ >= c.values.size()) {
+      run_ = 0;
+    }
+    while (run_ < c.values.size() &&
+           uint32_t(c.values[run_]) + c.values[run_ + 1] < low) {
+      run_ += 2;
+    }
+    if (run_ < c.values.size()) {
+      value_ = high | std::max<uint32_t>(low, c.values[run_]);
+      valid_ = true;
+    }
+  } else {
+    uint32_t w = low >> 6;
+    uint64_t word = c.words[w] & (~uint64_t(0) << (low & 63));
+    while (word == 0 && ++w < kBitmapWords) {
+      word = c.words[w];
+    }
+    if (word != 0) {
+      value_ = high | (w << 6) | __builtin_ctzll(word);
+      valid_ = true;
+    }
+  }
+  return valid_;
+}
+
+}  // namespace component
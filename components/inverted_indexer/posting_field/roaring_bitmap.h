@@ -0,0 +1,136 @@
+#ifndef _LT_COMPONENT_ROARING_BITMAP_H_
+#define _LT_COMPONENT_ROARING_BITMAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace component {
+
+/* roaring style compressed bitmap of uint32
+ *
+ * values are grouped by high 16 bits into containers, a container keep
+ * the low 16 bits in the smallest form of:
+ *  array:  sorted uint16 values, cardinality <= 4096
+ *  bitmap: 1024 x uint64 words
+ *  run:    [start, length - 1] pairs, eg a full range
+ *
+ * bitmap-bitmap operations use AVX2 when the build enables it;
+ * call Optimize after build to pick the smallest containers
+ * */
+class RoaringBitmap {
+public:
+  static const uint32_t kArrayMaxSize = 4096;
+  static const uint32_t kBitmapWords = 1024;
+
+  class Iterator;
+
+  RoaringBitmap() {}
+
+  void Add(uint32_t value);
+
+  void Remove(uint32_t value);
+
+  bool Contains(uint32_t value) const;
+
+  // add all in [begin, end)
+  void AddRange(uint32_t begin, uint32_t end);
+
+  uint64_t Cardinality() const;
+
+  bool Empty() const { return containers_.empty(); }
+
+  void Clear();
+
+  // convert every container into its smallest form
+  void Optimize();
+
+  void UnionWith(const RoaringBitmap& other);
+
+  void IntersectWith(const RoaringBitmap& other);
+
+  void SubtractWith(const RoaringBitmap& other);
+
+  size_t MemoryUsage() const;
+
+  Iterator Begin() const;
+
+  template <typename Fn>
+  void ForEach(Fn fn) const {
+    for (size_t i = 0; i < containers_.size(); i++) {
+      const Container& c = containers_[i];
+      uint32_t high = uint32_t(keys_[i]) << 16;
+      if (c.type == kArray) {
+        for (uint16_t low : c.values) {
+          fn(high | low);
+        }
+      } else if (c.type == kRun) {
+        for (size_t r = 0; r < c.values.size(); r += 2) {
+          uint32_t start = c.values[r], last = start + c.values[r + 1];
+          for (uint32_t low = start; low <= last; low++) {
+            fn(high | low);
+          }
+        }
+      } else {
+        for (uint32_t w = 0; w < kBitmapWords; w++) {
+          for (uint64_t word = c.words[w]; word != 0; word &= word - 1) {
+            fn(high | (w << 6) | uint32_t(__builtin_ctzll(word)));
+          }
+        }
+      }
+    }
+  }
+
+private:
+  enum Type : uint8_t { kArray = 0, kBitmap = 1, kRun = 2 };
+
+  struct Container {
+    Type type = kArray;
+    uint32_t cardinality = 0;
+    // kArray: sorted values; kRun: [start, length - 1] pairs
+    std::vector<uint16_t> values;
+    // kBitmap only
+    std::vector<uint64_t> words;
+  };
+
+  friend class Iterator;
+  friend struct ContainerOps;
+
+  Container* GetOrCreate(uint16_t key);
+
+  int IndexOf(uint16_t key) const;
+
+  std::vector<uint16_t> keys_;
+
+  std::vector<Container> containers_;
+};
+
+// ascending values of a bitmap, bitmap must not change when iterating
+class RoaringBitmap::Iterator {
+public:
+  explicit Iterator(const RoaringBitmap* bitmap);
+
+  bool Valid() const { return valid_; }
+
+  uint32_t Value() const { return value_; }
+
+  void Next();
+
+private:
+  // position at first value >= low in current container
+  bool Seek(uint32_t low);
+
+  const RoaringBitmap* bitmap_;
+
+  size_t container_ = 0;
+
+  // kRun: index of the run holding value_
+  size_t run_ = 0;
+
+  bool valid_ = false;
+
+  uint32_t value_ = 0;
+};
+
+}  // namespace component
+#endif
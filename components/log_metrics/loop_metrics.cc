@@ -0,0 +1,125 @@
+#include "loop_metrics.h"
+
+#include <string.h>
+#include <unordered_map>
+#include <vector>
+
+#include "base/message_loop/message_loop.h"
+
+namespace component {
+
+const size_t LoopMetrics::kMaxLocations;
+
+namespace {
+
+struct LocationKey {
+  const void* owner;
+  const char* file;
+  const char* function;
+  int line;
+
+  bool operator==(const LocationKey& other) const {
+    return owner == other.owner && file == other.file &&
+           function == other.function && line == other.line;
+  }
+};
+
+struct LocationKeyHash {
+  size_t operator()(const LocationKey& key) const {
+    size_t h = std::hash<const void*>()(key.file);
+    h = h * 31 + std::hash<const void*>()(key.function);
+    h = h * 31 + std::hash<const void*>()(key.owner);
+    return h * 31 + key.line;
+  }
+};
+
+}  // namespace
+
+LoopMetrics::LoopMetrics(MetricsRegistry* registry)
+  : LoopMetrics(registry, Options()) {}
+
+LoopMetrics::LoopMetrics(MetricsRegistry* registry, const Options& options)
+  : base::LoopTracer(options),
+    registry_(registry) {}
+
+// static
+std::string LoopMetrics::LocationLabel(const base::Location& location) {
+  if (!location.has_source_info()) {
+    return "unknown";
+  }
+  const char* file = location.file_name();
+  const char* slash = strrchr(file, '/');
+  std::string label(location.function_name());
+  label.append("@").append(slash ? slash + 1 : file);
+  label.append(":").append(std::to_string(location.line_number()));
+  return label;
+}
+
+LoopMetrics::LoopEntry* LoopMetrics::EntryOf(const base::MessageLoop* loop) {
+  // a thread usually run only one loop
+  static thread_local std::vector<LoopEntry> entries;
+  for (LoopEntry& entry : entries) {
+    if (entry.owner == this && entry.loop == loop) {
+      return &entry;
+    }
+  }
+  MetricLabels labels = {{"loop", loop ? loop->LoopName() : "none"}};
+  LoopEntry entry;
+  entry.owner = this;
+  entry.loop = loop;
+  entry.queue_us = registry_->NewHistogram(
+      "loop_task_queue_us", "delay from post to run of loop tasks", labels);
+  entry.lag_us = registry_->NewHistogram(
+      "loop_lag_us", "lateness of the loop lag probe timer", labels);
+  entry.slow_tasks = registry_->NewCounter(
+      "loop_slow_tasks_total", "tasks or io events run too long", labels);
+  entries.push_back(entry);
+  return &entries.back();
+}
+
+Histogram* LoopMetrics::RunHistogramOf(const base::Location& location) {
+  static thread_local std::unordered_map<LocationKey, Histogram*,
+                                         LocationKeyHash> histograms;
+  LocationKey key = {this, location.file_name(), location.function_name(),
+                     location.line_number()};
+  auto iter = histograms.find(key);
+  if (iter != histograms.end()) {
+    return iter->second;
+  }
+  std::string label = LocationLabel(location);
+  {
+    std::lock_guard<std::mutex> guard(locations_mtx_);
+    if (locations_.size() >= kMaxLocations && !locations_.count(label)) {
+      label = "other";
+    } else {
+      locations_.insert(label);
+    }
+  }
+  Histogram* histogram = registry_->NewHistogram(
+      "loop_task_run_us", "run time of loop tasks by post location",
+      {{"location", label}});
+  histograms[key] = histogram;
+  return histogram;
+}
+
+void LoopMetrics::OnTaskRun(const base::MessageLoop* loop,
+                            const base::Location& location,
+                            int64_t queue_us,
+                            int64_t run_us) {
+  if (queue_us >= 0) {
+    EntryOf(loop)->queue_us->Record(queue_us);
+  }
+  RunHistogramOf(location)->Record(run_us);
+}
+
+void LoopMetrics::OnSlowTask(const base::MessageLoop* loop,
+                             const base::Location& location,
+                             int64_t run_us) {
+  EntryOf(loop)->slow_tasks->Inc();
+}
+
+void LoopMetrics::OnLoopLag(const base::MessageLoop* loop, int64_t lag_us) {
+  EntryOf(loop)->lag_us->Record(lag_us);
+}
+
+}  // namespace component
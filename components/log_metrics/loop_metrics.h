@@ -0,0 +1,71 @@
+#ifndef _COMPONENT_LOOP_METRICS_H_
+#define _COMPONENT_LOOP_METRICS_H_
+
+#include <mutex>
+#include <set>
+#include <string>
+
+#include "base/message_loop/loop_tracer.h"
+#include "metrics_registry.h"
+
+namespace component {
+
+/**
+ * LoopTracer feed message loop timing into MetricsRegistry, take effect
+ * only when ltio build with LTIO_WITH_LOOP_TRACE:
+ *
+ *  loop_task_queue_us{loop}       post to run delay of loop tasks
+ *  loop_task_run_us{location}     run time of tasks by post location
+ *  loop_lag_us{loop}              lateness of the lag probe timer
+ *  loop_slow_tasks_total{loop}    tasks/io events over slow_task_us
+ *
+ *  static LoopMetrics metrics(MetricsRegistry::Default());
+ *  base::SetLoopTracer(&metrics);
+ *
+ * metrics are registered at first hit and cached per thread,
+ * the hot path has no lock; locations over kMaxLocations share the
+ * series location="other"
+ * */
+class LoopMetrics : public base::LoopTracer {
+public:
+  static const size_t kMaxLocations = 256;
+
+  explicit LoopMetrics(MetricsRegistry* registry);
+  LoopMetrics(MetricsRegistry* registry, const Options& options);
+
+  void OnTaskRun(const base::MessageLoop* loop,
+                 const base::Location& location,
+                 int64_t queue_us,
+                 int64_t run_us) override;
+
+  void OnSlowTask(const base::MessageLoop* loop,
+                  const base::Location& location,
+                  int64_t run_us) override;
+
+  void OnLoopLag(const base::MessageLoop* loop, int64_t lag_us) override;
+
+  // "function@file:line" with file basename
+  static std::string LocationLabel(const base::Location& location);
+
+private:
+  struct LoopEntry {
+    const LoopMetrics* owner;
+    const base::MessageLoop* loop;
+    Histogram* queue_us;
+    Histogram* lag_us;
+    Counter* slow_tasks;
+  };
+
+  LoopEntry* EntryOf(const base::MessageLoop* loop);
+
+  Histogram* RunHistogramOf(const base::Location& location);
+
+  MetricsRegistry* registry_;
+
+  // labels of loop_task_run_us registered
+  std::mutex locations_mtx_;
+  std::set<std::string> locations_;
+};
+
+}  // namespace component
+#endif
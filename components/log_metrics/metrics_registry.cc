@@ -0,0 +1,428 @@
+#include "metrics_registry.h"
+
+#include <ctype.h>
+#include <glog/logging.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+#include "base/sys/thread_slot.h"
+
+namespace component {
+
+namespace {
+
+bool ValidName(const std::string& name) {
+  if (name.empty() || isdigit(name[0])) {
+    return false;
+  }
+  for (char c : name) {
+    if (!isalnum(c) && c != '_' && c != ':') {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string EscapeLabelValue(const std::string& value) {
+  std::string result;
+  for (char c : value) {
+    switch (c) {
+      case '\\':
+        result.append("\\\\");
+        break;
+      case '"':
+        result.append("\\\"");
+        break;
+      case '\n':
+        result.append("\\n");
+        break;
+      default:
+        result.push_back(c);
+    }
+  }
+  return result;
+}
+
+std::string RenderLabels(const MetricLabels& labels) {
+  std::string result;
+  for (const auto& kv : labels) {
+    CHECK(ValidName(kv.first)) << "bad label name:" << kv.first;
+    if (!result.empty()) {
+      result.push_back(',');
+    }
+    result.append(kv.first).append("=\"");
+    result.append(EscapeLabelValue(kv.second)).append("\"");
+  }
+  return result;
+}
+
+void WriteSample(std::ostringstream& oss,
+                 const std::string& name,
+                 const std::string& labels,
+                 const std::string& extra_label) {
+  oss << name;
+  if (!labels.empty() || !extra_label.empty()) {
+    oss << '{' << labels;
+    if (!labels.empty() && !extra_label.empty()) {
+      oss << ',';
+    }
+    oss << extra_label << '}';
+  }
+  oss << ' ';
+}
+
+}  // namespace
+
+// >>> counter
+Counter::Counter(uint32_t shards)
+  : shard_count_(shards), cells_(new Cell[shards]) {
+  static_assert(sizeof(Cell) == 64, "one cell per cache line");
+  for (uint32_t i = 0; i < shard_count_; i++) {
+    cells_[i].value.store(0, std::memory_order_relaxed);
+  }
+}
+
+void Counter::Inc(uint64_t n) {
+  cells_[base::ThreadSlot() % shard_count_].value.fetch_add(
+      n, std::memory_order_relaxed);
+}
+
+uint64_t Counter::Value() const {
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < shard_count_; i++) {
+    sum += cells_[i].value.load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+// >>> histogram snapshot
+HistogramSnapshot::HistogramSnapshot(uint32_t bits)
+  : precision_bits(bits), buckets(BucketCount(bits), 0) {}
+
+// static
+uint32_t HistogramSnapshot::BucketCount(uint32_t bits) {
+  return (Histogram::kMaxExponent - bits + 1) << bits;
+}
+
+// static
+uint32_t HistogramSnapshot::BucketIndex(uint32_t bits, int64_t value) {
+  if (value < (int64_t(1) << bits)) {
+    return value > 0 ? value : 0;
+  }
+  if (value >= (int64_t(1) << Histogram::kMaxExponent)) {
+    return BucketCount(bits) - 1;
+  }
+  uint32_t exponent = 63 - __builtin_clzll(value);
+  uint32_t shift = exponent - bits;
+  uint32_t sub = (value >> shift) - (uint64_t(1) << bits);
+  return ((shift + 1) << bits) + sub;
+}
+
+// static
+int64_t HistogramSnapshot::BucketHighest(uint32_t bits, uint32_t index) {
+  if (index < (uint32_t(1) << bits)) {
+    return index;
+  }
+  uint32_t shift = (index >> bits) - 1;
+  uint64_t sub = index & ((uint32_t(1) << bits) - 1);
+  int64_t lowest = (sub + (uint64_t(1) << bits)) << shift;
+  return lowest + (int64_t(1) << shift) - 1;
+}
+
+int64_t HistogramSnapshot::Percentile(double q) const {
+  if (count == 0) {
+    return 0;
+  }
+  q = std::min(std::max(q, 0.0), 1.0);
+  uint64_t rank = std::max<uint64_t>(1, std::ceil(q * count));
+  uint64_t seen = 0;
+  for (uint32_t i = 0; i < buckets.size(); i++) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return std::min(BucketHighest(precision_bits, i), max);
+    }
+  }
+  return max;
+}
+
+HistogramSnapshot HistogramSnapshot::Delta(
+    const HistogramSnapshot& before) const {
+  HistogramSnapshot delta(precision_bits);
+  delta.count = count - before.count;
+  delta.sum = sum - before.sum;
+  for (uint32_t i = 0; i < buckets.size(); i++) {
+    delta.buckets[i] = buckets[i] - before.buckets[i];
+    if (delta.buckets[i]) {
+      delta.max = BucketHighest(precision_bits, i);
+    }
+  }
+  delta.max = std::min(delta.max, max);
+  return delta;
+}
+
+// >>> histogram
+Histogram::Histogram(uint32_t shards, uint32_t precision_bits)
+  : precision_bits_(precision_bits),
+    bucket_count_(HistogramSnapshot::BucketCount(precision_bits)),
+    shard_count_(shards),
+    shards_(new Shard[shards]) {
+  static_assert(sizeof(Shard) == 128, "hot fields of shards apart");
+  for (uint32_t i = 0; i < shard_count_; i++) {
+    Shard& shard = shards_[i];
+    shard.sum.store(0, std::memory_order_relaxed);
+    shard.max.store(0, std::memory_order_relaxed);
+    shard.buckets.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+Histogram::~Histogram() {
+  for (uint32_t i = 0; i < shard_count_; i++) {
+    delete[] shards_[i].buckets.load(std::memory_order_relaxed);
+  }
+}
+
+std::atomic<uint64_t>* Histogram::BucketsOf(uint32_t index) {
+  Shard& shard = shards_[index];
+  std::atomic<uint64_t>* buckets =
+      shard.buckets.load(std::memory_order_acquire);
+  if (buckets) {
+    return buckets;
+  }
+  std::atomic<uint64_t>* fresh = new std::atomic<uint64_t>[bucket_count_];
+  for (uint32_t b = 0; b < bucket_count_; b++) {
+    fresh[b].store(0, std::memory_order_relaxed);
+  }
+  // threads of the same slot may race here
+  if (shard.buckets.compare_exchange_strong(buckets, fresh,
+                                            std::memory_order_acq_rel)) {
+    return fresh;
+  }
+  delete[] fresh;
+  return buckets;
+}
+
+void Histogram::Record(int64_t value) {
+  uint32_t slot = base::ThreadSlot() % shard_count_;
+  Shard& shard = shards_[slot];
+  uint32_t index = HistogramSnapshot::BucketIndex(precision_bits_, value);
+  BucketsOf(slot)[index].fetch_add(1, std::memory_order_relaxed);
+  shard.sum.fetch_add(value, std::memory_order_relaxed);
+
+  int64_t max = shard.max.load(std::memory_order_relaxed);
+  while (value > max &&
+         !shard.max.compare_exchange_weak(max, value,
+                                          std::memory_order_relaxed)) {
+  }
+}
+
+HistogramSnapshot Histogram::Snapshot() const {
+  HistogramSnapshot snapshot(precision_bits_);
+  for (uint32_t i = 0; i < shard_count_; i++) {
+    const Shard& shard = shards_[i];
+    const std::atomic<uint64_t>* buckets =
+        shard.buckets.load(std::memory_order_acquire);
+    if (!buckets) {
+      continue;
+    }
+    snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    snapshot.max =
+        std::max(snapshot.max, shard.max.load(std::memory_order_relaxed));
+    for (uint32_t b = 0; b < bucket_count_; b++) {
+      uint64_t v = buckets[b].load(std::memory_order_relaxed);
+      snapshot.buckets[b] += v;
+      snapshot.count += v;
+    }
+  }
+  return snapshot;
+}
+
+// >>> registry
+const uint32_t MetricsRegistry::kMaxShards;
+
+// static
+MetricsRegistry* MetricsRegistry::Default() {
+  static MetricsRegistry registry;
+  return &registry;
+}
+
+MetricsRegistry::MetricsRegistry() : MetricsRegistry(Options()) {}
+
+MetricsRegistry::MetricsRegistry(const Options& options) : options_(options) {
+  CHECK(options_.precision_bits >= 1 && options_.precision_bits <= 7);
+  shard_count_ = options_.shards;
+  if (shard_count_ == 0) {
+    shard_count_ = std::max(1u, std::thread::hardware_concurrency());
+  }
+  shard_count_ = std::min(shard_count_, kMaxShards);
+}
+
+MetricsRegistry::~MetricsRegistry() {
+  StopSync();
+}
+
+MetricsRegistry::Entry* MetricsRegistry::FindOrCreate(
+    Type type,
+    const std::string& name,
+    const std::string& help,
+    const MetricLabels& labels) {
+  CHECK(ValidName(name)) << "bad metric name:" << name;
+  std::string rendered = RenderLabels(labels);
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto& family = families_[name];
+  for (auto& entry : family) {
+    if (entry->labels == rendered) {
+      CHECK(entry->type == type) << "metric type conflict:" << name;
+      return entry.get();
+    }
+  }
+  CHECK(family.empty() || family.front()->type == type)
+      << "metric type conflict:" << name;
+
+  Entry* entry = new Entry();
+  entry->type = type;
+  entry->name = name;
+  entry->help = help;
+  entry->labels = rendered;
+  switch (type) {
+    case Type::kCounter:
+      entry->counter.reset(new Counter(shard_count_));
+      break;
+    case Type::kGauge:
+      entry->gauge.reset(new Gauge());
+      break;
+    case Type::kHistogram:
+      entry->histogram.reset(
+          new Histogram(shard_count_, options_.precision_bits));
+      break;
+  }
+  family.emplace_back(entry);
+  return entry;
+}
+
+Counter* MetricsRegistry::NewCounter(const std::string& name,
+                                     const std::string& help,
+                                     const MetricLabels& labels) {
+  return FindOrCreate(Type::kCounter, name, help, labels)->counter.get();
+}
+
+Gauge* MetricsRegistry::NewGauge(const std::string& name,
+                                 const std::string& help,
+                                 const MetricLabels& labels) {
+  return FindOrCreate(Type::kGauge, name, help, labels)->gauge.get();
+}
+
+Histogram* MetricsRegistry::NewHistogram(const std::string& name,
+                                         const std::string& help,
+                                         const MetricLabels& labels) {
+  return FindOrCreate(Type::kHistogram, name, help, labels)->histogram.get();
+}
+
+void MetricsRegistry::Start() {
+  std::lock_guard<std::mutex> guard(running_mutex_);
+  CHECK(!running_ && !collector_);
+  running_ = true;
+  collector_.reset(new std::thread(&MetricsRegistry::CollectMain, this));
+}
+
+void MetricsRegistry::StopSync() {
+  {
+    std::lock_guard<std::mutex> guard(running_mutex_);
+    running_ = false;
+  }
+  running_cv_.notify_all();
+  if (collector_ && collector_->joinable()) {
+    collector_->join();
+  }
+  collector_.reset();
+}
+
+void MetricsRegistry::CollectMain() {
+  std::unique_lock<std::mutex> lock(running_mutex_);
+  while (running_) {
+    running_cv_.wait_for(
+        lock, std::chrono::milliseconds(options_.collect_interval_ms),
+        [this]() { return !running_; });
+    if (!running_) {
+      break;
+    }
+    lock.unlock();
+    Collect();
+    lock.lock();
+  }
+}
+
+void MetricsRegistry::Collect() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto& family : families_) {
+    for (auto& entry : family.second) {
+      if (entry->type != Type::kHistogram) {
+        continue;
+      }
+      std::unique_ptr<HistogramSnapshot> current(
+          new HistogramSnapshot(entry->histogram->Snapshot()));
+      if (entry->last) {
+        entry->recent.reset(
+            new HistogramSnapshot(current->Delta(*entry->last)));
+      }
+      entry->last = std::move(current);
+    }
+  }
+}
+
+std::string MetricsRegistry::PrometheusText() {
+  std::ostringstream oss;
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto& family : families_) {
+    if (family.second.empty()) {
+      continue;
+    }
+    const Entry* first = family.second.front().get();
+    const std::string& name = family.first;
+
+    const char* type_name = "counter";
+    if (first->type == Type::kGauge) {
+      type_name = "gauge";
+    } else if (first->type == Type::kHistogram) {
+      type_name = "summary";
+    }
+    if (!first->help.empty()) {
+      oss << "# HELP " << name << ' ' << first->help << '\n';
+    }
+    oss << "# TYPE " << name << ' ' << type_name << '\n';
+
+    for (auto& entry : family.second) {
+      switch (entry->type) {
+        case Type::kCounter:
+          WriteSample(oss, name, entry->labels, "");
+          oss << entry->counter->Value() << '\n';
+          break;
+        case Type::kGauge:
+          WriteSample(oss, name, entry->labels, "");
+          oss << entry->gauge->Value() << '\n';
+          break;
+        case Type::kHistogram: {
+          HistogramSnapshot total = entry->histogram->Snapshot();
+          const HistogramSnapshot& window =
+              entry->recent ? *entry->recent : total;
+          for (double q : options_.quantiles) {
+            std::ostringstream quantile;
+            quantile << "quantile=\"" << q << "\"";
+            WriteSample(oss, name, entry->labels, quantile.str());
+            oss << window.Percentile(q) << '\n';
+          }
+          WriteSample(oss, name + "_sum", entry->labels, "");
+          oss << total.sum << '\n';
+          WriteSample(oss, name + "_count", entry->labels, "");
+          oss << total.count << '\n';
+        } break;
+      }
+    }
+  }
+  return oss.str();
+}
+
+}  // namespace component
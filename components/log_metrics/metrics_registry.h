@@ -0,0 +1,207 @@
+#ifndef _COMPONENT_METRICS_REGISTRY_H_
+#define _COMPONENT_METRICS_REGISTRY_H_
+
+#include <inttypes.h>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace component {
+
+/**
+ * preregistered metrics, the hot path has no lock and no allocation:
+ *
+ *  static Histogram* latency =
+ *    MetricsRegistry::Default()->NewHistogram("http_latency_us", "...");
+ *  latency->Record(cost_us);
+ *
+ * counter and histogram are sharded by thread slot(at most kMaxShards),
+ * every thread write its own cache line, buckets of a histogram shard
+ * allocated once a thread hit it; the collector thread(Start) merge shards
+ * every interval
+ * and keep the delta of last interval for quantiles, PrometheusText render
+ * all metrics in prometheus text exposition format
+ * */
+
+typedef std::map<std::string, std::string> MetricLabels;
+
+class MetricsRegistry;
+
+class Counter {
+public:
+  void Inc(uint64_t n = 1);
+  uint64_t Value() const;
+
+private:
+  friend class MetricsRegistry;
+  Counter(uint32_t shards);
+
+  // padding, hot values of two shards never share a cache line
+  struct Cell {
+    std::atomic<uint64_t> value;
+    char padding[56];
+  };
+  const uint32_t shard_count_;
+  std::unique_ptr<Cell[]> cells_;
+};
+
+class Gauge {
+public:
+  void Set(int64_t v) { value_.store(v, std::memory_order_relaxed); }
+  void Add(int64_t delta) {
+    value_.fetch_add(delta, std::memory_order_relaxed);
+  }
+  int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+  friend class MetricsRegistry;
+  Gauge() : value_(0) {}
+
+  std::atomic<int64_t> value_;
+};
+
+/**
+ * HDR style log-linear buckets: values < 2^p are exact, every power of
+ * two range above is split into 2^p sub buckets, relative error < 1/2^p;
+ * p = 4 => 6.25%, values are clamped to [0, 2^kMaxExponent)
+ * */
+class HistogramSnapshot {
+public:
+  explicit HistogramSnapshot(uint32_t precision_bits);
+
+  // q in [0, 1], the highest value of the bucket where the rank falls
+  int64_t Percentile(double q) const;
+  double Mean() const { return count ? double(sum) / count : 0; }
+
+  HistogramSnapshot Delta(const HistogramSnapshot& before) const;
+
+  static uint32_t BucketCount(uint32_t precision_bits);
+  static uint32_t BucketIndex(uint32_t precision_bits, int64_t value);
+  static int64_t BucketHighest(uint32_t precision_bits, uint32_t index);
+
+  uint32_t precision_bits;
+  uint64_t count = 0;
+  int64_t sum = 0;
+  int64_t max = 0;
+  std::vector<uint64_t> buckets;
+};
+
+class Histogram {
+public:
+  static const uint32_t kMaxExponent = 48;
+
+  ~Histogram();
+
+  void Record(int64_t value);
+
+  // merge all shards, cumulative since registered
+  HistogramSnapshot Snapshot() const;
+
+  uint32_t PrecisionBits() const { return precision_bits_; }
+
+private:
+  friend class MetricsRegistry;
+  Histogram(uint32_t shards, uint32_t precision_bits);
+
+  // buckets of shard, allocated at first record
+  std::atomic<uint64_t>* BucketsOf(uint32_t shard);
+
+  struct Shard {
+    std::atomic<int64_t> sum;
+    std::atomic<int64_t> max;
+    std::atomic<std::atomic<uint64_t>*> buckets;
+    char padding[104];
+  };
+
+  const uint32_t precision_bits_;
+  const uint32_t bucket_count_;
+  const uint32_t shard_count_;
+  std::unique_ptr<Shard[]> shards_;
+};
+
+class MetricsRegistry {
+public:
+  // a histogram shard is BucketCount(precision_bits) * 8 bytes
+  static const uint32_t kMaxShards = 16;
+
+  struct Options {
+    // 0: hardware_concurrency, capped by kMaxShards
+    uint32_t shards = 0;
+    uint32_t precision_bits = 4;
+    uint32_t collect_interval_ms = 10000;
+    // quantiles rendered for histogram
+    std::vector<double> quantiles = {0.5, 0.9, 0.99, 0.999};
+  };
+
+  static MetricsRegistry* Default();
+
+  MetricsRegistry();
+  explicit MetricsRegistry(const Options& options);
+  ~MetricsRegistry();
+
+  // same name + labels return the same metric; name must match
+  // [a-zA-Z_:][a-zA-Z0-9_:]*, register all metrics at startup
+  Counter* NewCounter(const std::string& name,
+                      const std::string& help,
+                      const MetricLabels& labels = {});
+  Gauge* NewGauge(const std::string& name,
+                  const std::string& help,
+                  const MetricLabels& labels = {});
+  Histogram* NewHistogram(const std::string& name,
+                          const std::string& help,
+                          const MetricLabels& labels = {});
+
+  // start/stop the collector thread
+  void Start();
+  void StopSync();
+
+  // merge once, called by collector thread every interval
+  void Collect();
+
+  // histograms render as summary, quantiles from the last collect
+  // interval(cumulative before first collect), _sum/_count cumulative
+  std::string PrometheusText();
+
+private:
+  enum class Type { kCounter, kGauge, kHistogram };
+
+  struct Entry {
+    Type type;
+    std::string name;
+    std::string help;
+    std::string labels;  // rendered: k1="v1",k2="v2"
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+    // collector state
+    std::unique_ptr<HistogramSnapshot> last;
+    std::unique_ptr<HistogramSnapshot> recent;
+  };
+
+  Entry* FindOrCreate(Type type,
+                      const std::string& name,
+                      const std::string& help,
+                      const MetricLabels& labels);
+
+  void CollectMain();
+
+  const Options options_;
+  uint32_t shard_count_;
+
+  std::mutex mutex_;
+  // sorted by name, so a metric family render together
+  std::map<std::string, std::vector<std::unique_ptr<Entry>>> families_;
+
+  bool running_ = false;
+  std::mutex running_mutex_;
+  std::condition_variable running_cv_;
+  std::unique_ptr<std::thread> collector_;
+};
+
+}  // namespace component
+#endif
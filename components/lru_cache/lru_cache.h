@@ -1,6 +1,7 @@
 #ifndef LT_COMPONENT_LRU_CACHE_H
 #define LT_COMPONENT_LRU_CACHE_H
 
+#include <stddef.h>
 #include <list>
 #include <unordered_map>
 #include <utility>
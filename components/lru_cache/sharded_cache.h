@@ -0,0 +1,442 @@
+#ifndef LT_COMPONENT_SHARDED_CACHE_H
+#define LT_COMPONENT_SHARDED_CACHE_H
+
+#include <inttypes.h>
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/time/time_utils.h"
+
+namespace component {
+
+namespace __detail {
+
+/**
+ * tiny count-min sketch for tinylfu admission, 4 rows of 8bits counters
+ * saturated at 15; all counters are halved when samples reach 10 * width,
+ * so history frequency fade out
+ * */
+class FrequencySketch {
+public:
+  explicit FrequencySketch(size_t width) {
+    size_t w = 16;
+    while (w < width && w < (1UL << 24)) {
+      w <<= 1;
+    }
+    mask_ = w - 1;
+    sample_limit_ = w * 10;
+    table_.assign(w * kDepth, 0);
+  }
+
+  void Increment(uint64_t hash) {
+    for (size_t i = 0; i < kDepth; i++) {
+      uint8_t& c = table_[IndexOf(hash, i)];
+      if (c < 15) {
+        c++;
+      }
+    }
+    if (++samples_ >= sample_limit_) {
+      for (auto& c : table_) {
+        c >>= 1;
+      }
+      samples_ /= 2;
+    }
+  }
+
+  uint8_t Frequency(uint64_t hash) const {
+    uint8_t freq = 15;
+    for (size_t i = 0; i < kDepth; i++) {
+      freq = std::min(freq, table_[IndexOf(hash, i)]);
+    }
+    return freq;
+  }
+
+private:
+  static const size_t kDepth = 4;
+
+  size_t IndexOf(uint64_t hash, size_t row) const {
+    static const uint64_t kSeeds[kDepth] = {
+        0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+        0xcbf29ce484222325ULL};
+    uint64_t h = (hash ^ (hash >> 29)) * kSeeds[row];
+    return row * (mask_ + 1) + ((h >> 32) & mask_);
+  }
+
+  size_t mask_ = 0;
+  size_t samples_ = 0;
+  size_t sample_limit_ = 0;
+  std::vector<uint8_t> table_;
+};
+
+}  // namespace __detail
+
+/**
+ * concurrent cache shared by io/worker loops
+ *
+ * - N shards, each has its own lock and W-TinyLFU policy: a small LRU
+ *   window(1% of capacity) in front of a segmented LRU(probation/protected),
+ *   a entry evicted from window only enter main space when it's more
+ *   frequent than the main's victim, one-hit keys can't flush hot ones
+ * - capacity is counted by `charge`, use bytes size to be memory aware
+ * - ttl_ms expire lazily, a expired entry is removed when touched
+ *
+ * V is copied out under shard lock, use shared_ptr for big value
+ * */
+template <typename K, typename V, typename Hash = std::hash<K>>
+class ShardedCache {
+public:
+  struct Options {
+    // total charge of all shards
+    size_t capacity = 1024;
+    // power of 2
+    uint32_t shards = 64;
+    // percentage of capacity for admission window
+    double window_percent = 0.01;
+    // percentage of main space for protected segment
+    double protected_percent = 0.8;
+    // size the frequency sketch, 0: capacity(charge of every entry is 1)
+    size_t expected_entries = 0;
+  };
+
+  struct Stats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t inserts = 0;
+    uint64_t evictions = 0;
+    uint64_t expirations = 0;
+    // rejected by tinylfu admission
+    uint64_t rejections = 0;
+    uint64_t entries = 0;
+    uint64_t charge = 0;
+
+    double HitRate() const {
+      uint64_t total = hits + misses;
+      return total ? double(hits) / total : 0;
+    }
+  };
+
+  explicit ShardedCache(const Options& options) : hasher_() {
+    uint32_t count = 1;
+    while (count < options.shards) {
+      count <<= 1;
+    }
+    // fewer shards for a small cache, a shard holds at least one window
+    // and one main entry, more shards than that inflate the total capacity
+    while (count > 1 && count * 2 > options.capacity) {
+      count >>= 1;
+    }
+    shard_mask_ = count - 1;
+    size_t per_shard = std::max<size_t>(1, options.capacity / count);
+    size_t entries = options.expected_entries ? options.expected_entries
+                                              : options.capacity;
+    size_t sketch_width = entries / count;
+    for (uint32_t i = 0; i < count; i++) {
+      shards_.emplace_back(new Shard(per_shard, sketch_width, options));
+    }
+  }
+
+  // return false when rejected: charge larger than shard capacity or
+  // it's not frequent enough to evict others
+  bool Put(const K& key, V value, size_t charge = 1, int64_t ttl_ms = 0) {
+    uint64_t hash = hasher_(key);
+    int64_t expire_at = ttl_ms > 0 ? base::time_ms() + ttl_ms : 0;
+    Shard* shard = ShardOf(hash);
+    std::lock_guard<std::mutex> guard(shard->lock);
+    return shard->Put(key, hash, std::move(value), charge, expire_at);
+  }
+
+  bool Get(const K& key, V* value) {
+    uint64_t hash = hasher_(key);
+    Shard* shard = ShardOf(hash);
+    std::lock_guard<std::mutex> guard(shard->lock);
+    return shard->Get(key, hash, value);
+  }
+
+  bool Exists(const K& key) {
+    uint64_t hash = hasher_(key);
+    Shard* shard = ShardOf(hash);
+    std::lock_guard<std::mutex> guard(shard->lock);
+    return shard->Exists(key);
+  }
+
+  bool Remove(const K& key) {
+    uint64_t hash = hasher_(key);
+    Shard* shard = ShardOf(hash);
+    std::lock_guard<std::mutex> guard(shard->lock);
+    return shard->Remove(key);
+  }
+
+  void Clear() {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> guard(shard->lock);
+      shard->Clear();
+    }
+  }
+
+  Stats GetStats() const {
+    Stats result;
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> guard(shard->lock);
+      const Stats& s = shard->stats;
+      result.hits += s.hits;
+      result.misses += s.misses;
+      result.inserts += s.inserts;
+      result.evictions += s.evictions;
+      result.expirations += s.expirations;
+      result.rejections += s.rejections;
+      result.entries += shard->entries.size();
+      result.charge += shard->window_charge + shard->MainCharge();
+    }
+    return result;
+  }
+
+  size_t size() const { return GetStats().entries; }
+
+private:
+  enum Region { kWindow, kProbation, kProtected };
+
+  struct Entry {
+    K key;
+    V value;
+    uint64_t hash;
+    size_t charge;
+    int64_t expire_at;
+    Region region;
+  };
+  typedef std::list<Entry> EntryList;
+  typedef typename EntryList::iterator EntryIter;
+
+  struct Shard {
+    Shard(size_t capacity, size_t sketch_width, const Options& options)
+      : sketch(sketch_width) {
+      window_capacity =
+          std::max<size_t>(1, capacity * options.window_percent);
+      main_capacity =
+          capacity > window_capacity ? capacity - window_capacity : 0;
+      protected_capacity = main_capacity * options.protected_percent;
+    }
+
+    bool Put(const K& key, uint64_t hash, V&& value, size_t charge,
+             int64_t expire_at) {
+      sketch.Increment(hash);
+      if (charge > window_capacity + main_capacity) {
+        stats.rejections++;
+        return false;
+      }
+
+      auto iter = entries.find(key);
+      if (iter != entries.end()) {
+        EntryIter e = iter->second;
+        ChargeOf(e->region) += charge;
+        ChargeOf(e->region) -= e->charge;
+        e->value = std::move(value);
+        e->charge = charge;
+        e->expire_at = expire_at;
+        Touch(e);
+        Rebalance();
+        return entries.find(key) != entries.end();
+      }
+
+      stats.inserts++;
+      window.push_front(Entry{key, std::move(value), hash, charge, expire_at,
+                              kWindow});
+      entries[key] = window.begin();
+      window_charge += charge;
+      Rebalance();
+      return entries.find(key) != entries.end();
+    }
+
+    bool Get(const K& key, uint64_t hash, V* value) {
+      sketch.Increment(hash);
+      auto iter = entries.find(key);
+      if (iter == entries.end()) {
+        stats.misses++;
+        return false;
+      }
+      EntryIter e = iter->second;
+      if (Expired(e)) {
+        stats.expirations++;
+        stats.misses++;
+        Erase(e);
+        return false;
+      }
+      stats.hits++;
+      *value = e->value;
+      Touch(e);
+      Rebalance();
+      return true;
+    }
+
+    bool Exists(const K& key) {
+      auto iter = entries.find(key);
+      if (iter == entries.end()) {
+        return false;
+      }
+      if (Expired(iter->second)) {
+        stats.expirations++;
+        Erase(iter->second);
+        return false;
+      }
+      return true;
+    }
+
+    bool Remove(const K& key) {
+      auto iter = entries.find(key);
+      if (iter == entries.end()) {
+        return false;
+      }
+      Erase(iter->second);
+      return true;
+    }
+
+    void Clear() {
+      entries.clear();
+      window.clear();
+      probation.clear();
+      protecteds.clear();
+      window_charge = probation_charge = protected_charge = 0;
+    }
+
+    size_t MainCharge() const { return probation_charge + protected_charge; }
+
+    bool Expired(EntryIter e) const {
+      return e->expire_at && e->expire_at <= base::time_ms();
+    }
+
+    size_t& ChargeOf(Region region) {
+      switch (region) {
+        case kWindow:
+          return window_charge;
+        case kProbation:
+          return probation_charge;
+        default:
+          break;
+      }
+      return protected_charge;
+    }
+
+    EntryList& ListOf(Region region) {
+      switch (region) {
+        case kWindow:
+          return window;
+        case kProbation:
+          return probation;
+        default:
+          break;
+      }
+      return protecteds;
+    }
+
+    void MoveTo(EntryIter e, Region region) {
+      ChargeOf(e->region) -= e->charge;
+      ChargeOf(region) += e->charge;
+      ListOf(region).splice(ListOf(region).begin(), ListOf(e->region), e);
+      e->region = region;
+    }
+
+    // window/protected: move to front; probation: promote to protected
+    void Touch(EntryIter e) {
+      Region region = e->region == kProbation ? kProtected : e->region;
+      MoveTo(e, region);
+    }
+
+    void Erase(EntryIter e) {
+      ChargeOf(e->region) -= e->charge;
+      entries.erase(e->key);
+      ListOf(e->region).erase(e);
+    }
+
+    void Evict(EntryIter e) {
+      stats.evictions++;
+      Erase(e);
+    }
+
+    void Rebalance() {
+      // protected overflow demote to probation
+      while (protected_charge > protected_capacity && !protecteds.empty()) {
+        MoveTo(std::prev(protecteds.end()), kProbation);
+      }
+
+      // window overflow, the candidate compete with main's victim
+      while (window_charge > window_capacity && !window.empty()) {
+        EntryIter candidate = std::prev(window.end());
+        if (Expired(candidate)) {
+          stats.expirations++;
+          Erase(candidate);
+          continue;
+        }
+        uint8_t freq = sketch.Frequency(candidate->hash);
+
+        bool admit = candidate->charge <= main_capacity;
+        while (admit && MainCharge() + candidate->charge > main_capacity) {
+          EntryList& list = probation.empty() ? protecteds : probation;
+          if (list.empty()) {
+            break;
+          }
+          EntryIter victim = std::prev(list.end());
+          if (Expired(victim)) {
+            stats.expirations++;
+            Erase(victim);
+            continue;
+          }
+          if (freq <= sketch.Frequency(victim->hash)) {
+            admit = false;
+            break;
+          }
+          Evict(victim);
+        }
+
+        if (admit) {
+          MoveTo(candidate, kProbation);
+        } else {
+          stats.rejections++;
+          Erase(candidate);
+        }
+      }
+
+      // a updated entry may grow bigger than main space
+      while (MainCharge() > main_capacity) {
+        EntryList& list = probation.empty() ? protecteds : probation;
+        Evict(std::prev(list.end()));
+      }
+    }
+
+    mutable std::mutex lock;
+
+    __detail::FrequencySketch sketch;
+    std::unordered_map<K, EntryIter, Hash> entries;
+
+    EntryList window;
+    EntryList probation;
+    EntryList protecteds;
+
+    size_t window_capacity = 0;
+    size_t main_capacity = 0;
+    size_t protected_capacity = 0;
+
+    size_t window_charge = 0;
+    size_t probation_charge = 0;
+    size_t protected_charge = 0;
+
+    Stats stats;
+  };
+
+  Shard* ShardOf(uint64_t hash) const {
+    // std::hash of integer is identity, mix before pick shard
+    uint64_t h = (hash ^ (hash >> 31)) * 0x9E3779B97F4A7C15ULL;
+    return shards_[(h >> 40) & shard_mask_].get();
+  }
+
+  Hash hasher_;
+  uint32_t shard_mask_ = 0;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+}  // end namespace component
+#endif
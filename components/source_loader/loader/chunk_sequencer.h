@@ -0,0 +1,44 @@
+#ifndef LT_COMPONENT_SOURCELOADER_CHUNK_SEQUENCER_H
+#define LT_COMPONENT_SOURCELOADER_CHUNK_SEQUENCER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace component {
+namespace sl {
+
+/* deliver results of chunks parsed by loader threads one at a time;
+ * ordered: in chunk index order, a thread wait the chunks before it,
+ * chunks must be taken by threads in index order(FileLoader does)
+ * unordered: in the order they finished */
+class ChunkSequencer {
+public:
+  void Reset(bool ordered) {
+    std::lock_guard<std::mutex> lck(mtx_);
+    ordered_ = ordered;
+    next_ = 0;
+  }
+
+  void Deliver(size_t index, const std::function<void()>& fn) {
+    std::unique_lock<std::mutex> lck(mtx_);
+    if (ordered_) {
+      cv_.wait(lck, [this, index]() { return next_ == index; });
+    }
+    fn();
+    next_++;
+    if (ordered_) {
+      cv_.notify_all();
+    }
+  }
+
+private:
+  std::mutex mtx_;
+  std::condition_variable cv_;
+  bool ordered_ = true;
+  size_t next_ = 0;
+};
+
+}  // namespace sl
+}  // namespace component
+#endif
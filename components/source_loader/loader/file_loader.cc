@@ -1,10 +1,14 @@
 
 #include "file_loader.h"
 #include <stdio.h>
-#include <fstream>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
 #include "base/logging.h"
-#include "base/memory/scoped_guard.h"
 #include "glog/logging.h"
+#include "mapped_file.h"
 
 namespace component {
 namespace sl {
@@ -26,48 +30,155 @@ int FileLoader::Load() {
   VLOG(VTRACE) << __FUNCTION__ << " Enter, source count:" << files_.size();
 
   int result = 0;
+  if (parser_content_mode_ == "line") {
+    result = LoadLines();
+  } else if (parser_content_mode_ == "content") {
+    result = LoadContent();
+  } else {
+    LOG(ERROR) << "not supported mode to read file:" << parser_content_mode_;
+    result = -1;
+  }
 
-  std::ifstream ifs;
+  watcher_->OnFinish(result);
+  VLOG(VTRACE) << __FUNCTION__ << " Leave with result :" << result;
+  return result;
+}
 
+int FileLoader::LoadLines() {
+  std::vector<std::unique_ptr<MappedFile>> mapped_files;
+  std::vector<LoadChunk> chunks;
+  loaded_.clear();
   for (auto& file : files_) {
-    ifs.open(file);
-    if (!ifs.is_open()) {
+    std::unique_ptr<MappedFile> mapped(new MappedFile());
+    if (!mapped->Open(file)) {
       LOG(ERROR) << __FUNCTION__ << " file [" << file
                  << "] can't be open correctly";
       continue;
     }
+    // appending: complete lines only, a partial last line left to
+    // LoadAppended
+    const char* data = mapped->Data();
+    size_t size = mapped->Size();
+    if (append_ && size > 0) {
+      const char* eol =
+          static_cast<const char*>(::memrchr(data, '\n', size));
+      size = eol ? eol + 1 - data : 0;
+    }
+    SplitChunks(data, size, &chunks);
+    loaded_[file] = MakeState(mapped->Inode(), data, size);
+    mapped_files.push_back(std::move(mapped));
+  }
+  LoadChunks(chunks);
+  return 0;
+}
+
+int FileLoader::LoadAppended() {
+  if (parser_content_mode_ != "line" || !append_) {
+    return -1;
+  }
+  VLOG(VTRACE) << __FUNCTION__ << " Enter, source count:" << files_.size();
 
-    {
-      base::ScopedGuard guard([&]() { ifs.close(); });
-
-      if (parser_content_mode_ == "line") {
-        std::string line;
-
-        while (!ifs.eof()) {
-          std::getline(ifs, line);
-          watcher_->OnReadData(line);
-        };
-      } else if (parser_content_mode_ == "content") {
-        std::string content;
-
-        ifs.seekg(0, std::ios::end);
-        content.reserve(ifs.tellg());
-        ifs.seekg(0, std::ios::beg);
-        content.assign((std::istreambuf_iterator<char>(ifs)),
-                       std::istreambuf_iterator<char>());
-
-        watcher_->OnReadData(content);
-      } else {
-        LOG(ERROR) << "not supported mode to read file:[" << file << "]";
-        result = -1;
-        break;
-      }
+  std::vector<std::unique_ptr<MappedFile>> mapped_files;
+  std::vector<LoadChunk> chunks;
+  std::map<std::string, FileState> loaded;
+  // check all files before loading any
+  for (auto& file : files_) {
+    auto iter = loaded_.find(file);
+    std::unique_ptr<MappedFile> mapped(new MappedFile());
+    if (iter == loaded_.end() || !mapped->Open(file)) {
+      return -1;
+    }
+    const FileState& state = iter->second;
+    const char* data = mapped->Data();
+    if (mapped->Inode() != state.inode || mapped->Size() < state.size ||
+        state.tail.compare(0, state.tail.size(),
+                           data + state.size - state.tail.size(),
+                           state.tail.size()) != 0) {
+      LOG(INFO) << __FUNCTION__ << " file [" << file << "] rewritten";
+      return -1;
     }
+    // complete lines only, the last one may be writing
+    size_t size = state.size;
+    const char* eol = mapped->Size() == size
+                          ? nullptr
+                          : static_cast<const char*>(::memrchr(
+                                data + size, '\n', mapped->Size() - size));
+    if (eol != nullptr) {
+      SplitChunks(data + size, eol + 1 - (data + size), &chunks);
+      size = eol + 1 - data;
+    }
+    loaded[file] = MakeState(mapped->Inode(), data, size);
+    mapped_files.push_back(std::move(mapped));
   }
+  LoadChunks(chunks);
+  loaded_.swap(loaded);
 
-  watcher_->OnFinish(result);
-  VLOG(VTRACE) << __FUNCTION__ << " Leave with result :" << result;
-  return result;
+  watcher_->OnFinish(0);
+  VLOG(VTRACE) << __FUNCTION__ << " Leave, chunks:" << chunks.size();
+  return 0;
+}
+
+void FileLoader::LoadChunks(const std::vector<LoadChunk>& chunks) {
+  // chunks taken in index order, ChunkSequencer depend on it
+  std::atomic<size_t> next(0);
+  auto load_chunks = [&]() {
+    for (size_t i = next++; i < chunks.size(); i = next++) {
+      watcher_->OnReadChunk(chunks[i]);
+    }
+  };
+  size_t threads = std::min<size_t>(threads_, chunks.size());
+  std::vector<std::thread> loaders;
+  for (size_t i = 1; i < threads; i++) {
+    loaders.emplace_back(load_chunks);
+  }
+  load_chunks();
+  for (auto& loader : loaders) {
+    loader.join();
+  }
+}
+
+// static
+FileLoader::FileState FileLoader::MakeState(uint64_t inode,
+                                            const char* data,
+                                            size_t size) {
+  const size_t kTailSize = 64;
+  FileState state;
+  state.inode = inode;
+  state.size = size;
+  size_t tail = size < kTailSize ? size : kTailSize;
+  state.tail.assign(data + size - tail, tail);
+  return state;
+}
+
+int FileLoader::LoadContent() {
+  for (auto& file : files_) {
+    MappedFile mapped;
+    if (!mapped.Open(file)) {
+      LOG(ERROR) << __FUNCTION__ << " file [" << file
+                 << "] can't be open correctly";
+      continue;
+    }
+    watcher_->OnReadData(std::string(mapped.Data(), mapped.Size()));
+  }
+  return 0;
+}
+
+void FileLoader::SplitChunks(const char* data,
+                             size_t size,
+                             std::vector<LoadChunk>* out) {
+  size_t begin = 0;
+  while (begin < size) {
+    size_t end = begin + chunk_size_;
+    if (end >= size) {
+      end = size;
+    } else {
+      const char* eol = static_cast<const char*>(
+          ::memchr(data + end - 1, '\n', size - end + 1));
+      end = eol ? (eol - data + 1) : size;
+    }
+    out->push_back({out->size(), data + begin, end - begin});
+    begin = end;
+  }
 }
 
 bool FileLoader::ParseAndCheckConfig() {
@@ -94,6 +205,9 @@ bool FileLoader::ParseAndCheckConfig() {
     }
     files_.push_back(file);
   }
+  threads_ = std::max(1, config_.value("threads", 1));
+  chunk_size_ = std::max<size_t>(4096, config_.value("chunk_size", chunk_size_));
+  append_ = config_.value("append", false);
   return true;
 }
 
@@ -1,6 +1,7 @@
 #ifndef LT_COMPONENT_ROW_FILE_READER_H
 #define LT_COMPONENT_ROW_FILE_READER_H
 
+#include <map>
 #include <string>
 #include <vector>
 #include "loader.h"
@@ -8,6 +9,21 @@
 namespace component {
 namespace sl {
 
+/* "loader": {
+ *   "type": "file",
+ *   "threads": 8,         // parallel line loading, default 1: in Load thread
+ *   "chunk_size": 16777216,  // bytes of a line aligned chunk
+ *   "ordered": true,      // chunks delivered in order, see ChunkSequencer
+ *   "append": false,      // set by SourceReloader for append reloading
+ *   "resources": [{"path": "./data_file_test.txt"}]
+ * }
+ * files are mmap'ed; in line mode each file split into chunks, handed to
+ * LoaderDelegate::OnReadChunk by the threads
+ *
+ * with "append", only lines ended by '\n' are loaded, a partial last line
+ * is taken as being written and loaded by LoadAppended once completed;
+ * LoadAppended load complete lines appended to the files, a file
+ * replaced or truncated fail it */
 class FileLoader : public Loader {
 public:
   FileLoader(LoaderDelegate* watcher, Json reader_config);
@@ -15,11 +31,39 @@ public:
 
   int Initialize() override;
   int Load() override;
+  int LoadAppended() override;
 
 private:
+  struct FileState {
+    uint64_t inode = 0;
+    // bytes loaded
+    size_t size = 0;
+    // bytes before size, check it's not rewritten
+    std::string tail;
+  };
+
   bool ParseAndCheckConfig();
+
+  int LoadLines();
+
+  // by threads_
+  void LoadChunks(const std::vector<LoadChunk>& chunks);
+
+  static FileState MakeState(uint64_t inode, const char* data, size_t size);
+
+  int LoadContent();
+
+  // append line aligned chunks of data
+  void SplitChunks(const char* data, size_t size, std::vector<LoadChunk>* out);
+
   std::string parse_mode_;
   std::vector<std::string> files_;
+  uint32_t threads_ = 1;
+  size_t chunk_size_ = 16 << 20;
+  // partial last line held back for LoadAppended
+  bool append_ = false;
+  // files loaded in line mode
+  std::map<std::string, FileState> loaded_;
 };
 
 }  // namespace sl
@@ -2,6 +2,7 @@
 #define LT_COMPONENT_SOURCELOADER_READER_H
 
 #include <cinttypes>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <thirdparty/nlohmann/json.hpp>
@@ -11,11 +12,32 @@ namespace sl {
 
 using Json = nlohmann::json;
 
+// line aligned piece of the loading data
+struct LoadChunk {
+  // sequence in a whole Load, from 0
+  size_t index;
+  const char* data;
+  size_t size;
+};
+
 class LoaderDelegate {
 public:
   virtual void OnStart(){};
   virtual void OnFinish(int code){};
   virtual void OnReadData(const std::string& data) = 0;
+
+  // called by loader threads concurrently when loading in parallel,
+  // default deliver it line by line with OnReadData
+  virtual void OnReadChunk(const LoadChunk& chunk) {
+    const char* end = chunk.data + chunk.size;
+    for (const char* line = chunk.data; line < end;) {
+      const char* eol = static_cast<const char*>(
+          ::memchr(line, '\n', end - line));
+      eol = eol ? eol : end;
+      OnReadData(std::string(line, eol));
+      line = eol + 1;
+    }
+  }
 };
 
 class Loader {
@@ -26,10 +48,17 @@ public:
 
   virtual int Initialize() { return 0; };
   virtual int Load() { return 0; }
+
+  // load data appended since last Load(eg: lines appended to files),
+  // -1 when not supported or can't, a full Load needed
+  virtual int LoadAppended() { return -1; }
   void SetParserContentMode(const std::string& mode) {
     parser_content_mode_ = mode;
   };
 
+  // chunks delivered in order when loading in parallel, config "ordered"
+  bool OrderedDelivery() const { return config_.value("ordered", true); }
+
 protected:
   Json config_;
   LoaderDelegate* watcher_;
@@ -3,6 +3,7 @@
 //
 
 #include "components/source_loader/loader/loader_factory.h"
+#include <map>
 #include "file_loader.h"
 #include "glog/logging.h"
 
@@ -10,6 +11,12 @@ namespace component {
 namespace sl {
 
 static base::LazyInstance<LoaderFactory> loader_instance = LAZY_INSTANCE_INIT;
+static std::map<std::string, LoaderCreator> g_loader_creator;
+
+void RegisterLoaderCreator(const std::string& type, LoaderCreator creator) {
+  g_loader_creator[type] = creator;
+}
+
 // static
 LoaderFactory& LoaderFactory::Instance() {
   return loader_instance.get();
@@ -17,8 +24,11 @@ LoaderFactory& LoaderFactory::Instance() {
 
 Loader* LoaderFactory::CreateLoader(LoaderDelegate* d, const Json& conf) {
   const std::string& type = conf.at("type").get<std::string>();
+  auto iter = g_loader_creator.find(type);
   if (type == "file") {
     return new FileLoader(d, conf);
+  } else if (iter != g_loader_creator.end()) {
+    return iter->second(d, conf);
   } else {
     LOG(ERROR) << "loader type [" << type << "] not supported, conf:" << conf;
     CHECK(false);
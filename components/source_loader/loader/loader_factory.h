@@ -6,12 +6,18 @@
 #define LIGHTINGIO_READER_FACTORY_H
 
 #include <base/memory/lazy_instance.h>
+#include <functional>
 #include <string>
 #include "components/source_loader/loader/loader.h"
 
 namespace component {
 namespace sl {
 
+typedef std::function<Loader*(LoaderDelegate*, const Json&)> LoaderCreator;
+
+// loaders out of components(eg: mysql in integration) register themself
+void RegisterLoaderCreator(const std::string& type, LoaderCreator creator);
+
 class LoaderFactory {
 public:
   static LoaderFactory& Instance();
@@ -0,0 +1,57 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+
+namespace component {
+namespace sl {
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+bool MappedFile::Open(const std::string& path) {
+  Close();
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOG(ERROR) << __FUNCTION__ << " open file failed:" << path;
+    return false;
+  }
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    LOG(ERROR) << __FUNCTION__ << " stat file failed:" << path;
+    ::close(fd);
+    return false;
+  }
+  inode_ = st.st_ino;
+  if (st.st_size == 0) {
+    ::close(fd);
+    return true;
+  }
+  void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) {
+    LOG(ERROR) << __FUNCTION__ << " mmap file failed:" << path;
+    return false;
+  }
+  ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+  data_ = static_cast<const char*>(addr);
+  size_ = st.st_size;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  inode_ = 0;
+}
+
+}  // namespace sl
+}  // namespace component
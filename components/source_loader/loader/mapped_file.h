@@ -0,0 +1,41 @@
+#ifndef LT_COMPONENT_SOURCELOADER_MAPPED_FILE_H
+#define LT_COMPONENT_SOURCELOADER_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "base/lt_micro.h"
+
+namespace component {
+namespace sl {
+
+// whole file mapped read only, pages read in by the kernel ahead of use
+class MappedFile {
+public:
+  MappedFile() {}
+  ~MappedFile();
+
+  bool Open(const std::string& path);
+
+  void Close();
+
+  const char* Data() const { return data_; }
+
+  size_t Size() const { return size_; }
+
+  uint64_t Inode() const { return inode_; }
+
+private:
+  const char* data_ = nullptr;
+
+  size_t size_ = 0;
+
+  uint64_t inode_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFile);
+};
+
+}  // namespace sl
+}  // namespace component
+#endif
@@ -3,27 +3,31 @@
 //
 
 #include "mysql_loader.h"
-#include <cppconn/connection.h>
-#include <cppconn/exception.h>
-#include <driver.h>
-#include <mysql_connection.h>
-#include <sstream>
+#include <future>
+#include <memory>
+#include "async_mysql/mysql_pool.h"
+#include "base/logging.h"
+#include "base/message_loop/message_loop.h"
+#include "base/utils/string/str_utils.h"
 #include "glog/logging.h"
+#include "loader_factory.h"
 
 namespace component {
 namespace sl {
 
-void to_json(const MysqlConfig& c, Json& out) {
+void to_json(Json& out, const MysqlConfig& c) {
   out["port"] = c.port;
   out["host"] = c.host;
   out["database"] = c.db;
   out["user"] = c.user;
   out["password"] = c.password;
   out["sql_query"] = c.query;
+  out["timeout"] = c.timeout;
 }
 void from_json(const Json& j, MysqlConfig& c) {
   if (!j.is_object()) {
     c.SetNull(true);
+    return;
   }
   try {
     c.host = j.at("host");
@@ -32,12 +36,19 @@ void from_json(const Json& j, MysqlConfig& c) {
     c.user = j.at("user");
     c.password = j.at("password");
     c.query = j.at("sql_query");
+    c.timeout = j.value("timeout", c.timeout);
     c.SetNull(false);
   } catch (...) {
     c.SetNull(true);
   }
 }
 
+void RegisterMysqlLoader() {
+  RegisterLoaderCreator("mysql", [](LoaderDelegate* d, const Json& conf) {
+    return new MysqlLoader(d, conf);
+  });
+}
+
 MysqlLoader::MysqlLoader(LoaderDelegate* watcher, const Json& reader_config)
   : Loader(watcher, reader_config) {}
 MysqlLoader::~MysqlLoader() {}
@@ -49,13 +60,16 @@ int MysqlLoader::Initialize() {
   }
   int result = -1;
   do {
-    Json resources = config_.value("resources", "");
+    delimiter_ = config_.value("delimiter", "\t");
+    Json resources = config_.value("resources", Json());
     if (!resources.is_array()) {
       break;
     }
     for (Json::iterator it = resources.begin(); it != resources.end(); it++) {
       MysqlConfig mysql_config = (*it);
       if (mysql_config.IsNull()) {
+        LOG(INFO) << __FUNCTION__ << " resource:" << *it
+                  << " be omited for bad config";
         continue;
       }
       mysql_sources.push_back(mysql_config);
@@ -70,43 +84,71 @@ int MysqlLoader::Initialize() {
 }
 
 int MysqlLoader::Load() {
-  sql::Driver* driver driver = get_driver_instance();
+  VLOG(VTRACE) << __FUNCTION__ << " Enter, source count:"
+               << mysql_sources.size();
+  if (parser_content_mode_ != "line") {
+    LOG(ERROR) << "not supported mode to load mysql:" << parser_content_mode_;
+    watcher_->OnFinish(-1);
+    return -1;
+  }
+
+  base::MessageLoop loop;
+  loop.SetLoopName("mysql_loader");
+  loop.Start();
 
+  int result = 0;
   for (const auto& config : mysql_sources) {
-    std::ostringstream oss;
-    oss << "tcp://" << config.host << ":" << config.port;
+    lt::MysqlPoolOptions options;
+    options.mysql.host = config.host;
+    options.mysql.port = config.port;
+    options.mysql.user = config.user;
+    options.mysql.passwd = config.password;
+    options.mysql.dbname = config.db;
+    options.mysql.query_timeout = config.timeout;
+    options.mysql.health_check_ms = 0;
 
-    std::shared_ptr<sql::Connection> con try {
-      con.reset(driver->connect(oss.str(), config.user, config.password));
-      if (!con) {
-        LOG(WARNING) << " Sql Connection Failed";
-        continue;
-      }
+    // closed before loop gone
+    std::unique_ptr<lt::MysqlPool> pool(new lt::MysqlPool({&loop}));
+    pool->Initialize(options);
 
-      con->setSchema(config.db);
+    int64_t rows = LoadResource(pool.get(), config);
+    LOG(INFO) << __FUNCTION__ << " load " << rows << " rows from "
+              << config.host << ":" << config.port << "/" << config.db;
+    if (rows < 0) {
+      result = -1;
+    }
+  }
 
-      std::shared_ptr<sql::Statement> stmt(con->createStatement());
-      std::shared_ptr<sql::ResultSet> res = stmt->executeQuery(config.query);
+  watcher_->OnFinish(result);
+  VLOG(VTRACE) << __FUNCTION__ << " Leave with result :" << result;
+  return result;
+}
 
-      while (res->next()) {
-        cout << "id: " << res->getInt(1) << endl;
-        cout << "name: " << res->getString(2) << endl;
-        cout << "price: " << res->getDouble(3) << endl;
-        cout << "created: " << res->getString(4) << endl;
-      }
-      delete res;
-      delete stmt;
-
-    } catch (sql::SQLException& e) {
-      LOG(WARNING) << __FUNCTION__ << " connect mysql: " << oss.str()
-                   << " err:" << e.what() << " error code:" << e.getErrorCode
-                   << " status:" << e.getSQLState();
-    } catch (...) {
-      LOG(WARNING) << __FUNCTION__ << " other error";
-    }
+int64_t MysqlLoader::LoadResource(lt::MysqlPool* pool,
+                                  const MysqlConfig& config) {
+  int64_t rows = 0;
+  std::promise<void> done;
+
+  // in pool loop, parsed as they fetched without buffering all of them
+  lt::RefQuerySession query = lt::QuerySession::New();
+  query->Query(config.query)
+      .OnRow([&](lt::ResultRow&& row) -> bool {
+        rows++;
+        watcher_->OnReadData(base::StrUtil::Join(row, delimiter_));
+        return true;
+      })
+      .Then([&]() { done.set_value(); });
+  pool->PendingQuery(query);
+  done.get_future().wait();
+
+  if (query->Code() != 0) {
+    LOG(ERROR) << __FUNCTION__ << " query:" << config.query
+               << " failed, code:" << query->Code()
+               << " message:" << query->ErrorMessage();
+    return -1;
   }
-  return 0;
-};
+  return rows;
+}
 
 }  // namespace sl
-}  // namespace component
\ No newline at end of file
+}  // namespace component
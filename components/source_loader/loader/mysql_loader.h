@@ -9,18 +9,27 @@
 #include "loader.h"
 /*
  * "loader": {
- *    "type": "file",
- *    "mode": "line",
+ *    "type": "mysql",
+ *    "delimiter": "#",     // columns of a row joined into a line by it,
+ *                          // same as the column parser's
  *    "resources": [{
  *      "host":"127.0.0.1",
  *      "port":3306,
  *      "database": "uolo",
  *      "user": "root",
  *      "password": "gonghuan",
- *      "sql_query": "select name, age, info from users"
+ *      "sql_query": "select name, age, info from users",
+ *      "timeout": 5000     // ms
  *    }]
  *  }
+ * rows streamed by a lt::MysqlPool and parsed as they fetched, line mode
+ * only; built with integration/async_mysql, RegisterMysqlLoader() before
+ * any source loading from mysql created
  * */
+namespace lt {
+class MysqlPool;
+}
+
 namespace component {
 namespace sl {
 
@@ -31,20 +40,28 @@ struct MysqlConfig : public JsonClassMeta {
   std::string user;
   std::string password;
   std::string query;
+  int32_t timeout = 5000;
 };
 
-void to_json(const MysqlConfig& c, Json& out);
+void to_json(Json& out, const MysqlConfig& c);
 void from_json(const Json& j, MysqlConfig& c);
 
+// register loader type "mysql" to LoaderFactory
+void RegisterMysqlLoader();
+
 class MysqlLoader : public Loader {
 public:
-  MysqlLoader(LoaderDelegate* watcher, Json& reader_config);
+  MysqlLoader(LoaderDelegate* watcher, const Json& reader_config);
   ~MysqlLoader();
 
   int Initialize() override;
   int Load() override;
 
 private:
+  // rows loaded, -1 when query failed
+  int64_t LoadResource(lt::MysqlPool* pool, const MysqlConfig& config);
+
+  std::string delimiter_;
   std::vector<MysqlConfig> mysql_sources;
 };
 
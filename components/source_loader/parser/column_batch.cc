@@ -0,0 +1,126 @@
+#include "column_batch.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace component {
+namespace sl {
+
+namespace {
+
+// like atoi, values in a chunk not null terminated
+int64_t ToInt(const char* data, size_t len) {
+  const char* end = data + len;
+  while (data < end && ::isspace(*data)) {
+    data++;
+  }
+  bool negative = data < end && *data == '-';
+  if (data < end && (*data == '-' || *data == '+')) {
+    data++;
+  }
+  uint64_t value = 0;
+  for (; data < end && *data >= '0' && *data <= '9'; data++) {
+    value = value * 10 + (*data - '0');
+  }
+  return negative ? -value : value;
+}
+
+double ToDouble(const char* data, size_t len) {
+  char buf[64];
+  if (len < sizeof(buf)) {
+    ::memcpy(buf, data, len);
+    buf[len] = '\0';
+    return ::strtod(buf, nullptr);
+  }
+  return ::strtod(std::string(data, len).c_str(), nullptr);
+}
+
+}  // namespace
+
+ColumnBatch::Column::Column(const std::string& name,
+                            SourceValueType type,
+                            const Json& default_value)
+  : name_(name), type_(type), default_value_(default_value) {}
+
+void ColumnBatch::Column::Append(const char* data, size_t len) {
+  switch (type_) {
+    case ValueTypeBoolen:
+      ints_.push_back(len == 4 && ::memcmp(data, "true", 4) == 0);
+      break;
+    case ValueTypeInt:
+      ints_.push_back(ToInt(data, len));
+      break;
+    case ValueTypeDouble:
+      doubles_.push_back(ToDouble(data, len));
+      break;
+    case ValueTypeString:
+    case ValueTypeJsonObj:
+    default:
+      chars_.append(data, len);
+      offsets_.push_back(chars_.size());
+      break;
+  }
+}
+
+Json ColumnBatch::Column::ToJson(size_t row) const {
+  switch (type_) {
+    case ValueTypeBoolen:
+      return Json(ints_[row] != 0);
+    case ValueTypeInt:
+      return Json(ints_[row]);
+    case ValueTypeDouble:
+      return Json(doubles_[row]);
+    case ValueTypeJsonObj: {
+      base::StringPiece raw = Str(row);
+      Json j = Json::parse(raw.begin(), raw.end(), nullptr, false);
+      return j.is_discarded() ? default_value_ : j;
+    }
+    default:
+      break;
+  }
+  base::StringPiece str = Str(row);
+  return Json(std::string(str.data(), str.size()));
+}
+
+void ColumnBatch::Column::Clear() {
+  ints_.clear();
+  doubles_.clear();
+  chars_.clear();
+  offsets_.resize(1);
+}
+
+ColumnBatch::Column* ColumnBatch::AddColumn(const std::string& name,
+                                            SourceValueType type,
+                                            const Json& default_value) {
+  columns_.emplace_back(name, type, default_value);
+  return &columns_.back();
+}
+
+const ColumnBatch::Column* ColumnBatch::GetColumn(
+    const std::string& name) const {
+  for (const auto& column : columns_) {
+    if (column.Name() == name) {
+      return &column;
+    }
+  }
+  return nullptr;
+}
+
+Json ColumnBatch::RowJson(size_t row) const {
+  Json out;
+  for (const auto& column : columns_) {
+    out[column.Name()] = column.ToJson(row);
+  }
+  return out;
+}
+
+void ColumnBatch::Clear() {
+  for (auto& column : columns_) {
+    column.Clear();
+  }
+  rows_ = 0;
+}
+
+}  // namespace sl
+}  // namespace component
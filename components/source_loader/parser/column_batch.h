@@ -0,0 +1,85 @@
+#ifndef LIGHTINGIO_SOURCE_LOADER_COLUMN_BATCH_H
+#define LIGHTINGIO_SOURCE_LOADER_COLUMN_BATCH_H
+
+#include <string>
+#include <vector>
+
+#include "base/string/string_view.h"
+#include "parser.h"
+
+namespace component {
+namespace sl {
+
+/* rows parsed from a chunk, stored column by column with its type,
+ * no Json built for them
+ * int/bool: Int(), double: Double(), string/json(raw text): Str() */
+class ColumnBatch {
+public:
+  class Column {
+  public:
+    Column(const std::string& name,
+           SourceValueType type,
+           const Json& default_value);
+
+    const std::string& Name() const { return name_; }
+
+    SourceValueType Type() const { return type_; }
+
+    int64_t Int(size_t row) const { return ints_[row]; }
+
+    double Double(size_t row) const { return doubles_[row]; }
+
+    base::StringPiece Str(size_t row) const {
+      return base::StringPiece(chars_.data() + offsets_[row],
+                               offsets_[row + 1] - offsets_[row]);
+    }
+
+    // parse and append a value, converted as ColumnParser did
+    void Append(const char* data, size_t len);
+
+    Json ToJson(size_t row) const;
+
+    void Clear();
+
+  private:
+    std::string name_;
+    SourceValueType type_;
+    Json default_value_;
+
+    std::vector<int64_t> ints_;
+    std::vector<double> doubles_;
+    // all strings in one buffer, row i: [offsets_[i], offsets_[i + 1])
+    std::string chars_;
+    std::vector<size_t> offsets_ = {0};
+  };
+
+  Column* AddColumn(const std::string& name,
+                    SourceValueType type,
+                    const Json& default_value);
+
+  // after all columns of a row appended
+  void FinishRow() { rows_++; }
+
+  size_t Rows() const { return rows_; }
+
+  const std::vector<Column>& Columns() const { return columns_; }
+
+  Column* MutableColumn(size_t index) { return &columns_[index]; }
+
+  // nullptr if not found
+  const Column* GetColumn(const std::string& name) const;
+
+  // row as a json object, like ColumnParser::ParseContent output
+  Json RowJson(size_t row) const;
+
+  // keep columns, remove all rows
+  void Clear();
+
+private:
+  size_t rows_ = 0;
+  std::vector<Column> columns_;
+};
+
+}  // namespace sl
+}  // namespace component
+#endif
@@ -4,8 +4,11 @@
 
 #include "column_parser.h"
 #include <glog/logging.h>
+#include <string.h>
+#include <algorithm>
 #include "base/logging.h"
 #include "base/utils/string/str_utils.h"
+#include "column_batch.h"
 
 /*
  *   eg: AngleZhou#21#{"email":"gopher@gmail.com"}#extra_what_ever
@@ -106,6 +109,52 @@ bool ColumnParser::ParseContent(const std::string& content) {
   return true;
 }
 
+bool ColumnParser::ParseChunk(const char* data,
+                              size_t len,
+                              ColumnBatch* batch) const {
+  if (batch->Columns().empty()) {
+    for (const auto& name : header_) {
+      auto iter = columns_.find(name);
+      if (iter != columns_.end()) {
+        const ColumnInfo& info = iter->second;
+        batch->AddColumn(info.name, info.type, info.default_value);
+      }
+    }
+  }
+
+  const char* end = data + len;
+  std::vector<std::pair<const char*, size_t>> fields;
+  fields.reserve(header_.size());
+  for (const char* line = data; line < end;) {
+    const char* eol =
+        static_cast<const char*>(::memchr(line, '\n', end - line));
+    eol = eol ? eol : end;
+
+    fields.clear();
+    for (const char* field = line; field <= eol;) {
+      const char* next = std::search(field, eol, delimiter_.begin(),
+                                     delimiter_.end());
+      fields.emplace_back(field, next - field);
+      field = next + delimiter_.size();
+    }
+    if (eol == line) {  // empty line
+    } else if (fields.size() != header_.size()) {
+      LOG_EVERY_N(INFO, 1000) << __FUNCTION__ << " bad content:"
+                              << std::string(line, eol);
+    } else {
+      for (size_t i = 0; i < fields.size(); i++) {
+        if (header_columns_[i] >= 0) {
+          batch->MutableColumn(header_columns_[i])
+              ->Append(fields[i].first, fields[i].second);
+        }
+      }
+      batch->FinishRow();
+    }
+    line = eol + 1;
+  }
+  return true;
+}
+
 bool ColumnParser::HanleColumn(const ColumnInfo& info,
                                const std::string& content,
                                Json& out) {
@@ -186,6 +235,10 @@ bool ColumnParser::Initialize(const Json& config) {
     LOG(INFO) << "column parser header field not correct:" << header;
     return false;
   }
+  int batch_columns = 0;
+  for (const auto& name : header_) {
+    header_columns_.push_back(columns_.count(name) ? batch_columns++ : -1);
+  }
   auto it = config.find("ignore_header_line");
   if (it == config.end()) {
     ignore_header_line_ = false;
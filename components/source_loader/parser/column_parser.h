@@ -30,8 +30,16 @@ public:
   bool Initialize(const Json& config) override;
   bool ParseContent(const std::string& content) override;
 
+  bool SupportBatch() const override { return true; }
+
+  // columns of batch are the schemes in header order
+  bool ParseChunk(const char* data, size_t len, ColumnBatch* batch) const override;
+
 private:
   bool HanleColumn(const ColumnInfo& info, const std::string& data, Json& out);
+
+  // batch column of each header field, -1: no scheme for it
+  std::vector<int> header_columns_;
   std::string delimiter_;
   bool ignore_header_line_;
   std::vector<std::string> header_;
@@ -1,5 +1,6 @@
 
 #include "components/source_loader/parser/parser.h"
+#include "components/source_loader/parser/column_batch.h"
 #include "glog/logging.h"
 
 namespace component {
@@ -31,6 +32,12 @@ SourceValueType ToSourceValueType(const std::string& str) {
   return r;
 }
 
+void ParserDelegate::OnBatchParsed(const ColumnBatch& batch) {
+  for (size_t row = 0; row < batch.Rows(); row++) {
+    OnContentParsed(batch.RowJson(row));
+  }
+}
+
 Parser::~Parser(){};
 
 bool Parser::Initialize(const Json& config) {
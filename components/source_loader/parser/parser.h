@@ -23,9 +23,15 @@ typedef enum {
 const std::string& ValueTypeToString(SourceValueType t);
 SourceValueType ToSourceValueType(const std::string& type);
 
+class ColumnBatch;
+
 class ParserDelegate {
 public:
   virtual void OnContentParsed(const Json& data) = 0;
+
+  // rows of a chunk, default handle them one by one by OnContentParsed;
+  // override it to consume the typed columns without Json
+  virtual void OnBatchParsed(const ColumnBatch& batch);
 };
 
 class Parser {
@@ -37,6 +43,21 @@ public:
 
   virtual bool ParseContent(const std::string& content) = 0;
 
+  // ParseChunk supported, else lines of chunk go to ParseContent
+  virtual bool SupportBatch() const { return false; }
+
+  // parse lines of a chunk into batch, called by loader threads
+  // concurrently, so it must be thread safe
+  virtual bool ParseChunk(const char* data, size_t len, ColumnBatch* batch) const {
+    return false;
+  }
+
+  void DeliverBatch(const ColumnBatch& batch) {
+    if (delegate_) {
+      delegate_->OnBatchParsed(batch);
+    }
+  }
+
   virtual bool CheckDefault(SourceValueType t, Json& default_value);
 
   // use for reset status
@@ -3,8 +3,10 @@
 //
 
 #include "source.h"
+#include "base/logging.h"
 #include "glog/logging.h"
 #include "loader/loader_factory.h"
+#include "parser/column_batch.h"
 #include "parser/column_parser.h"
 
 namespace component {
@@ -67,17 +69,35 @@ bool Source::Initialize() {
 }
 
 int Source::StartLoad() {
+  sequencer_.Reset(loader_->OrderedDelivery());
   return loader_->Load();
 }
 
+int Source::LoadAppended() {
+  sequencer_.Reset(loader_->OrderedDelivery());
+  return loader_->LoadAppended();
+}
+
 void Source::OnFinish(int code) {
   parser_->OnSourceLoadFinished(code);
 }
 
 void Source::OnReadData(const std::string& content) {
-  LOG(INFO) << __FUNCTION__ << " enter";
+  VLOG(VTRACE) << __FUNCTION__ << " enter";
   parser_->ParseContent(content);
-  LOG(INFO) << __FUNCTION__ << " leave";
+  VLOG(VTRACE) << __FUNCTION__ << " leave";
+}
+
+void Source::OnReadChunk(const LoadChunk& chunk) {
+  if (!parser_->SupportBatch()) {
+    sequencer_.Deliver(chunk.index,
+                       [&]() { LoaderDelegate::OnReadChunk(chunk); });
+    return;
+  }
+  // parse in loader threads, deliver one by one
+  ColumnBatch batch;
+  parser_->ParseChunk(chunk.data, chunk.size, &batch);
+  sequencer_.Deliver(chunk.index, [&]() { parser_->DeliverBatch(batch); });
 }
 
 }  // namespace sl
@@ -6,6 +6,7 @@
 #define LIGHTINGIO_COMPONENT_SOURCE_H
 
 #include <memory>
+#include "components/source_loader/loader/chunk_sequencer.h"
 #include "components/source_loader/loader/loader.h"
 #include "components/source_loader/parser/parser.h"
 
@@ -25,9 +26,13 @@ public:
 
   int StartLoad();
 
+  // load data appended since last load, see Loader::LoadAppended
+  int LoadAppended();
+
   // override from LoaderDelegate
   void OnFinish(int code) override;
   void OnReadData(const std::string&) override;
+  void OnReadChunk(const LoadChunk& chunk) override;
 
 protected:
   Json source_config_;
@@ -35,6 +40,9 @@ protected:
 
   std::unique_ptr<Parser> parser_;
   std::unique_ptr<Loader> loader_;
+
+  // results of chunks loaded in parallel go out one at a time
+  ChunkSequencer sequencer_;
 };
 
 }  // namespace sl
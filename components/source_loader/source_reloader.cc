@@ -0,0 +1,269 @@
+#include "source_reloader.h"
+
+#include <libgen.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <set>
+
+#include "base/time/time_utils.h"
+#include "glog/logging.h"
+
+namespace component {
+namespace sl {
+
+SourceReloader::SourceReloader(const Json& source_config,
+                               SourceCreator creator)
+  : config_(source_config), creator_(creator) {}
+
+SourceReloader::~SourceReloader() {
+  Stop();
+}
+
+bool SourceReloader::Initialize() {
+  const static Json nil_json;
+  CHECK(config_.is_object());
+
+  const Json& reloader = config_.value("reloader", nil_json);
+  if (reloader.is_object()) {
+    mode_ = reloader.value("mode", "none");
+    interval_ms_ = std::max<int64_t>(1, reloader.value("interval", 3000));
+    append_ = reloader.value("append", false);
+  }
+
+  const Json& loader = config_.value("loader", nil_json);
+  if (loader.is_object() && loader.value("type", "") == "file") {
+    for (const auto& resource : loader.value("resources", nil_json)) {
+      std::string path = resource.value("path", "");
+      if (!path.empty()) {
+        files_.push_back(path);
+      }
+    }
+  }
+  if (mode_ == "watch" && files_.empty()) {
+    LOG(WARNING) << __FUNCTION__ << " no file to watch, reload by interval";
+    mode_ = "interval";
+  }
+  return Reload();
+}
+
+void SourceReloader::Start() {
+  if (mode_ != "interval" && mode_ != "watch") {
+    return;
+  }
+  if (reloader_.joinable()) {
+    return;
+  }
+  stopping_ = false;
+  wakeup_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  CHECK(wakeup_fd_ >= 0);
+  reloader_ = std::thread(&SourceReloader::ReloadMain, this);
+}
+
+void SourceReloader::Stop() {
+  if (!reloader_.joinable()) {
+    return;
+  }
+  stopping_ = true;
+  uint64_t one = 1;
+  ssize_t n = ::write(wakeup_fd_, &one, sizeof(one));
+  (void)n;
+  reloader_.join();
+  ::close(wakeup_fd_);
+  wakeup_fd_ = -1;
+}
+
+uint64_t SourceReloader::Version() const {
+  RefSnapshot snapshot = Current();
+  return snapshot ? snapshot->version : 0;
+}
+
+int64_t SourceReloader::LoadedTime() const {
+  RefSnapshot snapshot = Current();
+  return snapshot ? snapshot->loaded_ms : 0;
+}
+
+bool SourceReloader::StatFiles(FileStats* stats) const {
+  for (const auto& file : files_) {
+    struct stat st;
+    if (::stat(file.c_str(), &st) != 0) {
+      LOG(ERROR) << __FUNCTION__ << " file [" << file << "] not accessable";
+      return false;
+    }
+    FileStat& file_stat = (*stats)[file];
+    file_stat.inode = st.st_ino;
+    file_stat.size = st.st_size;
+    file_stat.mtime_ns = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+  }
+  return true;
+}
+
+bool SourceReloader::Changed() {
+  if (files_.empty()) {
+    return true;
+  }
+  FileStats stats;
+  if (!StatFiles(&stats)) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lck(reload_mtx_);
+  return !(stats == loaded_stats_);
+}
+
+std::shared_ptr<SourceReloader::Snapshot> SourceReloader::FullLoad() {
+  std::shared_ptr<Snapshot> snapshot(new Snapshot());
+  Json config = config_;
+  if (append_ && config["loader"].is_object()) {
+    // partial last line held back by loader, see FileLoader
+    config["loader"]["append"] = true;
+  }
+  snapshot->source.reset(creator_(config));
+  if (!snapshot->source || !snapshot->source->Initialize()) {
+    LOG(ERROR) << __FUNCTION__ << " source initialize failed:" << config_;
+    return nullptr;
+  }
+  int code = snapshot->source->StartLoad();
+  if (code != 0) {
+    LOG(ERROR) << __FUNCTION__ << " source load failed, code:" << code;
+    return nullptr;
+  }
+  return snapshot;
+}
+
+bool SourceReloader::Reload() {
+  bool ok = false;
+  {
+    std::lock_guard<std::mutex> lck(reload_mtx_);
+    ok = ReloadLocked();
+  }
+  Collect();
+  return ok;
+}
+
+bool SourceReloader::ReloadLocked() {
+  // not to publish a empty source when files removed or renaming
+  FileStats stats;
+  if (!StatFiles(&stats)) {
+    return false;
+  }
+
+  int64_t start_ms = base::time_ms();
+  std::shared_ptr<Snapshot> snapshot;
+  if (append_ && standby_ && standby_.use_count() == 1 &&
+      standby_->source->LoadAppended() == 0) {
+    snapshot = std::move(standby_);
+    snapshot->appended = true;
+  } else {
+    snapshot = FullLoad();
+    if (!snapshot) {
+      return false;
+    }
+    if (standby_) {
+      retired_.push_back(std::move(standby_));
+    }
+  }
+  std::shared_ptr<Snapshot> current = std::atomic_load(&current_);
+  snapshot->version = current ? current->version + 1 : 1;
+  snapshot->loaded_ms = base::time_ms();
+  std::atomic_store(&current_, snapshot);
+  loaded_stats_.swap(stats);
+
+  if (current && append_) {
+    standby_ = std::move(current);
+  } else if (current) {
+    retired_.push_back(std::move(current));
+  }
+  LOG(INFO) << __FUNCTION__ << " source reloaded, version:"
+            << snapshot->version << ", appended:" << snapshot->appended
+            << ", spend:" << base::delta_ms(start_ms) << "(ms)";
+  return true;
+}
+
+void SourceReloader::Collect() {
+  std::list<std::shared_ptr<Snapshot>> released;
+  {
+    std::lock_guard<std::mutex> lck(reload_mtx_);
+    for (auto iter = retired_.begin(); iter != retired_.end();) {
+      auto cur = iter++;
+      if (cur->use_count() == 1) {
+        released.splice(released.end(), retired_, cur);
+      }
+    }
+  }
+  // destructed out of lock
+}
+
+void SourceReloader::ReloadMain() {
+  int inotify_fd = -1;
+  std::set<std::string> names;
+  if (mode_ == "watch") {
+    inotify_fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    LOG_IF(ERROR, inotify_fd < 0) << __FUNCTION__ << " inotify init failed";
+    // watch dirs, files may be replaced by rename
+    for (const auto& file : files_) {
+      std::string path = file;
+      std::string dir = ::dirname(&path[0]);
+      path = file;
+      names.insert(::basename(&path[0]));
+      if (inotify_fd >= 0 &&
+          ::inotify_add_watch(inotify_fd, dir.c_str(),
+                              IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO |
+                                  IN_CREATE) < 0) {
+        LOG(ERROR) << __FUNCTION__ << " inotify watch failed, dir:" << dir;
+      }
+    }
+  }
+
+  // interval: check files every interval; watch: changes reloaded at
+  // most once per interval, check once for changes made before watching
+  bool dirty = mode_ == "watch";
+  int64_t next_ms = base::time_ms() + interval_ms_;
+  while (!stopping_) {
+    int64_t timeout = interval_ms_;
+    if (mode_ == "interval" || dirty) {
+      timeout = std::max<int64_t>(0, next_ms - base::time_ms());
+    }
+    struct pollfd fds[2] = {{wakeup_fd_, POLLIN, 0}, {inotify_fd, POLLIN, 0}};
+    ::poll(fds, inotify_fd >= 0 ? 2 : 1, timeout);
+    if (stopping_) {
+      break;
+    }
+
+    if (inotify_fd >= 0 && (fds[1].revents & POLLIN)) {
+      char buf[4096]
+          __attribute__((aligned(__alignof__(struct inotify_event))));
+      ssize_t len = 0;
+      while ((len = ::read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char* p = buf; p < buf + len;) {
+          auto event = reinterpret_cast<struct inotify_event*>(p);
+          if (event->len > 0 && names.count(event->name)) {
+            dirty = true;
+          }
+          p += sizeof(struct inotify_event) + event->len;
+        }
+      }
+    }
+
+    int64_t now = base::time_ms();
+    if (mode_ == "interval" && now >= next_ms) {
+      dirty = true;
+    }
+    if (dirty && now >= next_ms) {
+      if (Changed()) {
+        Reload();
+      }
+      dirty = false;
+      next_ms = base::time_ms() + interval_ms_;
+    }
+    Collect();
+  }
+  if (inotify_fd >= 0) {
+    ::close(inotify_fd);
+  }
+}
+
+}  // namespace sl
+}  // namespace component
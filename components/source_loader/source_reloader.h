@@ -0,0 +1,154 @@
+#ifndef LIGHTINGIO_COMPONENT_SOURCE_RELOADER_H
+#define LIGHTINGIO_COMPONENT_SOURCE_RELOADER_H
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "base/lt_micro.h"
+#include "source.h"
+
+namespace component {
+namespace sl {
+
+/* reload a source in background and publish the new data by a atomic
+ * swap of shared_ptr snapshot, readers never blocked by a reload
+ *
+ * "reloader": {
+ *   "mode": "interval",  // interval: check files(or reload) every interval
+ *                        // watch: inotify the file resources
+ *                        // none: only by Reload()
+ *   "interval": 3000,    // ms, min interval between reloads in watch mode
+ *   "append": false      // line files only appended, load new lines only
+ * }
+ *
+ * each reload build a new Source; a snapshot replaced is reclaimed in the
+ * reloader thread after the last reader released it(RCU like), so a big
+ * dictionary never freed in request threads.
+ * append: the replaced snapshot kept as the standby buffer, once no reader
+ * holding it, next reload load the lines appended since its last load into
+ * it(Source::LoadAppended) instead of a full load, then swap it in; a
+ * file rewritten or standby in use fall back to a full load.
+ * watch mode works for file loader only, others reload by interval */
+class SourceReloader {
+public:
+  typedef std::function<Source*(Json& config)> SourceCreator;
+
+  struct Snapshot {
+    std::shared_ptr<Source> source;
+    uint64_t version = 0;
+    // time_ms of loaded
+    int64_t loaded_ms = 0;
+    // loaded by LoadAppended
+    bool appended = false;
+  };
+  using RefSnapshot = std::shared_ptr<const Snapshot>;
+
+  SourceReloader(const Json& source_config, SourceCreator creator);
+  virtual ~SourceReloader();
+
+  // load the first version, blocking
+  bool Initialize();
+
+  // reload in background as configured
+  void Start();
+
+  void Stop();
+
+  // reload now, blocking; old snapshot kept when failed
+  bool Reload();
+
+  // nullptr before Initialize
+  RefSnapshot Current() const { return std::atomic_load(&current_); }
+
+  uint64_t Version() const;
+
+  int64_t LoadedTime() const;
+
+private:
+  struct FileStat {
+    ino_t inode = 0;
+    off_t size = 0;
+    int64_t mtime_ns = 0;
+
+    bool operator==(const FileStat& other) const {
+      return inode == other.inode && size == other.size &&
+             mtime_ns == other.mtime_ns;
+    }
+  };
+  typedef std::map<std::string, FileStat> FileStats;
+
+  // false when a file not exist, not to reload with it
+  bool StatFiles(FileStats* stats) const;
+
+  std::shared_ptr<Snapshot> FullLoad();
+
+  // under reload_mtx_
+  bool ReloadLocked();
+
+  // files changed since current snapshot loaded, always true without files
+  bool Changed();
+
+  // free snapshots no reader using, in reloader thread
+  void Collect();
+
+  void ReloadMain();
+
+  Json config_;
+  SourceCreator creator_;
+
+  std::string mode_;
+  int64_t interval_ms_ = 3000;
+  bool append_ = false;
+  // resources of file loader
+  std::vector<std::string> files_;
+
+  std::shared_ptr<Snapshot> current_;
+
+  // one reload at a time, guard members below
+  std::mutex reload_mtx_;
+  // files of current snapshot
+  FileStats loaded_stats_;
+  // replaced snapshot for append loading
+  std::shared_ptr<Snapshot> standby_;
+  std::list<std::shared_ptr<Snapshot>> retired_;
+
+  std::atomic<bool> stopping_{false};
+  int wakeup_fd_ = -1;
+  std::thread reloader_;
+
+  DISALLOW_COPY_AND_ASSIGN(SourceReloader);
+};
+
+/* typed reloader of a Source subclass
+ *  ReloadableSource<NameStructSource<Person>> persons(config);
+ *  persons.Initialize(); persons.Start();
+ *  // request threads
+ *  auto source = persons.Get(); source->GetByName("name"); */
+template <typename S>
+class ReloadableSource : public SourceReloader {
+public:
+  explicit ReloadableSource(const Json& source_config)
+    : SourceReloader(source_config,
+                     [](Json& config) -> Source* { return new S(config); }) {}
+
+  // keep it for a whole request, data never change under it
+  std::shared_ptr<const S> Get() const {
+    RefSnapshot snapshot = Current();
+    if (!snapshot) {
+      return nullptr;
+    }
+    return std::shared_ptr<const S>(
+        snapshot, static_cast<const S*>(snapshot->source.get()));
+  }
+};
+
+}  // namespace sl
+}  // namespace component
+#endif
@@ -1,71 +1,182 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <atomic>
+#include <fstream>
 #include <iostream>
 #include <sstream>
-#include <fstream>
 #include <string>
 
-#include "base/utils//rand_util.h"
 #include "base/time//time_utils.h"
+#include "base/utils//rand_util.h"
+#include "components/boolean_indexer/builder/be_indexer_builder.h"
 #include "components/boolean_indexer/document.h"
 #include "components/boolean_indexer/id_generator.h"
-#include "components/boolean_indexer/builder/be_indexer_builder.h"
 #include "components/boolean_indexer/index_scanner.h"
-#include "components//boolean_indexer/mock//mock_target.h"
+#include "nlohmann/json.hpp"
 
 //#include "gperftools/profiler.h"
 
+/**
+ * retrieve throughput of IndexScanner on documents like
+ * unittests/component/test_documents.txt, one json per line:
+ * {"doc":1,"cond":[{"excl":false,"exps":["1"],"field":"source"}]}
+ *
+ * usage: be_index_bench [documents_file]
+ * without a file, 100k documents generated on fields source/title/desc/name
+ * */
 using namespace component;
 
-int main(int argc, char** argv) {
-  std::map<int, T*> targets;
-  component::BeIndexerBuilder builder;
-
-  for (int i=1; i< 100000; i++) {
-    auto a = rand_assigns(10, 0, 100);
-    T* t = new T({
-      .id = i,
-      .a = {"a", rand_assigns(5, 50, 75), base::RandInt(0, 100) > 80},
-      .b = {"b", rand_assigns(10, 0, 500), base::RandInt(0, 100) > 80},
-      .c = {"c", rand_assigns(8, 10, 170), base::RandInt(0, 100) > 80},
-    });
-
-    targets[i] = t;
+namespace {
+
+const int kQueries = 20000;
+
+struct FieldSpace {
+  const char* name;
+  int values;      // value space size
+  int max_assign;  // values count in a expression
+};
+
+const FieldSpace kFields[] = {
+    {"source", 20, 3},
+    {"title", 500, 5},
+    {"desc", 2000, 10},
+    {"name", 100, 2},
+};
+
+std::string value_of(const FieldSpace& field, int v) {
+  return std::string(field.name) + std::to_string(v);
+}
+
+AttrValues::ValueContainer rand_values(const FieldSpace& field, int n) {
+  AttrValues::ValueContainer values;
+  while (n-- > 0) {
+    values.insert(value_of(field, base::RandInt(0, field.values - 1)));
+  }
+  return values;
+}
+
+void generate_documents(BeIndexerBuilder* builder, int count) {
+  for (int i = 1; i <= count; i++) {
+    Conjunction* conj = new Conjunction();
+    for (const FieldSpace& field : kFields) {
+      // not all fields assigned in a conjunction
+      if (base::RandInt(0, 100) < 20) {
+        continue;
+      }
+      int n = base::RandInt(1, field.max_assign);
+      conj->AddExpression(BooleanExpr(field.name, rand_values(field, n),
+                                      base::RandInt(0, 100) < 5));
+    }
     Document doc(i);
-    doc.AddConjunction(new Conjunction({t->a, t->b, t->c}));
-    builder.AddDocument(std::move(doc));
+    doc.AddConjunction(conj);
+    builder->AddDocument(std::move(doc));
   }
-  auto index = builder.BuildIndexer();
+}
 
-  auto none_index_match = [&](QueryAssigns& assigns)-> std::set<int32_t> {
-    std::set<int32_t> result;
-    for (const auto& t : targets) {
-      int id = t.first;
-      if (t.second->match(assigns)) {
-        result.insert(id);
+int load_documents(BeIndexerBuilder* builder, const char* file) {
+  std::ifstream ifs(file);
+  if (!ifs.is_open()) {
+    std::cout << "open " << file << " failed" << std::endl;
+    return -1;
+  }
+  int count = 0;
+  std::string line;
+  while (std::getline(ifs, line)) {
+    nlohmann::json j_doc = nlohmann::json::parse(line, nullptr, false);
+    if (j_doc.is_discarded() || !j_doc.contains("doc")) {
+      continue;
+    }
+    Conjunction* conj = new Conjunction();
+    for (const auto& cond : j_doc["cond"]) {
+      AttrValues::ValueContainer values;
+      for (const auto& exp : cond["exps"]) {
+        values.insert(exp.get<std::string>());
       }
+      conj->AddExpression(BooleanExpr(cond["field"].get<std::string>(), values,
+                                      cond["excl"].get<bool>()));
     }
-    return result;
-  };
+    Document doc(j_doc["doc"].get<int>());
+    doc.AddConjunction(conj);
+    builder->AddDocument(std::move(doc));
+    count++;
+  }
+  return count;
+}
 
-  std::cout << "finish index build" << std::endl;
+void report(const char* name, int64_t start_us, size_t matched) {
+  int64_t cost = std::max<int64_t>(base::time_us() - start_us, 1);
+  std::cout << name << ": " << cost / 1000 << "(ms), "
+            << int64_t(kQueries) * 1000000 / cost << " qps, "
+            << "avg matched:" << matched / kQueries << std::endl;
+}
+
+}  // namespace
 
-  uint64_t start = base::time_us();
+int main(int argc, char** argv) {
+  BeIndexerBuilder builder;
+  int count = 100000;
+  if (argc > 1) {
+    count = load_documents(&builder, argv[1]);
+  } else {
+    generate_documents(&builder, count);
+  }
+  if (count <= 0) {
+    return -1;
+  }
+  int64_t start = base::time_us();
+  auto index = builder.BuildIndexer();
+  std::cout << "build index of " << count << " documents spend:"
+            << (base::time_us() - start) / 1000 << "(ms)" << std::endl;
+
+  // a query assign every field, like a ad request
   std::vector<QueryAssigns> queries;
-  for (int i; i < 1000; i++) {
-    QueryAssigns assigns = {
-      {"a", rand_assigns(1, 50, 100)},
-      {"b", rand_assigns(2, 0, 100)},
-      {"c", rand_assigns(3, 10, 70)},
-    };
+  for (int i = 0; i < kQueries; i++) {
+    QueryAssigns assigns;
+    for (const FieldSpace& field : kFields) {
+      assigns.emplace_back(field.name, rand_values(field, 2));
+    }
     queries.emplace_back(assigns);
   }
+
+  IndexScanner scanner(index.get());
+  size_t matched = 0;
+
   //ProfilerStart("profile.prof");
-  for (int i = 0; i < queries.size(); i++) {
-    auto scanner = IndexScanner(index.get());
-    auto result = scanner.Retrieve(queries[i]);
+  start = base::time_us();
+  for (const auto& query : queries) {
+    matched += scanner.Retrieve(query).result.size();
+  }
+  report("retrieve", start, matched);
+
+  IndexScanner::Context ctx;
+  matched = 0;
+  start = base::time_us();
+  for (const auto& query : queries) {
+    matched += scanner.Retrieve(query, nullptr, &ctx).result.size();
+  }
+  report("retrieve with context", start, matched);
+
+  std::vector<std::vector<QueryAssigns>> batches;
+  for (size_t i = 0; i < queries.size(); i += 100) {
+    batches.emplace_back(queries.begin() + i, queries.begin() + i + 100);
+  }
+  matched = 0;
+  start = base::time_us();
+  for (const auto& batch : batches) {
+    for (const auto& result : scanner.BatchRetrieve(batch, nullptr, &ctx)) {
+      matched += result.result.size();
+    }
+  }
+  report("batch retrieve(100)", start, matched);
+
+  IndexScanner::Option option;
+  option.limit = 10;
+  matched = 0;
+  start = base::time_us();
+  for (const auto& query : queries) {
+    matched += scanner.Retrieve(query, &option, &ctx).result.size();
   }
+  report("retrieve limit 10", start, matched);
   //ProfilerStop();
-  std::cout << "spend:" << (base::time_us() - start) / 1000 << "(ms)" << std::endl;
+  return 0;
 }
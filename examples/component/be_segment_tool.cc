@@ -0,0 +1,142 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "base/time/time_utils.h"
+#include "components/boolean_indexer/builder/parallel_builder.h"
+#include "components/boolean_indexer/document.h"
+#include "components/boolean_indexer/index_scanner.h"
+#include "components/boolean_indexer/index_segment.h"
+#include "nlohmann/json.hpp"
+
+/**
+ * build a BooleanIndexer segment offline and inspect it
+ *
+ * usage:
+ *  be_segment_tool build <documents_file> <segment> [threads]
+ *    documents_file: one json per line, like unittests/component/test_documents.txt
+ *    {"doc":1,"cond":[{"excl":false,"exps":["1"],"field":"source"}]}
+ *  be_segment_tool info <segment>
+ *  be_segment_tool query <segment> <field>=<v1>,<v2> [<field>=<v>...]
+ * */
+using namespace component;
+
+namespace {
+
+int build(const char* documents, const char* segment, uint32_t threads) {
+  std::ifstream ifs(documents);
+  if (!ifs.is_open()) {
+    std::cout << "open " << documents << " failed" << std::endl;
+    return -1;
+  }
+  ParallelIndexerBuilder::Options options;
+  options.threads = threads;
+  ParallelIndexerBuilder builder(options);
+
+  std::string line;
+  int lineno = 0;
+  while (std::getline(ifs, line)) {
+    lineno++;
+    nlohmann::json j_doc = nlohmann::json::parse(line, nullptr, false);
+    if (j_doc.is_discarded() || !j_doc.contains("doc")) {
+      std::cout << "bad document at line:" << lineno << std::endl;
+      continue;
+    }
+    Conjunction* conj = new Conjunction();
+    for (const auto& cond : j_doc["cond"]) {
+      AttrValues::ValueContainer values;
+      for (const auto& exp : cond["exps"]) {
+        values.insert(exp.get<std::string>());
+      }
+      conj->AddExpression(BooleanExpr(cond["field"].get<std::string>(), values,
+                                      cond["excl"].get<bool>()));
+    }
+    Document doc(j_doc["doc"].get<int>());
+    doc.AddConjunction(conj);
+    builder.AddDocument(std::move(doc));
+  }
+
+  RefBooleanIndexer indexer = builder.BuildIndexer();
+  if (!indexer) {
+    return -1;
+  }
+  std::cout << builder.Stats().ToString() << std::endl;
+
+  int64_t start = base::time_ms();
+  if (!IndexSegment::Save(indexer.get(), segment)) {
+    return -1;
+  }
+  std::cout << "segment saved:" << segment << ", spend "
+            << base::delta_ms(start) << "(ms)" << std::endl;
+  return 0;
+}
+
+RefBooleanIndexer open(const char* segment) {
+  int64_t start = base::time_us();
+  RefBooleanIndexer indexer = IndexSegment::Open(segment);
+  if (indexer) {
+    std::cout << "segment opened:" << segment << ", spend "
+              << base::time_us() - start << "(us)" << std::endl;
+  }
+  return indexer;
+}
+
+int info(const char* segment) {
+  RefBooleanIndexer indexer = open(segment);
+  if (!indexer) {
+    return -1;
+  }
+  std::ostringstream oss;
+  indexer->GetContainer("")->DumpEntries(oss);
+  std::cout << oss.str();
+  return 0;
+}
+
+int query(const char* segment, int argc, char** argv) {
+  RefBooleanIndexer indexer = open(segment);
+  if (!indexer) {
+    return -1;
+  }
+  QueryAssigns assigns;
+  for (int i = 0; i < argc; i++) {
+    std::string assign(argv[i]);
+    size_t eq = assign.find('=');
+    if (eq == std::string::npos) {
+      std::cout << "bad assign:" << assign << std::endl;
+      return -1;
+    }
+    AttrValues::ValueContainer values;
+    std::istringstream iss(assign.substr(eq + 1));
+    for (std::string v; std::getline(iss, v, ',');) {
+      values.insert(v);
+    }
+    assigns.emplace_back(assign.substr(0, eq), values);
+  }
+
+  IndexScanner scanner(indexer.get());
+  std::cout << scanner.Retrieve(assigns).to_string() << std::endl;
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    std::cout << "usage: " << argv[0] << " build <documents> <segment> [threads]"
+              << "\n       " << argv[0] << " info <segment>"
+              << "\n       " << argv[0]
+              << " query <segment> <field>=<v1>,<v2> ..." << std::endl;
+    return -1;
+  }
+  std::string cmd(argv[1]);
+  if (cmd == "build" && argc >= 4) {
+    return build(argv[2], argv[3], argc > 4 ? std::stoul(argv[4]) : 0);
+  } else if (cmd == "info") {
+    return info(argv[2]);
+  } else if (cmd == "query") {
+    return query(argv[2], argc - 3, argv + 3);
+  }
+  std::cout << "unknown command:" << cmd << std::endl;
+  return -1;
+}
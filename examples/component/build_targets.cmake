@@ -17,3 +17,19 @@ TARGET_LINK_LIBRARIES(be_index_bench
   profiler
 )
 
+
+ADD_EXECUTABLE(cache_bench
+  component/cache_bench.cc
+)
+
+TARGET_LINK_LIBRARIES(cache_bench
+  ltio
+)
+
+ADD_EXECUTABLE(be_segment_tool
+  component/be_segment_tool.cc
+)
+
+TARGET_LINK_LIBRARIES(be_segment_tool
+  ltio
+)
@@ -0,0 +1,136 @@
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "base/time/time_utils.h"
+#include "components/lru_cache/lru_cache.h"
+#include "components/lru_cache/sharded_cache.h"
+
+/**
+ * compare a global-mutex LRUCache with ShardedCache on
+ * threads x key distribution(uniform/zipf); a miss load the value by Put
+ * usage: cache_bench [ops_per_thread]
+ * */
+using namespace component;
+
+namespace {
+
+const uint64_t kKeySpace = 1000000;
+const size_t kCapacity = 100000;
+
+// sample from a precomputed zipf cdf
+class ZipfKeys {
+public:
+  ZipfKeys(uint64_t n, double s) {
+    cdf_.resize(n);
+    double sum = 0;
+    for (uint64_t i = 0; i < n; i++) {
+      sum += (s == 0) ? 1.0 : 1.0 / std::pow(double(i + 1), s);
+      cdf_[i] = sum;
+    }
+    for (auto& v : cdf_) {
+      v /= sum;
+    }
+  }
+
+  uint64_t Next(std::mt19937_64& rng) const {
+    double r = std::uniform_real_distribution<double>(0, 1)(rng);
+    return std::lower_bound(cdf_.begin(), cdf_.end(), r) - cdf_.begin();
+  }
+
+private:
+  std::vector<double> cdf_;
+};
+
+class LockedLRU {
+public:
+  LockedLRU() : cache_(kCapacity) {}
+  bool Get(uint64_t key, uint64_t* value) {
+    std::lock_guard<std::mutex> guard(lock_);
+    return cache_.Get(key, value);
+  }
+  void Put(uint64_t key, uint64_t value) {
+    std::lock_guard<std::mutex> guard(lock_);
+    cache_.Add(key, std::move(value));
+  }
+
+private:
+  std::mutex lock_;
+  LRUCache<uint64_t, uint64_t> cache_;
+};
+
+class Sharded {
+public:
+  Sharded() : cache_(MakeOptions()) {}
+  bool Get(uint64_t key, uint64_t* value) { return cache_.Get(key, value); }
+  void Put(uint64_t key, uint64_t value) { cache_.Put(key, value); }
+
+private:
+  static ShardedCache<uint64_t, uint64_t>::Options MakeOptions() {
+    ShardedCache<uint64_t, uint64_t>::Options options;
+    options.capacity = kCapacity;
+    options.shards = 64;
+    return options;
+  }
+  ShardedCache<uint64_t, uint64_t> cache_;
+};
+
+template <typename Cache>
+void Run(const char* name,
+         const ZipfKeys& keys,
+         int threads,
+         uint64_t ops) {
+  Cache cache;
+  std::atomic<uint64_t> hits(0);
+  std::vector<std::thread> workers;
+
+  int64_t start = base::time_us();
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      std::mt19937_64 rng(t + 1);
+      uint64_t local_hits = 0, value = 0;
+      for (uint64_t i = 0; i < ops; i++) {
+        uint64_t key = keys.Next(rng);
+        if (cache.Get(key, &value)) {
+          local_hits++;
+        } else {
+          cache.Put(key, key);
+        }
+      }
+      hits += local_hits;
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+  int64_t cost_us = std::max<int64_t>(1, base::time_us() - start);
+
+  uint64_t total = ops * threads;
+  std::cout << name << "\tthreads:" << threads
+            << "\tmops:" << double(total) / cost_us
+            << "\thit_rate:" << double(hits) / total << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint64_t ops = argc > 1 ? atoll(argv[1]) : 1000000;
+
+  for (double skew : {0.0, 0.9, 1.2}) {
+    ZipfKeys keys(kKeySpace, skew);
+    std::cout << "--- zipf s=" << skew << std::endl;
+    for (int threads : {1, 4, 8, 16, 32}) {
+      Run<LockedLRU>("locked_lru", keys, threads, ops);
+      Run<Sharded>("sharded_tinylfu", keys, threads, ops);
+    }
+  }
+  return 0;
+}
@@ -76,3 +76,17 @@ TARGET_LINK_LIBRARIES(lt_http2_server
   ltio
 )
 #endif()
+
+ADD_EXECUTABLE(lt_rpc_bench
+  net_io/rpc_bench.cc
+)
+TARGET_LINK_LIBRARIES(lt_rpc_bench
+  ltio
+)
+
+ADD_EXECUTABLE(lt_udp_statsd
+  net_io/udp_statsd.cc
+)
+TARGET_LINK_LIBRARIES(lt_udp_statsd
+  ltio
+)
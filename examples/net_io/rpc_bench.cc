@@ -0,0 +1,153 @@
+#include <atomic>
+#include <csignal>
+#include <memory>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include "base/coroutine/co_runner.h"
+#include "base/coroutine/wait_group.h"
+#include "base/message_loop/message_loop.h"
+#include "base/time/time_utils.h"
+#include "net_io/clients/client.h"
+#include "net_io/rpc/rpc_service.h"
+#include "net_io/server/raw_server/raw_server.h"
+
+/*
+ * rpc echo benchmark, compare with fw_rapid_simple_server:
+ *  server: ./lt_rpc_bench --server --url=rpc://0.0.0.0:5008
+ *  client: ./lt_rpc_bench --url=rpc://127.0.0.1:5008 -c 64 -n 1000000
+ * */
+
+using namespace lt;
+
+DEFINE_bool(server, false, "run as echo server");
+DEFINE_int32(c, 64, "concurrency coroutines");
+DEFINE_int32(n, 1000000, "benchmark request numbers");
+DEFINE_int32(loops, 4, "io loops count");
+DEFINE_int32(size, 64, "payload size in bytes");
+DEFINE_string(url, "rpc://127.0.0.1:5008", "rpc server address");
+
+struct EchoRequest {
+  std::string content;
+  LT_RPC_FIELDS(content);
+};
+
+struct EchoResponse {
+  std::string content;
+  LT_RPC_FIELDS(content);
+};
+
+class EchoService : public net::RpcStub {
+public:
+  LT_RPC_SERVICE(EchoService, "bench.EchoService");
+  LT_RPC_METHOD(Echo, EchoRequest, EchoResponse);
+};
+
+std::vector<base::MessageLoop*> loops;
+base::MessageLoop main_loop;
+
+class BenchApp : public net::ClientDelegate {
+public:
+  base::MessageLoop* NextIOLoopForClient() override {
+    return loops[(index_++) % loops.size()];
+  }
+
+private:
+  std::atomic<uint32_t> index_ = {0};
+};
+
+int RunServer() {
+  net::RpcDispatcher dispatcher;
+  dispatcher.Register<EchoService::EchoMethod>(
+      [](const net::RpcContext&, const EchoRequest& req, EchoResponse* rsp) {
+        rsp->content = req.content;
+        return net::kRpcOk;
+      });
+  std::unique_ptr<net::CodecService::Handler> handler(
+      dispatcher.NewHandler(false));
+
+  net::RawServer server;
+  server.WithIOLoops(loops).WithAddress(FLAGS_url).ServeAddress(handler.get());
+
+  static auto stop = [&server]() {
+    server.StopServer(CO_RESUMER);
+    CO_YIELD;
+    main_loop.QuitLoop();
+  };
+  signal(SIGINT, [](int) { CO_GO &main_loop << stop; });
+  main_loop.WaitLoopEnd();
+  return 0;
+}
+
+int RunClient() {
+  BenchApp app;
+  net::url::RemoteInfo server_info;
+  if (!net::url::ParseRemote(FLAGS_url, server_info)) {
+    LOG(ERROR) << "bad url:" << FLAGS_url;
+    return -1;
+  }
+  net::Client client(&main_loop, server_info);
+
+  net::ClientConfig config;
+  config.connections = FLAGS_loops;
+  config.max_connections = FLAGS_loops * 4;
+  config.message_timeout = 5000;
+  client.SetDelegate(&app);
+  client.Initialize(config);
+  client.WaitForWarmup(3000);
+
+  net::RpcChannel channel(&client);
+  EchoService stub(&channel);
+
+  std::atomic<int64_t> remain = {FLAGS_n};
+  std::atomic<int64_t> success = {0}, failed = {0};
+  auto wg = co::WaitGroup::New();
+
+  EchoRequest req;
+  req.content.assign(FLAGS_size, 'x');
+  auto task = [&]() {
+    EchoResponse rsp;
+    while (remain.fetch_sub(1) > 0) {
+      stub.Echo(req, &rsp) == net::kRpcOk ? success++ : failed++;
+    }
+    wg->Done();
+  };
+
+  int64_t start = base::time_ms();
+  for (int i = 0; i < FLAGS_c; i++) {
+    wg->Add(1);
+    CO_GO loops[i % loops.size()] << task;
+  }
+
+  CO_GO &main_loop << [&]() {
+    wg->Wait();
+    int64_t cost = std::max<int64_t>(base::time_ms() - start, 1);
+    LOG(INFO) << "success:" << success << " failed:" << failed
+              << " cost:" << cost << "ms, qps:" << (success * 1000 / cost);
+    client.Finalize();
+    main_loop.QuitLoop();
+  };
+  main_loop.WaitLoopEnd();
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  main_loop.SetLoopName("main");
+  main_loop.Start();
+  for (int i = 0; i < FLAGS_loops; i++) {
+    auto loop = new base::MessageLoop();
+    loop->SetLoopName("io_" + std::to_string(i));
+    loop->Start();
+    loops.push_back(loop);
+  }
+
+  int ret = FLAGS_server ? RunServer() : RunClient();
+
+  for (auto loop : loops) {
+    delete loop;
+  }
+  return ret;
+}
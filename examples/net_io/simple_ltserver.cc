@@ -8,6 +8,7 @@
 #include "net_io/clients/client.h"
 #include "net_io/clients/client_connector.h"
 #include "net_io/codec/redis/redis_request.h"
+#include "net_io/server/admin_server/admin_server.h"
 #include "net_io/server/generic_server.h"
 #include "net_io/server/http_server/http_server.h"
 #include "net_io/server/raw_server/raw_server.h"
@@ -42,6 +43,7 @@ DEFINE_bool(http_client, false, "wheather enable self connected raw client");
 DEFINE_bool(use_coro, true, "wheather enable coro processor");
 
 DEFINE_int32(loops, 4, "how many loops use for handle message and io");
+DEFINE_string(admin, "", "host:port for runtime introspection, empty disable");
 
 net::ClientConfig DeafaultClientConfig(int count = 2) {
   net::ClientConfig config;
@@ -160,6 +162,12 @@ public:
     }
 #endif
     http_server.ServeAddress(http_handler.get());
+
+    if (!FLAGS_admin.empty()) {
+      admin_server.WatchServer("raw", &raw_server)
+          .WatchServer("http", &http_server);
+      admin_server.Serve(base::StrUtil::Concat("http://", FLAGS_admin), loops);
+    }
   }
 
   void HandleRawRequest(RefRawRequestContext context) {
@@ -332,6 +340,11 @@ public:
 
     CO_YIELD;
 
+    if (!FLAGS_admin.empty()) {
+      admin_server.Stop(CO_RESUMER);
+      CO_YIELD;
+    }
+
     LOG(INFO) << __FUNCTION__ << " stop leave";
     main_loop.QuitLoop();
   }
@@ -347,6 +360,7 @@ public:
   std::unique_ptr<CodecService::Handler> raw_handler;
   HttpCoroServer http_server;
   std::unique_ptr<CodecService::Handler> http_handler;
+  AdminServer admin_server;
 };
 std::atomic_int SimpleApp::io_round_count = {0};
 
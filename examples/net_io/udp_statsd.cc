@@ -0,0 +1,148 @@
+#include <csignal>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include "base/message_loop/message_loop.h"
+#include "base/utils/string/str_utils.h"
+#include "net_io/udp_io/udp_server.h"
+
+/*
+ * statsd like metrics reciever over udp, one socket per loop:
+ *  ./lt_udp_statsd --addr=0.0.0.0 --port=8125 --loops=4
+ *  echo -n "api.qps:1|c" | nc -u -w0 127.0.0.1 8125
+ * */
+
+using namespace lt;
+
+DEFINE_string(addr, "0.0.0.0", "ip listen on");
+DEFINE_int32(port, 8125, "udp port listen on");
+DEFINE_int32(loops, 4, "io loops count");
+DEFINE_int32(flush_ms, 10000, "dump metrics interval");
+DEFINE_bool(gro, false, "enable UDP_GRO receive offload");
+
+/* a datagram carry multi metric lines: `name:value|type[|@rate]`*/
+struct StatsdPacket {
+  struct Metric {
+    std::string name;
+    double value = 0;
+    char type = 'c';
+  };
+  std::vector<Metric> metrics;
+
+  bool Decode(const char* data, size_t len) {
+    std::string content(data, len);
+    for (const auto& line : base::StrUtil::Split(content, '\n')) {
+      auto colon = line.find(':');
+      auto bar = line.find('|');
+      if (colon == std::string::npos || bar == std::string::npos ||
+          bar < colon || bar + 1 >= line.size()) {
+        continue;
+      }
+      Metric metric;
+      metric.name = line.substr(0, colon);
+      metric.value = ::atof(line.c_str() + colon + 1);
+      metric.type = line[bar + 1];
+      auto at = line.find("|@", bar + 1);
+      if (at != std::string::npos && metric.type == 'c') {
+        double rate = ::atof(line.c_str() + at + 2);
+        metric.value = rate > 0 ? metric.value / rate : metric.value;
+      }
+      metrics.push_back(std::move(metric));
+    }
+    return metrics.size() > 0;
+  }
+
+  bool Encode(std::string* out) const { return false; }
+};
+
+class StatsdAggregator {
+public:
+  // called from every io loop
+  bool OnPacket(const net::IPEndPoint& peer,
+                const StatsdPacket& packet,
+                StatsdPacket* no_reply) {
+    std::lock_guard<std::mutex> guard(mtx_);
+    for (const auto& metric : packet.metrics) {
+      if (metric.type == 'g') {
+        gauges_[metric.name] = metric.value;
+      } else {
+        counters_[metric.name] += metric.value;
+      }
+    }
+    return false;
+  }
+
+  void Dump() {
+    std::map<std::string, double> counters, gauges;
+    {
+      std::lock_guard<std::mutex> guard(mtx_);
+      counters.swap(counters_);
+      gauges = gauges_;
+    }
+    for (const auto& kv : counters) {
+      LOG(INFO) << "counter " << kv.first << ":" << kv.second;
+    }
+    for (const auto& kv : gauges) {
+      LOG(INFO) << "gauge " << kv.first << ":" << kv.second;
+    }
+  }
+
+private:
+  std::mutex mtx_;
+  std::map<std::string, double> counters_;
+  std::map<std::string, double> gauges_;
+};
+
+base::MessageLoop main_loop;
+
+void signalHandler(int signum) {
+  LOG(INFO) << "sighandler sig:" << signum;
+  main_loop.QuitLoop();
+}
+
+int main(int argc, char* argv[]) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  signal(SIGINT, signalHandler);
+  signal(SIGTERM, signalHandler);
+
+  std::vector<base::MessageLoop*> loops;
+  for (int i = 0; i < FLAGS_loops; i++) {
+    loops.push_back(new base::MessageLoop());
+    loops.back()->SetLoopName("io_" + std::to_string(i));
+    loops.back()->Start();
+  }
+
+  StatsdAggregator aggregator;
+  net::UDPCodecHandler<StatsdPacket> handler(
+      std::bind(&StatsdAggregator::OnPacket, &aggregator,
+                std::placeholders::_1, std::placeholders::_2,
+                std::placeholders::_3));
+
+  net::UDPService::Options options;
+  options.enable_gro = FLAGS_gro;
+
+  net::UDPServer server;
+  server.WithIOLoops(loops).WithOptions(options);
+  server.Serve(net::IPEndPoint(FLAGS_addr, FLAGS_port), &handler);
+
+  main_loop.Start();
+  std::function<void()> dump = [&]() {
+    aggregator.Dump();
+    main_loop.PostDelayTask(NewClosure(dump), FLAGS_flush_ms);
+  };
+  main_loop.PostDelayTask(NewClosure(dump), FLAGS_flush_ms);
+  main_loop.WaitLoopEnd();
+
+  server.StopServer();
+  for (auto loop : loops) {
+    loop->QuitLoop();
+    loop->WaitLoopEnd();
+    delete loop;
+  }
+  return 0;
+}
@@ -39,8 +39,22 @@ public:
     conns_.Remove(ws);
   }
 
+  /* "sub {topic}": subscribe topic
+   * "pub {topic} {content}": broadcast content to topic's subscribers
+   * others: echo back */
   void OnMessage(Websocket* ws, const RefWebsocketFrame& message) {
     LOG(INFO) << __func__ << " message:" << message->Dump();
+    std::string content(message->Payload());
+    auto parts = base::StrUtil::Split(content, ' ');
+    if (parts.size() == 2 && parts[0] == "sub") {
+      broadcaster->Subscribe(ws, parts[1]);
+      return;
+    }
+    if (parts.size() >= 3 && parts[0] == "pub") {
+      size_t offset = parts[0].size() + parts[1].size() + 2;
+      broadcaster->Publish(parts[1], content.substr(offset));
+      return;
+    }
     ws->Send(message);
   }
 
@@ -57,7 +71,10 @@ public:
 
     std::string address = base::StrUtil::Concat("ws://", FLAGS_addr);
 
+    broadcaster.reset(new WSBroadcaster(loops));
+
     wss.WithIOLoops(loops);
+    wss.WithBroadcaster(broadcaster.get());
     wss.Register("/chat", this);
 
     wss.ServeAddress(address);
@@ -76,6 +93,8 @@ public:
 
   WsServer wss;
 
+  std::unique_ptr<WSBroadcaster> broadcaster;
+
   base::MessageLoop main_loop;
 
   nlohmann::json json_message;
@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include "mysql_async_con.h"
+#include "base/time/time_utils.h"
 
 namespace lt {
 
@@ -24,6 +26,7 @@ MysqlAsyncConnect::~MysqlAsyncConnect() {
     query->OnQueryDone();
   }
   query_list_.clear();
+  pending_ = 0;
 
   if (timeout_ || fd_event_) {
     RefTimeoutEvent to = timeout_;
@@ -51,16 +54,16 @@ std::string MysqlAsyncConnect::MysqlWaitStatusString(int status) {
 }
 
 //static
-int MysqlAsyncConnect::LtEvToMysqlStatus(base::LtEvent event) {
+int MysqlAsyncConnect::LtEvToMysqlStatus(base::LtEv::Event event) {
 
   int status = 0;
-  if (event & base::LtEv::LT_EVENT_READ) {
+  if (base::LtEv::has_read(event)) {
     status |= MYSQL_WAIT_READ;
   }
-  if (event & base::LtEv::LT_EVENT_WRITE) {
+  if (base::LtEv::has_write(event)) {
     status |= MYSQL_WAIT_WRITE;
   }
-  if (event & base::LtEv::LT_EVENT_ERROR) {
+  if (base::LtEv::has_error(event)) {
     status |= MYSQL_WAIT_EXCEPT;
   }
   return status;
@@ -121,7 +124,8 @@ bool MysqlAsyncConnect::HandleStateSelectDB(int in_event) {
         DoneCurrentQuery(0, "db change success");
         current_state_ = CONNECTION_IDLE;
       } else {
-        current_state_ = QUERY_START;
+        current_state_ =
+          in_process_->IsPrepared() ? STMT_PREPARE_START : QUERY_START;
       }
       return true;
     } break;
@@ -168,6 +172,7 @@ bool MysqlAsyncConnect::HandleStateConnect(int in_event) {
       return true;
     }break;
     case CLOSE_START: {
+      close_statements();
       int status = mysql_close_start(&mysql_);
       return go_next_state(status, CLOSE_WAIT, CLOSE_DONE);
     }break;
@@ -177,6 +182,7 @@ bool MysqlAsyncConnect::HandleStateConnect(int in_event) {
     } break;
     case CLOSE_DONE: {
       ready_ = false;
+      closed_ = true;
 
       clean_up();
       if (client_) {
@@ -194,6 +200,11 @@ bool MysqlAsyncConnect::HandleStateConnect(int in_event) {
 
 //decide next should connection do
 bool MysqlAsyncConnect::HandleStateIDLE(int in_event) {
+  if (!evicted_stmts_.empty()) {
+    current_state_ = STMT_CLOSE_START;
+    return true;
+  }
+
   if (query_list_.empty()) {
     if (schedule_close_) {
       current_state_ = CLOSE_START;
@@ -214,10 +225,250 @@ bool MysqlAsyncConnect::HandleStateIDLE(int in_event) {
     return true;
   }
 
-  current_state_ = QUERY_START;
+  current_state_ = in_process_->IsPrepared() ? STMT_PREPARE_START : QUERY_START;
   return true;
 }
 
+bool MysqlAsyncConnect::HandleStateStmt(int in_event) {
+  CHECK(in_process_);
+
+  switch(current_state_) {
+    case STMT_PREPARE_START: {
+      const std::string& sql = in_process_->QueryContent();
+      stmt_ = find_statement(sql);
+      if (stmt_) {
+        current_state_ = STMT_EXECUTE_START;
+        return true;
+      }
+      stmt_ = ::mysql_stmt_init(&mysql_);
+      if (!stmt_) {
+        DoneCurrentQuery(CR_OUT_OF_MEMORY, "stmt init failed");
+        current_state_ = CONNECTION_IDLE;
+        return true;
+      }
+      int status = ::mysql_stmt_prepare_start(&stmt_ret_, stmt_,
+                                              sql.c_str(), sql.size());
+      return go_next_state(status, STMT_PREPARE_WAIT, STMT_PREPARE_DONE);
+    } break;
+    case STMT_PREPARE_WAIT: {
+      int status = ::mysql_stmt_prepare_cont(&stmt_ret_, stmt_, in_event);
+      return go_next_state(status, STMT_PREPARE_WAIT, STMT_PREPARE_DONE);
+    } break;
+    case STMT_PREPARE_DONE: {
+      if (stmt_ret_ != 0) {
+        stmt_failed();
+        return true;
+      }
+      cache_statement(in_process_->QueryContent(), stmt_);
+      current_state_ = STMT_EXECUTE_START;
+      return true;
+    } break;
+    case STMT_EXECUTE_START: {
+      const auto& params = in_process_->Params();
+      if (::mysql_stmt_param_count(stmt_) != params.size()) {
+        DoneCurrentQuery(CR_INVALID_PARAMETER_NO, "params count mismatch");
+        stmt_ = NULL;
+        current_state_ = CONNECTION_IDLE;
+        return true;
+      }
+      // params live in in_process_ until executed
+      binds_.assign(params.size(), MYSQL_BIND());
+      for (size_t i = 0; i < params.size(); i++) {
+        binds_[i].buffer_type = MYSQL_TYPE_STRING;
+        binds_[i].buffer = const_cast<char*>(params[i].data());
+        binds_[i].buffer_length = params[i].size();
+      }
+      if (!params.empty() && ::mysql_stmt_bind_param(stmt_, binds_.data())) {
+        stmt_failed();
+        return true;
+      }
+      int status = ::mysql_stmt_execute_start(&stmt_ret_, stmt_);
+      return go_next_state(status, STMT_EXECUTE_WAIT, STMT_EXECUTE_DONE);
+    } break;
+    case STMT_EXECUTE_WAIT: {
+      int status = ::mysql_stmt_execute_cont(&stmt_ret_, stmt_, in_event);
+      return go_next_state(status, STMT_EXECUTE_WAIT, STMT_EXECUTE_DONE);
+    } break;
+    case STMT_EXECUTE_DONE: {
+      if (stmt_ret_ != 0) {
+        stmt_failed();
+        return true;
+      }
+      stmt_meta_ = ::mysql_stmt_result_metadata(stmt_);
+      if (!stmt_meta_) {
+        //no result set, eg: insert/update
+        in_process_->SetAffectedRows(::mysql_stmt_affected_rows(stmt_));
+        DoneCurrentQuery(0, NULL);
+        stmt_ = NULL;
+        current_state_ = CONNECTION_IDLE;
+        return true;
+      }
+      ParseResultDesc(stmt_meta_, in_process_.get());
+
+      //bind no buffer, values fetched by mysql_stmt_fetch_column
+      //once their length known
+      uint32_t field_count = ::mysql_num_fields(stmt_meta_);
+      binds_.assign(field_count, MYSQL_BIND());
+      lengths_.assign(field_count, 0);
+      nulls_.assign(field_count, 0);
+      for (uint32_t i = 0; i < field_count; i++) {
+        binds_[i].buffer_type = MYSQL_TYPE_STRING;
+        binds_[i].length = &lengths_[i];
+        binds_[i].is_null = &nulls_[i];
+      }
+      if (::mysql_stmt_bind_result(stmt_, binds_.data())) {
+        stmt_failed();
+        return true;
+      }
+      current_state_ = STMT_FETCH_START;
+      return true;
+    } break;
+    case STMT_FETCH_START: {
+      int status = ::mysql_stmt_fetch_start(&stmt_ret_, stmt_);
+      return go_next_state(status, STMT_FETCH_WAIT, STMT_FETCH_RESULT_READY);
+    } break;
+    case STMT_FETCH_WAIT: {
+      int status = ::mysql_stmt_fetch_cont(&stmt_ret_, stmt_, in_event);
+      return go_next_state(status, STMT_FETCH_WAIT, STMT_FETCH_RESULT_READY);
+    } break;
+    case STMT_FETCH_RESULT_READY: {
+      if (stmt_ret_ == MYSQL_NO_DATA) {
+        in_process_->SetResultRows(::mysql_stmt_num_rows(stmt_));
+        ::mysql_free_result(stmt_meta_);
+        stmt_meta_ = NULL;
+        ::mysql_stmt_free_result(stmt_);
+
+        DoneCurrentQuery(0, NULL);
+        stmt_ = NULL;
+        current_state_ = CONNECTION_IDLE;
+        return true;
+      }
+      if (stmt_ret_ == 1) {
+        stmt_failed();
+        return true;
+      }
+
+      //MYSQL_DATA_TRUNCATED for all of them bind no buffer
+      ResultRow row(binds_.size());
+      for (uint32_t i = 0; i < binds_.size(); i++) {
+        if (nulls_[i]) {
+          row[i] = "NULL";
+          continue;
+        }
+        if (lengths_[i] == 0) {
+          continue;
+        }
+        row[i].resize(lengths_[i]);
+        MYSQL_BIND bind = MYSQL_BIND();
+        bind.buffer_type = MYSQL_TYPE_STRING;
+        bind.buffer = &row[i][0];
+        bind.buffer_length = lengths_[i];
+        ::mysql_stmt_fetch_column(stmt_, &bind, i, 0);
+      }
+      current_state_ =
+        DeliverRow(std::move(row), STMT_FETCH_START, STMT_FETCH_PAUSED);
+      return current_state_ != STMT_FETCH_PAUSED;
+    } break;
+    default:
+      CHECK(false);
+      break;
+  }
+  return false;
+}
+
+bool MysqlAsyncConnect::HandleStateStmtClose(int in_event) {
+  CHECK(!evicted_stmts_.empty());
+
+  switch(current_state_) {
+    case STMT_CLOSE_START: {
+      int status = ::mysql_stmt_close_start(&stmt_close_ret_,
+                                            evicted_stmts_.front());
+      return go_next_state(status, STMT_CLOSE_WAIT, STMT_CLOSE_DONE);
+    } break;
+    case STMT_CLOSE_WAIT: {
+      int status = ::mysql_stmt_close_cont(&stmt_close_ret_,
+                                           evicted_stmts_.front(), in_event);
+      return go_next_state(status, STMT_CLOSE_WAIT, STMT_CLOSE_DONE);
+    } break;
+    case STMT_CLOSE_DONE: {
+      //handle freed whatever returned, a failed one leaves connection broken
+      evicted_stmts_.pop_front();
+      current_state_ = CONNECTION_IDLE;
+      return true;
+    } break;
+    default:
+      CHECK(false);
+      break;
+  }
+  return false;
+}
+
+MysqlAsyncConnect::State MysqlAsyncConnect::DeliverRow(ResultRow&& row,
+                                                       State next,
+                                                       State paused) {
+  return in_process_->PendingRow(std::move(row)) ? next : paused;
+}
+
+void MysqlAsyncConnect::stmt_failed() {
+  int code = ::mysql_stmt_errno(stmt_);
+  std::string sql = in_process_->QueryContent();
+  DoneCurrentQuery(code, ::mysql_stmt_error(stmt_));
+
+  if (stmt_meta_) {
+    ::mysql_free_result(stmt_meta_);
+    stmt_meta_ = NULL;
+  }
+  auto iter = statements_.find(sql);
+  if (iter != statements_.end() && iter->second.stmt == stmt_) {
+    ::mysql_stmt_free_result(stmt_);
+  } else {
+    //failed to prepare, not cached
+    ::mysql_stmt_close(stmt_);
+  }
+  stmt_ = NULL;
+  current_state_ = IsFatalError(code) ? CLOSE_START : CONNECTION_IDLE;
+}
+
+MYSQL_STMT* MysqlAsyncConnect::find_statement(const std::string& sql) {
+  auto iter = statements_.find(sql);
+  if (iter == statements_.end()) {
+    return NULL;
+  }
+  PreparedStmt& prepared = iter->second;
+  statements_lru_.splice(statements_lru_.begin(), statements_lru_, prepared.lru);
+  return prepared.stmt;
+}
+
+void MysqlAsyncConnect::cache_statement(const std::string& sql, MYSQL_STMT* stmt) {
+  uint32_t max_prepared = std::max(option_.max_prepared, 1u);
+  while (statements_.size() >= max_prepared) {
+    auto iter = statements_.find(statements_lru_.back());
+    //closed async once connection idle
+    evicted_stmts_.push_back(iter->second.stmt);
+    statements_.erase(iter);
+    statements_lru_.pop_back();
+  }
+  statements_lru_.push_front(sql);
+  statements_[sql] = {stmt, statements_lru_.begin()};
+}
+
+void MysqlAsyncConnect::close_statements() {
+  if (stmt_meta_) {
+    ::mysql_free_result(stmt_meta_);
+    stmt_meta_ = NULL;
+  }
+  for (auto& kv : statements_) {
+    ::mysql_stmt_close(kv.second.stmt);
+  }
+  for (MYSQL_STMT* stmt : evicted_stmts_) {
+    ::mysql_stmt_close(stmt);
+  }
+  evicted_stmts_.clear();
+  statements_.clear();
+  statements_lru_.clear();
+  stmt_ = NULL;
+}
+
 //decide can go on or broken
 bool MysqlAsyncConnect::IsFatalError(int code) {
   switch(code) {
@@ -289,7 +540,7 @@ void MysqlAsyncConnect::HandleState(int in_event) {
 
         int err_no = 0;
         int status = ::mysql_real_query_cont(&err_no, &mysql_, in_event);
-        if (err_no_ != 0) {
+        if (err_no != 0) {
           DoneCurrentQuery(err_no, ERR_STR);
           current_state_ = IsFatalError(err_no) ? CLOSE_START : CONNECTION_IDLE;
           st_continue = true;
@@ -352,9 +603,30 @@ void MysqlAsyncConnect::HandleState(int in_event) {
             row.push_back("NULL");
           }
         }
-        in_process_->PendingRow(std::move(row));
-
-        st_continue = go_next_state(0, FETCH_ROW_START, FETCH_ROW_START);
+        current_state_ =
+          DeliverRow(std::move(row), FETCH_ROW_START, FETCH_ROW_PAUSED);
+        st_continue = current_state_ != FETCH_ROW_PAUSED;
+      } break;
+      case FETCH_ROW_PAUSED:
+      case STMT_FETCH_PAUSED: {
+        //until ResumeFetch
+        st_continue = false;
+      } break;
+      case STMT_PREPARE_START:
+      case STMT_PREPARE_WAIT:
+      case STMT_PREPARE_DONE:
+      case STMT_EXECUTE_START:
+      case STMT_EXECUTE_WAIT:
+      case STMT_EXECUTE_DONE:
+      case STMT_FETCH_START:
+      case STMT_FETCH_WAIT:
+      case STMT_FETCH_RESULT_READY: {
+        st_continue = HandleStateStmt(in_event);
+      } break;
+      case STMT_CLOSE_START:
+      case STMT_CLOSE_WAIT:
+      case STMT_CLOSE_DONE: {
+        st_continue = HandleStateStmtClose(in_event);
       } break;
       default: {
         CHECK(false);
@@ -369,10 +641,10 @@ bool MysqlAsyncConnect::ParseResultDesc(MYSQL_RES* result, QuerySession* query)
 
   MYSQL_FIELD *field_desc;
   //uint32_t field_count = ::mysql_num_fields(result);
-  field_desc = ::mysql_fetch_field(result_);
+  field_desc = ::mysql_fetch_field(result);
   while(field_desc != NULL) {
     heards.push_back(field_desc->name);
-    field_desc = ::mysql_fetch_field(result_);
+    field_desc = ::mysql_fetch_field(result);
   }
   return true;
 }
@@ -384,7 +656,13 @@ void MysqlAsyncConnect::DoneCurrentQuery(int code, const char* message) {
     in_process_->SetCode(code, message != NULL ? message : "");
   }
 
-  in_process_->SetAffectedRows(::mysql_affected_rows(&mysql_));
+  if (!in_process_->IsPrepared()) {
+    in_process_->SetAffectedRows(::mysql_affected_rows(&mysql_));
+  }
+  if (!in_process_->health_check_) {
+    last_active_ms_ = base::time_ms();
+  }
+  pending_--;
   in_process_->OnQueryDone();
   in_process_.reset();
 }
@@ -394,31 +672,13 @@ void MysqlAsyncConnect::OnTimeOut() {
   HandleState(MYSQL_WAIT_TIMEOUT);
 }
 
-void MysqlAsyncConnect::OnWaitEventInvoked() {
-  int status = LtEvToMysqlStatus(fd_event_->ActivedEvent());
+void MysqlAsyncConnect::HandleEvent(base::FdEvent* fd_event,
+                                    base::LtEv::Event ev) {
+  int status = LtEvToMysqlStatus(ev);
   reset_wait_event();
   HandleState(status);
 }
 
-bool MysqlAsyncConnect::HandleRead(base::FdEvent* fd_event) {
-  OnWaitEventInvoked();
-  return true;
-}
-
-bool MysqlAsyncConnect::HandleWrite(base::FdEvent* fd_event) {
-  OnWaitEventInvoked();
-  return true;
-}
-bool MysqlAsyncConnect::HandleError(base::FdEvent* fd_event) {
-  OnWaitEventInvoked();
-  return true;
-}
-
-bool MysqlAsyncConnect::HandleClose(base::FdEvent* fd_event) {
-  OnWaitEventInvoked();
-  return true;
-}
-
 void MysqlAsyncConnect::reset_wait_event() {
   base::EventPump* pump = loop_->Pump();
   //pump->RemoveFdEvent(fd_event_.get());
@@ -434,7 +694,7 @@ void MysqlAsyncConnect::WaitMysqlStatus(int status) {
   if (!fd_event_) {
     int fd = ::mysql_get_socket(&mysql_);
     fd_event_ =
-      base::FdEvent::Create(this, fd, base::LtEv::LT_EVENT_NONE);
+      base::FdEvent::Create(this, fd, base::LtEv::NONE);
 
     fd_event_->ReleaseOwnership();
     pump->InstallFdEvent(fd_event_.get());
@@ -465,12 +725,44 @@ void MysqlAsyncConnect::WaitMysqlStatus(int status) {
 void MysqlAsyncConnect::StartQuery(RefQuerySession& query) {
   CHECK(loop_->IsInLoopThread());
 
+  query->connection_ = shared_from_this();
+  pending_++;
+  EnqueueQuery(query);
+}
+
+void MysqlAsyncConnect::PendingQuery(RefQuerySession query) {
+  query->connection_ = shared_from_this();
+  pending_++;
+  loop_->PostTask(NewClosure(
+    std::bind(&MysqlAsyncConnect::EnqueueQuery, shared_from_this(), query)));
+}
+
+void MysqlAsyncConnect::EnqueueQuery(RefQuerySession query) {
+  if (closed_) {
+    pending_--;
+    query->SetCode(-1, "closed");
+    query->OnQueryDone();
+    return;
+  }
   query_list_.push_back(query);
   if (current_state_ == CONNECTION_IDLE && !in_process_) {
     HandleState(0);
   }
 }
 
+void MysqlAsyncConnect::ResumeFetch() {
+  CHECK(loop_->IsInLoopThread());
+
+  if (current_state_ == FETCH_ROW_PAUSED) {
+    current_state_ = FETCH_ROW_START;
+  } else if (current_state_ == STMT_FETCH_PAUSED) {
+    current_state_ = STMT_FETCH_START;
+  } else {
+    return;
+  }
+  HandleState(0);
+}
+
 void MysqlAsyncConnect::InitConnection(const MysqlOptions& option) {
   ::mysql_init(&mysql_);
   option_ = option;
@@ -486,20 +778,26 @@ void MysqlAsyncConnect::InitConnection(const MysqlOptions& option) {
   ::mysql_options(&mysql_, MYSQL_OPT_CONNECT_TIMEOUT, &default_timeout);
 
   timeout_.reset(new base::TimeoutEvent(option.query_timeout, false));
-  timeout_->InstallTimerHandler(NewClosure(std::bind(&MysqlAsyncConnect::OnTimeOut, this)));
+  timeout_->InstallHandler(NewClosure(std::bind(&MysqlAsyncConnect::OnTimeOut, this)));
 
   current_state_ = CONNECT_INIT;
 }
 
+// a query pending to the connection like others instead of a blocking
+// ::mysql_ping, a broken connection get closed by its fatal error
 void MysqlAsyncConnect::do_connection_check() {
-
-  uint64_t start = base::time_us();
-  ready_ = ::mysql_ping(&mysql_) == 0;
-  LOG(INFO) << "::mysql_ping spend " << base::time_us()-start << "(us)";
-
-  if (ready_) return;
-
-  schedule_close_ = true;
+  if (!ready_ || pending_ > 0 ||
+      base::time_ms() - last_active_ms_ < option_.health_check_ms) {
+    return;
+  }
+  RefQuerySession check = QuerySession::New();
+  check->Query("SELECT 1");
+  check->health_check_ = true;
+  check->Then([check]() {
+    LOG_IF(ERROR, check->Code() != 0) << "mysql health check failed, code:"
+      << check->Code() << " message:" << check->ErrorMessage();
+  });
+  StartQuery(check);
 }
 
 void MysqlAsyncConnect::clean_up() {
@@ -513,12 +811,14 @@ void MysqlAsyncConnect::clean_up() {
   }
 
   if (in_process_) {
+    pending_--;
     in_process_->SetCode(-1, "closed");
     in_process_->OnQueryDone();
     in_process_.reset();
   }
 
   for (auto& query : query_list_) {
+    pending_--;
     query->SetCode(-1, "closed");
     query->OnQueryDone();
   }
@@ -527,8 +827,12 @@ void MysqlAsyncConnect::clean_up() {
 
 void MysqlAsyncConnect::Connect() {
   current_state_ = CONNECT_START;
+  last_active_ms_ = base::time_ms();
   loop_->PostTask(NewClosure(std::bind(&MysqlAsyncConnect::HandleState, this, 0)));
-  checker_.Start(60 * 1000, std::bind(&MysqlAsyncConnect::do_connection_check, this));
+  if (option_.health_check_ms > 0) {
+    checker_.Start(option_.health_check_ms,
+                   std::bind(&MysqlAsyncConnect::do_connection_check, this));
+  }
 }
 
 bool MysqlAsyncConnect::SyncConnect() {
@@ -543,7 +847,11 @@ bool MysqlAsyncConnect::SyncConnect() {
   }
   ready_ = true;
   current_state_ = CONNECTION_IDLE;
-  checker_.Start(60 * 1000, std::bind(&MysqlAsyncConnect::do_connection_check, this));
+  last_active_ms_ = base::time_ms();
+  if (option_.health_check_ms > 0) {
+    checker_.Start(option_.health_check_ms,
+                   std::bind(&MysqlAsyncConnect::do_connection_check, this));
+  }
   return true;
 }
 
@@ -551,16 +859,21 @@ void MysqlAsyncConnect::Close() {
   CHECK(loop_->IsInLoopThread());
 
   schedule_close_ = true;
-  if (!in_process_ && current_state_ == QUERY_START) {
+  if (!in_process_ && current_state_ == CONNECTION_IDLE) {
     HandleState(0);
   }
 }
 
 bool MysqlAsyncConnect::SyncClose() {
   CHECK(loop_->IsInLoopThread());
+  if (closed_) {
+    return true;
+  }
 
-  clean_up();
   ready_ = false;
+  closed_ = true;
+  clean_up();
+  close_statements();
   mysql_close(&mysql_);
   current_state_ = CLOSE_DONE;
   return true;
@@ -1,7 +1,9 @@
 #ifndef _LT_MYSQL_ASYNC_CONNECTION_H_H
 #define _LT_MYSQL_ASYNC_CONNECTION_H_H
 
+#include <map>
 #include <list>
+#include <atomic>
 #include <string>
 #include <mysql.h>
 #include <errmsg.h>
@@ -18,12 +20,20 @@ struct MysqlOptions {
   std::string passwd;
   std::string dbname;
   uint32_t query_timeout;
+  // prepared statements cached per connection, LRU evicted
+  uint32_t max_prepared = 64;
+  // ms, a idle connection checked by a query pending as normal ones,
+  // 0 for disable
+  uint32_t health_check_ms = 30000;
 };
 
 
 typedef std::shared_ptr<base::TimeoutEvent> RefTimeoutEvent;
 
-class MysqlAsyncConnect : public base::FdEvent::Handler {
+/* must be owned by a shared_ptr, QuerySession reference it weakly
+ * for resuming a paused row stream */
+class MysqlAsyncConnect : public base::FdEvent::Handler,
+                          public std::enable_shared_from_this<MysqlAsyncConnect> {
 public:
   enum State{
     STATE_NONE = 0,
@@ -45,13 +55,32 @@ public:
     FETCH_ROW_START,
     FETCH_ROW_WAIT,
     FETCH_ROW_RESULT_READY,
+    FETCH_ROW_PAUSED,
+
+    STMT_PREPARE_START,
+    STMT_PREPARE_WAIT,
+    STMT_PREPARE_DONE,
+
+    STMT_EXECUTE_START,
+    STMT_EXECUTE_WAIT,
+    STMT_EXECUTE_DONE,
+
+    STMT_FETCH_START,
+    STMT_FETCH_WAIT,
+    STMT_FETCH_RESULT_READY,
+    STMT_FETCH_PAUSED,
+
+    // close statements evicted from cache, when idle
+    STMT_CLOSE_START,
+    STMT_CLOSE_WAIT,
+    STMT_CLOSE_DONE,
 
     CLOSE_START,
     CLOSE_WAIT,
     CLOSE_DONE,
   };
 
-  static int LtEvToMysqlStatus(base::LtEvent event);
+  static int LtEvToMysqlStatus(base::LtEv::Event event);
   static std::string MysqlWaitStatusString(int status);
 
   struct MysqlClient {
@@ -64,7 +93,17 @@ public:
   MysqlAsyncConnect(MysqlClient* client, base::MessageLoop* bind_loop);
   ~MysqlAsyncConnect();
 
+  // in loop thread
   void StartQuery(RefQuerySession& query);
+  // thread safe, counted in Pending() immediately and queued by a task
+  void PendingQuery(RefQuerySession query);
+  // continue a row fetching paused by RowCallback
+  void ResumeFetch();
+
+  // queries pending and in process
+  int Pending() const {return pending_;}
+  // time_ms of last query done, health check not count
+  int64_t LastActive() const {return last_active_ms_;}
 
   void ResetClient() {client_ = NULL;};
   void InitConnection(const MysqlOptions& option);
@@ -77,7 +116,7 @@ public:
   void Close();
   bool SyncClose();
 
-  bool IsReady() {return ready_;}
+  bool IsReady() const {return ready_;}
 private:
   void DoneCurrentQuery(int code, const char*);
 
@@ -88,14 +127,24 @@ private:
   bool HandleStateIDLE(int in_event = 0);
   bool HandleStateConnect(int in_event = 0);
   bool HandleStateSelectDB(int in_event = 0);
+  bool HandleStateStmt(int in_event = 0);
+  bool HandleStateStmtClose(int in_event = 0);
+
+  void EnqueueQuery(RefQuerySession query);
+
+  // return state to go after a row delivered
+  State DeliverRow(ResultRow&& row, State next, State paused);
+
+  // cached statement of sql or NULL, touch it in LRU
+  MYSQL_STMT* find_statement(const std::string& sql);
+  void cache_statement(const std::string& sql, MYSQL_STMT* stmt);
+  void close_statements();
+  // fail current stmt query, a statement failed to prepare dropped
+  void stmt_failed();
 
   void OnTimeOut();
-  void OnWaitEventInvoked();
 
-  bool HandleRead(base::FdEvent* fd_event) override;
-  bool HandleWrite(base::FdEvent* fd_event) override;
-  bool HandleError(base::FdEvent* fd_event) override;
-  bool HandleClose(base::FdEvent* fd_event) override;
+  void HandleEvent(base::FdEvent* fd_event, base::LtEv::Event ev) override;
 
   void WaitMysqlStatus(int status);
 
@@ -106,8 +155,11 @@ private:
 
   bool ParseResultDesc(MYSQL_RES* result, QuerySession* query);
 private:
+  struct PreparedStmt {
+    MYSQL_STMT* stmt;
+    std::list<std::string>::iterator lru;
+  };
 
-  int err_no_;
   int current_state_;                   // State machine current state
 
   MYSQL mysql_;
@@ -117,6 +169,20 @@ private:
   //typedef char** MYSQL_ROW
   MYSQL_ROW result_row_ = NULL;
 
+  // statement of in process query
+  MYSQL_STMT* stmt_ = NULL;
+  int stmt_ret_ = 0;
+  MYSQL_RES* stmt_meta_ = NULL;
+  std::vector<MYSQL_BIND> binds_;
+  std::vector<unsigned long> lengths_;
+  std::vector<my_bool> nulls_;
+  std::map<std::string, PreparedStmt> statements_;
+  // front the most recently used
+  std::list<std::string> statements_lru_;
+  // evicted, closed by STMT_CLOSE_* before next query
+  std::list<MYSQL_STMT*> evicted_stmts_;
+  my_bool stmt_close_ret_ = 0;
+
   MysqlOptions option_;
   MysqlClient* client_ = NULL;
   base::MessageLoop* loop_ = NULL;
@@ -124,8 +190,12 @@ private:
   RefTimeoutEvent timeout_;
   base::RepeatingTimer checker_;
 
-  bool ready_ = false;
+  std::atomic<bool> ready_{false};
   bool schedule_close_ = false;
+  // closed, new query fail immediately
+  bool closed_ = false;
+  std::atomic<int> pending_{0};
+  std::atomic<int64_t> last_active_ms_{0};
 
   std::string last_selected_db_;
   RefQuerySession in_process_;
@@ -0,0 +1,302 @@
+#include "mysql_pool.h"
+
+#include <future>
+#include <algorithm>
+
+#include "base/time/time_utils.h"
+#include "base/coroutine/co_runner.h"
+
+namespace lt {
+
+namespace {
+
+// run fn in loop and wait it done
+void sync_run(base::MessageLoop* loop, std::function<void()> fn) {
+  if (loop->IsInLoopThread()) {
+    return fn();
+  }
+  std::promise<void> done;
+  loop->PostTask(NewClosure([&]() {
+    fn();
+    done.set_value();
+  }));
+  done.get_future().wait();
+}
+
+}  // namespace
+
+RowStream::RowStream(RefQuerySession session, size_t high_water)
+  : session_(session),
+    high_water_(std::max<size_t>(high_water, 1)) {
+}
+
+RowStream::~RowStream() {
+  //rows left discarded by session callback, not to leave it paused
+  bool paused = false;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    paused = paused_;
+    paused_ = false;
+  }
+  if (paused) {
+    session_->Resume();
+  }
+}
+
+bool RowStream::Next(ResultRow* row) {
+  CHECK(CO_CANYIELD);
+
+  std::unique_lock<std::mutex> lock(mtx_);
+  while (rows_.empty() && !done_) {
+    resumer_ = CO_RESUMER;
+    lock.unlock();
+    CO_YIELD;
+    lock.lock();
+  }
+  if (rows_.empty()) {
+    return false;
+  }
+  *row = std::move(rows_.front());
+  rows_.pop_front();
+
+  if (paused_ && rows_.size() <= high_water_ / 2) {
+    paused_ = false;
+    lock.unlock();
+    session_->Resume();
+  }
+  return true;
+}
+
+bool RowStream::OnRow(ResultRow&& row) {
+  std::unique_lock<std::mutex> lock(mtx_);
+  rows_.push_back(std::move(row));
+  paused_ = rows_.size() >= high_water_;
+  bool go_on = !paused_;
+  wakeup_locked(lock);
+  return go_on;
+}
+
+void RowStream::OnDone() {
+  std::unique_lock<std::mutex> lock(mtx_);
+  done_ = true;
+  wakeup_locked(lock);
+}
+
+void RowStream::wakeup_locked(std::unique_lock<std::mutex>& lock) {
+  base::LtClosure resumer = std::move(resumer_);
+  resumer_ = nullptr;
+  lock.unlock();
+  if (resumer) {
+    resumer();
+  }
+}
+
+MysqlPool::MysqlPool(const std::vector<base::MessageLoop*>& loops)
+  : loops_(loops) {
+  CHECK(!loops_.empty());
+  //not thread safe, before any connection created
+  ::mysql_library_init(0, NULL, NULL);
+}
+
+MysqlPool::~MysqlPool() {
+  if (maintainer_) {
+    maintainer_->Stop();
+  }
+  std::list<RefMysqlConnect> connections;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    closing_ = true;
+    connections.swap(connections_);
+    connections.splice(connections.end(), retiring_);
+  }
+  //detach from pool and close them in their loops
+  for (auto& con : connections) {
+    sync_run(con->BindLoop(), [&]() {
+      con->ResetClient();
+      con->SyncClose();
+    });
+  }
+}
+
+void MysqlPool::Initialize(const MysqlPoolOptions& options) {
+  options_ = options;
+  options_.max_connections = std::max(
+    std::max(options_.max_connections, options_.min_connections), 1u);
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (uint32_t i = 0; i < options_.min_connections; i++) {
+      new_connection_locked();
+    }
+  }
+  maintainer_.reset(new base::RepeatingTimer(loops_[0]));
+  maintainer_->Start(1000, std::bind(&MysqlPool::Maintain, this));
+}
+
+void MysqlPool::Close() {
+  std::list<RefMysqlConnect> connections;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    closing_ = true;
+    connections.swap(connections_);
+    retiring_.insert(retiring_.end(), connections.begin(), connections.end());
+  }
+  if (maintainer_) {
+    maintainer_->Stop();
+  }
+  for (auto& con : connections) {
+    con->BindLoop()->PostTask(
+      NewClosure(std::bind(&MysqlAsyncConnect::Close, con)));
+  }
+}
+
+void MysqlPool::PendingQuery(RefQuerySession query) {
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    RefMysqlConnect con = closing_ ? nullptr : select_connection_locked();
+    if (con) {
+      //counted before Maintain can see it idle
+      return con->PendingQuery(query);
+    }
+  }
+  query->SetCode(-1, "pool closed");
+  query->OnQueryDone();
+}
+
+RefRowStream MysqlPool::Query(const std::string& sql, size_t high_water) {
+  RefQuerySession session = QuerySession::New();
+  session->Query(sql);
+  return StreamQuery(session, high_water);
+}
+
+RefRowStream MysqlPool::Execute(const std::string& sql,
+                                const std::vector<std::string>& params,
+                                size_t high_water) {
+  RefQuerySession session = QuerySession::New();
+  session->Execute(sql, params);
+  return StreamQuery(session, high_water);
+}
+
+RefRowStream MysqlPool::StreamQuery(RefQuerySession session,
+                                    size_t high_water) {
+  RefRowStream stream(new RowStream(session, high_water));
+
+  std::weak_ptr<RowStream> weak_stream(stream);
+  session->OnRow([weak_stream](ResultRow&& row) -> bool {
+    auto stream = weak_stream.lock();
+    //reader gone, drain the rest
+    return stream ? stream->OnRow(std::move(row)) : true;
+  });
+  session->Then([weak_stream]() {
+    if (auto stream = weak_stream.lock()) {
+      stream->OnDone();
+    }
+  });
+  PendingQuery(session);
+  return stream;
+}
+
+size_t MysqlPool::Size() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return connections_.size();
+}
+
+size_t MysqlPool::ReadyCount() {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return std::count_if(connections_.begin(), connections_.end(),
+                       [](const RefMysqlConnect& con) {
+                         return con->IsReady();
+                       });
+}
+
+RefMysqlConnect MysqlPool::new_connection_locked() {
+  base::MessageLoop* loop = loops_[next_loop_++ % loops_.size()];
+
+  RefMysqlConnect con(new MysqlAsyncConnect(this, loop));
+  con->InitConnection(options_.mysql);
+  con->Connect();
+  connections_.push_back(con);
+  return con;
+}
+
+RefMysqlConnect MysqlPool::select_connection_locked() {
+  RefMysqlConnect best;
+  for (auto& con : connections_) {
+    if (!best ||
+        (con->IsReady() && !best->IsReady()) ||
+        (con->IsReady() == best->IsReady() &&
+         con->Pending() < best->Pending())) {
+      best = con;
+    }
+  }
+  if ((!best || best->Pending() >= (int)options_.grow_threshold) &&
+      connections_.size() < options_.max_connections) {
+    //a connecting one queue queries until it ready
+    RefMysqlConnect con = new_connection_locked();
+    if (!best) {
+      best = con;
+    }
+  }
+  return best;
+}
+
+void MysqlPool::Maintain() {
+  std::vector<RefMysqlConnect> idles;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (closing_) {
+      return;
+    }
+    int64_t now = base::time_ms();
+    auto iter = connections_.begin();
+    while (iter != connections_.end() &&
+           connections_.size() > options_.min_connections) {
+      RefMysqlConnect& con = *iter;
+      if (con->IsReady() && con->Pending() == 0 &&
+          now - con->LastActive() > options_.idle_timeout_ms) {
+        idles.push_back(con);
+        retiring_.push_back(con);
+        iter = connections_.erase(iter);
+        continue;
+      }
+      iter++;
+    }
+    while (connections_.size() < options_.min_connections) {
+      new_connection_locked();
+    }
+  }
+  for (auto& con : idles) {
+    con->BindLoop()->PostTask(
+      NewClosure(std::bind(&MysqlAsyncConnect::Close, con)));
+  }
+}
+
+void MysqlPool::OnConnectReady(MysqlAsyncConnect* con) {
+  VLOG(1) << "mysql pool connection ready, host:" << options_.mysql.host;
+}
+
+void MysqlPool::OnConnectionClosed(MysqlAsyncConnect* con) {
+  RefMysqlConnect closed;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto list : {&connections_, &retiring_}) {
+      auto iter = std::find_if(list->begin(), list->end(),
+                               [con](const RefMysqlConnect& c) {
+                                 return c.get() == con;
+                               });
+      if (iter != list->end()) {
+        closed = *iter;
+        list->erase(iter);
+        LOG(INFO) << "mysql pool connection closed, host:"
+          << options_.mysql.host;
+        break;
+      }
+    }
+  }
+  if (!closed) {
+    return;
+  }
+  //called in its state machine, release it after that
+  con->BindLoop()->PostTask(NewClosure([closed]() {}));
+}
+
+}  // namespace lt
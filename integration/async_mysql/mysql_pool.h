@@ -0,0 +1,130 @@
+#ifndef _LT_MYSQL_POOL_H_H
+#define _LT_MYSQL_POOL_H_H
+
+#include <deque>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "mysql_async_con.h"
+#include "query_session.h"
+#include "base/message_loop/message_loop.h"
+#include "base/message_loop/repeating_timer.h"
+
+namespace lt {
+
+class RowStream;
+typedef std::shared_ptr<RowStream> RefRowStream;
+typedef std::shared_ptr<MysqlAsyncConnect> RefMysqlConnect;
+
+struct MysqlPoolOptions {
+  MysqlOptions mysql;
+  // connections kept, reconnected when broken
+  uint32_t min_connections = 1;
+  // 0: same as min_connections
+  uint32_t max_connections = 0;
+  // a new connection created when the least pending connection has more
+  uint32_t grow_threshold = 4;
+  // ms, connections above min_connections closed when idle so long
+  uint32_t idle_timeout_ms = 60000;
+};
+
+/* rows of a query streamed to a coroutine, rows buffered at most
+ * high_water, fetching paused until reader drain it to half of it
+ *
+ * co_go [&]() {
+ *   auto rows = pool->Query("select name, age from users");
+ *   ResultRow row;
+ *   while (rows->Next(&row)) {...}
+ *   if (rows->Code() != 0) {...}
+ * };
+ * */
+class RowStream {
+public:
+  ~RowStream();
+
+  // yield until a row ready, false when no more rows or failed
+  bool Next(ResultRow* row);
+
+  // valid after Next return false
+  int Code() const {return session_->Code();}
+  const std::string& ErrorMessage() const {return session_->ErrorMessage();}
+  int32_t AffectedRows() const {return session_->AffectedRows();}
+  // valid after first row
+  const RowHeaders& Headers() const {return session_->ColumnHeaders();}
+private:
+  friend class MysqlPool;
+  RowStream(RefQuerySession session, size_t high_water);
+
+  // in connection loop
+  bool OnRow(ResultRow&& row);
+  void OnDone();
+  void wakeup_locked(std::unique_lock<std::mutex>& lock);
+
+  RefQuerySession session_;
+  const size_t high_water_;
+
+  std::mutex mtx_;
+  std::deque<ResultRow> rows_;
+  bool done_ = false;
+  bool paused_ = false;
+  base::LtClosure resumer_;
+};
+
+/* connections spread over loops, a query pending to the ready one
+ * with least queries pending, the pool grow to max_connections when
+ * all of them busy(grow_threshold), and shrink to min_connections
+ * by idle timeout; broken connections dropped and the min ones
+ * reconnected in background */
+class MysqlPool : public MysqlAsyncConnect::MysqlClient {
+public:
+  // loops must outlive the pool
+  explicit MysqlPool(const std::vector<base::MessageLoop*>& loops);
+  ~MysqlPool();
+
+  void Initialize(const MysqlPoolOptions& options);
+
+  // close all connections, queries pending fail with code -1
+  void Close();
+
+  // thread safe, callback style
+  void PendingQuery(RefQuerySession query);
+
+  // in coroutine, rows delivered as they fetched
+  RefRowStream Query(const std::string& sql, size_t high_water = 256);
+  RefRowStream Execute(const std::string& sql,
+                       const std::vector<std::string>& params,
+                       size_t high_water = 256);
+
+  size_t Size();
+  size_t ReadyCount();
+
+  void OnConnectReady(MysqlAsyncConnect* con) override;
+  void OnConnectionClosed(MysqlAsyncConnect* con) override;
+private:
+  RefRowStream StreamQuery(RefQuerySession session, size_t high_water);
+
+  // under mtx_
+  RefMysqlConnect new_connection_locked();
+  RefMysqlConnect select_connection_locked();
+
+  // in loops_[0]
+  void Maintain();
+
+  MysqlPoolOptions options_;
+  std::vector<base::MessageLoop*> loops_;
+  std::atomic<uint32_t> next_loop_{0};
+
+  std::mutex mtx_;
+  bool closing_ = false;
+  std::list<RefMysqlConnect> connections_;
+  // closed by idle timeout or Close, until OnConnectionClosed
+  std::list<RefMysqlConnect> retiring_;
+
+  std::unique_ptr<base::RepeatingTimer> maintainer_;
+};
+
+}
+#endif
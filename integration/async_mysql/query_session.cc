@@ -1,4 +1,5 @@
 #include "query_session.h"
+#include "mysql_async_con.h"
 
 namespace lt {
 //static
@@ -21,6 +22,17 @@ QuerySession& QuerySession::Query(const std::string& sql) {
   query_ = sql;
   return *this;
 }
+QuerySession& QuerySession::Execute(const std::string& sql,
+                                    const std::vector<std::string>& params) {
+  query_ = sql;
+  params_ = params;
+  prepared_ = true;
+  return *this;
+}
+QuerySession& QuerySession::OnRow(RowCallback callback) {
+  row_callback_ = std::move(callback);
+  return *this;
+}
 QuerySession& QuerySession::Then(base::LtClosure callback) {
   finish_callback_ = callback;
   return *this;
@@ -36,8 +48,22 @@ void QuerySession::SetCode(int code, const char* err_message) {
   err_message_ = err_message;
 }
 
-void QuerySession::PendingRow(ResultRow&& one_row) {
+bool QuerySession::PendingRow(ResultRow&& one_row) {
+  if (row_callback_) {
+    return row_callback_(std::move(one_row));
+  }
   results_.push_back(std::move(one_row));
+  return true;
+}
+
+void QuerySession::Resume() {
+  auto connection = connection_.lock();
+  if (!connection) {
+    return;
+  }
+  // always by task, the connection may pausing it in loop right now
+  connection->BindLoop()->PostTask(
+    NewClosure(std::bind(&MysqlAsyncConnect::ResumeFetch, connection)));
 }
 
 void QuerySession::OnQueryDone() {
@@ -45,6 +71,7 @@ void QuerySession::OnQueryDone() {
     finish_callback_();
   }
   finish_callback_ = nullptr;
+  row_callback_ = nullptr;
 }
 
 }//end lt
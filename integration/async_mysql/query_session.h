@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include <memory>
+#include <functional>
 
 #include <mysql.h>
 #include "base/closure/closure_task.h"
@@ -20,6 +21,8 @@ typedef std::vector<std::string> ResultRow;
 typedef std::vector<ResultRow> QueryResults;
 typedef std::vector<std::string> RowHeaders;
 typedef std::shared_ptr<QuerySession> RefQuerySession;
+// return false to pause fetching rows, until QuerySession::Resume
+typedef std::function<bool(ResultRow&&)> RowCallback;
 
 class QuerySession {
   public:
@@ -28,8 +31,21 @@ class QuerySession {
 
     QuerySession& UseDB(const std::string& db);
     QuerySession& Query(const std::string& sql);
+    // a server side prepared statement with '?' params, statements
+    // prepared are cached by connection for the same sql
+    QuerySession& Execute(const std::string& sql,
+                          const std::vector<std::string>& params);
+    // rows streamed to callback as they fetched in connection loop,
+    // instead of buffered in Result()
+    QuerySession& OnRow(RowCallback callback);
     QuerySession& Then(base::ClosureCallback callback);
 
+    // continue fetching rows paused by RowCallback, thread safe
+    void Resume();
+
+    bool IsPrepared() const {return prepared_;}
+    const std::vector<std::string>& Params() const {return params_;}
+
     const int Code() const {return code_;}
     const std::string& ErrorMessage() const {return err_message_;}
     const RowHeaders& ColumnHeaders() const {return colum_names_;}
@@ -40,6 +56,7 @@ class QuerySession {
   private:
     friend class MysqlAsyncConnect;
     friend class MysqlAsyncClientImpl;
+    friend class MysqlPool;
 
     QuerySession();
 
@@ -47,7 +64,8 @@ class QuerySession {
 
     const std::string& DB() const {return db_name_;};
 
-    void PendingRow(ResultRow&& one_row);
+    // false when callback want a pause
+    bool PendingRow(ResultRow&& one_row);
     void SetCode(int code, const char* err_message);
     void SetCode(int code, std::string& err_message);
     void SetResultRows(int rows) { result_count_ = rows;}
@@ -59,13 +77,20 @@ class QuerySession {
 
     std::string query_;
     std::string db_name_;
+    bool prepared_ = false;
+    std::vector<std::string> params_;
+    // internal health check query
+    bool health_check_ = false;
 
     int32_t result_count_ = 0;
     int32_t affected_rows_ = 0;
 
     RowHeaders colum_names_;
     QueryResults results_;
+    RowCallback row_callback_;
     base::ClosureCallback finish_callback_;
+    // connection run it, set before query pending to it
+    std::weak_ptr<MysqlAsyncConnect> connection_;
 };
 
 }//end lt
@@ -42,6 +42,7 @@ void AsyncChannel::SendRequest(RefCodecMessage request) {
   // guard herer ?
   // A -> b -> c -> call something it delete this Channel --> Back to A
   request->SetIOCtx(codec_);
+  OnRequestOut(request.get());
 
   bool success = codec_->SendRequest(request.get());
   if (!success) {
@@ -55,7 +56,7 @@ void AsyncChannel::SendRequest(RefCodecMessage request) {
   auto guard_this = shared_from_this();
   auto functor = std::bind(&AsyncChannel::OnRequestTimeout, guard_this, weak);
 
-  IOLoop()->PostDelayTask(NewClosure(functor), request_timeout_);
+  IOLoop()->PostDelayTask(NewClosure(functor), RequestTimeout(request.get()));
 
   uint64_t message_identify = request->AsyncId();
   in_progress_.insert(std::make_pair(message_identify, std::move(request)));
@@ -69,13 +70,13 @@ void AsyncChannel::OnRequestTimeout(const WeakCodecMessage& weak) {
     return;
   }
 
-
   uint64_t identify = request->AsyncId();
   size_t numbers = in_progress_.erase(identify);
   if (numbers == 0) {
     VLOG(VTRACE) << "message has reponsed";
     return;
   }
+  codec_->CancelRequest(request.get());
   request->SetFailCode(MessageCode::kTimeOut);
   HandleResponse(request, nullptr);
 }
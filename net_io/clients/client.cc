@@ -45,6 +45,7 @@ namespace lt {
 namespace net {
 
 static const uint32_t kConnetBatchCount = 10;
+static const uint32_t kMinReapInterval = 500;
 const uint32_t Client::kMaxReconInterval = 10000;
 
 Client::Client(base::MessageLoop* loop, const url::RemoteInfo& info)
@@ -52,8 +53,11 @@ Client::Client(base::MessageLoop* loop, const url::RemoteInfo& info)
     remote_info_(info),
     work_loop_(loop),
     stopping_(false),
-    delegate_(NULL) {
+    delegate_(NULL),
+    inflight_count_(0),
+    next_reconnect_interval_(0) {
   next_index_ = 0;
+  growing_.clear();
   CHECK(work_loop_);
 
   auto empty_list = std::make_shared<ClientChannelList>();
@@ -82,14 +86,42 @@ void Client::Initialize(const ClientConfig& config) {
                          address_,
                          this);
   }
+
+  if (config_.idle_timeout_ms > 0) {
+    uint32_t interval = std::max(config_.idle_timeout_ms / 2, kMinReapInterval);
+    reap_timer_.reset(new base::RepeatingTimer(work_loop_));
+    reap_timer_->Start(interval,
+                       std::bind(&Client::reap_idle_channels, this));
+  }
 }
 
-void Client::Finalize() {
-  if (stopping_.exchange(true)) {
-    return;
+bool Client::WaitForWarmup(int64_t timeout_ms) {
+  CHECK(!work_loop_->IsInLoopThread());
+
+  auto warmed = [this]() -> bool {
+    return stopping_ || ready_count() >= config_.connections;
+  };
+  std::unique_lock<std::mutex> lck(warmup_mtx_);
+  if (timeout_ms < 0) {
+    warmup_cv_.wait(lck, warmed);
+  } else {
+    warmup_cv_.wait_for(lck, std::chrono::milliseconds(timeout_ms), warmed);
   }
+  return !stopping_ && ready_count() >= config_.connections;
+}
 
-  channels_count_ = 0;
+void Client::Finalize() {
+  {
+    std::lock_guard<std::mutex> lck(warmup_mtx_);
+    if (stopping_.exchange(true)) {
+      return;
+    }
+    channels_count_ = 0;
+  }
+  warmup_cv_.notify_all();
+  if (reap_timer_) {
+    reap_timer_->Stop();
+  }
   work_loop_->PostTask(FROM_HERE, &Connector::Stop, connector_);
 
   auto channels = std::atomic_load(&in_use_channels_);
@@ -134,12 +166,76 @@ base::MessageLoop* Client::next_client_io_loop() {
   return io_loop ? io_loop : work_loop_;
 }
 
+uint32_t Client::max_count() const {
+  return std::max(config_.connections, config_.max_connections);
+}
+
 uint32_t Client::required_count() const {
-  return config_.connections;
+  uint32_t threshold = std::max(config_.grow_threshold, uint32_t(1));
+  uint64_t demand = (inflight_count_ + threshold - 1) / threshold;
+  demand = std::max(demand, uint64_t(config_.connections));
+  return std::min(demand, uint64_t(max_count()));
+}
+
+uint32_t Client::ready_count() const {
+  uint32_t count = 0;
+  auto channels = std::atomic_load(&in_use_channels_);
+  for (const RefClientChannel& ch : *channels) {
+    count += (ch && ch->Ready()) ? 1 : 0;
+  }
+  return count;
+}
+
+void Client::grow_pool_if_need() {
+  if (stopping_ || max_count() <= config_.connections) {
+    return;
+  }
+  uint64_t connected = ConnectedCount();
+  if (connected >= max_count() ||
+      inflight_count_ <= connected * config_.grow_threshold) {
+    return;
+  }
+  if (growing_.test_and_set()) {
+    return;
+  }
+  work_loop_->PostTask(FROM_HERE, &Client::launch_next_if_need, this);
+}
+
+void Client::reap_idle_channels() {
+  CHECK(work_loop_->IsInLoopThread());
+
+  uint32_t keep_count = required_count();
+  if (stopping_ || channels_.size() <= keep_count) {
+    return;
+  }
+
+  uint32_t reap_count = channels_.size() - keep_count;
+  for (const RefClientChannel& ch : channels_) {
+    if (reap_count == 0) {
+      break;
+    }
+    if (!ch->Ready() || !ch->IsIdleFor(config_.idle_timeout_ms)) {
+      continue;
+    }
+    reap_count--;
+    // close in io loop, removed from list when close notified back
+    ch->IOLoop()->PostTask(FROM_HERE,
+                           &ClientChannel::CloseIfIdle,
+                           ch,
+                           config_.idle_timeout_ms);
+  }
+}
+
+void Client::update_in_use_channels() {
+  RefClientChannelList new_list(
+      new ClientChannelList(channels_.begin(), channels_.end()));
+  channels_count_.store(new_list->size());
+  std::atomic_store(&in_use_channels_, new_list);
 }
 
 void Client::launch_next_if_need() {
   CHECK(work_loop_->IsInLoopThread());
+  growing_.clear();
 
   uint64_t connected = ConnectedCount();
   uint32_t inprocess_cnt = connector_->InprocessCount();
@@ -180,6 +276,11 @@ void Client::OnConnected(int socket_fd, IPEndPoint& local, IPEndPoint& remote) {
       CodecFactory::NewClientService(remote_info_.scheme, io_loop);
   CHECK(codec) << "no supported codec for:" << remote_info_.scheme;
 
+  if (config_.keepalive_sec > 0) {
+    int idle = config_.keepalive_sec;
+    socketutils::KeepAliveProbe(socket_fd, idle, std::max(idle / 3, 1), 3);
+  }
+
   RefClientChannel client_channel = CreateClientChannel(this, codec);
   client_channel->SetRequestTimeout(config_.message_timeout);
 
@@ -202,10 +303,7 @@ void Client::OnConnected(int socket_fd, IPEndPoint& local, IPEndPoint& remote) {
                     &ClientChannel::StartClientChannel,
                     client_channel);
 
-  RefClientChannelList new_list(
-      new ClientChannelList(channels_.begin(), channels_.end()));
-  channels_count_.store(new_list->size());
-  std::atomic_store(&in_use_channels_, new_list);
+  update_in_use_channels();
   VLOG(VINFO) << ClientInfo() << " connected, initializing...";
 
   launch_next_if_need();
@@ -221,6 +319,12 @@ void Client::OnClientChannelInited(const ClientChannel* channel) {
   if (delegate_) {
     delegate_->OnClientChannelReady(channel);
   }
+  // channel ready already, lock to avoid notify between waiter's
+  // predicate check and its sleep
+  {
+    std::lock_guard<std::mutex> lck(warmup_mtx_);
+  }
+  warmup_cv_.notify_all();
   VLOG(VINFO) << ClientInfo() << "@" << channel << " ready for use";
 }
 
@@ -234,17 +338,10 @@ void Client::OnClientChannelClosed(const RefClientChannel& channel) {
 
   VLOG(VINFO) << ClientInfo() << "@" << channel.get() << " closed";
 
-  do {
-    channels_.remove_if([&](const RefClientChannel& ch) -> bool {
-      return ch == NULL || ch == channel;
-    });
-
-    RefClientChannelList new_list(
-        new ClientChannelList(channels_.begin(), channels_.end()));
-    channels_count_.store(new_list->size());
-
-    std::atomic_store(&in_use_channels_, new_list);
-  } while (0);
+  channels_.remove_if([&](const RefClientChannel& ch) -> bool {
+    return ch == NULL || ch == channel;
+  });
+  update_in_use_channels();
 
   // reconnect
   launch_next_if_need();
@@ -257,6 +354,7 @@ void Client::OnClientChannelClosed(const RefClientChannel& channel) {
 
 void Client::OnRequestGetResponse(const RefCodecMessage& request,
                                   const RefCodecMessage& response) {
+  inflight_count_--;
   request->SetResponse(response);
   request->GetWorkCtx().resumer_fn();
 }
@@ -266,15 +364,23 @@ bool Client::AsyncDoRequest(const RefCodecMessage& req,
   base::MessageLoop* worker = next_client_io_loop();
   CHECK(worker);
 
+  if (!apply_context(req.get())) {
+    return false;
+  }
+
   // IMPORTANT: avoid self holder for capture list
-  CodecMessage* request = req.get();
+  std::weak_ptr<CodecMessage> weak_req(req);
 
   base::LtClosure resumer = [=]() {
+    // resumed by the channel holding it, the posted task keep request
+    // (and the response it owns) alive until callback run in worker
+    RefCodecMessage request = weak_req.lock();
     if (worker->IsInLoopThread()) {
-      callback(request->RawResponse());
+      callback(request ? request->RawResponse() : nullptr);
     } else {
-      auto responser = std::bind(callback, request->RawResponse());
-      worker->PostTask(FROM_HERE, responser);
+      worker->PostTask(FROM_HERE, [request, callback]() {
+        callback(request ? request->RawResponse() : nullptr);
+      });
     }
   };
 
@@ -285,13 +391,24 @@ bool Client::AsyncDoRequest(const RefCodecMessage& req,
     return false;
   }
 
+  inflight_count_++;
+  grow_pool_if_need();
+
   base::MessageLoop* io = client->IOLoop();
-  return io->PostTask(FROM_HERE, &ClientChannel::SendRequest, client, req);
+  if (!io->PostTask(FROM_HERE, &ClientChannel::SendRequest, client, req)) {
+    inflight_count_--;
+    return false;
+  }
+  return true;
 }
 
 CodecMessage* Client::DoRequest(RefCodecMessage& message) {
   CHECK(CO_CANYIELD);
 
+  if (!apply_context(message.get())) {
+    return NULL;
+  }
+
   message->SetWorkerCtx(base::MessageLoop::Current(), CO_RESUMER);
 
   auto channel = get_ready_channel();
@@ -302,11 +419,15 @@ CodecMessage* Client::DoRequest(RefCodecMessage& message) {
     return NULL;
   }
 
+  inflight_count_++;
+  grow_pool_if_need();
+
   base::MessageLoop* io_loop = channel->IOLoop();
   if (!io_loop->PostTask(FROM_HERE,
                          &ClientChannel::SendRequest,
                          channel,
                          message)) {
+    inflight_count_--;
     message->SetFailCode(MessageCode::kConnBroken);
     return NULL;
   }
@@ -316,14 +437,35 @@ CodecMessage* Client::DoRequest(RefCodecMessage& message) {
   return message->RawResponse();
 }
 
+bool Client::apply_context(CodecMessage* message) const {
+  co::RefContext ctx = co::Context::Current();
+  if (!ctx) {
+    return true;
+  }
+  if (ctx->Done()) {
+    message->SetFailCode(MessageCode::kTimeOut);
+    VLOG(VTRACE) << ClientInfo() << ", context done, request not sent";
+    return false;
+  }
+  uint32_t timeout = message->TimeoutMs();
+  timeout = ctx->LimitTimeout(timeout > 0 ? timeout : config_.message_timeout);
+  message->SetTimeoutMs(std::max<uint32_t>(timeout, 1));
+  return true;
+}
+
 uint64_t Client::ConnectedCount() const {
   return channels_count_;
 }
 
+uint32_t Client::ConnectingCount() const {
+  return connector_ ? connector_->InprocessCount() : 0;
+}
+
 std::string Client::ClientInfo() const {
   std::ostringstream oss;
   oss << "[remote:" << RemoteIpPort() << ", in_use:" << ConnectedCount()
-      << ", connecting:" << connector_->InprocessCount() << "]";
+      << ", connecting:" << connector_->InprocessCount()
+      << ", inflight:" << InflightCount() << "]";
   return oss.str();
 }
 
@@ -21,6 +21,7 @@
 #include <atomic>
 #include <chrono>  // std::chrono::seconds
 #include <cinttypes>
+#include <condition_variable>
 #include <list>
 #include <memory>
 #include <mutex>  // std::mutex, std::unique_lock
@@ -33,6 +34,10 @@
 #include "queued_channel.h"
 
 #include <base/ltio_config.h>
+#include <base/message_loop/repeating_timer.h>
+#ifdef LTIO_WITH_CXX20_COROUTINE
+#include <base/coroutine/co_task.h>
+#endif
 #include <net_io/url_utils.h>
 #include "net_io/codec/codec_factory.h"
 #include "net_io/codec/codec_message.h"
@@ -88,6 +93,10 @@ public:
 
   void Initialize(const ClientConfig& config);
 
+  /* block caller till `connections` channels ready or timeout,
+   * return true when pool warm up; can't call in client loops*/
+  bool WaitForWarmup(int64_t timeout_ms);
+
   void SetDelegate(ClientDelegate* delegate);
 
   Client* Use(Interceptor* interceptor);
@@ -104,6 +113,15 @@ public:
 
   bool AsyncDoRequest(const RefCodecMessage& req, AsyncCallBack);
 
+#ifdef LTIO_WITH_CXX20_COROUTINE
+  // co_await in a co::Task, the response or nullptr; req kept by caller
+  co::CallbackAwaiter<CodecMessage*> AwaitRequest(const RefCodecMessage& req) {
+    return co::CallbackAwaiter<CodecMessage*>([this, req](AsyncCallBack cb) {
+      return AsyncDoRequest(req, std::move(cb));
+    });
+  }
+#endif
+
   // notified from connector
   void OnConnectFailed(uint32_t count) override;
   // notified from connector
@@ -125,6 +143,14 @@ public:
 
   uint64_t ConnectedCount() const;
 
+  uint64_t InflightCount() const { return inflight_count_; }
+
+  // connected and initialized channels
+  uint32_t ReadyCount() const { return ready_count(); }
+
+  // connections in dialing
+  uint32_t ConnectingCount() const;
+
   std::string ClientInfo() const;
 
   std::string RemoteIpPort() const;
@@ -132,14 +158,31 @@ public:
 private:
   void launch_next_if_need();
 
+  // dial more connection when in-flight requests pile up
+  void grow_pool_if_need();
+
+  // close idle channels more than required
+  void reap_idle_channels();
+
+  // publish channels_ to in_use_channels_ for caller
+  void update_in_use_channels();
+
+  uint32_t max_count() const;
+
   uint32_t required_count() const;
 
+  uint32_t ready_count() const;
+
   /*return a connected and initialized channel*/
   RefClientChannel get_ready_channel();
 
   /*return a io loop for client channel work on*/
   base::MessageLoop* next_client_io_loop();
 
+  /* request timeout limited in the co::Context of caller,
+   * false with kTimeOut when the context done already*/
+  bool apply_context(CodecMessage* message) const;
+
   IPEndPoint address_;
 
   const url::RemoteInfo remote_info_;
@@ -164,6 +207,16 @@ private:
   std::atomic<uint32_t> channels_count_;
   std::list<RefClientChannel> channels_;
 
+  // request in flight, drive the pool size between
+  // config_.connections and config_.max_connections
+  std::atomic<uint64_t> inflight_count_;
+  std::atomic_flag growing_;
+
+  std::unique_ptr<base::RepeatingTimer> reap_timer_;
+
+  std::mutex warmup_mtx_;
+  std::condition_variable warmup_cv_;
+
   /* reset to zero when a success connected
    * otherwise increase utill kMaxReconInterval*/
   uint32_t next_reconnect_interval_;
@@ -44,11 +44,30 @@ namespace lt {
 namespace net {
 
 typedef struct ClientConfig {
+  // min connections, dialed at Initialize and always kept
   uint32_t connections = 1;
+
+  // pool grows up to this under in-flight pressure;
+  // 0: same as `connections`, a fixed size pool
+  uint32_t max_connections = 0;
+
+  // grow one more connection when in-flight requests
+  // per connection exceed this value
+  uint32_t grow_threshold = 8;
+
+  // 0: never reap; otherwise connections idle longer than
+  // this are closed till pool shrinks back to `connections`
+  uint32_t idle_timeout_ms = 0;
+
   // 0: without heartbeat needed
-  // heartbeat need protocol service supported
+  // heartbeat need protocol service supported(raw/http),
+  // only sent when connection idle for heartbeat_ms
   uint32_t heartbeat_ms = 0;
 
+  // 0: without tcp keepalive; otherwise SO_KEEPALIVE enabled
+  // and first probe sent after connection idle for this seconds
+  uint32_t keepalive_sec = 0;
+
   uint32_t recon_interval = 5000;
 
   uint16_t connect_timeout = 5000;
@@ -20,6 +20,7 @@
 //
 
 #include "client_channel.h"
+#include <base/time/time_utils.h>
 #include <base/utils/string/str_utils.h>
 #include "async_channel.h"
 #include "queued_channel.h"
@@ -38,7 +39,7 @@ RefClientChannel CreateClientChannel(ClientChannel::Delegate* delegate,
 }
 
 ClientChannel::ClientChannel(Delegate* d, const RefCodecService& service)
-  : delegate_(d), codec_(service) {
+  : delegate_(d), codec_(service), last_active_ms_(base::time_ms()) {
 
   codec_->SetHandler(this);
   codec_->SetDelegate(this);
@@ -98,25 +99,70 @@ const url::RemoteInfo* ClientChannel::GetRemoteInfo() const {
   return NULL;
 }
 
+bool ClientChannel::IsIdleFor(int64_t ms) const {
+  if (inflight_count_ > 0) {
+    return false;
+  }
+  return base::delta_ms(last_active_ms_) >= ms;
+}
+
+void ClientChannel::CloseIfIdle(int64_t ms) {
+  CHECK(IOLoop()->IsInLoopThread());
+  if (!Ready() || !IsIdleFor(ms)) {
+    return;
+  }
+  VLOG(VINFO) << ConnectionInfo() << " idle over " << ms << "ms, close it";
+  codec_->CloseService(false);
+}
+
+void ClientChannel::OnRequestOut(const CodecMessage* request) {
+  inflight_count_++;
+  if (request != heartbeat_message_.get()) {
+    last_active_ms_ = base::time_ms();
+  }
+}
+
 void ClientChannel::OnHearbeatTimerInvoke() {
   if (heartbeat_message_) {
     LOG(ERROR) << __FUNCTION__ << " heartbea snowball";
     return;
   }
+  // busy connection is alive, no need probe
+  if (!IsIdleFor(heartbeat_ms_)) {
+    return;
+  }
   heartbeat_message_ = codec_->NewHeartbeat();
+  if (!heartbeat_message_) {
+    return;
+  }
   return SendRequest(heartbeat_message_);
 }
 
 bool ClientChannel::HandleResponse(const RefCodecMessage& req,
                                    const RefCodecMessage& res) {
+  if (inflight_count_ > 0) {
+    inflight_count_--;
+  }
+
   if (heartbeat_message_.get() == req.get()) {
     LOG_IF(INFO, !res) << "heartbeat got null response, code:" << req->FailCode();
     heartbeat_message_.reset();
     if (res && !res->IsHeartbeat()) {
-      LOG(ERROR) << "heartbeat message got none heartbeat response";
+      VLOG(VINFO) << "heartbeat message got none heartbeat response";
+    }
+    // peer not response the probe, treat it as a broken connection,
+    // close in a new task bz here may inside a codec callback
+    if (!res && req->FailCode() == MessageCode::kTimeOut) {
+      RefCodecService codec = codec_;
+      IOLoop()->PostTask(FROM_HERE, [codec]() {
+        if (codec->IsConnected()) {
+          codec->CloseService(false);
+        }
+      });
     }
     return true;
   }
+  last_active_ms_ = base::time_ms();
 
   if (delegate_) {
     delegate_->OnRequestGetResponse(req, res);
@@ -149,6 +195,7 @@ void ClientChannel::OnCodecReady(const RefCodecService& service) {
   }
 
   if (codec_->KeepHeartBeat() && heartbeat_ms > 50) {
+    heartbeat_ms_ = heartbeat_ms;
     heartbeat_timer_ = new base::TimeoutEvent(heartbeat_ms, true);
 
     auto heartbeat_fun = std::bind(&ClientChannel::OnHearbeatTimerInvoke, this);
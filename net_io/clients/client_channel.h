@@ -18,6 +18,8 @@
 #ifndef _LT_NET_CLIENT_CHANNEL_H
 #define _LT_NET_CLIENT_CHANNEL_H
 
+#include <atomic>
+
 #include "base/message_loop/timeout_event.h"
 #include "net_io/codec/codec_message.h"
 #include "net_io/codec/codec_service.h"
@@ -69,6 +71,14 @@ public:
 
   void SetRequestTimeout(uint32_t ms) { request_timeout_ = ms; };
 
+  // no request in flight and no user request for `ms`;
+  // heartbeat won't refresh the idle time, thread safe
+  bool IsIdleFor(int64_t ms) const;
+
+  // close this channel when it still idle for `ms`, a close
+  // notify to delegate like a passive broken connection
+  void CloseIfIdle(int64_t ms);
+
   ::base::EventPump* EventPump() { return codec_->Pump(); }
 
   ::base::MessageLoop* IOLoop() { return codec_->IOLoop(); };
@@ -84,6 +94,14 @@ protected:
   void OnHearbeatTimerInvoke();
   std::string ConnectionInfo() const;
 
+  // book keeping for idle detecting, call before request send out
+  void OnRequestOut(const CodecMessage* request);
+
+  // request's own timeout first, otherwise channel default
+  uint32_t RequestTimeout(const CodecMessage* request) const {
+    return request->TimeoutMs() > 0 ? request->TimeoutMs() : request_timeout_;
+  }
+
   // return true when message be handled, otherwise return false
   bool HandleResponse(const RefCodecMessage& req, const RefCodecMessage& res);
 
@@ -94,6 +112,11 @@ protected:
   uint32_t request_timeout_ = 5000;  // 5s
   base::TimeoutEvent* heartbeat_timer_ = NULL;
   RefCodecMessage heartbeat_message_;
+  uint32_t heartbeat_ms_ = 0;
+
+  // written in io loop, read by client for pool management
+  std::atomic<uint32_t> inflight_count_ = {0};
+  std::atomic<int64_t> last_active_ms_ = {0};
 };
 
 RefClientChannel CreateClientChannel(ClientChannel::Delegate*, RefCodecService);
@@ -68,6 +68,7 @@ void Connector::Dial(const net::IPEndPoint& ep, Connector::Delegate* r) {
       pump_->InstallFdEvent(ev.get());
 
       inprogress_.push_back(connect_ctx{ev, r});
+      count_.store(inprogress_.size());
 
       VLOG(VTRACE) << "connect inprogress fd:" << sock_fd;
 
@@ -116,7 +117,7 @@ ConnDetail Connector::DialSync(const net::IPEndPoint& ep) {
 }
 
 void Connector::HandleEvent(FdEvent* fdev, base::LtEv::Event ev) {
-  if (base::LtEv::has_read(ev)) {
+  if (base::LtEv::has_write(ev)) {
     return HandleWrite(fdev);
   }
   // read/error/close
@@ -149,11 +150,13 @@ void Connector::HandleWrite(base::FdEvent* event) {
 
   connect_ctx c = *iter;
   inprogress_.erase(iter);
+  count_.store(inprogress_.size());
 
   IPEndPoint remote_addr, local_addr;
   if (!socketutils::GetPeerEndpoint(socket_fd, &remote_addr) ||
       !socketutils::GetLocalEndpoint(socket_fd, &local_addr)) {
     LOG(ERROR) << "bad socket fd, connect failed";
+    socketutils::CloseSocket(socket_fd);
     c.hdl->OnConnectFailed(inprogress_.size());
     return;
   }
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "clients_manager.h"
+
+#include "base/logging.h"
+#include "fmt/core.h"
+#include "glog/logging.h"
+
+namespace lt {
+namespace net {
+
+namespace {
+
+std::string origin_key(const url::RemoteInfo& remote) {
+  return fmt::format("{}://{}:{}", remote.scheme, remote.host_ip, remote.port);
+}
+
+}  // namespace
+
+ClientsManager::ClientsManager(base::MessageLoop* loop,
+                               ClientDelegate* delegate)
+  : loop_(loop),
+    delegate_(delegate) {
+  CHECK(loop_ && delegate_);
+}
+
+ClientsManager::~ClientsManager() {
+  Finalize();
+}
+
+void ClientsManager::SetClientConfig(const ClientConfig& config) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  config_ = config;
+}
+
+RefClient ClientsManager::GetClient(const std::string& remote) {
+  url::RemoteInfo info;
+  if (!url::ParseRemote(remote, info)) {
+    LOG(ERROR) << __FUNCTION__ << " bad remote:" << remote;
+    return nullptr;
+  }
+  return GetClient(info);
+}
+
+RefClient ClientsManager::GetClient(const url::RemoteInfo& remote) {
+  if (remote.scheme.empty() || remote.host_ip.empty()) {
+    LOG(ERROR) << __FUNCTION__ << " bad remote:" << remote.HostIpPort();
+    return nullptr;
+  }
+  const std::string key = origin_key(remote);
+
+  std::lock_guard<std::mutex> lck(mtx_);
+  if (finalized_) {
+    return nullptr;
+  }
+  auto iter = clients_.find(key);
+  if (iter != clients_.end()) {
+    return iter->second;
+  }
+
+  RefClient client = std::make_shared<Client>(loop_, remote);
+  client->SetDelegate(delegate_);
+  client->Initialize(config_);
+  clients_.emplace(key, client);
+
+  VLOG(VINFO) << __FUNCTION__ << " new client for:" << key;
+  return client;
+}
+
+size_t ClientsManager::ClientCount() const {
+  std::lock_guard<std::mutex> lck(mtx_);
+  return clients_.size();
+}
+
+std::vector<RefClient> ClientsManager::Clients() const {
+  std::vector<RefClient> result;
+  std::lock_guard<std::mutex> lck(mtx_);
+  for (auto& kv : clients_) {
+    result.push_back(kv.second);
+  }
+  return result;
+}
+
+void ClientsManager::Finalize() {
+  std::unordered_map<std::string, RefClient> clients;
+  {
+    std::lock_guard<std::mutex> lck(mtx_);
+    finalized_ = true;
+    clients.swap(clients_);
+  }
+  for (auto& kv : clients) {
+    kv.second->Finalize();
+  }
+}
+
+}  // namespace net
+}  // namespace lt
@@ -18,19 +18,56 @@
 #ifndef _NET_CLIENTS_MANAGER_H_H
 #define _NET_CLIENTS_MANAGER_H_H
 
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 #include "client.h"
 
 namespace lt {
 namespace net {
 
+/**
+ * ClientsManager keep a connection pool(a Client) per remote origin
+ * `scheme://host_ip:port`, client created lazily at first use and
+ * share the same config/delegate; eg: a http client talk to many hosts
+ *
+ * thread-safe, returned client can be cached by caller
+ * */
 class ClientsManager {
 public:
-  ClientsManager();
+  ClientsManager(base::MessageLoop* loop, ClientDelegate* delegate);
   ~ClientsManager();
 
-  void RegisterClient();
+  void SetClientConfig(const ClientConfig& config);
+
+  // eg: http://127.0.0.1:80, h2c://host:8080
+  RefClient GetClient(const std::string& remote);
+
+  RefClient GetClient(const url::RemoteInfo& remote);
+
+  size_t ClientCount() const;
+
+  // a copy of all clients
+  std::vector<RefClient> Clients() const;
+
+  void Finalize();
 
 private:
+  base::MessageLoop* loop_;
+
+  ClientDelegate* delegate_;
+
+  ClientConfig config_;
+
+  bool finalized_ = false;
+
+  mutable std::mutex mtx_;
+
+  std::unordered_map<std::string, RefClient> clients_;
+
+  DISALLOW_COPY_AND_ASSIGN(ClientsManager);
 };
 
 }  // namespace net
@@ -43,6 +43,7 @@ void QueuedChannel::SendRequest(RefCodecMessage request) {
   CHECK(IOLoop()->IsInLoopThread());
 
   request->SetIOCtx(codec_);
+  OnRequestOut(request.get());
   waiting_list_.push_back(std::move(request));
 
   TrySendNext();
@@ -72,7 +73,8 @@ bool QueuedChannel::TrySendNext() {
         ing_request_);  // weak ptr must init outside, Take Care of weakptr
     auto functor =
         std::bind(&QueuedChannel::OnRequestTimeout, shared_from_this(), weak);
-    IOLoop()->PostDelayTask(NewClosure(functor), request_timeout_);
+    IOLoop()->PostDelayTask(NewClosure(functor),
+                            RequestTimeout(ing_request_.get()));
   }
   return success;
 }
@@ -22,6 +22,7 @@
 #include <net_io/codec/codec_message.h>
 #include <atomic>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 namespace lt {
@@ -47,6 +48,23 @@ public:
 
   virtual RefClient GetNextClient(const std::string& hash_key,
                                   CodecMessage* hint_message = NULL) = 0;
+
+  // all clients added, for health inspecting from other threads
+  std::vector<RefClient> Clients() const {
+    std::lock_guard<std::mutex> lck(members_mtx_);
+    return members_;
+  }
+
+protected:
+  // called by AddClient, recorded for Clients()
+  void AddMember(const RefClient& client) {
+    std::lock_guard<std::mutex> lck(members_mtx_);
+    members_.push_back(client);
+  }
+
+private:
+  mutable std::mutex members_mtx_;
+  std::vector<RefClient> members_;
 };
 
 }  // namespace net
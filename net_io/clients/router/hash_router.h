@@ -34,6 +34,7 @@ public:
   virtual ~HashRouter(){};
 
   void AddClient(RefClient&& client) override {
+    AddMember(client);
     clients_.push_back(std::move(client));
   };
 
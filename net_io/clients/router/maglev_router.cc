@@ -26,6 +26,7 @@ static uint32_t k_num_seed = 0x12345678;
 static uint32_t k_hash_seed = 0x87654321;
 
 void MaglevRouter::AddClient(RefClient&& client) {
+  AddMember(client);
   clients_.push_back(client);
 }
 
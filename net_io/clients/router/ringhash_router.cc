@@ -39,6 +39,7 @@ void RingHashRouter::AddClient(RefClient&& client) {
   for (uint32_t i = 0; i < vnode_count_; i++) {
     clients_.insert(ClientNode(client, i));
   }
+  AddMember(client);
 }
 
 RefClient RingHashRouter::GetNextClient(const std::string& key,
@@ -21,6 +21,7 @@ namespace lt {
 namespace net {
 
 void RoundRobinRouter::AddClient(RefClient&& client) {
+  AddMember(client);
   clients_.push_back(std::move(client));
 }
 
@@ -6,49 +6,31 @@
 #include "net_io/socket_utils.h"
 #include "net_io/codec/codec_factory.h"
 #include "net_io/tcp_channel.h"
+#include "tcp_stream.h"
 
-using lt::net::SockaddrStorage;
 using namespace lt::net::socketutils;
 using lt::net::TcpChannel;
 using lt::net::SocketChannelPtr;
 
 namespace coso {
 
+namespace {
+const int kAcceptRetryMs = 50;
+}
+
 IOService::IOService(const IPEndPoint& addr) : address_(addr) {}
 
 void IOService::Run() {
-  int socket = CreateNoneBlockTCP(address_.GetSockAddrFamily());
-  CHECK(socket > 0);
-  ReUseSocketPort(socket, true);
-  ReUseSocketAddress(socket, true);
-
-  SockaddrStorage storage;
-  address_.ToSockAddr(storage.AsSockAddr(), storage.Size());
-
-  int ret = BindSocketFd(socket, storage.AsSockAddr());
-  CHECK(ret >= 0) << Name() << " bind socket fail, socket:" << socket;
-  CHECK(ListenSocket(socket) >= 0)
-      << "listen fail, reason:" << base::StrError();
-
-  return accept_loop(socket);
-}
-
-void IOService::accept_loop(int socket) {
-  base::FdEvent fdev(socket, base::LtEv::READ);
-  co::IOEvent ioev(&fdev);
+  co::TcpListener listener(address_);
   do {
-    ioev.Wait();
-    LOG(INFO) << "accept loop awake";
-
-    int err = 0;
-    struct sockaddr socket_in;
-    int peer_fd = AcceptSocket(socket, &socket_in, &err);
+    IPEndPoint client_addr;
+    int peer_fd = listener.Accept(&client_addr);
     if (peer_fd < 0) {
-      LOG(ERROR) << "accept failed, err:" << base::StrError(err);
+      // hard error eg: EMFILE, give other coroutines a chance to
+      // release fds instead of spinning the loop
+      co_sleep(kAcceptRetryMs);
       continue;
     }
-    IPEndPoint client_addr;
-    client_addr.FromSockAddr(&socket_in, sizeof(socket_in));
     VLOG(VTRACE) << "accept a connection:" << client_addr.ToString();
 
     // spawn a corotine handle this connection
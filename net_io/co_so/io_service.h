@@ -33,7 +33,6 @@ public:
   void OnCodecClosed(const lt::net::RefCodecService& service) override;
 
 private:
-  void accept_loop(int socket);
   void handle_connection(int client_socket, const IPEndPoint& peer);
 
   Handler* handler_;
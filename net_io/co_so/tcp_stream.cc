@@ -0,0 +1,346 @@
+#include "tcp_stream.h"
+
+#include <errno.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "base/coroutine/co_runner.h"
+#include "base/logging.h"
+#include "base/time/time_utils.h"
+#include "base/utils/sys_error.h"
+#include "glog/logging.h"
+#include "net_io/base/sockaddr_storage.h"
+#include "net_io/socket_utils.h"
+
+using lt::net::SockaddrStorage;
+namespace socketutils = lt::net::socketutils;
+
+namespace co {
+
+namespace {
+
+const size_t kReadBlockSize = 4096;
+
+// edge triggered, only woke by changes after a syscall would block
+base::RefFdEvent edge_event(int fd, base::LtEv::Event ev) {
+  base::RefFdEvent fdev = base::FdEvent::Create(nullptr, fd, ev);
+  fdev->SetEdgeTrigger(true);
+  return fdev;
+}
+
+int64_t deadline_of(int ms) {
+  return ms > 0 ? base::time_ms() + ms : 0;
+}
+
+int listen_socket(const IPEndPoint& address) {
+  int socket = socketutils::CreateNoneBlockTCP(address.GetSockAddrFamily());
+  CHECK(socket > 0);
+  socketutils::ReUseSocketPort(socket, true);
+  socketutils::ReUseSocketAddress(socket, true);
+
+  SockaddrStorage storage;
+  address.ToSockAddr(storage.AsSockAddr(), storage.Size());
+
+  CHECK(socketutils::BindSocketFd(socket, storage.AsSockAddr()) >= 0)
+      << address.ToString() << " bind socket fail, socket:" << socket;
+  CHECK(socketutils::ListenSocket(socket) >= 0)
+      << "listen fail, reason:" << base::StrError();
+  return socket;
+}
+
+}  // namespace
+
+const int TcpStream::kClosed;
+const int TcpStream::kError;
+const int TcpStream::kTimeout;
+const int TcpStream::kOverflow;
+
+TcpStream::TcpStream(int socket)
+  : fdev_(edge_event(socket, base::LtEv::READ | base::LtEv::WRITE)),
+    ioev_(fdev_.get()) {
+  socketutils::GetPeerEndpoint(socket, &peer_);
+}
+
+TcpStream::~TcpStream() {}
+
+int TcpStream::ReadSome(int ms) {
+  return read_some(deadline_of(ms));
+}
+
+int TcpStream::ReadExact(size_t n, int ms) {
+  int64_t deadline = deadline_of(ms);
+  while (in_.CanReadSize() < n) {
+    int res = read_some(deadline);
+    if (res <= 0) {
+      return res;
+    }
+  }
+  return n;
+}
+
+int TcpStream::ReadUntil(const std::string& delim, int ms, size_t limit) {
+  CHECK(!delim.empty());
+
+  int64_t deadline = deadline_of(ms);
+  // bytes searched without delim
+  size_t scanned = 0;
+  do {
+    size_t size = std::min(in_.CanReadSize(), limit);
+    const char* data = in_.GetRead();
+    const char* end = data + size;
+    const char* found =
+        std::search(data + scanned, end, delim.begin(), delim.end());
+    if (found != end) {
+      return found - data + delim.size();
+    }
+    if (size >= limit) {
+      return kOverflow;
+    }
+    scanned = size < delim.size() ? 0 : size - delim.size() + 1;
+
+    int res = read_some(deadline);
+    if (res <= 0) {
+      return res;
+    }
+  } while (true);
+}
+
+int TcpStream::Write(const char* data, size_t len, int ms) {
+  if (closed_) {
+    return kError;
+  }
+  // keep data in order with the data not flushed
+  if (out_.Empty()) {
+    int res = write_socket(data, len);
+    if (res < 0) {
+      return res;
+    }
+    data += res;
+    len -= res;
+    if (len == 0) {
+      return res;
+    }
+  }
+  size_t total = out_.CanReadSize() + len;
+  out_.WriteRawData(data, len);
+  int res = flush(deadline_of(ms));
+  return res < 0 ? res : total;
+}
+
+int TcpStream::Flush(int ms) {
+  return flush(deadline_of(ms));
+}
+
+void TcpStream::Close() {
+  if (closed_) {
+    return;
+  }
+  closed_ = true;
+  socketutils::ShutdownWrite(Fd());
+}
+
+int TcpStream::Read(IOBuffer* buf) {
+  do {
+    int res = read_socket(buf);
+    if (res != kAgain) {
+      return res;
+    }
+    ignore_result(wait(0));
+  } while (true);
+}
+
+bool TcpStream::TryFlush(IOBuffer* buf) {
+  if (closed_) {
+    return false;
+  }
+  int res = write_socket(buf->GetRead(), buf->CanReadSize());
+  if (res < 0) {
+    return false;
+  }
+  buf->Consume(res);
+  return true;
+}
+
+int32_t TcpStream::Send(const char* data, int32_t len) {
+  return Write(data, static_cast<size_t>(len));
+}
+
+int TcpStream::read_socket(IOBuffer* buf) {
+  if (eof_) {
+    return kClosed;
+  }
+  int total = 0;
+  do {
+    buf->EnsureWritableSize(kReadBlockSize);
+    size_t writable = buf->CanWriteSize();
+    ssize_t n = ::read(Fd(), buf->GetWrite(), writable);
+    if (n > 0) {
+      buf->Produce(n);
+      total += n;
+      // drained most likely, save a syscall return EAGAIN
+      if (size_t(n) < writable) {
+        break;
+      }
+      continue;
+    }
+    if (n == 0) {
+      eof_ = true;
+      break;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN) {
+      break;
+    }
+    error_ = errno;
+    VLOG(VTRACE) << peer_.ToString() << " read err:" << base::StrError();
+    return total > 0 ? total : kError;
+  } while (true);
+
+  if (total > 0) {
+    return total;
+  }
+  return eof_ ? kClosed : kAgain;
+}
+
+int TcpStream::write_socket(const char* data, size_t len) {
+  size_t written = 0;
+  while (written < len) {
+    ssize_t n = ::write(Fd(), data + written, len - written);
+    if (n >= 0) {
+      written += n;
+      continue;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if (errno == EAGAIN) {
+      break;
+    }
+    error_ = errno;
+    VLOG(VTRACE) << peer_.ToString() << " write err:" << base::StrError();
+    return kError;
+  }
+  return written;
+}
+
+int TcpStream::read_some(int64_t deadline) {
+  do {
+    int res = read_socket(&in_);
+    if (res != kAgain) {
+      return res;
+    }
+    res = wait(deadline);
+    if (res < 0) {
+      return res;
+    }
+  } while (true);
+}
+
+int TcpStream::flush(int64_t deadline) {
+  int total = 0;
+  while (!out_.Empty()) {
+    if (closed_) {
+      return kError;
+    }
+    int res = write_socket(out_.GetRead(), out_.CanReadSize());
+    if (res < 0) {
+      return res;
+    }
+    out_.Consume(res);
+    total += res;
+    if (out_.Empty()) {
+      break;
+    }
+    res = wait(deadline);
+    if (res < 0) {
+      return res;
+    }
+  }
+  return total;
+}
+
+int TcpStream::wait(int64_t deadline) {
+  int ms = -1;
+  if (deadline > 0) {
+    ms = deadline - base::time_ms();
+    if (ms <= 0) {
+      return kTimeout;
+    }
+  }
+  // error/hangup events reported as readable/writable, the syscall
+  // retried tell the detail
+  return ioev_.Wait(ms) == IOEvent::Timeout ? kTimeout : 0;
+}
+
+TcpListener::TcpListener(const IPEndPoint& address)
+  : address_(address),
+    fdev_(edge_event(listen_socket(address), base::LtEv::READ)),
+    ioev_(fdev_.get()) {}
+
+TcpListener::~TcpListener() {}
+
+int TcpListener::Accept(IPEndPoint* peer, int ms) {
+  int64_t deadline = deadline_of(ms);
+  do {
+    int err = 0;
+    struct sockaddr_in6 addr;
+    int socket = socketutils::AcceptSocket(
+        fdev_->GetFd(), reinterpret_cast<struct sockaddr*>(&addr), &err);
+    if (socket >= 0) {
+      if (peer) {
+        socketutils::GetPeerEndpoint(socket, peer);
+      }
+      return socket;
+    }
+    if (err != EAGAIN && err != EINTR && err != ECONNABORTED) {
+      LOG(ERROR) << "accept failed, err:" << base::StrError(err);
+      return -1;
+    }
+    int wait_ms = -1;
+    if (deadline > 0) {
+      wait_ms = deadline - base::time_ms();
+      if (wait_ms <= 0) {
+        return -1;
+      }
+    }
+    if (err == EAGAIN && ioev_.Wait(wait_ms) == IOEvent::Timeout) {
+      return -1;
+    }
+  } while (true);
+}
+
+int ConnectTcp(const IPEndPoint& address, int ms) {
+  int socket = socketutils::CreateNoneBlockTCP(address.GetSockAddrFamily());
+  if (socket < 0) {
+    return -1;
+  }
+  SockaddrStorage storage;
+  if (address.ToSockAddr(storage.AsSockAddr(), storage.Size()) == 0) {
+    socketutils::CloseSocket(socket);
+    return -1;
+  }
+
+  int err = 0;
+  if (socketutils::Connect(socket, storage.AsSockAddr(), &err) == 0) {
+    return socket;
+  }
+  if (err == EINPROGRESS) {
+    base::FdEvent fdev(socket, base::LtEv::WRITE);
+    fdev.ReleaseOwnership();
+    IOEvent ioev(&fdev);
+    err = ioev.Wait(ms) == IOEvent::Timeout
+              ? ETIMEDOUT
+              : socketutils::GetSocketError(socket);
+  }
+  if (err == 0) {
+    return socket;
+  }
+  VLOG(VTRACE) << "connect " << address.ToString()
+               << " failed:" << base::StrError(err);
+  socketutils::CloseSocket(socket);
+  return -1;
+}
+
+}  // namespace co
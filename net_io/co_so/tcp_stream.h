@@ -0,0 +1,147 @@
+#ifndef LT_CO_NET_TCP_STREAM_H_
+#define LT_CO_NET_TCP_STREAM_H_
+
+#include <string>
+
+#include "base/coroutine/io_event.h"
+#include "base/message_loop/fd_event.h"
+#include "net_io/base/ip_endpoint.h"
+#include "net_io/io_buffer.h"
+#include "socket_rw.h"
+
+namespace co {
+
+using lt::net::IOBuffer;
+using lt::net::IPEndPoint;
+
+/*
+ * IMPORTANT: like co::IOEvent, live in the coroutine using it(stack)
+ *
+ * a tcp connection driven by its coroutine, reads and writes yield the
+ * coroutine until done, error or deadline, so protocol handled linearly
+ * without callbacks; data read kept in ReadBuffer for zero-copy parsing
+ *
+ * co_go [fd]() {
+ *   co::TcpStream stream(fd);
+ *   int len = stream.ReadUntil("\r\n", 5000);
+ *   if (len <= 0) return;
+ *   handle(stream.ReadBuffer()->GetRead(), len);
+ *   stream.ReadBuffer()->Consume(len);
+ *   stream.Write("+OK\r\n");
+ * };
+ *
+ * ms of a operation is the deadline of the whole operation, <= 0 no
+ * deadline; the fd monitored edge triggered, a syscall tried before
+ * every wait, no epoll_ctl per operation
+ * */
+class TcpStream : public so::SocketReader, public so::SocketWriter {
+public:
+  // result of operations, > 0 for bytes
+  static const int kClosed = 0;     // peer closed
+  static const int kError = -1;
+  static const int kTimeout = -2;
+  static const int kOverflow = -3;  // ReadUntil delimiter not in limit
+
+  // take the owner of a connected non-blocking socket
+  explicit TcpStream(int socket);
+  ~TcpStream();
+
+  int Fd() const { return fdev_->GetFd(); }
+  const IPEndPoint& Peer() const { return peer_; }
+  // errno of last kError
+  int LastError() const { return error_; }
+
+  // read bytes available into ReadBuffer, wait when nothing to read
+  __CO_WAIT__ int ReadSome(int ms = -1);
+
+  // until ReadBuffer has n bytes at least, return n
+  __CO_WAIT__ int ReadExact(size_t n, int ms = -1);
+
+  // until delim in ReadBuffer, return bytes till the end of delim;
+  // kOverflow when not found in the first limit bytes
+  __CO_WAIT__ int ReadUntil(const std::string& delim,
+                            int ms = -1,
+                            size_t limit = 1 << 20);
+
+  // write all data, yield until flushed to socket, return len
+  __CO_WAIT__ int Write(const char* data, size_t len, int ms = -1);
+  __CO_WAIT__ int Write(const std::string& data, int ms = -1) {
+    return Write(data.data(), data.size(), ms);
+  }
+
+  // write all of WriteBuffer, data left in it when failed
+  __CO_WAIT__ int Flush(int ms = -1);
+
+  // consumed by user
+  IOBuffer* ReadBuffer() { return &in_; }
+  // build the data in place, then Flush it
+  IOBuffer* WriteBuffer() { return &out_; }
+
+  // shutdown write, socket closed when stream gone
+  void Close();
+  bool IsClosed() const { return closed_; }
+
+  // so::SocketReader/so::SocketWriter
+  bool Start(bool server) override { return !closed_; }
+  int Read(IOBuffer* buf) override;
+  bool TryFlush(IOBuffer* buf) override;
+  using so::SocketWriter::Send;
+  int32_t Send(const char* data, int32_t len) override;
+
+private:
+  // internal: syscall would block
+  static const int kAgain = -100;
+
+  // > 0 bytes, kClosed, kError or kAgain
+  int read_socket(IOBuffer* buf);
+  // >= 0 bytes, kError
+  int write_socket(const char* data, size_t len);
+
+  int read_some(int64_t deadline);
+  int flush(int64_t deadline);
+
+  // kTimeout or 0 for retry the syscall
+  int wait(int64_t deadline);
+
+  base::RefFdEvent fdev_;
+  IOEvent ioev_;
+  IPEndPoint peer_;
+
+  IOBuffer in_;
+  IOBuffer out_;
+
+  int error_ = 0;
+  bool eof_ = false;
+  bool closed_ = false;
+
+  DISALLOW_ALLOCT_HEAP_OBJECT;
+  DISALLOW_COPY_AND_ASSIGN(TcpStream);
+};
+
+/* listen on a address in coroutine, accepted sockets handled by
+ * TcpStream; live in the accepting coroutine like TcpStream */
+class TcpListener {
+public:
+  // bind and listen, CHECK when address not available
+  explicit TcpListener(const IPEndPoint& address);
+  ~TcpListener();
+
+  // a accepted non-blocking socket, -1 when timeout or failed
+  __CO_WAIT__ int Accept(IPEndPoint* peer = nullptr, int ms = -1);
+
+  const IPEndPoint& Address() const { return address_; }
+
+private:
+  IPEndPoint address_;
+  base::RefFdEvent fdev_;
+  IOEvent ioev_;
+
+  DISALLOW_ALLOCT_HEAP_OBJECT;
+  DISALLOW_COPY_AND_ASSIGN(TcpListener);
+};
+
+// connect in coroutine, a connected non-blocking socket or -1
+__CO_WAIT__ int ConnectTcp(const IPEndPoint& address, int ms = -1);
+
+}  // namespace co
+#endif
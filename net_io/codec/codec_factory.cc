@@ -24,6 +24,7 @@
 #include "raw/raw_codec_service.h"
 #include "redis/resp_codec_service.h"
 #include "websocket/ws_codec_service.h"
+#include "net_io/rpc/rpc_codec_service.h"
 
 #ifdef LTIO_WITH_HTTP2
 #include "http/h2/h2_codec_service.h"
@@ -109,6 +110,11 @@ void CodecFactory::InitInnerDefault() {
         auto service = std::make_shared<RawCodecService<RawMessage>>(loop);
         return std::static_pointer_cast<CodecService>(service);
       }));
+  creators_.insert(
+      std::make_pair("rpc", [](MessageLoop* loop) -> RefCodecService {
+        auto service = std::make_shared<RpcCodecService>(loop);
+        return std::static_pointer_cast<CodecService>(service);
+      }));
   creators_.insert(
       std::make_pair("redis", [](MessageLoop* loop) -> RefCodecService {
         std::shared_ptr<RespCodecService> service(new RespCodecService(loop));
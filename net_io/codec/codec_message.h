@@ -77,6 +77,12 @@ public:
 
   void SetTimeout();
 
+  /* per message timeout, 0 means use channel's
+   * default one(ClientConfig::message_timeout)*/
+  void SetTimeoutMs(uint32_t ms) { timeout_ms_ = ms; }
+
+  uint32_t TimeoutMs() const { return timeout_ms_; }
+
   void SetFailCode(MessageCode reason);
 
   MessageCode FailCode() const;
@@ -110,6 +116,8 @@ protected:
 private:
   MessageCode code_;
 
+  uint32_t timeout_ms_ = 0;
+
   RefCodecMessage response_;
 };
 
@@ -104,6 +104,10 @@ public:
 
   virtual bool SendRequest(CodecMessage* message) WARN_UNUSED_RESULT = 0;
 
+  /* request given up(eg: timeout) by client channel, a multiplexed
+   * protocol can release its stream here*/
+  virtual void CancelRequest(CodecMessage* message){};
+
   virtual bool SendResponse(const CodecMessage* req,
                             CodecMessage* res) WARN_UNUSED_RESULT = 0;
 
@@ -1,9 +1,14 @@
 
 #include "h2_codec_service.h"
 
+#include <algorithm>
+#include <tuple>
+
 #include "base/utils/arrayutils.h"
 #include "base/utils/string/str_utils.h"
 #include "fmt/core.h"
+#include "net_io/codec/http/http_compression.h"
+#include "net_io/codec/http/http_constants.h"
 #include "nghttp2_util.h"
 
 using base::MessageLoop;
@@ -13,6 +18,11 @@ namespace net {
 
 namespace {
 
+const uint32_t kMaxConcurrentStreams = 100;
+// per stream initial window, nghttp2 default 64k - 1
+const uint32_t kStreamWindowSize = 1 << 20;
+const int32_t kConnectionWindowSize = 1 << 24;
+
 nghttp2_nv make_nv(const char* name, const char* value) {
   nghttp2_nv nv;
   nv.name = (uint8_t*)name;
@@ -55,32 +65,11 @@ nghttp2_nv make_nv_ls(const char (&name)[N], const std::string& value) {
           NGHTTP2_NV_FLAG_NO_COPY_NAME};
 }
 
-int on_header(nghttp2_session* session,
-              const nghttp2_frame* frame,
-              const uint8_t* name,
-              size_t namelen,
-              const uint8_t* value,
-              size_t valuelen,
-              uint8_t flags,
-              void* user_data) {
-  LOG(INFO) << __FUNCTION__ << ", enter";
-  H2Util::PrintFrameHeader(&frame->hd);
-
-  if (frame->hd.type != NGHTTP2_HEADERS ||
-      frame->headers.cat != NGHTTP2_HCAT_REQUEST) {
-    LOG(INFO) << __FUNCTION__ << " not NGHTTP2_HEADERS, or not a request";
-    return 0;
-  }
-
-  H2CodecService* codec = (H2CodecService*)user_data;
-  int32_t stream_id = frame->hd.stream_id;
-  H2CodecService::StreamCtx* stream_ctx = codec->FindStreamCtx(stream_id);
-  if (!stream_ctx) {
-    return 0;
-  }
-
-  auto req = stream_ctx->Request();
-
+void on_request_header(HttpRequest* req,
+                       const uint8_t* name,
+                       size_t namelen,
+                       const uint8_t* value,
+                       size_t valuelen) {
   switch (lookup_token(name, namelen)) {
     case HD__METHOD:
       req->SetMethod(std::string(value, value + valuelen));
@@ -110,6 +99,57 @@ int on_header(nghttp2_session* session,
       req->InsertHeader(std::string(name, name + namelen),
                         std::string(value, value + valuelen));
   }
+}
+
+void on_response_header(HttpResponse* rsp,
+                        const uint8_t* name,
+                        size_t namelen,
+                        const uint8_t* value,
+                        size_t valuelen) {
+  if (lookup_token(name, namelen) == HD__STATUS) {
+    rsp->SetResponseCode(std::atoi(std::string(value, value + valuelen).c_str()));
+    return;
+  }
+  rsp->InsertHeader(std::string(name, name + namelen),
+                    std::string(value, value + valuelen));
+}
+
+int on_header(nghttp2_session* session,
+              const nghttp2_frame* frame,
+              const uint8_t* name,
+              size_t namelen,
+              const uint8_t* value,
+              size_t valuelen,
+              uint8_t flags,
+              void* user_data) {
+  VLOG(VTRACE) << __FUNCTION__ << ", enter";
+
+  if (frame->hd.type != NGHTTP2_HEADERS) {
+    return 0;
+  }
+
+  H2CodecService* codec = (H2CodecService*)user_data;
+  int32_t stream_id = frame->hd.stream_id;
+  H2CodecService::StreamCtx* stream_ctx = codec->FindStreamCtx(stream_id);
+  if (!stream_ctx) {
+    return 0;
+  }
+
+  switch (frame->headers.cat) {
+    case NGHTTP2_HCAT_REQUEST:
+      on_request_header(stream_ctx->Request().get(),
+                        name, namelen, value, valuelen);
+      break;
+    case NGHTTP2_HCAT_RESPONSE:
+    case NGHTTP2_HCAT_HEADERS:  // trailer
+      if (stream_ctx->Response()) {
+        on_response_header(stream_ctx->Response().get(),
+                           name, namelen, value, valuelen);
+      }
+      break;
+    default:
+      break;
+  }
   return 0;
 }
 
@@ -119,7 +159,7 @@ int on_data_chunk(nghttp2_session* session,
                   const uint8_t* data,
                   size_t len,
                   void* user_data) {
-  LOG(INFO) << __FUNCTION__ << ", enter";
+  VLOG(VTRACE) << __FUNCTION__ << ", enter, len:" << len;
 
   H2CodecService* codec = (H2CodecService*)user_data;
   H2CodecService::StreamCtx* stream_ctx = codec->FindStreamCtx(stream_id);
@@ -129,80 +169,96 @@ int on_data_chunk(nghttp2_session* session,
   }
 
   if (codec->IsServerSide()) {
-    auto req = stream_ctx->Request();
-    req->AppendBody((const char*)data, len);
+    stream_ctx->Request()->AppendBody((const char*)data, len);
   } else {
-    // TODO: response support
-    // HttpRequest* req = stream_ctx->Request();
+    stream_ctx->Response()->AppendBody((const char*)data, len);
   }
   return 0;
 }
 
-// 网络io操作，将数据发送到网络
+// 网络io操作，将数据写入channel的发送缓冲, 由FlushSession统一发送
 ssize_t send_callback(nghttp2_session* session,
                       const uint8_t* data,
                       size_t length,
                       int flags,
                       void* user_data) {
-  LOG(INFO) << __FUNCTION__ << ", enter, send data len:" << length
-            << ", flag:" << flags;
+  VLOG(VTRACE) << __FUNCTION__ << ", enter, send data len:" << length
+               << ", flag:" << flags;
 
   H2CodecService* codec = (H2CodecService*)user_data;
 
-  auto channel = codec->Channel();
-  if (channel->Send((const char*)data, length) >= 0) {
-    return length;
-  }
-  return NGHTTP2_ERR_CALLBACK_FAILURE;
+  codec->Channel()->WriterBuffer()->WriteRawData(data, length);
+  return length;
 }
 
 // 发送数据帧, 流程
 // Send req/res->send HeaderFrame -> SendDataFrame -> BackTo
 // SendRequest/SendResponse
+// 每次只发送read_callback许诺的长度(受流控窗口限制), 而非整个body
 int send_data_callback(nghttp2_session* session,
                        nghttp2_frame* frame,
                        const uint8_t* framehd,
                        size_t length,
                        nghttp2_data_source* source,
                        void* user_data) {
-  LOG(INFO) << __FUNCTION__ << ", enter";
-  H2Util::PrintFrameHeader(&frame->hd);
+  VLOG(VTRACE) << __FUNCTION__ << ", enter, length:" << length;
 
   H2CodecService* conn = (H2CodecService*)user_data;
   H2CodecService::StreamCtx* stream_ctx =
       conn->FindStreamCtx(frame->hd.stream_id);
-  // strm = nghttp2_session_get_stream_user_data(session, frame->hd.stream_id);
-  if (!stream_ctx) {
+  if (!stream_ctx || !stream_ctx->OutgoingBody()) {
     return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
   }
 
   /* We never use padding in this program */
   assert(frame->data.padlen == 0);
 
-  auto channel = conn->Channel();
-  if (channel->Send((const char*)framehd, 9) < 0) {
-    return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+  const std::string* body = stream_ctx->OutgoingBody();
+  CHECK(stream_ctx->out_written_ + length <= body->size());
+
+  IOBuffer* buffer = conn->Channel()->WriterBuffer();
+  buffer->WriteRawData(framehd, 9);
+  buffer->WriteRawData(body->data() + stream_ctx->out_written_, length);
+  stream_ctx->out_written_ += length;
+  return 0;
+}
+
+// data provider, 按流控窗口允许的长度切分body, 避免一次把整个body
+// 塞给一个超过窗口的数据帧
+ssize_t data_source_read_callback(nghttp2_session* session,
+                                  int32_t stream_id,
+                                  uint8_t* buf,
+                                  size_t length,
+                                  uint32_t* data_flags,
+                                  nghttp2_data_source* source,
+                                  void* user_data) {
+  *data_flags |= NGHTTP2_DATA_FLAG_NO_COPY;
+
+  H2CodecService* codec = (H2CodecService*)user_data;
+  H2CodecService::StreamCtx* ctx = codec->FindStreamCtx(stream_id);
+  if (!ctx || !ctx->OutgoingBody()) {
+    *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+    return 0;
   }
-  const HttpResponse* response =
-      (HttpResponse*)stream_ctx->Request()->RawResponse();
-  CHECK(response);
-  LOG(INFO) << __FUNCTION__ << ", enter send data body:" << response->Body();
-  if (channel->Send(response->Body()) < 0) {
-    return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+  const size_t total = ctx->OutgoingBody()->size();
+  const size_t n = std::min(total - ctx->out_pending_, length);
+  ctx->out_pending_ += n;
+  if (ctx->out_pending_ == total) {
+    *data_flags |= NGHTTP2_DATA_FLAG_EOF;
   }
-  stream_ctx->data_frame_send_ = true;
-  return 0;
+  VLOG(VTRACE) << "data provider, stream:" << stream_id << ", window:"
+               << length << ", provide:" << n;
+  return n;
 }
 
 static int on_begin_headers(nghttp2_session* session,
                             const nghttp2_frame* frame,
                             void* user_data) {
-  LOG(INFO) << __FUNCTION__ << ", enter";
-  H2Util::PrintFrameHeader(&frame->hd);
+  VLOG(VTRACE) << __FUNCTION__ << ", enter";
 
   if (frame->hd.type != NGHTTP2_HEADERS ||
       frame->headers.cat != NGHTTP2_HCAT_REQUEST) {
-    LOG(INFO) << __FUNCTION__ << ", not a request";
+    // client side stream ctx created when submit request
     return 0;
   }
 
@@ -217,10 +273,13 @@ static int on_stream_close(nghttp2_session* session,
                            int32_t stream_id,
                            uint32_t error_code,
                            void* user_data) {
-  LOG(INFO) << __FUNCTION__ << ", enter, stream:" << stream_id
-            << ", error_code:" << error_code;
-  (void)error_code;
+  VLOG(VTRACE) << __FUNCTION__ << ", enter, stream:" << stream_id
+               << ", error_code:" << error_code;
   H2CodecService* codec = (H2CodecService*)user_data;
+  // client side: a reset stream without response, the request
+  // will be failed by channel's request timeout
+  LOG_IF(ERROR, error_code != 0) << "stream:" << stream_id
+                                 << " closed with error:" << error_code;
   codec->DelStreamCtx(stream_id);
   return 0;
 }
@@ -228,8 +287,7 @@ static int on_stream_close(nghttp2_session* session,
 static int on_frame_recv(nghttp2_session* session,
                          const nghttp2_frame* frame,
                          void* user_data) {
-  LOG(INFO) << __FUNCTION__ << ", enter";
-  H2Util::PrintFrameHeader(&frame->hd);
+  VLOG(VTRACE) << __FUNCTION__ << ", enter";
 
   auto codec = static_cast<H2CodecService*>(user_data);
   H2CodecService::StreamCtx* stream_data =
@@ -240,32 +298,15 @@ static int on_frame_recv(nghttp2_session* session,
 
   switch (frame->hd.type) {
     case NGHTTP2_DATA:
-      if (frame->hd.flags & NGHTTP2_FLAG_END_STREAM) {
-        // all body data recv, invoke request handler
-        stream_data->Request()->SetIOCtx(codec->shared_from_this());
-        codec->GetHandler()->OnCodecMessage(stream_data->Request());
-
-        // stream_data->Request()->AppendBody();
-        // strm->request().impl().call_on_data(nullptr, 0);
-      }
-      break;
     case NGHTTP2_HEADERS: {
-      if (frame->headers.cat != NGHTTP2_HCAT_REQUEST) {
-        break;
-      }
-
-      // auto& req = strm->request().impl();
-      // req.remote_endpoint(handler->remote_endpoint());
-
-      // all body data recv, invoke request handler
-      stream_data->Request()->SetIOCtx(codec->shared_from_this());
-      codec->GetHandler()->OnCodecMessage(stream_data->Request());
-
+      // all header and body data recv, invoke handler
       if (frame->hd.flags & NGHTTP2_FLAG_END_STREAM) {
-        // strm->request().impl().call_on_data(nullptr, 0);
+        codec->CommitStream(stream_data);
       }
       break;
     }
+    default:
+      break;
   }
   return 0;
 }
@@ -273,8 +314,7 @@ static int on_frame_recv(nghttp2_session* session,
 int on_frame_send(nghttp2_session* session,
                   const nghttp2_frame* frame,
                   void* user_data) {
-  LOG(INFO) << __FUNCTION__ << ", enter";
-  H2Util::PrintFrameHeader(&frame->hd);
+  VLOG(VTRACE) << __FUNCTION__ << ", enter";
 
   if (frame->hd.type != NGHTTP2_PUSH_PROMISE) {
     return 0;
@@ -363,7 +403,8 @@ void H2CodecService::StartProtocolService() {
   }
   nghttp2_settings_entry settings[] = {
       //{NGHTTP2_SETTINGS_ENABLE_PUSH, 1},
-      {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 100}};
+      {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, kMaxConcurrentStreams},
+      {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, kStreamWindowSize}};
 
   CodecService::StartProtocolService();
 
@@ -371,17 +412,25 @@ void H2CodecService::StartProtocolService() {
                           NGHTTP2_FLAG_NONE,
                           settings,
                           ARRAY_SIZE(settings));
-
-  nghttp2_session_send(session_);
+  // connection level window, default 64k is too small for
+  // many concurrent streams
+  nghttp2_session_set_local_window_size(session_,
+                                        NGHTTP2_FLAG_NONE,
+                                        0,
+                                        kConnectionWindowSize);
+
+  if (!FlushSession()) {
+    LOG(ERROR) << __FUNCTION__ << " send settings failed";
+  }
 }
 
 void H2CodecService::OnDataReceived(IOBuffer* buf) {
-  LOG(INFO) << __FUNCTION__ << ", enter";
+  VLOG(VTRACE) << __FUNCTION__ << ", enter";
 
   const uint8_t* data = buf->GetReadU();
   const size_t len = buf->CanReadSize();
-  size_t ret = nghttp2_session_mem_recv(session_, data, len);
-  if (ret != buf->CanReadSize()) {
+  ssize_t ret = nghttp2_session_mem_recv(session_, data, len);
+  if (ret < 0 || size_t(ret) != len) {
     LOG(ERROR) << __FUNCTION__ << " nghttp2 mem recv failed";
     return CloseService(false);
   }
@@ -391,14 +440,16 @@ void H2CodecService::OnDataReceived(IOBuffer* buf) {
 void H2CodecService::HandleEvent(base::FdEvent* fdev, base::LtEv::Event ev) {
   VLOG(VTRACE) << __FUNCTION__ << ", enter";
 
+  auto guard = shared_from_this();
   CodecService::HandleEvent(fdev, ev);
   if (IsClosed()) {
     return;
   }
 
   do {
-    // write stream buffer
-    if (0 != nghttp2_session_send(session_)) {
+    // write stream buffer, eg: settings ack/window update/data
+    // frames wait for window
+    if (!FlushSession()) {
       break;
     }
     if (IsSessionClosed() || ShouldClose()) {
@@ -411,6 +462,35 @@ void H2CodecService::HandleEvent(base::FdEvent* fdev, base::LtEv::Event ev) {
   return CloseService(false);
 }
 
+bool H2CodecService::FlushSession() {
+  if (0 != nghttp2_session_send(session_)) {
+    return false;
+  }
+  if (!channel_->HasOutgoingData()) {
+    return true;
+  }
+  return TryFlushChannel();
+}
+
+void H2CodecService::ScheduleFlush() {
+  if (flush_scheduled_) {
+    return;
+  }
+  flush_scheduled_ = true;
+
+  std::weak_ptr<CodecService> weak(shared_from_this());
+  loop_->PostTask(FROM_HERE, [weak, this]() {
+    auto guard = weak.lock();
+    if (!guard || IsClosed()) {
+      return;
+    }
+    flush_scheduled_ = false;
+    if (!FlushSession()) {
+      CloseService(false);
+    }
+  });
+}
+
 bool H2CodecService::IsSessionClosed() const {
   if (!session_) {
     return false;
@@ -472,24 +552,96 @@ void H2CodecService::PushPromise(const std::string& method,
   return;
 }
 
-void H2CodecService::BeforeSendRequest(HttpRequest*) {
-  LOG(INFO) << __FUNCTION__ << "enter";
-}
+void H2CodecService::BeforeSendRequest(HttpRequest*) {}
 
 bool H2CodecService::SendRequest(CodecMessage* message) {
-  LOG(INFO) << __FUNCTION__ << "enter";
+  VLOG(VTRACE) << __FUNCTION__ << ", enter";
+  HttpRequest* req = static_cast<HttpRequest*>(message);
+  BeforeSendRequest(req);
+
+  std::string authority = req->GetHeader(HttpConstant::kHost);
+  if (authority.empty()) {
+    const url::RemoteInfo* remote = delegate_->GetRemoteInfo();
+    authority = fmt::format("{}:{}", remote->host, remote->port);
+  }
+  const std::string scheme = UseSSLChannel() ? "https" : "http";
+
+  std::vector<nghttp2_nv> nvs;
+  nvs.reserve(4 + req->Headers().size());
+  nvs.push_back(make_nv_ls(":method", req->Method()));
+  nvs.push_back(make_nv_ls(":scheme", scheme));
+  nvs.push_back(make_nv_ls(":authority", authority));
+  nvs.push_back(make_nv_ls(":path", req->RequestUrl()));
+  for (auto& kv : req->Headers()) {
+    // HTTP2 connection specific header not allowed, host => :authority
+    if (base::StrUtil::IgnoreCaseEquals(kv.first, "connection") ||
+        base::StrUtil::IgnoreCaseEquals(kv.first, "host")) {
+      continue;
+    }
+    // HTTP2 have frame_hd.length
+    if (base::StrUtil::IgnoreCaseEquals(kv.first, "content-length")) {
+      continue;
+    }
+    nvs.push_back(make_nv(kv.first, kv.second));
+  }
+
+  // stream id not known before submit, data provider find the
+  // stream ctx by stream id
+  nghttp2_data_provider *prd_ptr = nullptr, prd;
+  if (req->Body().size() > 0) {
+    prd.source.ptr = nullptr;
+    prd.read_callback = data_source_read_callback;
+    prd_ptr = &prd;
+  }
+
+  int32_t stream_id = nghttp2_submit_request(session_,
+                                             nullptr,
+                                             nvs.data(),
+                                             nvs.size(),
+                                             prd_ptr,
+                                             nullptr);
+  if (stream_id < 0) {
+    LOG(ERROR) << __FUNCTION__ << " submit request failed:" << stream_id;
+    return false;
+  }
+  req->SetAsyncId(stream_id);
+
+  // request may gone(timeout) before its data frames flushed,
+  // so stream ctx keep a copy of the body
+  StreamCtx* ctx = AddStreamCtx(stream_id, req->Body());
+  CHECK(ctx);
+
+  ScheduleFlush();
   return true;
 }
 
-bool H2CodecService::BeforeSendResponse(const HttpRequest*, HttpResponse*) {
-  LOG(INFO) << __FUNCTION__ << "enter";
+void H2CodecService::CancelRequest(CodecMessage* message) {
+  int32_t stream_id = message->AsyncId();
+  StreamCtx* ctx = FindStreamCtx(stream_id);
+  if (!ctx || IsSessionClosed()) {
+    return;
+  }
+  // no response commit after canceled, ctx removed when stream closed
+  ctx->committed_ = true;
+  int rv = nghttp2_submit_rst_stream(session_,
+                                     NGHTTP2_FLAG_NONE,
+                                     stream_id,
+                                     NGHTTP2_CANCEL);
+  LOG_IF(ERROR, rv != 0) << __FUNCTION__ << " reset stream:" << stream_id
+                         << " failed:" << nghttp2_strerror(rv);
+  ScheduleFlush();
+}
 
+bool H2CodecService::BeforeSendResponse(const HttpRequest* req,
+                                        HttpResponse* res) {
+  HttpCompression::CompressResponse(req, res);
   return true;
 }
 
 bool H2CodecService::SendResponse(const CodecMessage* req, CodecMessage* r) {
-  LOG(INFO) << __FUNCTION__ << ", enter, res:" << r->Dump();
+  VLOG(VTRACE) << __FUNCTION__ << ", enter, res:" << r->Dump();
   HttpResponse* res = (HttpResponse*)(r);
+  BeforeSendResponse((const HttpRequest*)req, res);
 
   std::vector<nghttp2_nv> nvs;
 
@@ -508,28 +660,17 @@ bool H2CodecService::SendResponse(const CodecMessage* req, CodecMessage* r) {
   }
 
   StreamCtx* ctx = FindStreamCtx(req->AsyncId());
+  if (!ctx) {
+    LOG(ERROR) << __FUNCTION__ << " stream:" << req->AsyncId() << " gone";
+    return false;
+  }
 
   nghttp2_data_provider *prd_ptr = nullptr, prd;
   if (res->Body().size() > 0) {
+    // response bind to request, which hold by stream ctx
+    ctx->SetOutgoingBody(&res->Body());
     prd.source.ptr = ctx;
-    prd.read_callback = [](nghttp2_session* session,
-                           int32_t stream_id,
-                           uint8_t* buf,
-                           size_t length,
-                           uint32_t* data_flags,
-                           nghttp2_data_source* source,
-                           void* user_data) -> ssize_t {
-      LOG(INFO) << "data provider:" << length;
-      *data_flags |= NGHTTP2_DATA_FLAG_NO_COPY;
-      *data_flags |= NGHTTP2_DATA_FLAG_EOF;
-
-      StreamCtx* _ctx = (StreamCtx*)source->ptr;
-      if (!_ctx || _ctx->data_frame_send_) {
-        return 0;
-      }
-      HttpResponse* res = (HttpResponse*)(_ctx->Request()->RawResponse());
-      return res->Body().size();
-    };
+    prd.read_callback = data_source_read_callback;
     prd_ptr = &prd;
   }
 
@@ -538,14 +679,31 @@ bool H2CodecService::SendResponse(const CodecMessage* req, CodecMessage* r) {
                                    nvs.data(),
                                    nvs.size(),
                                    prd_ptr);
-  LOG(INFO) << "submit response return value:" << rv;
-  // nghttp2_submit_headers(session_, flags, stream_id, NULL, &nvs[0],
-  // nvs.size(), NULL);
+  if (rv != 0) {
+    LOG(ERROR) << __FUNCTION__ << " submit response failed:" << rv;
+    return false;
+  }
   // avoid DATA_SOURCE_COPY, we do not use nghttp2_submit_data
-  // data_prd.read_callback = data_source_read_callback;
-  // nghttp2_submit_response(session, stream_id, &nvs[0], nvs.size(),
-  // &data_prd);
-  return rv == 0 && 0 == nghttp2_session_send(session_);
+  ScheduleFlush();
+  return true;
+}
+
+void H2CodecService::CommitStream(StreamCtx* ctx) {
+  if (IsServerSide()) {
+    LOG_IF(ERROR, !HttpCompression::DecompressBody(ctx->Request().get()))
+        << __FUNCTION__ << " decode request body failed";
+    ctx->Request()->SetIOCtx(shared_from_this());
+    handler_->OnCodecMessage(ctx->Request());
+    return;
+  }
+  if (ctx->committed_) {
+    return;
+  }
+  ctx->committed_ = true;
+  LOG_IF(ERROR, !HttpCompression::DecompressBody(ctx->Response().get()))
+      << __FUNCTION__ << " decode response body failed";
+  ctx->Response()->SetIOCtx(shared_from_this());
+  handler_->OnCodecMessage(ctx->Response());
 }
 
 const RefCodecMessage H2CodecService::NewResponse(const CodecMessage*) {
@@ -557,12 +715,26 @@ bool H2CodecService::UseSSLChannel() const {
 }
 
 H2CodecService::StreamCtx* H2CodecService::AddStreamCtx(int32_t sid) {
-  auto ret = stream_ctxs_.emplace(sid, StreamCtx(IsServerSide(), sid));
+  auto ret = stream_ctxs_.emplace(std::piecewise_construct,
+                                  std::forward_as_tuple(sid),
+                                  std::forward_as_tuple(sid));
+  if (!ret.second) {
+    return nullptr;
+  }
+  VLOG(VTRACE) << __FUNCTION__ << " add streamctx, id:" << sid;
+  return &(ret.first->second);
+}
+
+H2CodecService::StreamCtx* H2CodecService::AddStreamCtx(
+    int32_t sid,
+    const std::string& req_body) {
+  auto ret = stream_ctxs_.emplace(std::piecewise_construct,
+                                  std::forward_as_tuple(sid),
+                                  std::forward_as_tuple(sid, req_body));
   if (!ret.second) {
     return nullptr;
   }
-  LOG(INFO) << __FUNCTION__
-            << " add streamctx, id:" << ret.first->second.Request()->AsyncId();
+  VLOG(VTRACE) << __FUNCTION__ << " add client streamctx, id:" << sid;
   return &(ret.first->second);
 }
 
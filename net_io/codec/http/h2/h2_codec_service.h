@@ -15,27 +15,44 @@ public:
   // one http2 conneciton support multiple stream;
   class StreamCtx {
   public:
-    StreamCtx(bool server, int32_t sid) {
-      HttpMessage* message = nullptr;
-      if (server) {
-        req_ = std::make_shared<HttpRequest>();
-        message = req_.get();
-      } else {
-        rsp_ = std::make_shared<HttpResponse>();
-        message = rsp_.get();
-      }
-      message->SetStreamID(sid);
-      message->SetKeepAlive(true);
+    // server side, stream opened by peer's HEADERS frame
+    explicit StreamCtx(int32_t sid) {
+      req_ = std::make_shared<HttpRequest>();
+      req_->SetStreamID(sid);
+      req_->SetKeepAlive(true);
+    }
+    // client side, stream opened by the request we submit
+    StreamCtx(int32_t sid, const std::string& req_body)
+      : req_body_(req_body) {
+      rsp_ = std::make_shared<HttpResponse>();
+      rsp_->SetStreamID(sid);
+      rsp_->SetKeepAlive(true);
+      out_body_ = &req_body_;
     }
     ~StreamCtx() { };
 
     const RefHttpRequest& Request() { return req_; }
     const RefHttpResponse& Response() { return rsp_; }
 
-    bool data_frame_send_ = false;
+    // body of outgoing message, response for server side,
+    // request for client side; data frames are sliced from it
+    // according to flow control window, see read_callback
+    void SetOutgoingBody(const std::string* body) { out_body_ = body; }
+    const std::string* OutgoingBody() const { return out_body_; }
+
+    // bytes promised to nghttp2 by data provider
+    size_t out_pending_ = 0;
+    // bytes really written to channel by send_data_callback
+    size_t out_written_ = 0;
+    // client side, response has been delivered to handler
+    bool committed_ = false;
   private:
     RefHttpRequest req_;
     RefHttpResponse rsp_;
+    // client side request body, see SendRequest
+    std::string req_body_;
+    const std::string* out_body_ = nullptr;
+    DISALLOW_COPY_AND_ASSIGN(StreamCtx);
   };
 
   H2CodecService(base::MessageLoop*);
@@ -46,11 +63,17 @@ public:
 
   void OnDataReceived(IOBuffer*) override;
 
+  // multiplexing, response matched by stream id
+  bool KeepSequence() override { return false; }
+
   // last change for codec modify request
   void BeforeSendRequest(HttpRequest*);
 
   bool SendRequest(CodecMessage* message) override;
 
+  // reset the stream, avoid peer keep sending to a timeout stream
+  void CancelRequest(CodecMessage* message) override;
+
   // last change for codec modify response
   bool BeforeSendResponse(const HttpRequest*, HttpResponse*);
 
@@ -62,8 +85,12 @@ public:
 
   void DelStreamCtx(int32_t sid);
   StreamCtx* AddStreamCtx(int32_t sid);
+  StreamCtx* AddStreamCtx(int32_t sid, const std::string& req_body);
   StreamCtx* FindStreamCtx(int32_t sid);
 
+  // deliver a full received message to handler
+  void CommitStream(StreamCtx* ctx);
+
   void PushPromise(const std::string& method,
                    const std::string& req_path,
                    const HttpRequest* bind_req,
@@ -74,6 +101,13 @@ private:
 
   bool IsSessionClosed() const;
 
+  // drive nghttp2 serialize pending frames into channel's writer
+  // buffer and flush them with one write
+  bool FlushSession();
+
+  // batch frames submit in one loop iteration into one flush
+  void ScheduleFlush();
+
 private:
   friend int on_begin_headers(nghttp2_session* session,
                               const nghttp2_frame* frame,
@@ -84,6 +118,8 @@ private:
   nghttp2_session* session_ = nullptr;
 
   std::map<int32_t, StreamCtx> stream_ctxs_;
+
+  bool flush_scheduled_ = false;
 };
 
 }  // namespace net
@@ -18,7 +18,6 @@
 #include "http_codec_service.h"
 
 #include <base/message_loop/message_loop.h>
-#include <base/utils/gzip/gzip_utils.h>
 #include <net_io/codec/codec_factory.h>
 #include <net_io/codec/codec_message.h>
 #include <net_io/io_buffer.h>
@@ -26,6 +25,7 @@
 
 #include "fmt/core.h"
 #include "glog/logging.h"
+#include "http_compression.h"
 #include "http_constants.h"
 
 namespace lt {
@@ -34,7 +34,6 @@ namespace net {
 namespace {
 static const int32_t kMeanHeaderSize = 32;
 static const int32_t kHttpMsgReserveSize = 512;
-static const int32_t kCompressionThreshold = 8096;
 
 const char* kHTTP_RESPONSE_HEADER_1_1 = "HTTP/1.1";
 const char* kHTTP_RESPONSE_HEADER_1_0 = "HTTP/1.0";
@@ -42,7 +41,8 @@ const char* kHTTP_RESPONSE_HEADER_1_0 = "HTTP/1.0";
 }  // namespace
 
 HttpCodecService::HttpCodecService(base::MessageLoop* loop)
-  : CodecService(loop) {
+  : CodecService(loop),
+    flush_scheduled_(false) {
 
   flush_fn_ = [this]() {
     TryFlushChannel();
@@ -72,12 +72,14 @@ void HttpCodecService::OnDataReceived(IOBuffer* buf) {
     auto parser = req_parser();
     success = parser->Parse(buf) == HttpReqParser::Success;
   } else {
-    auto parser = req_parser();
-    success = parser->Parse(buf) == HttpReqParser::Success;
+    auto parser = rsp_parser();
+    success = parser->Parse(buf) == HttpResParser::Success;
   }
 
   if (!success) {
-    ignore_result(channel_->Send(HttpConstant::kBadRequest));
+    if (IsServerSide()) {
+      ignore_result(channel_->Send(HttpConstant::kBadRequest));
+    }
     CloseService(true);  // no callback here
     NotifyCodecClosed();
   }
@@ -107,7 +109,7 @@ bool HttpCodecService::RequestToBuffer(const HttpRequest* request,
   }
 
   if (!request->HasHeader(HttpConstant::kAcceptEncoding)) {
-    buffer->WriteString(HttpConstant::kHeaderSupportedEncoding);
+    buffer->WriteString(HttpCompression::AcceptEncodingHeader());
   }
 
   if (!request->HasHeader(HttpConstant::kContentLength)) {
@@ -231,19 +233,15 @@ const RefCodecMessage HttpCodecService::NewResponse(
   return std::move(http_res);
 }
 
+const RefCodecMessage HttpCodecService::NewHeartbeat() {
+  auto request = std::make_shared<HttpRequest>();
+  request->AsHeartbeat();
+  return std::move(request);
+}
+
 void HttpCodecService::BeforeSendRequest(HttpRequest* out_message) {
   HttpRequest* request = static_cast<HttpRequest*>(out_message);
-  if (request->Body().size() > kCompressionThreshold &&
-      !request->HasHeader(HttpConstant::kContentEncoding)) {
-    std::string compressed_body;
-    if (0 == base::Gzip::compress_gzip(request->Body(),
-                                       compressed_body)) {  // success
-      request->InsertHeader(HttpConstant::kContentEncoding, "gzip");
-      request->InsertHeader(HttpConstant::kContentLength,
-                            std::to_string(compressed_body.size()));
-      request->body_ = std::move(compressed_body);
-    }
-  }
+  HttpCompression::CompressRequest(request);
 
   if (!out_message->HasHeader(HttpConstant::kHost)) {
     const url::RemoteInfo* remote = delegate_->GetRemoteInfo();
@@ -253,26 +251,9 @@ void HttpCodecService::BeforeSendRequest(HttpRequest* out_message) {
 
 bool HttpCodecService::BeforeSendResponse(const HttpRequest* request,
                                           HttpResponse* response) {
-  // response compression if needed
-  if (response->Body().size() > kCompressionThreshold &&
-      !response->HasHeader(HttpConstant::kContentEncoding)) {
-    const std::string& accept =
-        request->GetHeader(HttpConstant::kAcceptEncoding);
-    std::string compressed_body;
-    if (accept.find("gzip") != std::string::npos) {
-      if (0 == base::Gzip::compress_gzip(response->Body(),
-                                         compressed_body)) {  // success
-        response->body_ = std::move(compressed_body);
-        response->InsertHeader("Content-Encoding", "gzip");
-      }
-    } else if (accept.find("deflate") != std::string::npos) {
-      if (0 ==
-          base::Gzip::compress_deflate(response->Body(), compressed_body)) {
-        response->body_ = std::move(compressed_body);
-        response->InsertHeader("Content-Encoding", "deflate");
-      }
-    }
-  }
+  // response compression if needed, skipped when handler has
+  // done it in worker(Content-Encoding present)
+  HttpCompression::CompressResponse(request, response);
   return true;
 }
 
@@ -282,6 +263,12 @@ void HttpCodecService::CommitHttpRequest(const RefHttpRequest&& request) {
 }
 
 void HttpCodecService::CommitHttpResponse(const RefHttpResponse&& response) {
+  // server side said 'Connection: close', this connection can't be reused
+  // by the pool any more, close it after response handled; client will
+  // reconnect a new one
+  if (!response->IsKeepAlive()) {
+    schedule_close_ = true;
+  }
   response->SetIOCtx(shared_from_this());
   handler_->OnCodecMessage(std::move(response));
 }
@@ -60,6 +60,11 @@ public:
 
   const RefCodecMessage NewResponse(const CodecMessage*) override;
 
+  // client side keepalive probe for a idle connection
+  bool KeepHeartBeat() override { return !IsServerSide(); }
+
+  const RefCodecMessage NewHeartbeat() override;
+
   void CommitHttpRequest(const RefHttpRequest&& request);
 
   void CommitHttpResponse(const RefHttpResponse&& response);
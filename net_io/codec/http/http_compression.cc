@@ -0,0 +1,356 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "http_compression.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <list>
+#include <unordered_map>
+
+#include "base/logging.h"
+#include "base/utils/string/str_utils.h"
+#include "http_constants.h"
+
+namespace lt {
+namespace net {
+
+namespace {
+
+std::string build_accept_encoding(const HttpCompressionConfig& config) {
+  std::string value;
+  for (const auto& name : config.encodings) {
+    if (!base::Compressor::Get(name)) {
+      continue;
+    }
+    value.append(value.empty() ? "" : ", ").append(name);
+  }
+  if (value.empty()) {
+    value = "identity";
+  }
+  return HttpConstant::kAcceptEncoding + ": " + value + "\r\n";
+}
+
+struct GlobalSetting {
+  GlobalSetting() : accept_encoding(build_accept_encoding(config)) {}
+  HttpCompressionConfig config;
+  // header line built from config, not every request
+  std::string accept_encoding;
+};
+
+GlobalSetting& global_setting() {
+  static GlobalSetting setting;
+  return setting;
+}
+
+// content already compressed, compress again just waste cpu
+bool compressible_content_type(const std::string& type) {
+  static const char* kSkipPrefix[] = {
+      "image/",           "video/",           "audio/",
+      "font/woff",        "application/zip",  "application/gzip",
+      "application/x-gzip", "application/zstd", "application/octet-stream",
+  };
+  if (type.empty()) {
+    return true;
+  }
+  // svg is text
+  if (type.compare(0, 13, "image/svg+xml") == 0) {
+    return true;
+  }
+  for (const char* prefix : kSkipPrefix) {
+    if (strncasecmp(type.c_str(), prefix, strlen(prefix)) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t fnv1a_hash(const std::string& data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/* lru cache for precompressed body, avoid compress the same
+ * hot content(static file, cached api result) again and again;
+ * thread local, so no lock needed*/
+class PrecompressedCache {
+public:
+  const std::string* Find(uint64_t key, const std::string& origin) {
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      return nullptr;
+    }
+    // hash collision, not the same content
+    if (iter->second->origin != origin) {
+      return nullptr;
+    }
+    entries_.splice(entries_.begin(), entries_, iter->second);
+    return &(iter->second->compressed);
+  }
+
+  void Put(uint64_t key,
+           const std::string& origin,
+           const std::string& compressed,
+           size_t capacity) {
+    auto iter = index_.find(key);
+    if (iter != index_.end()) {
+      entries_.erase(iter->second);
+      index_.erase(iter);
+    }
+    while (entries_.size() && entries_.size() >= capacity) {
+      index_.erase(entries_.back().key);
+      entries_.pop_back();
+    }
+    entries_.push_front(Entry{key, origin, compressed});
+    index_[key] = entries_.begin();
+  }
+
+private:
+  struct Entry {
+    uint64_t key;
+    std::string origin;
+    std::string compressed;
+  };
+  std::list<Entry> entries_;
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index_;
+};
+
+// compress body with cache, return false when fail or no gain
+bool compress_body(const base::Compressor* compressor,
+                   const std::string& body,
+                   std::string* out) {
+  const HttpCompressionConfig& config = HttpCompression::Config();
+  const int level = HttpCompression::LevelOf(compressor);
+
+  bool use_cache =
+      config.cache_capacity > 0 && body.size() <= config.cache_max_body;
+  if (!use_cache) {
+    return compressor->Compress(body, out, level) && out->size() < body.size();
+  }
+
+  thread_local PrecompressedCache cache;
+  uint64_t key = fnv1a_hash(body) ^ (uint64_t(compressor->Id()) << 56) ^
+                 (uint64_t(level & 0xFF) << 48);
+  const std::string* hit = cache.Find(key, body);
+  if (hit) {
+    out->assign(*hit);
+  } else {
+    if (!compressor->Compress(body, out, level)) {
+      return false;
+    }
+    cache.Put(key, body, *out, config.cache_capacity);
+  }
+  return out->size() < body.size();
+}
+
+void add_vary_header(HttpResponse* response) {
+  const std::string kVary("Vary");
+  if (!response->HasHeader(kVary)) {
+    return response->InsertHeader(kVary, HttpConstant::kAcceptEncoding);
+  }
+  std::string& vary = response->MutableHeaders()["vary"];
+  std::string lower(vary);
+  base::StrUtil::ToLower(lower);
+  if (lower.find("accept-encoding") == std::string::npos &&
+      lower.find('*') == std::string::npos) {
+    vary.append(", ").append(HttpConstant::kAcceptEncoding);
+  }
+}
+
+}  // namespace
+
+// static
+void HttpCompression::SetConfig(const HttpCompressionConfig& config) {
+  GlobalSetting& setting = global_setting();
+  setting.config = config;
+  setting.accept_encoding = build_accept_encoding(config);
+}
+
+// static
+const HttpCompressionConfig& HttpCompression::Config() {
+  return global_setting().config;
+}
+
+// static
+int HttpCompression::LevelOf(const base::Compressor* compressor) {
+  const auto& levels = Config().levels;
+  auto iter = levels.find(compressor->Name());
+  return iter != levels.end() ? iter->second : compressor->DefaultLevel();
+}
+
+// static
+const base::Compressor* HttpCompression::Negotiate(const std::string& accept) {
+  if (accept.empty()) {
+    return nullptr;
+  }
+  // coding => qvalue, -1 for `*`
+  std::map<std::string, float> qvalues;
+  float star = 0;
+  for (std::string& item : base::StrUtil::Split(accept, ',')) {
+    auto params = base::StrUtil::Split(item, ';');
+    if (params.empty()) {
+      continue;
+    }
+    std::string coding = params[0];
+    base::StrUtil::Trim(coding);
+    base::StrUtil::ToLower(coding);
+    if (coding.empty()) {
+      continue;
+    }
+    float q = 1.0;
+    for (size_t i = 1; i < params.size(); i++) {
+      std::string param = params[i];
+      base::StrUtil::Trim(param);
+      if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') &&
+          param[1] == '=') {
+        q = ::atof(param.c_str() + 2);
+      }
+    }
+    if (coding == "*") {
+      star = q;
+    } else {
+      qvalues[coding == "x-gzip" ? "gzip" : coding] = q;
+    }
+  }
+
+  float best_q = 0;
+  const base::Compressor* best = nullptr;
+  for (const auto& name : Config().encodings) {
+    const base::Compressor* compressor = base::Compressor::Get(name);
+    if (!compressor) {
+      continue;
+    }
+    auto iter = qvalues.find(compressor->Name());
+    float q = iter != qvalues.end() ? iter->second : star;
+    // tie break by server side preference
+    if (q > best_q) {
+      best_q = q;
+      best = compressor;
+    }
+  }
+  return best;
+}
+
+// static
+bool HttpCompression::CompressResponse(const HttpRequest* request,
+                                       HttpResponse* response) {
+  const HttpCompressionConfig& config = Config();
+  if (!config.enable || response->Body().size() < config.min_length ||
+      response->HasHeader(HttpConstant::kContentEncoding)) {
+    return false;
+  }
+  uint16_t code = response->ResponseCode();
+  if (code < 200 || code == 204 || code == 304) {
+    return false;
+  }
+  if (!compressible_content_type(
+          response->GetHeader(HttpConstant::kContentType))) {
+    return false;
+  }
+  // the representation vary by Accept-Encoding from here
+  add_vary_header(response);
+
+  const base::Compressor* compressor =
+      Negotiate(request->GetHeader(HttpConstant::kAcceptEncoding));
+  if (!compressor) {
+    return false;
+  }
+
+  std::string compressed;
+  if (!compress_body(compressor, response->Body(), &compressed)) {
+    return false;
+  }
+  response->SetBody(std::move(compressed));
+  response->RemoveHeader(HttpConstant::kContentLength);
+  response->InsertHeader(HttpConstant::kContentEncoding, compressor->Name());
+  return true;
+}
+
+// static
+bool HttpCompression::CompressRequest(HttpRequest* request) {
+  const HttpCompressionConfig& config = Config();
+  if (!config.enable || config.request_encoding.empty() ||
+      request->Body().size() < config.min_length ||
+      request->HasHeader(HttpConstant::kContentEncoding)) {
+    return false;
+  }
+  const base::Compressor* compressor =
+      base::Compressor::Get(config.request_encoding);
+  if (!compressor) {
+    return false;
+  }
+  std::string compressed;
+  if (!compressor->Compress(request->Body(), &compressed,
+                            LevelOf(compressor)) ||
+      compressed.size() >= request->Body().size()) {
+    return false;
+  }
+  request->SetBody(std::move(compressed));
+  request->RemoveHeader(HttpConstant::kContentLength);
+  request->InsertHeader(HttpConstant::kContentEncoding, compressor->Name());
+  return true;
+}
+
+// static
+bool HttpCompression::DecompressBody(HttpMessage* message) {
+  const std::string& encoding =
+      message->GetHeader(HttpConstant::kContentEncoding);
+  if (encoding.empty()) {
+    return true;
+  }
+  auto codings = base::StrUtil::Split(encoding, ',');
+  std::vector<const base::Compressor*> compressors;
+  for (std::string& coding : codings) {
+    base::StrUtil::Trim(coding);
+    if (coding.empty() || strcasecmp(coding.c_str(), "identity") == 0) {
+      continue;
+    }
+    const base::Compressor* compressor = base::Compressor::Get(coding);
+    if (!compressor) {
+      // keep it as it is, let handler decide
+      VLOG(VINFO) << "unsupported content-coding:" << coding;
+      return true;
+    }
+    compressors.push_back(compressor);
+  }
+
+  // codings applied in order, decode in reverse
+  const size_t max_size = Config().max_decompressed_size;
+  for (auto iter = compressors.rbegin(); iter != compressors.rend(); iter++) {
+    std::string decompressed;
+    if (!(*iter)->Decompress(message->Body(), &decompressed, max_size)) {
+      LOG(ERROR) << "decode " << (*iter)->Name() << " body failed";
+      return false;
+    }
+    message->SetBody(std::move(decompressed));
+  }
+  message->RemoveHeader(HttpConstant::kContentEncoding);
+  return true;
+}
+
+// static
+const std::string& HttpCompression::AcceptEncodingHeader() {
+  return global_setting().accept_encoding;
+}
+
+}  // namespace net
+}  // namespace lt
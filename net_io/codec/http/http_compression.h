@@ -0,0 +1,89 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _NET_HTTP_COMPRESSION_H_H
+#define _NET_HTTP_COMPRESSION_H_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <base/utils/compression/compressor.h>
+#include "http_message.h"
+
+namespace lt {
+namespace net {
+
+struct HttpCompressionConfig {
+  bool enable = true;
+  // body smaller than this not worth a compression
+  size_t min_length = 1024;
+  // server side preference, used when client's q-values tie;
+  // codec not compiled in will be ignored
+  std::vector<std::string> encodings = {"zstd", "br", "gzip", "deflate"};
+  // content-coding => level, default: Compressor::DefaultLevel
+  std::map<std::string, int> levels;
+  // per thread precompressed body cache for hot static content, every
+  // compressed body is hashed and copied when on, so opt-in(0 for disable);
+  // body larger than cache_max_body never cached
+  size_t cache_capacity = 0;
+  size_t cache_max_body = 256 * 1024;
+  // compress response in handler's thread instead of io loop
+  bool compress_in_worker = true;
+  // client request body coding, empty for disable
+  std::string request_encoding = "gzip";
+  // received body decoded larger than this is rejected, 0 for no limit
+  size_t max_decompressed_size = 32 * 1024 * 1024;
+};
+
+/* Accept-Encoding negotiation and body (de)compression for http/1.x,
+ * replace the level-9 gzip before; config is global and should be
+ * set before any server/client start
+ *
+ * not a streaming encoder: a body is compressed in one pass straight into
+ * the tail of a std::string(no temporary buffer), so a chunked/large body
+ * is fully buffered before compress*/
+class HttpCompression {
+public:
+  static void SetConfig(const HttpCompressionConfig& config);
+
+  static const HttpCompressionConfig& Config();
+
+  /* parse Accept-Encoding with q-values and `*`, the highest q wins,
+   * return nullptr for identity*/
+  static const base::Compressor* Negotiate(const std::string& accept);
+
+  // return true when body compressed and headers updated
+  static bool CompressResponse(const HttpRequest* request,
+                               HttpResponse* response);
+
+  static bool CompressRequest(HttpRequest* request);
+
+  /* decode body according Content-Encoding(may multi codings), the
+   * header removed after success; return false when decode failed or
+   * decoded body larger than max_decompressed_size*/
+  static bool DecompressBody(HttpMessage* message);
+
+  // `Accept-Encoding: zstd, br, gzip, deflate\r\n` of compiled codecs
+  static const std::string& AcceptEncodingHeader();
+
+  static int LevelOf(const base::Compressor* compressor);
+};
+
+}  // namespace net
+}  // namespace lt
+#endif
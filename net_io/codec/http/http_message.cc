@@ -108,7 +108,11 @@ void HttpMessage::SetBody(const char* body, size_t len) {
   body_.append(body, len);
 }
 
-HttpRequest::HttpRequest() : method_("GET"), url_param_parsed_(false) {}
+HttpRequest::HttpRequest() : method_("GET"), url_param_parsed_(false) {
+  // HTTP/1.1 default persistent connection, so client connection can be
+  // reused by pool; server side overwrite this by parser result
+  keepalive_ = true;
+}
 
 HttpRequest::~HttpRequest() {}
 
@@ -195,6 +199,17 @@ const std::string HttpRequest::Dump() const {
   return std::move(oss.str());
 }
 
+bool HttpRequest::AsHeartbeat() {
+  method_ = "OPTIONS";
+  url_ = "*";
+  keepalive_ = true;
+  return true;
+}
+
+bool HttpRequest::IsHeartbeat() const {
+  return url_ == "*" && method_ == "OPTIONS";
+}
+
 void HttpRequest::SetMethod(const std::string method) {
   method_ = method;
   base::StrUtil::ToUpper(method_);
@@ -145,6 +145,11 @@ public:
 
   const std::string Dump() const override;
 
+  // `OPTIONS * HTTP/1.1` as a server-wide ping
+  bool AsHeartbeat() override;
+
+  bool IsHeartbeat() const override;
+
   void parse_url_view();
 
 private:
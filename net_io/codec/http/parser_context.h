@@ -23,7 +23,7 @@
 #include <vector>
 
 #include <base/logging.h>
-#include <base/utils/gzip/gzip_utils.h>
+#include "http_compression.h"
 #include "http_constants.h"
 #include "http_request.h"
 #include "http_response.h"
@@ -101,6 +101,13 @@ Status Parse(IOBuffer* buf) {
   size_t buffer_size = buf->CanReadSize();
   const char* buffer_start = (const char*)buf->GetRead();
   llhttp_errno_t err = llhttp_execute(&parser_, buffer_start, buffer_size);
+  if (err == HPE_PAUSED_UPGRADE) {
+    // upgraded(websocket), data after the handshake message left in buffer
+    const char* end = llhttp_get_error_pos(&parser_);
+    buf->Consume(end - buffer_start);
+    llhttp_resume_after_upgrade(&parser_);
+    return Success;
+  }
   if (err != HPE_OK) {
     LOG(ERROR) << "parser err:" << llhttp_errno_name(err)
                << ", reason:" << parser_.reason
@@ -214,25 +221,10 @@ int OnMessageParsed() {
   current_->SetKeepAlive(llhttp_should_keep_alive(&parser_));
   current_->SetMethod(llhttp_method_name(llhttp_method_t(parser_.method)));
 
-  // gzip, inflat
-  const std::string kgzip("gzip");
-  const std::string& encoding =
-      current_->GetHeader(HttpConstant::kContentEncoding);
-  if (encoding.find(kgzip) != std::string::npos) {
-    std::string decompress_body;
-    if (0 != base::Gzip::decompress_gzip(current_->Body(), decompress_body)) {
-      LOG(ERROR) << " Decode gzip HttpRequest Body Failed";
-      return -1;
-    }
-    current_->SetBody(std::move(decompress_body));
-  } else if (encoding.find("deflate") != std::string::npos) {
-    std::string decompress_body;
-    if (0 !=
-        base::Gzip::decompress_deflate(current_->Body(), decompress_body)) {
-      LOG(ERROR) << " Decode deflate HttpRequest Body Failed";
-      return -1;
-    }
-    current_->SetBody(std::move(decompress_body));
+  // gzip, deflate, zstd, br...
+  if (!HttpCompression::DecompressBody(current_.get())) {
+    LOG(ERROR) << " Decode HttpRequest Body Failed";
+    return -1;
   }
 
   reciever_->CommitHttpRequest(std::move(current_));
@@ -249,27 +241,9 @@ int OnMessageParsed() {
   current_->http_minor_ = parser_.http_minor;
   current_->status_code_ = parser_.status_code;
 
-  const std::string& encoding =
-      current_->GetHeader(HttpConstant::kContentEncoding);
-
-  if (encoding.find("gzip") != std::string::npos) {
-    std::string decompress_body;
-    if (0 != base::Gzip::decompress_gzip(current_->Body(), decompress_body)) {
-      LOG(ERROR) << " Decode gzip HttpRequest Body Failed";
-      return -1;
-    }
-    current_->SetBody(std::move(decompress_body));
-    current_->RemoveHeader(HttpConstant::kContentEncoding);
-
-  } else if (encoding.find("deflate") != std::string::npos) {
-    std::string decompress_body;
-    if (0 !=
-        base::Gzip::decompress_deflate(current_->Body(), decompress_body)) {
-      LOG(ERROR) << " Decode deflate HttpRequest Body Failed";
-      return -1;
-    }
-    current_->SetBody(std::move(decompress_body));
-    current_->RemoveHeader(HttpConstant::kContentEncoding);
+  if (!HttpCompression::DecompressBody(current_.get())) {
+    LOG(ERROR) << " Decode HttpResponse Body Failed";
+    return -1;
   }
   reciever_->CommitHttpResponse(std::move(current_));
   return 0;
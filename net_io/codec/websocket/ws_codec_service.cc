@@ -164,6 +164,18 @@ bool WSCodecService::Send(RefWebsocketFrame message) {
   return IsServerSide() ? SendResponse(nullptr, ptr) : SendRequest(ptr);
 }
 
+bool WSCodecService::SendEncoded(const RefWSEncodedFrame& frame) {
+  DCHECK(IsServerSide() && loop_->IsInLoopThread());
+  if (IsClosed() || hs_state != HS_SUCCEESS) {
+    return false;
+  }
+  int n = channel_->Send(frame->Data(), frame->Size());
+  if (n > 0 && !channel_->HasOutgoingData()) {
+    OnDataFinishSend();
+  }
+  return n >= 0;
+}
+
 bool WSCodecService::SendRequest(CodecMessage* req) {
   WebsocketFrame* wsmsg = (WebsocketFrame*)req;
   size_t size =
@@ -218,7 +230,7 @@ void WSCodecService::CommitHttpRequest(const RefHttpRequest&& request) {
     return;
   }
 
-  ws_path_ = request->Path().to_string();
+  ws_path_ = std::string(request->Path());
   sec_key_ = request->GetHeader(SEC_WEBSOCKET_KEY);
 
   auto ws_accept = WebsocketUtil::GenAcceptKey(sec_key_.c_str());
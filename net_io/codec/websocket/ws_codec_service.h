@@ -45,6 +45,16 @@ public:
 
   bool Send(RefWebsocketFrame message) override;
 
+  /* server side only, write a shared pre-encoded frame; data write
+   * to socket from the shared buffer directly, only the part socket
+   * can't take now is copied into out buffer*/
+  bool SendEncoded(const RefWSEncodedFrame& frame);
+
+  // bytes queued in out buffer waiting for socket writable
+  size_t PendingBytes() const { return channel_->WriterBuffer()->CanReadSize(); }
+
+  bool Handshaked() const { return hs_state == HS_SUCCEESS; }
+
   bool SendRequest(CodecMessage* message) override;
 
   // for bi-stream service/client, req may nil,
@@ -3,6 +3,7 @@
 #include "fmt/core.h"
 
 #include "base/sys/byteorders.h"
+#include "ws_util.h"
 
 namespace lt {
 namespace net {
@@ -29,8 +30,20 @@ void WebsocketFrame::AppendData(const char* data, size_t len) {
   std::copy(data, data + len, std::back_inserter(payload_));
 }
 
+// static
+RefWSEncodedFrame WSEncodedFrame::New(const char* data,
+                                      size_t len,
+                                      int opcode) {
+  std::shared_ptr<WSEncodedFrame> frame(new WSEncodedFrame());
+  frame->frame_.resize(WebsocketUtil::CalculateFrameSize(len));
+  int n = WebsocketUtil::BuildServerFrame(&frame->frame_[0], data, len,
+                                          (ws_opcode)opcode);
+  frame->frame_.resize(n);
+  return frame;
+}
+
 const std::string WebsocketFrame::Dump() const {
-  return fmt::format("opcode:{}, payload:{}", opcode_, Payload().to_string());
+  return fmt::format("opcode:{}, payload:{}", opcode_, std::string(Payload()));
 }
 
 }  // namespace net
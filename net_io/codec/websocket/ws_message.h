@@ -54,6 +54,33 @@ private:
 
 using RefWebsocketFrame = std::shared_ptr<WebsocketFrame>;
 
+class WSEncodedFrame;
+using RefWSEncodedFrame = std::shared_ptr<const WSEncodedFrame>;
+
+/* a server side(unmasked) frame encoded once, immutable after
+ * created, so can be shared by all receivers of a broadcast across
+ * io loops without copy and re-encode for each connection*/
+class WSEncodedFrame {
+public:
+  static RefWSEncodedFrame New(const char* data,
+                               size_t len,
+                               int opcode = WS_OP_TEXT);
+
+  static RefWSEncodedFrame New(const std::string& data,
+                               int opcode = WS_OP_TEXT) {
+    return New(data.data(), data.size(), opcode);
+  }
+
+  const char* Data() const { return frame_.data(); }
+
+  size_t Size() const { return frame_.size(); }
+
+private:
+  WSEncodedFrame() {}
+
+  std::string frame_;
+};
+
 }
 }  // namespace lt
 
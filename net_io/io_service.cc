@@ -40,6 +40,7 @@ IOService::IOService(const IPEndPoint& addr,
     acpt_io_(ioloop),
     delegate_(delegate),
     is_stopping_(false),
+    channel_count_(0),
     endpoint_(addr) {
 
   CHECK(delegate_);
@@ -189,6 +190,7 @@ void IOService::StoreProtocolService(const RefCodecService service) {
   VLOG(VINFO) << "codec:" << service.get() << " added";
 
   codecs_.insert(service);
+  channel_count_ = codecs_.size();
   delegate_->IncreaseChannelCount();
 }
 
@@ -197,6 +199,7 @@ void IOService::RemoveProtocolService(const RefCodecService service) {
   VLOG(VINFO) << "codec:" << service.get() << " stoped";
 
   if (codecs_.erase(service)) {
+    channel_count_ = codecs_.size();
     delegate_->DecreaseChannelCount();
   } else {
     LOG(ERROR) << "seems has been erase preivously";
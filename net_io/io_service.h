@@ -99,6 +99,11 @@ public:
 
   bool IsRunning() { return acceptor_ && acceptor_->IsListening(); }
 
+  const std::string& Protocol() const { return protocol_; }
+
+  // thread safe, connections managed by this service
+  uint64_t ConnectionCount() const { return channel_count_; }
+
 private:
   // void HandleProtoMessage(RefCodecMessage message);
   /* create a new connection channel */
@@ -130,7 +135,7 @@ private:
 
   bool is_stopping_ = false;
 
-  uint64_t channel_count_;
+  std::atomic<uint64_t> channel_count_;
 
   IPEndPoint endpoint_;
 
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _NET_RPC_CODEC_SERVICE_H_H
+#define _NET_RPC_CODEC_SERVICE_H_H
+
+#include "net_io/codec/raw/raw_codec_service.h"
+#include "rpc_message.h"
+
+namespace lt {
+namespace net {
+
+/* raw codec with frame check, a broken frame can't be
+ * skipped, so close the connection instead of waiting for ever*/
+class RpcCodecService : public RawCodecService<RpcMessage> {
+public:
+  RpcCodecService(base::MessageLoop* loop)
+    : RawCodecService<RpcMessage>(loop) {}
+
+  void OnDataReceived(IOBuffer* buffer) override {
+    RawCodecService<RpcMessage>::OnDataReceived(buffer);
+    if (IsClosed() || !RpcMessage::IsBadFrame(buffer)) {
+      return;
+    }
+    LOG(ERROR) << channel_->ChannelInfo() << " bad rpc frame, close it";
+    // closed by HandleEvent after this round
+    schedule_close_ = true;
+  }
+};
+
+}  // namespace net
+}  // namespace lt
+#endif
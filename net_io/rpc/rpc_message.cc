@@ -0,0 +1,181 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <endian.h>
+#include <sstream>
+
+#include "glog/logging.h"
+#include "rpc_message.h"
+
+namespace lt {
+namespace net {
+
+const uint32_t RpcHeader::kHeaderSize = sizeof(RpcHeader);
+const uint8_t RpcHeader::kMagic = 0x4C;  // 'L'
+const uint32_t RpcHeader::kMaxFrameSize = 64 * 1024 * 1024;
+const uint8_t RpcHeader::kCompressMask = 0x0F;
+const uint32_t RpcMessage::kCompressMinSize = 512;
+
+static_assert(sizeof(RpcHeader) == 24, "rpc header should be 24 bytes");
+
+void RpcHeader::ToNetOrder(RpcHeader* out) const {
+  *out = *this;
+  out->frame_size = ::htobe32(frame_size);
+  out->method_id = ::htobe32(method_id);
+  out->timeout_ms = ::htobe32(timeout_ms);
+  out->sequence_id = ::htobe64(sequence_id);
+}
+
+void RpcHeader::FromNetOrder(const RpcHeader* in) {
+  *this = *in;
+  frame_size = ::be32toh(in->frame_size);
+  method_id = ::be32toh(in->method_id);
+  timeout_ms = ::be32toh(in->timeout_ms);
+  sequence_id = ::be64toh(in->sequence_id);
+}
+
+const std::string RpcHeader::Dump() const {
+  std::ostringstream oss;
+  oss << "{\"type\": " << int(type) << ", \"code\": " << int(code)
+      << ", \"flags\": " << int(flags)
+      << ", \"method\": " << method_id << ", \"timeout\": " << timeout_ms
+      << ", \"frame_size\": " << frame_size
+      << ", \"sequence_id\": " << sequence_id << "}";
+  return oss.str();
+}
+
+RefRpcMessage RpcMessage::Create() {
+  return std::make_shared<RpcMessage>();
+}
+
+RefRpcMessage RpcMessage::CreateResponse(const RpcMessage* request) {
+  auto response = Create();
+  response->header_.type = kRpcResponse;
+  response->header_.method_id = request->MethodId();
+  response->header_.sequence_id = request->AsyncId();
+  response->compression_ = request->compression_;
+  return response;
+}
+
+bool RpcMessage::IsBadFrame(IOBuffer* buffer) {
+  if (buffer->CanReadSize() < RpcHeader::kHeaderSize) {
+    return false;
+  }
+  const RpcHeader* wire = (const RpcHeader*)buffer->GetRead();
+  const uint32_t frame_size = ::be32toh(wire->frame_size);
+  return wire->magic != RpcHeader::kMagic ||
+         frame_size < RpcHeader::kHeaderSize ||
+         frame_size > RpcHeader::kMaxFrameSize;
+}
+
+RefRpcMessage RpcMessage::Decode(IOBuffer* buffer, bool server_side) {
+  // a bad frame left in buffer, RpcCodecService close the connection
+  if (buffer->CanReadSize() < RpcHeader::kHeaderSize || IsBadFrame(buffer)) {
+    return nullptr;
+  }
+  const RpcHeader* wire = (const RpcHeader*)buffer->GetRead();
+  const uint32_t frame_size = ::be32toh(wire->frame_size);
+  if (buffer->CanReadSize() < frame_size) {
+    return nullptr;
+  }
+
+  auto message = Create();
+  message->header_.FromNetOrder(wire);
+  message->SetTimeoutMs(message->header_.timeout_ms);
+  buffer->Consume(RpcHeader::kHeaderSize);
+
+  const uint32_t payload_size = message->header_.payload_size();
+  if (payload_size > 0) {
+    message->payload_.assign((const char*)buffer->GetRead(), payload_size);
+    buffer->Consume(payload_size);
+  }
+
+  uint8_t type = message->header_.flags & RpcHeader::kCompressMask;
+  if (type == base::Compressor::kNone) {
+    return message;
+  }
+  message->compression_ = type;
+  const base::Compressor* compressor =
+      base::Compressor::Get(base::Compressor::Type(type));
+  // bounded as a frame, a small compressed one may inflate unlimited
+  std::string payload;
+  if (compressor && compressor->Decompress(message->payload_, &payload,
+                                           RpcHeader::kMaxFrameSize)) {
+    message->payload_.swap(payload);
+    return message;
+  }
+  // frame is complete, only the payload broken; let upper layer
+  // reply/fail this call instead of closing the connection
+  LOG(ERROR) << "decompress rpc payload failed, compression:" << int(type);
+  message->payload_.clear();
+  message->header_.code = server_side ? kRpcBadRequest : kRpcBadResponse;
+  return message;
+}
+
+RpcMessage::RpcMessage() : CodecMessage() {
+  header_.magic = RpcHeader::kMagic;
+}
+
+bool RpcMessage::EncodeTo(SocketChannel* ch) {
+  const std::string* payload = &payload_;
+
+  std::string compressed;
+  header_.flags &= ~RpcHeader::kCompressMask;
+  if (compression_ != base::Compressor::kNone &&
+      payload_.size() >= kCompressMinSize) {
+    const base::Compressor* compressor =
+        base::Compressor::Get(base::Compressor::Type(compression_));
+    if (compressor && compressor->Compress(payload_, &compressed) &&
+        compressed.size() < payload_.size()) {
+      payload = &compressed;
+      header_.flags |= (compression_ & RpcHeader::kCompressMask);
+    }
+  }
+
+  header_.frame_size = RpcHeader::kHeaderSize + payload->size();
+  header_.timeout_ms = TimeoutMs();
+
+  RpcHeader wire;
+  header_.ToNetOrder(&wire);
+
+  // gather header and payload into writer buffer, flush once
+  IOBuffer* buffer = ch->WriterBuffer();
+  buffer->EnsureWritableSize(header_.frame_size);
+  buffer->WriteRawData(&wire, RpcHeader::kHeaderSize);
+  buffer->WriteRawData(payload->data(), payload->size());
+  return ch->HandleWrite() >= 0;
+}
+
+bool RpcMessage::AsHeartbeat() {
+  header_.type = kRpcHeartbeat;
+  header_.code = kRpcOk;
+  return true;
+}
+
+bool RpcMessage::IsHeartbeat() const {
+  return header_.type == kRpcHeartbeat;
+}
+
+const std::string RpcMessage::Dump() const {
+  std::ostringstream oss;
+  oss << "{\"header\": " << header_.Dump()
+      << ", \"payload_size\": " << payload_.size() << "}";
+  return oss.str();
+}
+
+}  // namespace net
+}  // namespace lt
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _NET_RPC_MESSAGE_H_H
+#define _NET_RPC_MESSAGE_H_H
+
+#include <cinttypes>
+
+#include <base/utils/compression/compressor.h>
+#include <net_io/channel.h>
+#include <net_io/codec/codec_message.h>
+
+namespace lt {
+namespace net {
+
+/* status code carried by response header, user define
+ * code should start from kRpcUserCode*/
+typedef enum {
+  kRpcOk = 0,
+  kRpcMethodNotFound = 1,
+  kRpcBadRequest = 2,      // request payload decode failed
+  kRpcBadResponse = 3,     // response payload decode failed
+  kRpcDeadlineExceeded = 4,
+  kRpcUnavailable = 5,     // transport failed, connection broken etc
+  kRpcInternal = 6,
+  kRpcUserCode = 64,
+} RpcCode;
+
+typedef enum {
+  kRpcRequest = 0,
+  kRpcResponse = 1,
+  kRpcHeartbeat = 2,
+} RpcMessageType;
+
+/* 24 bytes fixed header, all fields in network order on wire
+ * +------------+------+------+------+-------+
+ * | frame_size | magic| type | code | flags |
+ * +------------+------+------+------+-------+
+ * | method_id  | timeout_ms  | sequence_id  |
+ * +------------+-------------+--------------+
+ * flags: low 4 bits is base::Compressor::Type of payload
+ * */
+typedef struct RpcHeader {
+  static const uint32_t kHeaderSize;
+  static const uint8_t kMagic;
+  static const uint32_t kMaxFrameSize;
+  static const uint8_t kCompressMask;
+
+  // frame_size = header_size + payload_size
+  uint32_t frame_size = sizeof(RpcHeader);
+  uint8_t magic = 0;
+  uint8_t type = kRpcRequest;
+  uint8_t code = kRpcOk;
+  uint8_t flags = 0;
+  // see RpcMethodId, hash of `service.method`
+  uint32_t method_id = 0;
+  // time budget of this call left when send out, 0 means no deadline;
+  // relative value, so the clocks of two peers needn't be in sync
+  uint32_t timeout_ms = 0;
+  uint64_t sequence_id = 0;
+
+  inline uint32_t payload_size() const { return frame_size - kHeaderSize; }
+
+  void ToNetOrder(RpcHeader* out) const;
+  void FromNetOrder(const RpcHeader* in);
+
+  const std::string Dump() const;
+} RpcHeader;
+
+class RpcMessage : public CodecMessage {
+public:
+  typedef RpcMessage ResponseType;
+  typedef std::shared_ptr<RpcMessage> RefRpcMessage;
+
+  // feature trait, see RawCodecService
+  static bool KeepQueue() { return false; }
+  static bool WithHeartbeat() { return true; }
+
+  static RefRpcMessage Create();
+  static RefRpcMessage CreateResponse(const RpcMessage* request);
+  /* return nullptr when data not enough for a full frame*/
+  static RefRpcMessage Decode(IOBuffer* buffer, bool server_side);
+  /* a broken frame(bad magic or oversize) can't be recovered,
+   * the connection should be closed*/
+  static bool IsBadFrame(IOBuffer* buffer);
+
+  // header and payload write to channel by one write,
+  // CodecMessage::TimeoutMs() carried as the call's time budget
+  bool EncodeTo(SocketChannel* channel);
+
+  // payload smaller than this never compressed
+  static const uint32_t kCompressMinSize;
+
+  RpcMessage();
+  ~RpcMessage() {};
+
+  void SetAsyncId(uint64_t id) override { header_.sequence_id = id; }
+  const uint64_t AsyncId() const override { return header_.sequence_id; };
+
+  bool AsHeartbeat() override;
+  bool IsHeartbeat() const override;
+
+  uint8_t Code() const { return header_.code; }
+  void SetCode(uint8_t code) { header_.code = code; }
+
+  uint32_t MethodId() const { return header_.method_id; }
+  void SetMethodId(uint32_t id) { header_.method_id = id; }
+
+  // serialized payload, see RpcWriter/RpcReader
+  const std::string& Payload() const { return payload_; }
+  std::string* MutablePayload() { return &payload_; }
+
+  /* payload compressed when encode if it's large enough and
+   * get smaller, a response use the same codec as it's request;
+   * type not compiled in will be ignored, see base::Compressor*/
+  void SetCompression(uint8_t type) { compression_ = type; }
+  uint8_t Compression() const { return compression_; }
+
+  const RpcHeader& Header() const { return header_; }
+
+  const std::string Dump() const override;
+
+private:
+  RpcHeader header_;
+  std::string payload_;
+  uint8_t compression_ = base::Compressor::kNone;
+};
+typedef RpcMessage::RefRpcMessage RefRpcMessage;
+
+}  // namespace net
+}  // namespace lt
+#endif
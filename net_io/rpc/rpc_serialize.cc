@@ -0,0 +1,112 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <endian.h>
+
+#include "rpc_serialize.h"
+
+namespace lt {
+namespace net {
+
+void RpcWriter::WriteVarint(uint64_t v) {
+  char buf[10];
+  size_t n = 0;
+  while (v >= 0x80) {
+    buf[n++] = char(v | 0x80);
+    v >>= 7;
+  }
+  buf[n++] = char(v);
+  out_->append(buf, n);
+}
+
+void RpcWriter::WriteFixed32(uint32_t v) {
+  v = ::htole32(v);
+  out_->append((const char*)&v, sizeof(v));
+}
+
+void RpcWriter::WriteFixed64(uint64_t v) {
+  v = ::htole64(v);
+  out_->append((const char*)&v, sizeof(v));
+}
+
+size_t RpcWriter::BeginNested() {
+  size_t offset = out_->size();
+  out_->append(sizeof(uint32_t), '\0');
+  return offset;
+}
+
+void RpcWriter::EndNested(size_t offset) {
+  uint32_t len = out_->size() - offset - sizeof(uint32_t);
+  len = ::htole32(len);
+  ::memcpy(&(*out_)[offset], &len, sizeof(len));
+}
+
+bool RpcReader::ReadVarint(uint64_t* v) {
+  uint64_t result = 0;
+  for (int shift = 0; shift < 64 && data_ < end_; shift += 7) {
+    uint8_t byte = uint8_t(*data_++);
+    result |= uint64_t(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      *v = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool RpcReader::ReadFixed32(uint32_t* v) {
+  if (Remain() < sizeof(uint32_t)) {
+    return false;
+  }
+  ::memcpy(v, data_, sizeof(uint32_t));
+  *v = ::le32toh(*v);
+  data_ += sizeof(uint32_t);
+  return true;
+}
+
+bool RpcReader::ReadFixed64(uint64_t* v) {
+  if (Remain() < sizeof(uint64_t)) {
+    return false;
+  }
+  ::memcpy(v, data_, sizeof(uint64_t));
+  *v = ::le64toh(*v);
+  data_ += sizeof(uint64_t);
+  return true;
+}
+
+bool RpcReader::ReadBytes(std::string_view* out) {
+  uint64_t len = 0;
+  if (!ReadVarint(&len) || len > Remain()) {
+    return false;
+  }
+  *out = std::string_view(data_, len);
+  data_ += len;
+  return true;
+}
+
+bool RpcReader::ReadNested(RpcReader* nested) {
+  uint32_t len = 0;
+  if (!ReadFixed32(&len) || len > Remain()) {
+    return false;
+  }
+  *nested = RpcReader(data_, len);
+  data_ += len;
+  return true;
+}
+
+}  // namespace net
+}  // namespace lt
@@ -0,0 +1,362 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _NET_RPC_SERIALIZE_H_H
+#define _NET_RPC_SERIALIZE_H_H
+
+#include <cinttypes>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <base/string/string_view.h>
+
+/**
+ * compact binary format for rpc payload
+ *
+ * - unsigned integer/bool/enum: varint
+ * - signed integer: zigzag varint
+ * - float/double: fixed 32/64 little endian
+ * - string/bytes: varint length + data
+ * - vector: varint count + elements
+ * - nested struct: fixed32 length + fields
+ *
+ * a struct declare its fields by LT_RPC_FIELDS in order, fields have no tag,
+ * so schema can only evolve by append new field at the tail: an older peer
+ * ignore the trailing bytes and a newer one keep default value for missing
+ * fields.
+ *
+ * decode std::string_view field point into the payload without copy, so
+ * the view only valid before the message gone.
+ *
+ * a type with protobuf like api(SerializeToString/ParseFromArray) can be
+ * used as request/response directly without any dependency here.
+ *
+ * struct EchoRequest {
+ *   std::string content;
+ *   uint32_t repeat = 1;
+ *   LT_RPC_FIELDS(content, repeat);
+ * };
+ * */
+
+namespace lt {
+namespace net {
+
+class RpcWriter {
+public:
+  explicit RpcWriter(std::string* out) : out_(out) {}
+
+  void WriteVarint(uint64_t v);
+
+  void WriteZigzag(int64_t v) {
+    WriteVarint((uint64_t(v) << 1) ^ uint64_t(v >> 63));
+  }
+
+  void WriteFixed32(uint32_t v);
+
+  void WriteFixed64(uint64_t v);
+
+  void WriteBytes(const char* data, size_t len) {
+    WriteVarint(len);
+    out_->append(data, len);
+  }
+
+  // nested message: reserve fixed32 length, patch it in EndNested
+  size_t BeginNested();
+  void EndNested(size_t offset);
+
+private:
+  std::string* out_;
+};
+
+class RpcReader {
+public:
+  RpcReader(const char* data, size_t len) : data_(data), end_(data + len) {}
+
+  bool Empty() const { return data_ >= end_; }
+
+  size_t Remain() const { return end_ - data_; }
+
+  bool ReadVarint(uint64_t* v);
+
+  bool ReadZigzag(int64_t* v) {
+    uint64_t u = 0;
+    if (!ReadVarint(&u)) {
+      return false;
+    }
+    *v = int64_t(u >> 1) ^ -int64_t(u & 1);
+    return true;
+  }
+
+  bool ReadFixed32(uint32_t* v);
+
+  bool ReadFixed64(uint64_t* v);
+
+  // zero copy, view point to the underlying payload
+  bool ReadBytes(std::string_view* out);
+
+  // nested message reader bounded by its length
+  bool ReadNested(RpcReader* nested);
+
+private:
+  const char* data_;
+  const char* end_;
+};
+
+namespace rpc_detail {
+
+template <typename... Ts>
+struct make_void {
+  typedef void type;
+};
+template <typename... Ts>
+using void_t = typename make_void<Ts...>::type;
+
+template <typename T, typename = void>
+struct has_rpc_fields : std::false_type {};
+template <typename T>
+struct has_rpc_fields<
+    T,
+    void_t<decltype(std::declval<const T&>().Encode((RpcWriter*)nullptr)),
+           decltype(std::declval<T&>().Decode((RpcReader*)nullptr))>>
+  : std::true_type {};
+
+template <typename T, typename = void>
+struct is_pb_message : std::false_type {};
+template <typename T>
+struct is_pb_message<
+    T,
+    void_t<decltype(std::declval<const T&>().SerializeToString(
+               (std::string*)nullptr)),
+           decltype(std::declval<T&>().ParseFromArray(nullptr, 0))>>
+  : std::true_type {};
+
+}  // namespace rpc_detail
+
+template <typename T, typename Enable = void>
+struct RpcField;
+
+template <typename T>
+struct RpcField<T,
+                typename std::enable_if<std::is_integral<T>::value &&
+                                        std::is_unsigned<T>::value>::type> {
+  static void Encode(RpcWriter* w, const T& v) { w->WriteVarint(v); }
+  static bool Decode(RpcReader* r, T* v) {
+    uint64_t u = 0;
+    if (!r->ReadVarint(&u)) {
+      return false;
+    }
+    *v = static_cast<T>(u);
+    return true;
+  }
+};
+
+template <typename T>
+struct RpcField<T,
+                typename std::enable_if<std::is_integral<T>::value &&
+                                        std::is_signed<T>::value>::type> {
+  static void Encode(RpcWriter* w, const T& v) { w->WriteZigzag(v); }
+  static bool Decode(RpcReader* r, T* v) {
+    int64_t s = 0;
+    if (!r->ReadZigzag(&s)) {
+      return false;
+    }
+    *v = static_cast<T>(s);
+    return true;
+  }
+};
+
+template <typename T>
+struct RpcField<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+  static void Encode(RpcWriter* w, const T& v) { w->WriteVarint(uint64_t(v)); }
+  static bool Decode(RpcReader* r, T* v) {
+    uint64_t u = 0;
+    if (!r->ReadVarint(&u)) {
+      return false;
+    }
+    *v = static_cast<T>(u);
+    return true;
+  }
+};
+
+template <>
+struct RpcField<float> {
+  static void Encode(RpcWriter* w, const float& v) {
+    uint32_t bits;
+    ::memcpy(&bits, &v, sizeof(bits));
+    w->WriteFixed32(bits);
+  }
+  static bool Decode(RpcReader* r, float* v) {
+    uint32_t bits = 0;
+    if (!r->ReadFixed32(&bits)) {
+      return false;
+    }
+    ::memcpy(v, &bits, sizeof(bits));
+    return true;
+  }
+};
+
+template <>
+struct RpcField<double> {
+  static void Encode(RpcWriter* w, const double& v) {
+    uint64_t bits;
+    ::memcpy(&bits, &v, sizeof(bits));
+    w->WriteFixed64(bits);
+  }
+  static bool Decode(RpcReader* r, double* v) {
+    uint64_t bits = 0;
+    if (!r->ReadFixed64(&bits)) {
+      return false;
+    }
+    ::memcpy(v, &bits, sizeof(bits));
+    return true;
+  }
+};
+
+template <>
+struct RpcField<std::string> {
+  static void Encode(RpcWriter* w, const std::string& v) {
+    w->WriteBytes(v.data(), v.size());
+  }
+  static bool Decode(RpcReader* r, std::string* v) {
+    std::string_view view;
+    if (!r->ReadBytes(&view)) {
+      return false;
+    }
+    v->assign(view.data(), view.size());
+    return true;
+  }
+};
+
+template <>
+struct RpcField<std::string_view> {
+  static void Encode(RpcWriter* w, const std::string_view& v) {
+    w->WriteBytes(v.data(), v.size());
+  }
+  static bool Decode(RpcReader* r, std::string_view* v) {
+    return r->ReadBytes(v);
+  }
+};
+
+template <typename T>
+struct RpcField<std::vector<T>> {
+  static void Encode(RpcWriter* w, const std::vector<T>& v) {
+    w->WriteVarint(v.size());
+    for (const auto& item : v) {
+      RpcField<T>::Encode(w, item);
+    }
+  }
+  static bool Decode(RpcReader* r, std::vector<T>* v) {
+    uint64_t count = 0;
+    // every element take one byte at least
+    if (!r->ReadVarint(&count) || count > r->Remain()) {
+      return false;
+    }
+    v->resize(count);
+    for (auto& item : *v) {
+      if (!RpcField<T>::Decode(r, &item)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+// nested struct declared with LT_RPC_FIELDS
+template <typename T>
+struct RpcField<
+    T,
+    typename std::enable_if<rpc_detail::has_rpc_fields<T>::value>::type> {
+  static void Encode(RpcWriter* w, const T& v) {
+    size_t offset = w->BeginNested();
+    v.Encode(w);
+    w->EndNested(offset);
+  }
+  static bool Decode(RpcReader* r, T* v) {
+    RpcReader nested(nullptr, 0);
+    return r->ReadNested(&nested) && v->Decode(&nested);
+  }
+};
+
+inline void RpcEncodeFields(RpcWriter* w) {}
+
+template <typename T, typename... Args>
+void RpcEncodeFields(RpcWriter* w, const T& field, const Args&... fields) {
+  RpcField<T>::Encode(w, field);
+  RpcEncodeFields(w, fields...);
+}
+
+inline bool RpcDecodeFields(RpcReader* r) {
+  return true;
+}
+
+template <typename T, typename... Args>
+bool RpcDecodeFields(RpcReader* r, T& field, Args&... fields) {
+  // missing tail fields, written by an older peer
+  if (r->Empty()) {
+    return true;
+  }
+  if (!RpcField<T>::Decode(r, &field)) {
+    return false;
+  }
+  return RpcDecodeFields(r, fields...);
+}
+
+#define LT_RPC_FIELDS(...)                               \
+  void Encode(::lt::net::RpcWriter* _w) const {          \
+    ::lt::net::RpcEncodeFields(_w, __VA_ARGS__);         \
+  }                                                      \
+  bool Decode(::lt::net::RpcReader* _r) {                \
+    return ::lt::net::RpcDecodeFields(_r, __VA_ARGS__);  \
+  }
+
+/* serialize a request/response into rpc payload*/
+template <typename T>
+typename std::enable_if<rpc_detail::has_rpc_fields<T>::value, bool>::type
+RpcSerialize(const T& message, std::string* out) {
+  RpcWriter writer(out);
+  message.Encode(&writer);
+  return true;
+}
+
+template <typename T>
+typename std::enable_if<rpc_detail::has_rpc_fields<T>::value, bool>::type
+RpcParse(const std::string& payload, T* message) {
+  RpcReader reader(payload.data(), payload.size());
+  return message->Decode(&reader);
+}
+
+template <typename T>
+typename std::enable_if<rpc_detail::is_pb_message<T>::value &&
+                            !rpc_detail::has_rpc_fields<T>::value,
+                        bool>::type
+RpcSerialize(const T& message, std::string* out) {
+  return message.SerializeToString(out);
+}
+
+template <typename T>
+typename std::enable_if<rpc_detail::is_pb_message<T>::value &&
+                            !rpc_detail::has_rpc_fields<T>::value,
+                        bool>::type
+RpcParse(const std::string& payload, T* message) {
+  return message->ParseFromArray(payload.data(), int(payload.size()));
+}
+
+}  // namespace net
+}  // namespace lt
+#endif
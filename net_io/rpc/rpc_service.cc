@@ -0,0 +1,172 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rpc_service.h"
+
+#include "base/time/time_utils.h"
+#include "glog/logging.h"
+
+namespace lt {
+namespace net {
+
+namespace {
+
+int rpc_code_from_fail(MessageCode fail) {
+  switch (fail) {
+    case kSuccess:
+      return kRpcOk;
+    case kTimeOut:
+      return kRpcDeadlineExceeded;
+    case kBadMessage:
+      return kRpcBadResponse;
+    default:
+      break;
+  }
+  return kRpcUnavailable;
+}
+
+}  // namespace
+
+RpcContext::RpcContext(const RefRawRequestContext& raw) : raw_(raw) {
+  uint32_t timeout = Request()->TimeoutMs();
+  if (timeout > 0) {
+    deadline_ = base::time_ms() + timeout;
+  }
+}
+
+bool RpcContext::Expired() const {
+  return deadline_ > 0 && base::time_ms() >= deadline_;
+}
+
+int64_t RpcContext::RemainMs() const {
+  if (deadline_ == 0) {
+    return -1;
+  }
+  return std::max<int64_t>(deadline_ - base::time_ms(), 0);
+}
+
+bool RpcDispatcher::RegisterHandler(uint32_t method_id,
+                                    const std::string& name,
+                                    const MethodHandler& handler) {
+  auto ret = methods_.emplace(method_id, MethodEntry{name, handler});
+  LOG_IF(ERROR, !ret.second) << "rpc method:" << name << " id:" << method_id
+                             << " conflict with:" << ret.first->second.name;
+  return ret.second;
+}
+
+void RpcDispatcher::Dispatch(const RefRawRequestContext& context) {
+  const RpcMessage* request = context->GetRequest<RpcMessage>();
+  RefRpcMessage response = RpcMessage::CreateResponse(request);
+
+  RpcContext ctx(context);
+
+  int code = kRpcOk;
+  auto iter = methods_.find(request->MethodId());
+  if (request->Code() != kRpcOk) {
+    // payload broken when decode, see RpcMessage::Decode
+    code = request->Code();
+  } else if (iter == methods_.end()) {
+    VLOG(VINFO) << "rpc method not found:" << request->MethodId();
+    code = kRpcMethodNotFound;
+  } else if (ctx.Expired()) {
+    code = kRpcDeadlineExceeded;
+  } else {
+    code = iter->second.handler(ctx, *request, response.get());
+  }
+
+  // caller has given up, the response is useless
+  if (ctx.Expired()) {
+    VLOG(VINFO) << "rpc call deadline exceeded, drop response, method:"
+                << request->MethodId();
+    return;
+  }
+
+  if (code != kRpcOk) {
+    response->MutablePayload()->clear();
+  }
+  response->SetCode(code);
+  context->Response(response);
+}
+
+CodecService::Handler* RpcDispatcher::NewHandler(bool coro) {
+  auto dispatch = [this](const RefRawRequestContext& context) {
+    Dispatch(context);
+  };
+  if (coro) {
+    return NewRawCoroHandler(dispatch);
+  }
+  return NewRawHandler(dispatch);
+}
+
+void RpcChannel::prepare_request(uint32_t method_id,
+                                 RpcMessage* request,
+                                 uint32_t timeout_ms) const {
+  request->SetMethodId(method_id);
+  if (timeout_ms == 0) {
+    timeout_ms = client_->GetClientConfig().message_timeout;
+  }
+  request->SetTimeoutMs(timeout_ms);
+  request->SetCompression(compression_);
+}
+
+int RpcChannel::CallMethod(uint32_t method_id,
+                           RefRpcMessage& request,
+                           uint32_t timeout_ms,
+                           RefRpcMessage* response) {
+  prepare_request(method_id, request.get(), timeout_ms);
+
+  RpcMessage* res = client_->SendRecieve(request);
+  int code = rpc_code_from_fail(request->FailCode());
+  if (code != kRpcOk) {
+    return code;
+  }
+  if (!res) {
+    return kRpcUnavailable;
+  }
+  *response = RefCast(RpcMessage, request->Response());
+  return res->Code();
+}
+
+bool RpcChannel::AsyncCallMethod(
+    uint32_t method_id,
+    const RefRpcMessage& request,
+    uint32_t timeout_ms,
+    const std::function<void(int, const RpcMessage*)>& callback) {
+  prepare_request(method_id, request.get(), timeout_ms);
+
+  // weak ref, a strong one captured by request's resumer make a cycle
+  std::weak_ptr<RpcMessage> weak(request);
+  AsyncCallBack resumer = [weak, callback](CodecMessage* response) {
+    auto req = weak.lock();
+    if (!req) {
+      return callback(kRpcUnavailable, nullptr);
+    }
+    int code = rpc_code_from_fail(req->FailCode());
+    if (code == kRpcOk && !response) {
+      code = kRpcUnavailable;
+    }
+    if (code != kRpcOk) {
+      return callback(code, nullptr);
+    }
+    const RpcMessage* res = static_cast<const RpcMessage*>(response);
+    callback(res->Code(), res);
+  };
+  return client_->AsyncDoRequest(request, resumer);
+}
+
+}  // namespace net
+}  // namespace lt
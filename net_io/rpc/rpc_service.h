@@ -0,0 +1,262 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _NET_RPC_SERVICE_H_H
+#define _NET_RPC_SERVICE_H_H
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+
+#include "net_io/clients/client.h"
+#include "net_io/server/raw_server/raw_server.h"
+#include "rpc_message.h"
+#include "rpc_serialize.h"
+
+/**
+ * rpc over RpcMessage(raw codec with 24 bytes header), scheme `rpc://`
+ *
+ * define a service, method id is fnv1a hash of `service.method`:
+ *
+ * class EchoService : public lt::net::RpcStub {
+ * public:
+ *   LT_RPC_SERVICE(EchoService, "demo.EchoService");
+ *   LT_RPC_METHOD(Echo, EchoRequest, EchoResponse);
+ * };
+ *
+ * server side:
+ *   RpcDispatcher dispatcher;
+ *   dispatcher.Register<EchoService::EchoMethod>(
+ *     [](const RpcContext& ctx, const EchoRequest& req, EchoResponse* rsp) {
+ *       rsp->content = req.content;
+ *       return kRpcOk;
+ *     });
+ *   server.ServeAddress("rpc://0.0.0.0:5008", dispatcher.NewHandler());
+ *
+ * client side(in coroutine):
+ *   RpcChannel channel(&client);
+ *   EchoService stub(&channel);
+ *   int code = stub.Echo(req, &rsp, 100);  // with 100ms deadline
+ * */
+
+namespace lt {
+namespace net {
+
+constexpr uint32_t RpcHash(const char* s, uint32_t h = 2166136261u) {
+  return *s ? RpcHash(s + 1, (h ^ uint8_t(*s)) * 16777619u) : h;
+}
+
+constexpr uint32_t RpcMethodId(const char* service, const char* method) {
+  return RpcHash(method, RpcHash(".", RpcHash(service)));
+}
+
+/* server side context of a call*/
+class RpcContext {
+public:
+  RpcContext(const RefRawRequestContext& raw);
+
+  const RpcMessage* Request() const {
+    return raw_->GetRequest<RpcMessage>();
+  }
+
+  uint32_t MethodId() const { return Request()->MethodId(); }
+
+  // absolute deadline in ms, 0 means the caller not set one
+  int64_t Deadline() const { return deadline_; }
+
+  bool Expired() const;
+
+  // ms left before deadline, <0 when no deadline
+  int64_t RemainMs() const;
+
+private:
+  RefRawRequestContext raw_;
+  int64_t deadline_ = 0;
+};
+
+class RpcDispatcher {
+public:
+  // handle a call, fill response payload and return the code
+  typedef std::function<int(const RpcContext&, const RpcMessage&, RpcMessage*)>
+      MethodHandler;
+
+  RpcDispatcher() {}
+
+  /* Method: a method descriptor defined by LT_RPC_METHOD
+   * Functor: int(const RpcContext&, const Method::Request&, Method::Response*)
+   * */
+  template <typename Method, typename Functor>
+  bool Register(const Functor& fn) {
+    typedef typename Method::Request Req;
+    typedef typename Method::Response Rsp;
+    MethodHandler handler = [fn](const RpcContext& ctx,
+                                 const RpcMessage& request,
+                                 RpcMessage* response) -> int {
+      Req req;
+      if (!RpcParse(request.Payload(), &req)) {
+        return kRpcBadRequest;
+      }
+      Rsp rsp;
+      int code = fn(ctx, req, &rsp);
+      if (code == kRpcOk && !RpcSerialize(rsp, response->MutablePayload())) {
+        return kRpcInternal;
+      }
+      return code;
+    };
+    return RegisterHandler(Method::Id(), Method::FullName(), handler);
+  }
+
+  // register before serving, the registry is not guarded by lock
+  bool RegisterHandler(uint32_t method_id,
+                       const std::string& name,
+                       const MethodHandler& handler);
+
+  void Dispatch(const RefRawRequestContext& context);
+
+  // a handler for RawServer/RawCoroServer, dispatch in coroutine
+  // when `coro` is true, so handler can do blocking style io
+  CodecService::Handler* NewHandler(bool coro = true);
+
+  size_t MethodCount() const { return methods_.size(); }
+
+private:
+  struct MethodEntry {
+    std::string name;
+    MethodHandler handler;
+  };
+  std::unordered_map<uint32_t, MethodEntry> methods_;
+
+  DISALLOW_COPY_AND_ASSIGN(RpcDispatcher);
+};
+
+/* client side, wrap a Client created with `rpc://` scheme*/
+class RpcChannel {
+public:
+  template <typename Rsp>
+  using Callback = std::function<void(int code, const Rsp* response)>;
+
+  explicit RpcChannel(Client* client) : client_(client) {}
+
+  /* must call in coroutine, return RpcCode or user code;
+   * timeout_ms 0: use client's message_timeout*/
+  template <typename Method>
+  int Call(const typename Method::Request& req,
+           typename Method::Response* rsp,
+           uint32_t timeout_ms = 0) {
+    RefRpcMessage request = RpcMessage::Create();
+    if (!RpcSerialize(req, request->MutablePayload())) {
+      return kRpcBadRequest;
+    }
+    RefRpcMessage response;
+    int code = CallMethod(Method::Id(), request, timeout_ms, &response);
+    if (code != kRpcOk) {
+      return code;
+    }
+    return RpcParse(response->Payload(), rsp) ? code : kRpcBadResponse;
+  }
+
+  /* callback run on a client's io loop*/
+  template <typename Method>
+  bool AsyncCall(const typename Method::Request& req,
+                 const Callback<typename Method::Response>& callback,
+                 uint32_t timeout_ms = 0) {
+    typedef typename Method::Response Rsp;
+    RefRpcMessage request = RpcMessage::Create();
+    if (!RpcSerialize(req, request->MutablePayload())) {
+      return false;
+    }
+    return AsyncCallMethod(
+        Method::Id(), request, timeout_ms,
+        [callback](int code, const RpcMessage* response) {
+          if (code != kRpcOk) {
+            return callback(code, nullptr);
+          }
+          Rsp rsp;
+          if (!RpcParse(response->Payload(), &rsp)) {
+            return callback(kRpcBadResponse, nullptr);
+          }
+          callback(code, &rsp);
+        });
+  }
+
+  int CallMethod(uint32_t method_id,
+                 RefRpcMessage& request,
+                 uint32_t timeout_ms,
+                 RefRpcMessage* response);
+
+  bool AsyncCallMethod(
+      uint32_t method_id,
+      const RefRpcMessage& request,
+      uint32_t timeout_ms,
+      const std::function<void(int, const RpcMessage*)>& callback);
+
+  Client* GetClient() { return client_; }
+
+  /* compress large request payload with this codec, server
+   * reply with the same one, eg: base::Compressor::kLz4*/
+  void SetCompression(base::Compressor::Type type) { compression_ = type; }
+
+private:
+  void prepare_request(uint32_t method_id,
+                       RpcMessage* request,
+                       uint32_t timeout_ms) const;
+
+  Client* client_;
+  base::Compressor::Type compression_ = base::Compressor::kNone;
+};
+
+/* base of generated stubs, see LT_RPC_SERVICE/LT_RPC_METHOD*/
+class RpcStub {
+public:
+  explicit RpcStub(RpcChannel* channel) : channel_(channel) {}
+  virtual ~RpcStub() {}
+
+  RpcChannel* Channel() { return channel_; }
+
+protected:
+  RpcChannel* channel_;
+};
+
+#define LT_RPC_SERVICE(Stub, service_name)                          \
+  explicit Stub(::lt::net::RpcChannel* channel = nullptr)           \
+    : ::lt::net::RpcStub(channel) {}                                \
+  static constexpr const char* ServiceName() { return service_name; }
+
+#define LT_RPC_METHOD(method, Req, Rsp)                                  \
+  struct method##Method {                                               \
+    typedef Req Request;                                                \
+    typedef Rsp Response;                                               \
+    static constexpr const char* Name() { return #method; }             \
+    static constexpr uint32_t Id() {                                    \
+      return ::lt::net::RpcMethodId(ServiceName(), #method);            \
+    }                                                                   \
+    static std::string FullName() {                                     \
+      return std::string(ServiceName()) + "." + #method;                \
+    }                                                                   \
+  };                                                                    \
+  int method(const Req& req, Rsp* rsp, uint32_t timeout_ms = 0) {       \
+    return channel_->Call<method##Method>(req, rsp, timeout_ms);        \
+  }                                                                     \
+  bool Async##method(const Req& req,                                    \
+                     const ::lt::net::RpcChannel::Callback<Rsp>& cb,    \
+                     uint32_t timeout_ms = 0) {                         \
+    return channel_->AsyncCall<method##Method>(req, cb, timeout_ms);    \
+  }
+
+}  // namespace net
+}  // namespace lt
+#endif
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "admin_server.h"
+
+#include "base/coroutine/co_runner.h"
+#include "components/log_metrics/metrics_registry.h"
+#include "nlohmann/json.hpp"
+
+namespace lt {
+namespace net {
+
+namespace {
+
+nlohmann::json LoopsJson() {
+  nlohmann::json loops = nlohmann::json::array();
+  for (const base::LoopStats& stats : base::MessageLoop::AllLoopStats()) {
+    nlohmann::json loop;
+    loop["name"] = stats.name;
+    loop["id"] = stats.loop_id;
+    loop["iterations"] = stats.iterations;
+    loop["tasks_run"] = stats.tasks_run;
+    loop["queue_depth"] = stats.queue_depth;
+    loop["timers"] = stats.timers;
+    loop["last_busy_us"] = stats.last_busy_us;
+    loop["max_busy_us"] = stats.max_busy_us;
+    loop["running_us"] = stats.running_us;
+    loops.push_back(std::move(loop));
+  }
+  return loops;
+}
+
+nlohmann::json CoroutinesJson() {
+  nlohmann::json runners = nlohmann::json::array();
+  for (const co::CoroRunnerStats& stats : co::CoroRunner::AllStats()) {
+    nlohmann::json runner;
+    runner["loop"] = stats.loop_name;
+    runner["loop_id"] = stats.loop_id;
+    runner["coroutines"] = stats.coroutines;
+    runner["free"] = stats.free;
+    runner["ready"] = stats.ready;
+    runner["parked"] = stats.parked;
+    runner["pending_tasks"] = stats.pending_tasks;
+    runner["tasks_run"] = stats.tasks_run;
+    runner["tasks_stolen"] = stats.tasks_stolen;
+    runners.push_back(std::move(runner));
+  }
+  nlohmann::json result;
+  result["published_tasks"] = co::CoroRunner::PublishedTaskCount();
+  result["runners"] = std::move(runners);
+  return result;
+}
+
+nlohmann::json ClientJson(const RefClient& client) {
+  nlohmann::json result;
+  const ClientConfig& config = client->GetClientConfig();
+  uint32_t ready = client->ReadyCount();
+  result["remote"] = client->RemoteIpPort();
+  result["ready"] = ready;
+  result["connected"] = client->ConnectedCount();
+  result["connecting"] = client->ConnectingCount();
+  result["inflight"] = client->InflightCount();
+  result["min_connections"] = config.connections;
+  result["max_connections"] =
+      std::max(config.connections, config.max_connections);
+  result["healthy"] = ready > 0;
+  return result;
+}
+
+}  // namespace
+
+AdminServer::AdminServer() {
+  handler_.reset(NewHttpHandler(
+      std::bind(&AdminServer::HandleRequest, this, std::placeholders::_1)));
+}
+
+AdminServer::~AdminServer() {}
+
+AdminServer& AdminServer::WatchIOServices(const std::string& name,
+                                          const IOServicesGetter& getter) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  servers_.emplace_back(name, getter);
+  return *this;
+}
+
+AdminServer& AdminServer::WatchClients(const std::string& name,
+                                       ClientsManager* manager) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  clients_.push_back({name, [manager]() { return manager->Clients(); }});
+  return *this;
+}
+
+AdminServer& AdminServer::WatchRouter(const std::string& name,
+                                      ClientRouter* router) {
+  std::lock_guard<std::mutex> lck(mtx_);
+  clients_.push_back({name, [router]() { return router->Clients(); }});
+  return *this;
+}
+
+void AdminServer::Serve(const std::string& address,
+                        const base::RawLoopList& loops) {
+  http_server_.WithIOLoops(loops).ServeAddress(address, handler_.get());
+}
+
+void AdminServer::Stop(const base::ClosureCallback& callback) {
+  http_server_.StopServer(callback);
+}
+
+std::string AdminServer::Report(const std::string& section) const {
+  nlohmann::json report;
+  bool all = section.empty();
+
+  if (all || section == "loops") {
+    report["loops"] = LoopsJson();
+  }
+  if (all || section == "coroutines") {
+    report["coroutines"] = CoroutinesJson();
+  }
+
+  std::unique_lock<std::mutex> lck(mtx_);
+  if (all || section == "servers") {
+    nlohmann::json servers = nlohmann::json::array();
+    for (auto& watched : servers_) {
+      nlohmann::json server;
+      nlohmann::json services = nlohmann::json::array();
+      uint64_t connections = 0;
+      for (const RefIOService& service : watched.second()) {
+        nlohmann::json s;
+        s["address"] = service->IOServiceName();
+        s["protocol"] = service->Protocol();
+        s["running"] = service->IsRunning();
+        s["loop"] = service->AcceptorLoop()->LoopName();
+        s["connections"] = service->ConnectionCount();
+        connections += service->ConnectionCount();
+        services.push_back(std::move(s));
+      }
+      server["name"] = watched.first;
+      server["connections"] = connections;
+      server["io_services"] = std::move(services);
+      servers.push_back(std::move(server));
+    }
+    report["servers"] = std::move(servers);
+  }
+  if (all || section == "clients") {
+    nlohmann::json groups = nlohmann::json::array();
+    for (auto& watched : clients_) {
+      nlohmann::json group;
+      nlohmann::json clients = nlohmann::json::array();
+      uint32_t healthy = 0;
+      for (const RefClient& client : watched.clients()) {
+        if (!client) {
+          continue;
+        }
+        nlohmann::json c = ClientJson(client);
+        healthy += c["healthy"].get<bool>() ? 1 : 0;
+        clients.push_back(std::move(c));
+      }
+      group["name"] = watched.name;
+      group["healthy"] = healthy;
+      group["total"] = clients.size();
+      group["clients"] = std::move(clients);
+      groups.push_back(std::move(group));
+    }
+    report["clients"] = std::move(groups);
+  }
+  lck.unlock();
+
+  if (report.empty()) {
+    return std::string();
+  }
+  if (!all) {
+    return report.begin()->dump(2);
+  }
+  return report.dump(2);
+}
+
+void AdminServer::HandleRequest(const RefHttpRequestCtx& context) {
+  const HttpRequest* request = context->Request();
+  std::string path(request->Path().data(), request->Path().size());
+  while (path.size() > 1 && path.back() == '/') {
+    path.pop_back();
+  }
+
+  if (path == "/metrics") {
+    return context->String(
+        component::MetricsRegistry::Default()->PrometheusText());
+  }
+
+  std::string section = path.size() > 1 ? path.substr(1) : std::string();
+  std::string report = Report(section);
+  if (report.empty()) {
+    return context->String("not found", 404);
+  }
+  context->Json(report);
+}
+
+}  // namespace net
+}  // namespace lt
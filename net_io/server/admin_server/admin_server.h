@@ -0,0 +1,107 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LT_NET_ADMIN_SERVER_H_H
+#define _LT_NET_ADMIN_SERVER_H_H
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "base/message_loop/message_loop.h"
+#include "net_io/clients/clients_manager.h"
+#include "net_io/clients/router/client_router.h"
+#include "net_io/server/http_server/http_server.h"
+
+namespace lt {
+namespace net {
+
+/*
+ * optional runtime introspection over http, all data come from
+ * counters published by loops/runners, a blocked loop can still
+ * be inspected; requests are answered in io loop directly
+ *
+ * GET /            all sections below in one json
+ * GET /loops       per MessageLoop queue depth, busy time, timers
+ * GET /coroutines  per CoroRunner coroutines(free/ready/parked), steals
+ * GET /servers     watched servers' io services and connections
+ * GET /clients     watched client pools and routers health
+ * GET /metrics     MetricsRegistry::Default() in prometheus text
+ *
+ * usage example:
+ *
+ * AdminServer admin;
+ * admin.WatchServer("http", &http_server)
+ *      .WatchClients("upstream", &clients_manager);
+ * admin.Serve("http://127.0.0.1:6060", loops);
+ * */
+class AdminServer {
+public:
+  typedef std::function<std::list<RefIOService>()> IOServicesGetter;
+
+  AdminServer();
+
+  ~AdminServer();
+
+  template <typename Server>
+  AdminServer& WatchServer(const std::string& name, Server* server) {
+    return WatchIOServices(name, [server]() { return server->IOServices(); });
+  }
+
+  AdminServer& WatchIOServices(const std::string& name,
+                               const IOServicesGetter& getter);
+
+  AdminServer& WatchClients(const std::string& name, ClientsManager* manager);
+
+  AdminServer& WatchRouter(const std::string& name, ClientRouter* router);
+
+  // address eg: http://127.0.0.1:6060
+  void Serve(const std::string& address, const base::RawLoopList& loops);
+
+  void Stop(const base::ClosureCallback& callback);
+
+  // thread safe; section: "", loops, coroutines, servers, clients
+  // return empty string for unknown section
+  std::string Report(const std::string& section) const;
+
+private:
+  struct ClientsWatcher {
+    std::string name;
+    std::function<std::vector<RefClient>()> clients;
+  };
+
+  void HandleRequest(const RefHttpRequestCtx& context);
+
+  mutable std::mutex mtx_;
+
+  std::vector<std::pair<std::string, IOServicesGetter>> servers_;
+
+  std::vector<ClientsWatcher> clients_;
+
+  HttpServer http_server_;
+
+  std::unique_ptr<CodecService::Handler> handler_;
+
+  DISALLOW_COPY_AND_ASSIGN(AdminServer);
+};
+
+}  // namespace net
+}  // namespace lt
+#endif
@@ -71,6 +71,15 @@ public:
 
   const url::SchemeIpPort& ServeURI() const { return uri_; }
 
+  // connections of all io services
+  uint32_t ClientCount() const { return client_count_; }
+
+  // a copy of running io services, thread safe
+  RefIOServiceList IOServices() {
+    std::unique_lock<std::mutex> lck(mtx_);
+    return ioservices_;
+  }
+
   void ServeAddress(Handler* handler) { ServeAddress(address_, handler); }
 
   void ServeAddress(const std::string& address, Handler* handler) {
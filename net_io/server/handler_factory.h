@@ -20,7 +20,12 @@ class HandlerFactory : public CodecService::Handler {
 public:
   HandlerFactory(const Functor& handler) : handler_(handler) {}
 
+  /* handled with a co::Context when the request carry a TimeoutMs(),
+   * inherited by coroutines and client calls of the handler */
   void OnCodecMessage(const RefCodecMessage& message) override {
+    uint32_t timeout = message->TimeoutMs();
+    co::ScopedContext scope(
+        timeout > 0 ? co::Context::WithTimeout(timeout, nullptr) : nullptr);
     if (coro) {
       co_go std::bind(handler_, Context::New(message));
       return;
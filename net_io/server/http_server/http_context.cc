@@ -18,6 +18,7 @@
 #include <glog/logging.h>
 #include "base/message_loop/message_loop.h"
 #include "net_io/codec/codec_service.h"
+#include "net_io/codec/http/http_compression.h"
 
 #include "http_context.h"
 #include "net_io/codec/http/h2/h2_codec_service.h"
@@ -88,6 +89,10 @@ void HttpRequestCtx::Response(RefHttpResponse& response) {
   response->SetKeepAlive(keep_alive);
 
   if (!io_loop_->IsInLoopThread()) {
+    // compress here, keep cpu heavy work away from io loop
+    if (HttpCompression::Config().compress_in_worker) {
+      HttpCompression::CompressResponse(request, response.get());
+    }
     auto req = request_;
 
     auto functor = [=]() {
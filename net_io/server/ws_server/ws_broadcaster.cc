@@ -0,0 +1,321 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ws_broadcaster.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "base/logging.h"
+
+namespace lt {
+namespace net {
+
+/* per io loop subscriptions, touched only in its own loop except
+ * the pending queue which is the only cross thread entrance;
+ * tasks posted to the loop hold a weak ref, so a hub(or the
+ * broadcaster) gone before they run is safe*/
+class WSBroadcaster::LoopHub : public EnableShared(LoopHub) {
+public:
+  typedef std::shared_ptr<WSCodecService> RefWSCodec;
+  typedef std::unordered_map<WSCodecService*, RefWSCodec> Subscribers;
+
+  LoopHub(const Config& config, base::MessageLoop* loop)
+    : config_(config),
+      loop_(loop),
+      subscriptions_(0),
+      delivered_(0),
+      dropped_(0),
+      closed_(0) {}
+
+  base::MessageLoop* Loop() { return loop_; }
+
+  /* run in hub's loop, at once when in loop already; dropped
+   * when hub gone before the task run*/
+  void RunInLoop(std::function<void(LoopHub*)> func) {
+    if (loop_->IsInLoopThread()) {
+      return func(this);
+    }
+    std::weak_ptr<LoopHub> weak(shared_from_this());
+    loop_->PostTask(FROM_HERE, [weak, func]() {
+      if (auto hub = weak.lock()) {
+        func(hub.get());
+      }
+    });
+  }
+
+  void CollectStats(Stats* stats) const {
+    stats->delivered += delivered_;
+    stats->dropped += dropped_;
+    stats->closed += closed_;
+  }
+
+  bool HasSubscription() const { return subscriptions_ > 0; }
+
+  void Subscribe(const RefWSCodec& codec, const std::string& topic) {
+    DCHECK(loop_->IsInLoopThread());
+    if (codec->IsClosed()) {
+      return;
+    }
+    auto ret = topics_[topic].emplace(codec.get(), codec);
+    if (!ret.second) {
+      return;
+    }
+    conns_[codec.get()].push_back(topic);
+    subscriptions_++;
+  }
+
+  void Unsubscribe(WSCodecService* codec, const std::string& topic) {
+    DCHECK(loop_->IsInLoopThread());
+    auto iter = conns_.find(codec);
+    if (iter == conns_.end()) {
+      return;
+    }
+    auto& topics = iter->second;
+    auto pos = std::find(topics.begin(), topics.end(), topic);
+    if (pos == topics.end()) {
+      return;
+    }
+    topics.erase(pos);
+    if (topics.empty()) {
+      conns_.erase(iter);
+    }
+    remove_subscriber(topic, codec);
+  }
+
+  void UnsubscribeAll(WSCodecService* codec) {
+    DCHECK(loop_->IsInLoopThread());
+    auto iter = conns_.find(codec);
+    if (iter == conns_.end()) {
+      return;
+    }
+    for (const auto& topic : iter->second) {
+      remove_subscriber(topic, codec);
+    }
+    conns_.erase(iter);
+  }
+
+  // any thread, only the first message of a batch post a task
+  void Enqueue(const std::string& topic, const RefWSEncodedFrame& frame) {
+    bool schedule = false;
+    {
+      std::lock_guard<std::mutex> guard(mtx_);
+      schedule = pending_.empty();
+      pending_.emplace_back(topic, frame);
+    }
+    if (schedule) {
+      std::weak_ptr<LoopHub> weak(shared_from_this());
+      loop_->PostTask(FROM_HERE, [weak]() {
+        if (auto hub = weak.lock()) {
+          hub->Drain();
+        }
+      });
+    }
+  }
+
+  void Drain() {
+    DCHECK(loop_->IsInLoopThread());
+    batch_.clear();
+    {
+      std::lock_guard<std::mutex> guard(mtx_);
+      batch_.swap(pending_);
+    }
+    for (const auto& message : batch_) {
+      Deliver(message.first, message.second);
+    }
+    batch_.clear();
+
+    // close after iteration, closing will unsubscribe(modify topics_)
+    for (auto& codec : closing_) {
+      if (!codec->IsClosed()) {
+        codec->CloseService();
+      }
+      UnsubscribeAll(codec.get());
+    }
+    closing_.clear();
+  }
+
+private:
+  void Deliver(const std::string& topic, const RefWSEncodedFrame& frame) {
+    auto iter = topics_.find(topic);
+    if (iter == topics_.end()) {
+      return;
+    }
+    const Config& config = config_;
+
+    uint64_t delivered = 0, dropped = 0;
+    for (auto& kv : iter->second) {
+      const RefWSCodec& codec = kv.second;
+      if (codec->IsClosed()) {
+        closing_.push_back(codec);
+        continue;
+      }
+      // handshake not finished, not a subscriber yet
+      if (!codec->Handshaked()) {
+        continue;
+      }
+      size_t pending = codec->PendingBytes();
+      if (pending > 0 && pending + frame->Size() > config.max_pending_bytes) {
+        if (config.policy == kCloseConnection) {
+          VLOG(VINFO) << "close slow consumer, pending bytes:" << pending;
+          closing_.push_back(codec);
+          closed_++;
+        } else {
+          dropped++;
+        }
+        continue;
+      }
+      if (!codec->SendEncoded(frame)) {
+        closing_.push_back(codec);
+        continue;
+      }
+      delivered++;
+    }
+    delivered_ += delivered;
+    dropped_ += dropped;
+  }
+
+  void remove_subscriber(const std::string& topic, WSCodecService* codec) {
+    auto iter = topics_.find(topic);
+    if (iter == topics_.end()) {
+      return;
+    }
+    if (iter->second.erase(codec)) {
+      subscriptions_--;
+    }
+    if (iter->second.empty()) {
+      topics_.erase(iter);
+    }
+  }
+
+  const Config config_;
+
+  base::MessageLoop* loop_;
+
+  std::unordered_map<std::string, Subscribers> topics_;
+
+  // connection => topics, for unsubscribe when connection closed
+  std::unordered_map<WSCodecService*, std::vector<std::string>> conns_;
+
+  std::atomic<uint32_t> subscriptions_;
+
+  std::atomic<uint64_t> delivered_;
+  std::atomic<uint64_t> dropped_;
+  std::atomic<uint64_t> closed_;
+
+  typedef std::vector<std::pair<std::string, RefWSEncodedFrame>> MessageList;
+
+  std::mutex mtx_;
+  MessageList pending_;
+
+  // loop only, reused between batches
+  MessageList batch_;
+  std::vector<RefWSCodec> closing_;
+};
+
+WSBroadcaster::WSBroadcaster(const std::vector<base::MessageLoop*>& loops)
+  : WSBroadcaster(loops, Config()) {}
+
+WSBroadcaster::WSBroadcaster(const std::vector<base::MessageLoop*>& loops,
+                             const Config& config)
+  : config_(config),
+    published_(0) {
+  CHECK(loops.size());
+  for (base::MessageLoop* loop : loops) {
+    hubs_[loop] = std::make_shared<LoopHub>(config_, loop);
+  }
+}
+
+WSBroadcaster::~WSBroadcaster() {}
+
+WSBroadcaster::LoopHub* WSBroadcaster::HubOf(WSCodecService* codec) const {
+  auto iter = hubs_.find(codec->IOLoop());
+  if (iter == hubs_.end()) {
+    LOG(ERROR) << "websocket's io loop not managed by broadcaster";
+    return nullptr;
+  }
+  return iter->second.get();
+}
+
+bool WSBroadcaster::Subscribe(Websocket* ws, const std::string& topic) {
+  WSCodecService* codec = static_cast<WSCodecService*>(ws);
+  LoopHub* hub = HubOf(codec);
+  if (!hub) {
+    return false;
+  }
+  auto ref = std::static_pointer_cast<WSCodecService>(codec->shared_from_this());
+  hub->RunInLoop([ref, topic](LoopHub* hub) { hub->Subscribe(ref, topic); });
+  return true;
+}
+
+bool WSBroadcaster::Unsubscribe(Websocket* ws, const std::string& topic) {
+  WSCodecService* codec = static_cast<WSCodecService*>(ws);
+  LoopHub* hub = HubOf(codec);
+  if (!hub) {
+    return false;
+  }
+  // keep codec alive until the task run
+  auto ref = codec->shared_from_this();
+  hub->RunInLoop([ref, codec, topic](LoopHub* hub) {
+    hub->Unsubscribe(codec, topic);
+  });
+  return true;
+}
+
+void WSBroadcaster::UnsubscribeAll(Websocket* ws) {
+  WSCodecService* codec = static_cast<WSCodecService*>(ws);
+  LoopHub* hub = HubOf(codec);
+  if (!hub) {
+    return;
+  }
+  auto ref = codec->shared_from_this();
+  hub->RunInLoop(
+      [ref, codec](LoopHub* hub) { hub->UnsubscribeAll(codec); });
+}
+
+size_t WSBroadcaster::Publish(const std::string& topic,
+                              const std::string& payload,
+                              int opcode) {
+  return Publish(topic, WSEncodedFrame::New(payload, opcode));
+}
+
+size_t WSBroadcaster::Publish(const std::string& topic,
+                              const RefWSEncodedFrame& frame) {
+  published_++;
+  size_t count = 0;
+  for (auto& kv : hubs_) {
+    LoopHub* hub = kv.second.get();
+    if (!hub->HasSubscription()) {
+      continue;
+    }
+    hub->Enqueue(topic, frame);
+    count++;
+  }
+  return count;
+}
+
+WSBroadcaster::Stats WSBroadcaster::GetStats() const {
+  Stats stats;
+  stats.published = published_;
+  for (auto& kv : hubs_) {
+    kv.second->CollectStats(&stats);
+  }
+  return stats;
+}
+
+}  // namespace net
+}  // namespace lt
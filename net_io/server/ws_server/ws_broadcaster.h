@@ -0,0 +1,123 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LT_NET_WS_BROADCASTER_H_H
+#define _LT_NET_WS_BROADCASTER_H_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "base/message_loop/message_loop.h"
+#include "net_io/codec/websocket/ws_codec_service.h"
+
+namespace lt {
+namespace net {
+
+/*
+ * pub/sub fan-out for websocket server
+ *
+ * - subscriptions are held by the io loop owning the connection,
+ *   no lock on the delivery path
+ * - a message is encoded once into a shared frame, all receivers
+ *   write from the same buffer
+ * - a publish post at most one task to a loop, messages published
+ *   before the task run are delivered by the same task
+ * - slow consumer: a connection with too many bytes queued in its
+ *   out buffer will drop the message or be closed, see Config
+ *
+ * usage example:
+ *
+ * WSBroadcaster broadcaster(loops);
+ * server.WithBroadcaster(&broadcaster);
+ *
+ * // in WSService::OnOpen/OnMessage
+ * broadcaster.Subscribe(ws, "quote.600519");
+ *
+ * // any thread
+ * broadcaster.Publish("quote.600519", json);
+ * */
+class WSBroadcaster {
+public:
+  enum SlowConsumerPolicy {
+    kDropMessage = 0,
+    kCloseConnection = 1,
+  };
+
+  struct Config {
+    // bytes in a connection's out buffer, exceed this treat as slow
+    size_t max_pending_bytes = 4 * 1024 * 1024;
+    SlowConsumerPolicy policy = kDropMessage;
+  };
+
+  struct Stats {
+    uint64_t published = 0;
+    uint64_t delivered = 0;
+    uint64_t dropped = 0;
+    uint64_t closed = 0;
+  };
+
+  explicit WSBroadcaster(const std::vector<base::MessageLoop*>& loops);
+
+  WSBroadcaster(const std::vector<base::MessageLoop*>& loops,
+                const Config& config);
+
+  ~WSBroadcaster();
+
+  /* can be called in any thread, the subscription take effect in
+   * the connection's io loop; return false when ws's loop unknown*/
+  bool Subscribe(Websocket* ws, const std::string& topic);
+
+  bool Unsubscribe(Websocket* ws, const std::string& topic);
+
+  // should be called when connection closed, WsServer do it if bind
+  void UnsubscribeAll(Websocket* ws);
+
+  /* thread safe, return number of loops the message dispatched to,
+   * loops without any subscription are skipped*/
+  size_t Publish(const std::string& topic,
+                 const std::string& payload,
+                 int opcode = WS_OP_TEXT);
+
+  size_t Publish(const std::string& topic, const RefWSEncodedFrame& frame);
+
+  Stats GetStats() const;
+
+  const Config& GetConfig() const { return config_; }
+
+private:
+  class LoopHub;
+
+  LoopHub* HubOf(WSCodecService* codec) const;
+
+  const Config config_;
+
+  // built in constructor and never changed, lookup without lock
+  std::unordered_map<base::MessageLoop*, std::shared_ptr<LoopHub>> hubs_;
+
+  std::atomic<uint64_t> published_;
+
+  DISALLOW_COPY_AND_ASSIGN(WSBroadcaster);
+};
+
+}  // namespace net
+}  // namespace lt
+#endif
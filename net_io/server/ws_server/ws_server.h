@@ -4,6 +4,7 @@
 #include "net_io/codec/websocket/ws_codec_service.h"
 #include "net_io/io_service.h"
 #include "net_io/server/generic_server.h"
+#include "ws_broadcaster.h"
 
 namespace lt {
 namespace net {
@@ -36,6 +37,12 @@ public:
 
   void Register(const std::string& topic, WSService*);
 
+  // closed connection auto unsubscribed from the broadcaster
+  WsServer& WithBroadcaster(WSBroadcaster* broadcaster) {
+    broadcaster_ = broadcaster;
+    return *this;
+  }
+
   void Listen(const std::string& addr) {
     ServeAddress(addr);
   };
@@ -66,6 +73,9 @@ protected:
     WSCodecService* s = (WSCodecService*)codec.get();
 
     VLOG(VINFO) << __FUNCTION__ << ", enter, topic:" << s->TopicPath();
+    if (broadcaster_) {
+      broadcaster_->UnsubscribeAll(s);
+    }
     auto iter = wss_.find(s->TopicPath());
     if (iter == wss_.end()) {
       LOG(ERROR) << __FUNCTION__ << " not found service implement";
@@ -105,6 +115,8 @@ private:
   }
 
   std::unordered_map<std::string, WSService*> wss_;
+
+  WSBroadcaster* broadcaster_ = nullptr;
 };
 
 }  // namespace net
@@ -307,6 +307,22 @@ void KeepAlive(SocketFd fd, bool alive) {
                static_cast<socklen_t>(sizeof optval));
 }
 
+bool KeepAliveProbe(SocketFd fd, int idle, int interval, int count) {
+  KeepAlive(fd, true);
+  int ret = 0;
+#ifdef TCP_KEEPIDLE
+  ret |= ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+#endif
+#ifdef TCP_KEEPINTVL
+  ret |= ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+#endif
+#ifdef TCP_KEEPCNT
+  ret |= ::setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+#endif
+  LOG_IF(ERROR, ret != 0) << "set keepalive probe failed, fd:" << fd;
+  return ret == 0;
+}
+
 void TCPNoDelay(SocketFd fd) {
   int on = 1;
   ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, (void*)&on, sizeof(on));
@@ -71,6 +71,9 @@ bool ReUseSocketPort(SocketFd, bool reuse);
 bool ReUseSocketAddress(SocketFd socket_fd, bool reuse);
 
 void KeepAlive(SocketFd, bool alive);
+/* enable SO_KEEPALIVE with kernel probe timing, all in seconds;
+ * a dead peer is detected after idle + interval * count */
+bool KeepAliveProbe(SocketFd fd, int idle, int interval, int count);
 void TCPNoDelay(SocketFd fd);
 }  // namespace socketutils
 }  // namespace net
@@ -17,15 +17,26 @@
 
 #include "udp_context.h"
 
+#include "udp_service.h"
+
 namespace lt {
 namespace net {
 
-UDPIOContextPtr UDPIOContext::Create(base::MessageLoop* io) {
-  UDPIOContextPtr context(new UDPIOContext(io));
+UDPIOContextPtr UDPIOContext::Create(base::MessageLoop* io,
+                                     UDPService* service) {
+  UDPIOContextPtr context(new UDPIOContext(io, service));
   return context;
 }
 
-UDPIOContext::UDPIOContext(base::MessageLoop* io) : io_(io) {}
+UDPIOContext::UDPIOContext(base::MessageLoop* io, UDPService* service)
+  : io_(io),
+    service_(service) {}
+
+bool UDPIOContext::Reply(const UDPSegment& segment,
+                         const char* data,
+                         size_t len) {
+  return service_->SendTo(segment.sender, data, len);
+}
 
 }  // namespace net
 }  // namespace lt
@@ -19,8 +19,9 @@
 #define _LT_NET_UDP_CONTEXT_H_
 
 #include <base/lt_micro.h>
-#include <net_io/io_buffer.h>
 #include <memory>
+#include <vector>
+#include "base/string/string_view.h"
 #include "net_io/base/ip_endpoint.h"
 
 namespace base {
@@ -30,24 +31,51 @@ class MessageLoop;
 namespace lt {
 namespace net {
 
+class UDPService;
+
+/* a received datagram, data point into the poll buffer of UDPService,
+ * only valid in Reciever::OnDataRecieve, copy it if need keep longer*/
 struct UDPSegment {
-  IOBuffer buffer;
+  nonstd::string_view data;
   IPEndPoint sender;
 };
 
 class UDPIOContext;
 typedef std::unique_ptr<UDPIOContext> UDPIOContextPtr;
 
+/* a batch of datagrams received by one round of recvmmsg, created once
+ * for a service and reused between batches; with GRO, a coalesced
+ * datagram has been split back into segments*/
 class UDPIOContext {
 public:
-  static UDPIOContextPtr Create(base::MessageLoop* io);
+  static UDPIOContextPtr Create(base::MessageLoop* io, UDPService* service);
   ~UDPIOContext(){};
 
+  base::MessageLoop* IOLoop() const { return io_; }
+
+  UDPService* Service() const { return service_; }
+
+  const std::vector<UDPSegment>& Segments() const { return segments_; }
+
+  size_t Count() const { return segments_.size(); }
+
+  /* queue a reply to segment's sender, flushed by sendmmsg in batch
+   * after this round; must be called in io loop*/
+  bool Reply(const UDPSegment& segment, const char* data, size_t len);
+
+  bool Reply(const UDPSegment& segment, const std::string& data) {
+    return Reply(segment, data.data(), data.size());
+  }
+
 private:
-  UDPIOContext(base::MessageLoop* io);
+  friend class UDPService;
+  UDPIOContext(base::MessageLoop* io, UDPService* service);
+
+  void Reset() { segments_.clear(); }
 
 private:
   base::MessageLoop* io_;
+  UDPService* service_;
   std::vector<UDPSegment> segments_;
 
   DISALLOW_COPY_AND_ASSIGN(UDPIOContext);
@@ -0,0 +1,57 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "udp_server.h"
+
+#include "base/message_loop/message_loop.h"
+
+namespace lt {
+namespace net {
+
+UDPServer::~UDPServer() {
+  LOG_IF(ERROR, services_.size()) << "udp server destroyed without stop";
+}
+
+bool UDPServer::Serve(const IPEndPoint& endpoint,
+                      UDPService::Reciever* reciever) {
+  CHECK(io_loops_.size() && reciever);
+  if (services_.size()) {
+    LOG(ERROR) << "udp server already serving";
+    return false;
+  }
+
+  size_t count = options_.reuse_port ? io_loops_.size() : 1;
+  for (size_t i = 0; i < count; i++) {
+    auto service = UDPService::Create(io_loops_[i], endpoint, options_);
+    service->SetReciever(reciever);
+    service->StartService();
+    services_.push_back(std::move(service));
+  }
+  LOG(INFO) << "udp server serve:" << endpoint.ToString()
+            << " sockets:" << count;
+  return true;
+}
+
+void UDPServer::StopServer() {
+  for (auto& service : services_) {
+    service->StopService();
+  }
+  services_.clear();
+}
+
+}  // namespace net
+}  // namespace lt
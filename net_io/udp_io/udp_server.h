@@ -0,0 +1,110 @@
+/*
+ * Copyright 2021 <name of copyright holder>
+ * Author: Huan.Gong <gonghuan.dev@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _NET_IO_UDP_SERVER_H_H_
+#define _NET_IO_UDP_SERVER_H_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "udp_service.h"
+
+namespace lt {
+namespace net {
+
+/* one SO_REUSEPORT socket per loop, kernel dispatch datagrams to
+ * sockets by hash of peer address, every loop recv/send on its own
+ * socket without any lock
+ *
+ * UDPServer server;
+ * server.WithIOLoops(loops).Serve(IPEndPoint("0.0.0.0", 8125), &reciever);
+ * */
+class UDPServer {
+public:
+  UDPServer() {}
+  ~UDPServer();
+
+  UDPServer& WithIOLoops(const std::vector<base::MessageLoop*>& loops) {
+    io_loops_ = loops;
+    return *this;
+  }
+
+  UDPServer& WithOptions(const UDPService::Options& options) {
+    options_ = options;
+    return *this;
+  }
+
+  /* reciever called in every io loop at the same time, should be
+   * thread safe; without reuse_port only the first loop serve*/
+  bool Serve(const IPEndPoint& endpoint, UDPService::Reciever* reciever);
+
+  void StopServer();
+
+  const std::vector<RefUDPService>& Services() const { return services_; }
+
+private:
+  UDPService::Options options_;
+  std::vector<base::MessageLoop*> io_loops_;
+  std::vector<RefUDPService> services_;
+
+  DISALLOW_COPY_AND_ASSIGN(UDPServer);
+};
+
+/* request/response hook for udp protocols(dns/statsd like), one
+ * datagram one message; Request/Response should implement:
+ *
+ *   bool Decode(const char* data, size_t len); // false: drop datagram
+ *   bool Encode(std::string* out) const;
+ *
+ * handler return true to reply the response to peer, false for no
+ * reply(eg: statsd); called in io loop, keep it quick*/
+template <typename Request, typename Response = Request>
+class UDPCodecHandler : public UDPService::Reciever {
+public:
+  typedef std::function<
+      bool(const IPEndPoint& peer, const Request& req, Response* rsp)>
+      Handler;
+
+  explicit UDPCodecHandler(const Handler& handler) : handler_(handler) {}
+
+  void OnDataRecieve(UDPIOContext* context) override {
+    std::string out;
+    for (const UDPSegment& segment : context->Segments()) {
+      Request request;
+      if (!request.Decode(segment.data.data(), segment.data.size())) {
+        VLOG(VTRACE) << "drop bad datagram from:" << segment.sender.ToString();
+        continue;
+      }
+      Response response;
+      if (!handler_(segment.sender, request, &response)) {
+        continue;
+      }
+      out.clear();
+      if (response.Encode(&out)) {
+        context->Reply(segment, out);
+      }
+    }
+  }
+
+private:
+  Handler handler_;
+};
+
+}  // namespace net
+}  // namespace lt
+#endif
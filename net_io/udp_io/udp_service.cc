@@ -17,22 +17,118 @@
 
 #include "udp_service.h"
 
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <string.h>
+
 #include <base/message_loop/message_loop.h>
 #include <net_io/socket_utils.h>
 #include <memory>
+#include "base/utils/sys_error.h"
 #include "net_io/base/sockaddr_storage.h"
 
+// not all libc headers have those, values from linux/udp.h
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
 namespace lt {
 namespace net {
 
+namespace {
+
+// kernel limit UDP_MAX_SEGMENTS
+const size_t kMaxGSOSegments = 64;
+// total payload of a GSO send, keep headroom for ip/udp header
+const size_t kMaxGSOPayload = 65000;
+// limit recvmmsg rounds of a event, socket is level triggered,
+// left data will fire again and not starve other fds in this loop
+const int kMaxReadRounds = 8;
+
+bool same_address(const SockaddrStorage& l, const SockaddrStorage& r) {
+  return l.addr_len == r.addr_len &&
+         0 == ::memcmp(&l.addr_storage, &r.addr_storage, l.addr_len);
+}
+
+}  // namespace
+
+UDPPollBuffer::UDPPollBuffer(size_t count, size_t buffer_size)
+  : buffer_size_(buffer_size),
+    memory_(count * buffer_size),
+    iovecs_(count),
+    addrs_(count),
+    controls_(count),
+    mmsghdr_(count) {
+  for (size_t i = 0; i < count; i++) {
+    iovecs_[i].iov_base = &memory_[i * buffer_size_];
+    iovecs_[i].iov_len = buffer_size_;
+
+    struct msghdr& hdr = mmsghdr_[i].msg_hdr;
+    ::memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iovecs_[i];
+    hdr.msg_iovlen = 1;
+    hdr.msg_name = addrs_[i].AsSockAddr();
+    hdr.msg_control = controls_[i].buf;
+  }
+  Prepare();
+}
+
+struct mmsghdr* UDPPollBuffer::Prepare() {
+  for (auto& mmsg : mmsghdr_) {
+    mmsg.msg_len = 0;
+    mmsg.msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+    mmsg.msg_hdr.msg_controllen = sizeof(ControlBuffer);
+    mmsg.msg_hdr.msg_flags = 0;
+  }
+  return GetMmsghdr();
+}
+
+uint16_t UDPPollBuffer::SegmentSize(size_t index) const {
+  const struct msghdr* hdr = &mmsghdr_[index].msg_hdr;
+  if (hdr->msg_controllen == 0) {
+    return 0;
+  }
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(hdr);
+  for (; cmsg != nullptr; cmsg = CMSG_NXTHDR((struct msghdr*)hdr, cmsg)) {
+    if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+      int gso_size = 0;
+      ::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+      return gso_size;
+    }
+  }
+  return 0;
+}
+
 RefUDPService UDPService::Create(base::MessageLoop* io, const IPEndPoint& ep) {
-  return RefUDPService(new UDPService(io, ep));
+  return Create(io, ep, Options());
 }
 
-UDPService::UDPService(base::MessageLoop* io, const IPEndPoint& ep)
+RefUDPService UDPService::Create(base::MessageLoop* io,
+                                 const IPEndPoint& ep,
+                                 const Options& options) {
+  return RefUDPService(new UDPService(io, ep, options));
+}
+
+UDPService::UDPService(base::MessageLoop* io,
+                       const IPEndPoint& ep,
+                       const Options& options)
   : io_(io),
+    options_(options),
     endpoint_(ep),
-    buffers_(100) {}
+    buffers_(options.batch_count,
+             options.enable_gro ? LT_UDP_MAX_SIZE : LT_UDP_MTU_SIZE) {
+  CHECK(options_.batch_count > 0);
+}
+
+UDPService::~UDPService() {
+  LOG_IF(ERROR, socket_event_) << "udp service destroyed without stop";
+}
 
 void UDPService::StartService() {
   if (!io_->IsInLoopThread()) {
@@ -40,6 +136,9 @@ void UDPService::StartService() {
     io_->PostTask(FROM_HERE, functor);
     return;
   }
+  if (socket_event_) {
+    return;
+  }
 
   int socket = socketutils::CreateNoneBlockUDP(endpoint_.GetSockAddrFamily());
   if (socket < 0) {
@@ -47,7 +146,7 @@ void UDPService::StartService() {
     return;
   }
   // reuse socket addr and port if possible
-  socketutils::ReUseSocketPort(socket, true);
+  socketutils::ReUseSocketPort(socket, options_.reuse_port);
   socketutils::ReUseSocketAddress(socket, true);
 
   SockaddrStorage storage;
@@ -60,6 +159,23 @@ void UDPService::StartService() {
     socketutils::CloseSocket(socket);
     return;
   }
+  socketutils::GetLocalEndpoint(socket, &local_ep_);
+
+  // probe offload support, older kernel reject these options
+  if (options_.enable_gso) {
+    int segment = 0;
+    gso_enabled_ = 0 == ::setsockopt(socket, SOL_UDP, UDP_SEGMENT, &segment,
+                                     sizeof(segment));
+  }
+  if (options_.enable_gro) {
+    int on = 1;
+    gro_enabled_ =
+        0 == ::setsockopt(socket, SOL_UDP, UDP_GRO, &on, sizeof(on));
+  }
+  VLOG(VINFO) << "udp service bind:" << local_ep_.ToString()
+              << " gso:" << gso_enabled_ << " gro:" << gro_enabled_;
+
+  context_ = UDPIOContext::Create(io_, this);
   socket_event_ = base::FdEvent::Create(this, socket, base::LtEv::READ);
   io_->Pump()->InstallFdEvent(socket_event_.get());
 }
@@ -71,55 +187,263 @@ void UDPService::StopService() {
   }
   if (!socket_event_)
     return;
-  socketutils::CloseSocket(socket_event_->GetFd());
+  // fdevent own the socket, closed when it gone
+  io_->Pump()->RemoveFdEvent(socket_event_.get());
+  socket_event_.reset();
+
+  pending_.clear();
+  send_arena_.clear();
+}
+
+bool UDPService::SendTo(const IPEndPoint& to, const char* data, size_t len) {
+  if (!io_->IsInLoopThread()) {
+    auto self = shared_from_this();
+    std::string copied(data, len);
+    io_->PostTask(FROM_HERE,
+                  [self, to, copied]() { self->SendTo(to, copied); });
+    return true;
+  }
+  if (!socket_event_ || len > LT_UDP_MAX_SIZE) {
+    return false;
+  }
+  if (send_arena_.size() + len > options_.max_pending_bytes) {
+    stats_.send_dropped++;
+    return false;
+  }
+
+  PendingDatagram datagram;
+  datagram.to.addr_len = to.ToSockAddr(datagram.to.AsSockAddr(),
+                                       sizeof(datagram.to.addr_storage));
+  if (datagram.to.addr_len == 0) {
+    return false;
+  }
+  datagram.offset = send_arena_.size();
+  datagram.len = len;
+  send_arena_.append(data, len);
+  pending_.push_back(datagram);
+
+  ScheduleFlush();
+  return true;
+}
+
+void UDPService::ScheduleFlush() {
+  if (flush_scheduled_) {
+    return;
+  }
+  flush_scheduled_ = true;
+  auto self = shared_from_this();
+  io_->PostTask(FROM_HERE, [self]() {
+    self->flush_scheduled_ = false;
+    self->Flush();
+  });
+}
+
+bool UDPService::Flush() {
+  DCHECK(io_->IsInLoopThread());
+  if (!socket_event_ || pending_.empty()) {
+    return socket_event_ != nullptr;
+  }
+
+  const size_t batch = options_.batch_count;
+  send_iovecs_.resize(pending_.size());
+  send_msgs_.resize(batch);
+  send_controls_.resize(batch);
+  send_carried_.resize(batch);
+
+  auto& iovecs = send_iovecs_;
+  auto& msgs = send_msgs_;
+  auto& controls = send_controls_;
+  auto& carried = send_carried_;
+
+  for (size_t i = 0; i < pending_.size(); i++) {
+    iovecs[i].iov_base = &send_arena_[pending_[i].offset];
+    iovecs[i].iov_len = pending_[i].len;
+  }
+
+  bool success = true;
+  size_t sent = 0;
+  while (sent < pending_.size()) {
+    size_t count = 0;
+    bool with_gso = false;
+    for (size_t idx = sent; idx < pending_.size() && count < batch;) {
+      PendingDatagram& first = pending_[idx];
+      size_t segments = 1;
+      if (gso_enabled_ && first.len > 0) {
+        size_t total = first.len;
+        while (idx + segments < pending_.size() &&
+               segments < kMaxGSOSegments) {
+          const PendingDatagram& next = pending_[idx + segments];
+          if (next.len > first.len || total + next.len > kMaxGSOPayload ||
+              !same_address(first.to, next.to)) {
+            break;
+          }
+          total += next.len;
+          segments++;
+          // only the last segment can be shorter
+          if (next.len < first.len) {
+            break;
+          }
+        }
+      }
+
+      struct msghdr& hdr = msgs[count].msg_hdr;
+      ::memset(&hdr, 0, sizeof(hdr));
+      hdr.msg_name = first.to.AsSockAddr();
+      hdr.msg_namelen = first.to.addr_len;
+      hdr.msg_iov = &iovecs[idx];
+      hdr.msg_iovlen = segments;
+      if (segments > 1) {
+        with_gso = true;
+        hdr.msg_control = controls[count].buf;
+        hdr.msg_controllen = sizeof(controls[count].buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        uint16_t gso_size = first.len;
+        ::memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+      }
+      carried[count] = segments;
+      idx += segments;
+      count++;
+    }
+
+    int n = ::sendmmsg(socket_event_->GetFd(), &msgs[0], count, 0);
+    stats_.send_syscalls++;
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        socket_event_->EnableWriting();
+        break;
+      }
+      // device without checksum offload etc, fallback for ever
+      if (with_gso && (errno == EIO || errno == EINVAL)) {
+        LOG(WARNING) << "udp gso send failed, disable it, err:"
+                     << base::StrError();
+        gso_enabled_ = false;
+        continue;
+      }
+      // drop the bad one, eg: unreachable peer
+      VLOG(VINFO) << "udp send failed, err:" << base::StrError();
+      stats_.send_dropped += carried[0];
+      sent += carried[0];
+      success = false;
+      continue;
+    }
+    for (int i = 0; i < n; i++) {
+      sent += carried[i];
+      stats_.send_datagrams += carried[i];
+    }
+  }
+
+  pending_.erase(pending_.begin(), pending_.begin() + sent);
+  if (pending_.empty()) {
+    send_arena_.clear();
+    if (socket_event_->IsWriteEnable()) {
+      socket_event_->DisableWriting();
+    }
+  }
+  return success;
 }
 
 void UDPService::HandleEvent(base::FdEvent* fdev, base::LtEv::Event ev) {
+  if (base::LtEv::has_error(ev)) {
+    return HandleError(fdev);
+  }
+  if (base::LtEv::has_write(ev)) {
+    HandleWrite(fdev);
+  }
   if (base::LtEv::has_read(ev)) {
     return HandleRead(fdev);
   }
 }
 
+void UDPService::collect_segments(size_t index) {
+  struct mmsghdr* msg = buffers_.GetMmsghdr() + index;
+  if (msg->msg_hdr.msg_flags & MSG_TRUNC) {
+    VLOG(VINFO) << "drop truncated datagram, buffer size:"
+                << buffers_.BufferSize();
+    return;
+  }
+
+  UDPSegment segment;
+  if (!segment.sender.FromSockAddr(buffers_.Sender(index)->AsSockAddr(),
+                                   msg->msg_hdr.msg_namelen)) {
+    LOG(ERROR) << "send addr can't be parse, check implement, should be a bug";
+    return;
+  }
+
+  nonstd::string_view data = buffers_.Data(index);
+  size_t seg_size = buffers_.SegmentSize(index);
+  if (seg_size == 0 || seg_size >= data.size()) {
+    segment.data = data;
+    context_->segments_.push_back(segment);
+    return;
+  }
+  // GRO coalesced, split back to the origin datagrams
+  for (size_t offset = 0; offset < data.size(); offset += seg_size) {
+    segment.data = data.substr(offset, seg_size);
+    context_->segments_.push_back(segment);
+  }
+}
+
 // override from FdEvent::Handler
 void UDPService::HandleRead(base::FdEvent* fd_event) {
-  do {
-    struct mmsghdr* hdr = buffers_.GetMmsghdr();
+  for (int round = 0; round < kMaxReadRounds; round++) {
+    struct mmsghdr* hdr = buffers_.Prepare();
     int recv_cnt = recvmmsg(fd_event->GetFd(),
                             hdr,
                             buffers_.Count(),
                             MSG_WAITFORONE,
                             NULL);
-    if (recv_cnt <= 0) {
-      if (errno == EAGAIN || errno == EINTR) {
+    if (recv_cnt < 0) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
         break;
       }
-
+      if (errno == EINTR) {
+        continue;
+      }
       return HandleClose(fd_event);
     }
+    stats_.recv_syscalls++;
 
+    context_->Reset();
     for (int i = 0; i < recv_cnt; i++) {
-      UDPBufferDetail detail = buffers_.GetBufferDetail(i);
-      IPEndPoint endpoint;
-      bool ok = endpoint.FromSockAddr(detail.buffer->src_addr_.AsSockAddr(),
-                                      detail.buffer->src_addr_.Size());
-      LOG_IF(ERROR, !ok)
-          << "send addr can't be parse, check implement, should be a bug";
-      LOG(INFO) << "recv:" << detail.data()
-                << " sender:" << endpoint.ToString();
+      collect_segments(i);
     }
-  } while (true);
+    stats_.recv_datagrams += context_->Count();
+
+    if (reciever_ && context_->Count()) {
+      reciever_->OnDataRecieve(context_.get());
+    }
+    // reciever may stop service
+    if (!socket_event_) {
+      return;
+    }
+    if (size_t(recv_cnt) < buffers_.Count()) {
+      break;
+    }
+  }
+  // replies of this round leave by one sendmmsg
+  ignore_result(Flush());
 }
 
 void UDPService::HandleWrite(base::FdEvent* fd_event) {
-  LOG(INFO) << __FUNCTION__ << "fd_event:" << fd_event;
+  ignore_result(Flush());
 }
 
 void UDPService::HandleError(base::FdEvent* fd_event) {
-  LOG(INFO) << __FUNCTION__ << "fd_event:" << fd_event;
+  LOG(ERROR) << __FUNCTION__ << " fd:" << fd_event->GetFd()
+             << " err:" << base::StrError();
+  StopService();
 }
 
 void UDPService::HandleClose(base::FdEvent* fd_event) {
-  LOG(INFO) << __FUNCTION__ << "fd_event:" << fd_event;
+  LOG(ERROR) << __FUNCTION__ << " fd:" << fd_event->GetFd()
+             << " err:" << base::StrError();
+  StopService();
 }
 
 }  // namespace net
@@ -20,15 +20,18 @@
 
 #include <net_io/base/sockaddr_storage.h>
 #include <sys/socket.h>
-#include <array>
-#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include "base/message_loop/fd_event.h"
 #include "udp_context.h"
 
+namespace base {
+class MessageLoop;
+}
+
 namespace lt {
 namespace net {
 
@@ -36,99 +39,182 @@ class UDPService;
 typedef std::shared_ptr<UDPService> RefUDPService;
 
 #define LT_UDP_MTU_SIZE (2048 - 64 * 2)
+// max udp payload, also the max size of a GRO coalesced datagram
+#define LT_UDP_MAX_SIZE 65535
 
-typedef struct IOVecBuffer {
-  IOVecBuffer() {
-    LOG(INFO) << " construct buffer";
-    iovec_.iov_base = buffer_;
-    iovec_.iov_len = LT_UDP_MTU_SIZE;
-  }
-  const char* Buffer() const { return buffer_; }
-
-  struct iovec iovec_;
-  char buffer_[LT_UDP_MTU_SIZE];
-  SockaddrStorage src_addr_;
-} IOVecBuffer;
-//__attribute__ ((aligned (64)));
-
-typedef struct UDPBufferDetail {
-  UDPBufferDetail(struct mmsghdr* hdr, IOVecBuffer* buffer)
-    : mmsg_hdr(hdr),
-      buffer(buffer) {}
-  nonstd::string_view data() const {
-    if (mmsg_hdr == nullptr || buffer == nullptr) {
-      return nonstd::string_view();
-    }
-    return nonstd::string_view(buffer->Buffer(), mmsg_hdr->msg_len);
-  }
-
-  struct mmsghdr* mmsg_hdr = nullptr;
-  IOVecBuffer* buffer = nullptr;
-} UDPBufferDetail;
-
+/* buffers for recvmmsg, one contiguous block for all datagrams,
+ * with control message space for UDP_GRO segment size*/
 class UDPPollBuffer final {
 public:
-  UDPPollBuffer(size_t count) : iovec_buf_(count), mmsghdr_(count) {
-    for (int i = 0; i < mmsghdr_.size(); i++) {
-      struct mmsghdr* msg = &mmsghdr_[i];
-      IOVecBuffer& buffer = iovec_buf_[i];
-
-      msg->msg_hdr.msg_control = 0;
-      msg->msg_hdr.msg_controllen = 0;
-      msg->msg_hdr.msg_iovlen = 1;
-      msg->msg_hdr.msg_iov = &buffer.iovec_;
-      msg->msg_hdr.msg_name = buffer.src_addr_.AsSockAddr();
-      msg->msg_hdr.msg_namelen = buffer.src_addr_.Size();
-    }
-  }
+  UDPPollBuffer(size_t count, size_t buffer_size = LT_UDP_MTU_SIZE);
 
   std::size_t Count() const { return mmsghdr_.size(); };
-  std::size_t BufferSize() const { return LT_UDP_MTU_SIZE; };
+  std::size_t BufferSize() const { return buffer_size_; };
 
-  UDPBufferDetail GetBufferDetail(size_t index) {
-    return {&(mmsghdr_[index]), &iovec_buf_[index]};
-  }
+  // reset name/control length changed by kernel, call before recvmmsg
+  struct mmsghdr* Prepare();
+
+  struct mmsghdr* GetMmsghdr() { return &mmsghdr_[0]; }
 
-  struct mmsghdr* GetMmsghdr() {
-    return &mmsghdr_[0];
+  nonstd::string_view Data(size_t index) const {
+    return nonstd::string_view((const char*)iovecs_[index].iov_base,
+                               mmsghdr_[index].msg_len);
   }
 
+  SockaddrStorage* Sender(size_t index) { return &addrs_[index]; }
+
+  // GRO segment size of a coalesced datagram, 0 for a normal one
+  uint16_t SegmentSize(size_t index) const;
+
 private:
+  typedef union {
+    char buf[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align;
+  } ControlBuffer;
+
+  size_t buffer_size_;
+  std::vector<char> memory_;
+  std::vector<struct iovec> iovecs_;
+  std::vector<SockaddrStorage> addrs_;
+  std::vector<ControlBuffer> controls_;
   std::vector<struct mmsghdr> mmsghdr_;
-  std::vector<IOVecBuffer> iovec_buf_;
 };
 
+/*
+ * udp socket bind to a loop, datagrams received in batch by recvmmsg
+ * and delivered to Reciever without copy; datagrams send in batch by
+ * sendmmsg, same size datagrams to a same peer merged into one GSO
+ * send(UDP_SEGMENT) when kernel support it
+ *
+ * server: UDPServer create a SO_REUSEPORT socket for each loop
+ * client: bind to port 0 and SendTo the server
+ * */
 class UDPService : public EnableShared(UDPService),
                    public base::FdEvent::Handler {
 public:
   class Reciever {
   public:
-    virtual void OnDataRecieve(UDPIOContextPtr context) = 0;
+    virtual ~Reciever() {}
+    // called in io loop of the service, see UDPIOContext
+    virtual void OnDataRecieve(UDPIOContext* context) = 0;
+  };
+
+  struct Options {
+    // datagrams per recvmmsg/sendmmsg
+    size_t batch_count = 64;
+    // SO_REUSEPORT, multi sockets for a endpoint, one per loop
+    bool reuse_port = true;
+    // receive coalesced datagrams, each buffer grow to 64k
+    bool enable_gro = false;
+    // merge same size datagrams to a peer into one send
+    bool enable_gso = true;
+    // datagrams wait in send queue, exceed will be dropped
+    size_t max_pending_bytes = 4 * 1024 * 1024;
+  };
+
+  struct Stats {
+    uint64_t recv_datagrams = 0;
+    uint64_t recv_syscalls = 0;
+    uint64_t send_datagrams = 0;
+    uint64_t send_syscalls = 0;
+    uint64_t send_dropped = 0;
   };
 
 public:
-  ~UDPService(){};
+  ~UDPService();
+
   static RefUDPService Create(base::MessageLoop* io, const IPEndPoint& ep);
 
+  static RefUDPService Create(base::MessageLoop* io,
+                              const IPEndPoint& ep,
+                              const Options& options);
+
+  // should be set before start, not owned
+  void SetReciever(Reciever* reciever) { reciever_ = reciever; }
+
   void StartService();
+
   void StopService();
 
+  bool IsRunning() const { return socket_event_ != nullptr; }
+
+  /* queue datagram and flush in batch later in this loop round;
+   * call from other thread the data will be copied and post to io
+   * loop, return false when queue full or service not running*/
+  bool SendTo(const IPEndPoint& to, const char* data, size_t len);
+
+  bool SendTo(const IPEndPoint& to, const std::string& data) {
+    return SendTo(to, data.data(), data.size());
+  }
+
+  // io loop only, write out queued datagrams now
+  bool Flush();
+
+  base::MessageLoop* IOLoop() const { return io_; }
+
+  // the real bound address, useful when bind to port 0
+  const IPEndPoint& LocalEndpoint() const { return local_ep_; }
+
+  bool GSOEnabled() const { return gso_enabled_; }
+
+  bool GROEnabled() const { return gro_enabled_; }
+
+  const Stats& GetStats() const { return stats_; }
+
 private:
-  UDPService(base::MessageLoop* io, const IPEndPoint& ep);
+  UDPService(base::MessageLoop* io, const IPEndPoint& ep, const Options& opt);
 
   // override from FdEvent::Handler
-  void HandleEvent(base::FdEvent* fdev, base::LtEv::Event ev);
+  void HandleEvent(base::FdEvent* fdev, base::LtEv::Event ev) override;
 
   void HandleRead(base::FdEvent* fd_event);
   void HandleWrite(base::FdEvent* fd_event);
   void HandleError(base::FdEvent* fd_event);
   void HandleClose(base::FdEvent* fd_event);
 
+  void ScheduleFlush();
+
+  // split a received datagram(may GRO coalesced) into segments
+  void collect_segments(size_t index);
+
 private:
+  // a queued datagram, data in send_arena_[offset, offset+len)
+  struct PendingDatagram {
+    SockaddrStorage to;
+    size_t offset;
+    size_t len;
+  };
+
   base::MessageLoop* io_;
+  const Options options_;
   IPEndPoint endpoint_;
+  IPEndPoint local_ep_;
   base::RefFdEvent socket_event_;
+  Reciever* reciever_ = nullptr;
+
   UDPPollBuffer buffers_;
+  UDPIOContextPtr context_;
+
+  bool gso_enabled_ = false;
+  bool gro_enabled_ = false;
+
+  typedef union {
+    char buf[CMSG_SPACE(sizeof(uint16_t))];
+    struct cmsghdr align;
+  } SegmentControl;
+
+  bool flush_scheduled_ = false;
+  std::string send_arena_;
+  std::vector<PendingDatagram> pending_;
+
+  // sendmmsg arguments, reused between flushes
+  std::vector<struct iovec> send_iovecs_;
+  std::vector<struct mmsghdr> send_msgs_;
+  std::vector<SegmentControl> send_controls_;
+  // how many datagrams carried by each msg
+  std::vector<size_t> send_carried_;
+
+  Stats stats_;
 
   DISALLOW_COPY_AND_ASSIGN(UDPService);
 };
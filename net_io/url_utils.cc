@@ -57,7 +57,7 @@ bool ParseURI(const std::string uri, SchemeIpPort& out) {
   std::string::size_type find_start = 0;
   std::string::size_type pos = in.find("://", find_start);
   if (pos != std::string::npos) {
-    out.protocol = in.substr(find_start, pos).to_string();
+    out.protocol = std::string(in.substr(find_start, pos));
     find_start = pos + sizeof("://") - 1;
   }
 
@@ -65,11 +65,11 @@ bool ParseURI(const std::string uri, SchemeIpPort& out) {
   if (pos != std::string::npos) {
     uint32_t len = pos - find_start;
 
-    base::StrUtil::ParseTo(in.substr(pos + 1).to_string(), out.port);
-    out.host = in.substr(find_start, len).to_string();
+    base::StrUtil::ParseTo(std::string(in.substr(pos + 1)), out.port);
+    out.host = std::string(in.substr(find_start, len));
     find_start = pos + sizeof(":") - 1;
   } else {
-    out.host = in.substr(find_start).to_string();
+    out.host = std::string(in.substr(find_start));
   }
 
   if (!out.host.empty()) {
@@ -130,15 +130,15 @@ bool ParseRemote(const std::string& str, RemoteInfo& out, bool resolve) {
   std::string::size_type find_start = 0;
   std::string::size_type pos = in.find("://", find_start);
   if (pos != std::string::npos) {
-    out.scheme = in.substr(find_start, pos).to_string();
+    out.scheme = std::string(in.substr(find_start, pos));
     find_start = pos + sizeof("://") - 1;
   }
 
   pos = in.find("@", find_start);
   if (pos != std::string::npos) {  // got user:psd
     uint32_t len = pos - find_start;
-    auto user_psd = base::StrUtil::Split(in.substr(find_start, len).to_string(),
-                                         ":", false);
+    auto user_psd =
+        base::StrUtil::Split(std::string(in.substr(find_start, len)), ":", false);
     out.user = user_psd[0];
     if (user_psd.size() > 1) {
       out.passwd = user_psd[1];
@@ -150,7 +150,7 @@ bool ParseRemote(const std::string& str, RemoteInfo& out, bool resolve) {
   {
     uint32_t len = pos - find_start;
     auto host_port = base::StrUtil::Split(
-        in.substr(find_start, len).to_string(), ":", false);
+        std::string(in.substr(find_start, len)), ":", false);
     out.host = host_port.front();
     if (host_port.size() > 1) {
       out.port = base::StrUtil::Parse<uint16_t>(host_port[1]);
@@ -165,7 +165,7 @@ bool ParseRemote(const std::string& str, RemoteInfo& out, bool resolve) {
     find_start = pos + sizeof("?") - 1;
   }
 
-  auto querys = base::StrUtil::Split(in.substr(find_start).to_string(), '&');
+  auto querys = base::StrUtil::Split(std::string(in.substr(find_start)), '&');
   for (auto& query : querys) {
     auto kv = base::StrUtil::Split(query, "=", false);
     if (kv.size() != 2) {
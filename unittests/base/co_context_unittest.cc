@@ -0,0 +1,102 @@
+#include <unistd.h>
+#include <atomic>
+
+#include <base/coroutine/co_context.h>
+#include <base/coroutine/co_runner.h>
+#include <base/coroutine/wait_group.h>
+#include <base/message_loop/message_loop.h>
+#include <base/time/time_utils.h>
+#include "glog/logging.h"
+
+#include <catch/catch.hpp>
+
+TEST_CASE("co_context.propagate", "[context inherited and cancelled]") {
+  auto root = co::Context::WithTimeout(1000, nullptr);
+  auto child = co::Context::New(root);
+  auto short_child = co::Context::WithTimeout(10, root);
+
+  REQUIRE(child->Deadline() == root->Deadline());
+  REQUIRE(short_child->Deadline() < root->Deadline());
+  REQUIRE(child->LimitTimeout(-1) <= 1000);
+  REQUIRE(child->LimitTimeout(5) <= 5);
+
+  int hooked = 0;
+  uint64_t removed = child->AddCancelHook([&]() { hooked += 10; });
+  child->AddCancelHook([&]() { hooked++; });
+  child->RemoveCancelHook(removed);
+
+  REQUIRE_FALSE(child->Done());
+  root->Cancel();
+  REQUIRE(child->Done());
+  REQUIRE(child->IsCancelled());
+  REQUIRE(hooked == 1);
+
+  // called at once when cancelled already
+  REQUIRE(child->AddCancelHook([&]() { hooked++; }) == 0);
+  REQUIRE(hooked == 2);
+}
+
+TEST_CASE("co_context.co_sleep", "[context deadline wakeup co_sleep]") {
+  base::MessageLoop loop;
+  loop.Start();
+
+  std::atomic<int64_t> child_cost = {0};
+  std::atomic<bool> child_inherited = {false};
+  co_go &loop << [&]() {
+    auto ctx = co::Context::WithTimeout(50);
+    auto wg = co::WaitGroup::New();
+    wg->Add(1);
+    {
+      co::ScopedContext scope(ctx);
+      co_go [&, ctx, wg]() {
+        child_inherited = co::Context::Current() == ctx;
+        int64_t start = base::time_ms();
+        co_sleep(5000);
+        child_cost = base::time_ms() - start;
+        wg->Done();
+      };
+    }
+    REQUIRE(co::Context::Current() == nullptr);
+    REQUIRE(wg->Wait(5000) == co::WaitGroup::kSuccess);
+
+    // done, return at once
+    co::ScopedContext scope(ctx);
+    int64_t start = base::time_ms();
+    co_sleep(1000);
+    REQUIRE(base::time_ms() - start < 100);
+    loop.QuitLoop();
+  };
+  loop.WaitLoopEnd();
+  REQUIRE(child_inherited);
+  REQUIRE(child_cost < 1000);
+}
+
+TEST_CASE("co_context.cancel_wait", "[cancel a waitgroup waiting]") {
+  base::MessageLoop loop;
+  loop.Start();
+
+  auto ctx = co::Context::New(nullptr);
+  std::atomic<bool> waiting = {false};
+  std::atomic<int64_t> cost = {0};
+  co_go &loop << [&]() {
+    co::ScopedContext scope(ctx);
+
+    // never done
+    auto wg = co::WaitGroup::New();
+    wg->Add(1);
+    waiting = true;
+    int64_t start = base::time_ms();
+    REQUIRE(wg->Wait(5000) == co::WaitGroup::kTimeout);
+    cost = base::time_ms() - start;
+    loop.QuitLoop();
+  };
+
+  while (!waiting) {
+    usleep(1000);
+  }
+  usleep(20000);
+  // from other thread
+  ctx->Cancel();
+  loop.WaitLoopEnd();
+  REQUIRE(cost < 1000);
+}
@@ -0,0 +1,171 @@
+#include <base/ltio_config.h>
+
+#ifdef LTIO_WITH_CXX20_COROUTINE
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <iostream>
+
+#include <base/coroutine/co_task.h>
+#include <base/message_loop/message_loop.h>
+#include <base/time/time_utils.h>
+#include "glog/logging.h"
+
+#include <catch/catch.hpp>
+
+namespace {
+
+co::Task<int> add_later(int a, int b) {
+  co_await co::SleepFor(5);
+  co_return a + b;
+}
+
+co::Task<int> sum(int n) {
+  int total = 0;
+  for (int i = 0; i < n; i++) {
+    total += co_await add_later(i, 1);
+  }
+  co_return total;
+}
+
+}  // namespace
+
+// a coroutine lambda must not capture, the closure gone before it run
+TEST_CASE("co_task.await", "[stackless task await task]") {
+  base::MessageLoop loop("co_task");
+  loop.Start();
+
+  int result = 0;
+  co::Spawn(&loop, [](base::MessageLoop* loop, int* result) -> co::Task<> {
+    *result = co_await sum(10);
+    loop->QuitLoop();
+  }(&loop, &result));
+  loop.WaitLoopEnd();
+  REQUIRE(result == 55);
+}
+
+TEST_CASE("co_task.wait_io", "[stackless task wait fd ready]") {
+  base::MessageLoop loop("co_task");
+  loop.Start();
+
+  int fd = eventfd(0, EFD_NONBLOCK);
+  REQUIRE(fd > 0);
+
+  int ok_count = 0, timeout_count = 0;
+  co::Spawn(&loop, [](base::MessageLoop* loop, int fd, int* ok_count,
+                      int* timeout_count) -> co::Task<> {
+    base::FdEvent fdev(fd, base::LtEv::READ);
+    fdev.ReleaseOwnership();
+    do {
+      auto res = co_await co::WaitIO(&fdev, 50);
+      if (res == co::IOEvent::Timeout) {
+        (*timeout_count)++;
+        break;
+      }
+      uint64_t val = 0;
+      if (eventfd_read(fd, &val) == 0) {
+        (*ok_count)++;
+      }
+    } while (true);
+    loop->QuitLoop();
+  }(&loop, fd, &ok_count, &timeout_count));
+
+  for (int i = 0; i < 3; i++) {
+    usleep(10000);
+    ignore_result(eventfd_write(fd, 1));
+  }
+  loop.WaitLoopEnd();
+  close(fd);
+  REQUIRE(ok_count > 0);
+  REQUIRE(timeout_count == 1);
+}
+
+namespace {
+
+co::Task<> sleep_done(co::RefWaitGroup wg, int ms, int* done_count) {
+  co_await co::SleepFor(ms);
+  (*done_count)++;
+  wg->Done();
+}
+
+}  // namespace
+
+TEST_CASE("co_task.wait_group", "[stackless task wait group]") {
+  base::MessageLoop loop("co_task");
+  loop.Start();
+
+  bool timeout_ok = false;
+  int done_count = 0;
+  co::Spawn(&loop, [](base::MessageLoop* loop, int* done_count,
+                      bool* timeout_ok) -> co::Task<> {
+    auto wg = co::WaitGroup::New();
+    for (int i = 0; i < 10; i++) {
+      wg->Add(1);
+      co::Spawn(loop, sleep_done(wg, 5, done_count));
+    }
+    auto res = co_await co::WaitAll(wg, 1000);
+    REQUIRE(res == co::WaitGroup::kSuccess);
+
+    auto slow_wg = co::WaitGroup::New();
+    slow_wg->Add(1);
+    loop->PostDelayTask(NewClosure([slow_wg]() { slow_wg->Done(); }), 100);
+    res = co_await co::WaitAll(slow_wg, 10);
+    *timeout_ok = res == co::WaitGroup::kTimeout;
+    loop->QuitLoop();
+  }(&loop, &done_count, &timeout_ok));
+  loop.WaitLoopEnd();
+  REQUIRE(done_count == 10);
+  REQUIRE(timeout_ok);
+}
+
+TEST_CASE("co_task.callback", "[stackless task await a callback]") {
+  base::MessageLoop loop("co_task"), worker("worker");
+  loop.Start();
+  worker.Start();
+
+  int result = 0, not_started = -1;
+  co::Spawn(&loop, [](base::MessageLoop* loop, base::MessageLoop* worker,
+                      int* result, int* not_started) -> co::Task<> {
+    // callback from other loop, resumed in own loop
+    *result = co_await co::CallbackAwaiter<int>(
+        [worker](std::function<void(int)> cb) {
+          return worker->PostTask(FROM_HERE, [cb]() { cb(42); });
+        });
+    REQUIRE(loop->IsInLoopThread());
+
+    *not_started = co_await co::CallbackAwaiter<int>(
+        [](std::function<void(int)>) { return false; });
+    loop->QuitLoop();
+  }(&loop, &worker, &result, &not_started));
+  loop.WaitLoopEnd();
+  REQUIRE(result == 42);
+  REQUIRE(not_started == 0);
+}
+
+TEST_CASE("co_task.fanout", "[stackless task huge concurrent waits]") {
+  base::MessageLoop loop("co_task");
+  loop.Start();
+
+  const int count = 100000;
+  int done_count = 0;
+  int64_t start = base::time_ms();
+  co::Spawn(&loop, [](base::MessageLoop* loop, int count,
+                      int* done_count) -> co::Task<> {
+    auto wg = co::WaitGroup::New();
+    wg->Add(count);
+    for (int i = 0; i < count; i++) {
+      co::Spawn(loop, sleep_done(wg, 100, done_count));
+    }
+    auto res = co_await co::WaitAll(wg, 10000);
+    REQUIRE(res == co::WaitGroup::kSuccess);
+    // frames of finished tasks kept for reuse
+    REQUIRE(co::FramePool::CachedCount() > 0);
+    loop->QuitLoop();
+  }(&loop, count, &done_count));
+  loop.WaitLoopEnd();
+  REQUIRE(done_count == count);
+  LOG(INFO) << count << " concurrent tasks done in "
+            << base::time_ms() - start << "ms";
+}
+
+#endif
@@ -384,3 +384,55 @@ TEST_CASE("coro.ioevent2", "[ioevent for coro]") {
   loop.WaitLoopEnd();
   close(fd);
 }
+
+TEST_CASE("coro.stats", "[coroutine runner stats]") {
+  base::MessageLoop loop;
+  loop.Start();
+  const uint64_t loop_id = loop.Pump()->LoopID();
+
+  auto runner_stats = [&]() {
+    for (auto& stats : co::CoroRunner::AllStats()) {
+      if (stats.loop_id == loop_id) {
+        return stats;
+      }
+    }
+    return co::CoroRunnerStats();
+  };
+
+  std::atomic<int> parked(0);
+  std::vector<base::LtClosure> resumers;
+  for (int i = 0; i < 10; i++) {
+    CO_GO &loop << [&]() {
+      resumers.push_back(CO_RESUMER);
+      parked++;
+      CO_YIELD;
+      parked--;
+    };
+  }
+  while (parked < 10) {
+    usleep(1000);
+  }
+  usleep(10000);
+
+  co::CoroRunnerStats stats = runner_stats();
+  REQUIRE(stats.loop_name == loop.LoopName());
+  REQUIRE(stats.parked == 10);
+  REQUIRE(stats.coroutines >= 10);
+
+  loop.PostTask(FROM_HERE, [&]() {
+    for (auto& resumer : resumers) {
+      resumer();
+    }
+  });
+  while (parked > 0) {
+    usleep(1000);
+  }
+  usleep(10000);
+
+  stats = runner_stats();
+  REQUIRE(stats.parked == 0);
+  REQUIRE(stats.tasks_run >= 10);
+
+  loop.PostTask(FROM_HERE, [&]() { loop.QuitLoop(); });
+  loop.WaitLoopEnd();
+}
@@ -121,6 +121,111 @@ TEST_CASE("messageloop.delaytask", "[run delay task]") {
   loop.WaitLoopEnd();
 }
 
+TEST_CASE("messageloop.stats", "[loop runtime stats]") {
+  base::MessageLoop loop("StatsTestLoop");
+  loop.Start();
+
+  std::atomic<int> count(0);
+  for (int i = 0; i < 100; i++) {
+    loop.PostTask(FROM_HERE, [&]() { count++; });
+  }
+  loop.PostDelayTask(NewClosure([]() {}), 60000);
+
+  std::atomic<bool> blocked(false), release(false);
+  loop.PostTask(FROM_HERE, [&]() {
+    blocked = true;
+    while (!release) {
+      usleep(1000);
+    }
+  });
+  while (!blocked) {
+    usleep(1000);
+  }
+  usleep(20000);
+
+  // inspect a blocked loop from other thread
+  base::LoopStats stats = loop.Stats();
+  REQUIRE(stats.name == "StatsTestLoop");
+  REQUIRE(stats.running_us >= 20000);
+  REQUIRE(stats.timers == 1);
+  release = true;
+
+  bool found = false;
+  for (auto& s : base::MessageLoop::AllLoopStats()) {
+    found |= s.loop_id == stats.loop_id;
+  }
+  REQUIRE(found);
+
+  loop.PostDelayTask(NewClosure([&]() { loop.QuitLoop(); }), 100);
+  loop.WaitLoopEnd();
+  REQUIRE(count == 100);
+
+  stats = loop.Stats();
+  REQUIRE(stats.tasks_run >= 102);
+  REQUIRE(stats.iterations > 0);
+  REQUIRE(stats.queue_depth == 0);
+}
+
+#ifdef LTIO_WITH_LOOP_TRACE
+class CountingTracer : public base::LoopTracer {
+public:
+  CountingTracer(const Options& options) : base::LoopTracer(options) {}
+
+  void OnTaskRun(const base::MessageLoop* loop,
+                 const base::Location& location,
+                 int64_t queue_us,
+                 int64_t run_us) override {
+    tasks++;
+    queued += queue_us >= 0 ? 1 : 0;
+  }
+  void OnSlowTask(const base::MessageLoop* loop,
+                  const base::Location& location,
+                  int64_t run_us) override {
+    slow_line = location.line_number();
+  }
+  void OnLoopLag(const base::MessageLoop* loop, int64_t lag_us) override {
+    lags++;
+    max_lag = std::max<int64_t>(max_lag, lag_us);
+  }
+
+  std::atomic<int> tasks = {0};
+  std::atomic<int> queued = {0};
+  std::atomic<int> slow_line = {0};
+  std::atomic<int> lags = {0};
+  std::atomic<int64_t> max_lag = {0};
+};
+
+TEST_CASE("messageloop.tracer", "[task timing and loop lag]") {
+  base::LoopTracer::Options options;
+  options.slow_task_us = 20000;
+  options.lag_probe_ms = 10;
+  CountingTracer tracer(options);
+  base::SetLoopTracer(&tracer);
+
+  base::MessageLoop loop("TracerTestLoop");
+  loop.Start();
+
+  for (int i = 0; i < 10; i++) {
+    loop.PostTask(FROM_HERE, []() {});
+  }
+  // wait lag probe installed(after first stats window)
+  usleep(1200 * 1000);
+  int slow_line = __LINE__ + 1;
+  loop.PostTask(FROM_HERE, []() { usleep(50000); });
+  usleep(200 * 1000);
+
+  loop.PostTask(FROM_HERE, [&]() { loop.QuitLoop(); });
+  loop.WaitLoopEnd();
+  base::SetLoopTracer(nullptr);
+
+  REQUIRE(tracer.tasks >= 11);
+  REQUIRE(tracer.queued >= 11);
+  REQUIRE(tracer.slow_line == slow_line);
+  REQUIRE(tracer.lags > 5);
+  REQUIRE(tracer.max_lag >= 30000);
+}
+#endif
+
 TEST_CASE("messageloop.replytask", "[task with reply function]") {
   base::MessageLoop loop;
   loop.Start();
@@ -59,3 +59,42 @@ TEST_CASE("defer", "[task run]") {
   } while(0);
   REQUIRE(cnt == 0);
 }
+
+#include "base/utils/compression/compressor.h"
+TEST_CASE("compression.roundtrip", "[compressor]") {
+  std::string origin;
+  for (int i = 0; i < 2000; i++) {
+    origin.append("{\"id\": ").append(std::to_string(i)).append(", \"v\": \"ltio\"},");
+  }
+
+  auto names = base::Compressor::Supported();
+  REQUIRE(names.size() >= 2);
+  for (const auto& name : names) {
+    const base::Compressor* c = base::Compressor::Get(name);
+    REQUIRE(c);
+    REQUIRE(base::Compressor::Get(c->Id()) == c);
+
+    // run twice, second time reuse the thread cached context
+    for (int level : {-1, c->DefaultLevel() + 1}) {
+      std::string compressed("prefix");
+      REQUIRE(c->Compress(origin, &compressed, level));
+      CHECK(compressed.size() < origin.size());
+      CHECK(compressed.compare(0, 6, "prefix") == 0);
+
+      std::string out;
+      REQUIRE(c->Decompress(compressed.data() + 6, compressed.size() - 6, &out));
+      CHECK(out == origin);
+
+      // output over max_size fail and keep out untouched
+      std::string limited("x");
+      CHECK_FALSE(c->Decompress(compressed.substr(6), &limited, origin.size() / 2));
+      CHECK(limited == "x");
+    }
+
+    std::string broken("not a compressed data"), out;
+    CHECK_FALSE(c->Decompress(broken, &out));
+    CHECK(out.empty());
+  }
+  CHECK(base::Compressor::Get("x-gzip") == base::Compressor::Get(base::Compressor::kGzip));
+  CHECK(base::Compressor::Get("unknown") == nullptr);
+}
@@ -1,7 +1,9 @@
+#include "components/bloomfilter/blocked_bloom_filter.h"
 #include "components/bloomfilter/bloom_filter.h"
 #include <stdlib.h>
 #include <unistd.h>
 #include <iostream>
+#include <vector>
 
 #include <catch/catch.hpp>
 
@@ -30,3 +32,50 @@ TEST_CASE("bloom_filter.falserate", "[false case]") {
 
   REQUIRE(false_count < 50);
 }
+
+TEST_CASE("blocked_bloom_filter.falserate", "[blocked bloom filter]") {
+  component::BlockedBloomFilter filter(1000000, 0.00001);
+
+  std::vector<uint64_t> hashes;
+  for (uint64_t i = 0; i < 1000000; i++) {
+    hashes.push_back(component::BlockedBloomFilter::Hash(&i, sizeof(i)));
+  }
+  filter.SetMany(hashes.data(), hashes.size());
+
+  for (uint64_t i = 0; i < 1000000; i++) {
+    REQUIRE(filter.IsSet(&i, sizeof(uint64_t)));
+  }
+
+  hashes.clear();
+  for (uint64_t i = 5000000; i < 10000000; i++) {
+    hashes.push_back(component::BlockedBloomFilter::Hash(&i, sizeof(i)));
+  }
+  std::vector<uint8_t> results(hashes.size());
+  size_t false_count =
+      filter.ContainsMany(hashes.data(), hashes.size(), results.data());
+  REQUIRE(false_count < 100);
+}
+
+TEST_CASE("blocked_bloom_filter.save_open", "[blocked bloom filter]") {
+  component::BlockedBloomFilter filter(10000, 0.001, true);
+  uint64_t false_count = 0;
+  for (uint64_t i = 0; i < 10000; i++) {
+    false_count += filter.TestAndSet(&i, sizeof(uint64_t));
+    REQUIRE(filter.TestAndSet(&i, sizeof(uint64_t)));
+  }
+  REQUIRE(false_count < 50);
+
+  const std::string path = "blocked_bloom_filter_test.bbf";
+  REQUIRE(filter.Save(path));
+
+  auto loaded = component::BlockedBloomFilter::Open(path);
+  REQUIRE(loaded);
+  REQUIRE(loaded->HashCount() == filter.HashCount());
+  REQUIRE(loaded->BlockCount() == filter.BlockCount());
+  for (uint64_t i = 0; i < 10000; i++) {
+    REQUIRE(loaded->IsSet(&i, sizeof(uint64_t)));
+  }
+  unlink(path.c_str());
+
+  REQUIRE_FALSE(component::BlockedBloomFilter::Open(path));
+}
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <atomic>
 #include <fstream>
@@ -8,11 +9,20 @@
 
 #include "base/time//time_utils.h"
 #include "base/utils//rand_util.h"
+#include "fmt/format.h"
 #include "components//boolean_indexer/mock//mock_target.h"
 #include "components/boolean_indexer/builder/be_indexer_builder.h"
+#include "components/boolean_indexer/builder/parallel_builder.h"
+#include "components/boolean_indexer/compressed_entries.h"
 #include "components/boolean_indexer/document.h"
+#include "components/boolean_indexer/flat_hash_map.h"
 #include "components/boolean_indexer/id_generator.h"
 #include "components/boolean_indexer/index_scanner.h"
+#include "components/boolean_indexer/incremental_indexer.h"
+#include "components/boolean_indexer/index_segment.h"
+#include "components/boolean_indexer/parser/geo_parser.h"
+#include "components/boolean_indexer/range_container.h"
+#include "components/geo_utils/geohash.h"
 
 #include <thirdparty/catch/catch.hpp>
 #include "gperftools/profiler.h"
@@ -106,7 +116,8 @@ TEST_CASE("be_posting_list", "[be posting list sort id]") {
   Entries entrylist = {0, 1, 1, 4, 8, 20};
 
   Attr attr("age", 0);
-  EntriesCursor cursor(attr, entrylist);
+  CompressedEntries entries(entrylist);
+  EntriesCursor cursor(attr, &entries);
 
   REQUIRE(cursor.ReachEnd() == false);
   REQUIRE(cursor.GetCurEntryID() == 0);
@@ -125,7 +136,8 @@ TEST_CASE("entries_cursor", "[skip posting list sort id]") {
   Entries ids = {1, 18, 24, 57, 70};
   Attr attr("test", 0);
 
-  EntriesCursor curosr(attr, ids);
+  CompressedEntries entries(ids);
+  EntriesCursor curosr(attr, &entries);
 
   EntriesCursor c2 = curosr;
 }
@@ -134,12 +146,68 @@ TEST_CASE("skipto_test", "[skip posting list sort id]") {
   //[<1,1>,<18,1>,<24,1>,<57,1>,<70,1>,]
   Entries ids = {1, 18, 24, 57, 70};
   Attr attr("test", 0);
-  EntriesCursor iter(attr, ids);
+  CompressedEntries entries(ids);
+  EntriesCursor iter(attr, &entries);
 
   int res = iter.SkipTo(2);
   REQUIRE(res == 18);
 }
 
+TEST_CASE("compressed_entries", "[block packed entries skip]") {
+  Entries ids;
+  EntryId id = 0;
+  for (int i = 0; i < 10000; i++) {
+    int r = base::RandInt(0, 100);
+    // duplicated, small gap, big gap(conjunction size bits)
+    id += r < 10 ? 0 : (r < 95 ? base::RandInt(1, 1000) : (1ULL << 52));
+    ids.push_back(id);
+  }
+  CompressedEntries entries(ids);
+  REQUIRE(entries.Size() == ids.size());
+  REQUIRE(entries.Decode() == ids);
+  REQUIRE(entries.MemoryUsage() < ids.size() * sizeof(EntryId));
+  REQUIRE(CompressedEntries(Entries()).Empty());
+  Entries wide = {1, 2, NULLENTRY - 1};
+  REQUIRE(CompressedEntries(wide).Decode() == wide);
+
+  Attr attr("test", 0);
+  for (int round = 0; round < 100; round++) {
+    EntriesCursor cursor(attr, &entries);
+    EntryId target = 0;
+    while (!cursor.ReachEnd()) {
+      target += base::RandInt(0, 100) < 50 ? base::RandInt(0, 2000)
+                                           : base::RandInt(0, 1 << 20);
+      bool skip = base::RandInt(0, 1);
+      EntryId expect = NULLENTRY;
+      auto iter = skip ? std::upper_bound(ids.begin(), ids.end(), target)
+                       : std::lower_bound(ids.begin(), ids.end(), target);
+      if (iter != ids.end()) {
+        expect = *iter;
+      }
+      EntryId got = skip ? cursor.Skip(target) : cursor.SkipTo(target);
+      REQUIRE(got == expect);
+      REQUIRE(cursor.GetCurEntryID() == expect);
+      target = std::max(target, got == NULLENTRY ? target : got);
+    }
+  }
+}
+
+TEST_CASE("flat_hash_map", "[open addressing attr map]") {
+  FlatHashMap<Attr, int, pair_hash> map;
+  for (int i = 0; i < 1000; i++) {
+    REQUIRE(map.Insert(Attr("a", i), i));
+    REQUIRE(map.Insert(Attr("b", i), -i));
+  }
+  REQUIRE_FALSE(map.Insert(Attr("a", 1), 100));
+  REQUIRE(map.Size() == 2000);
+  for (int i = 0; i < 1000; i++) {
+    REQUIRE(*map.Find(Attr("a", i)) == i);
+    REQUIRE(*map.Find(Attr("b", i)) == -i);
+  }
+  REQUIRE(map.Find(Attr("a", 1000)) == nullptr);
+  REQUIRE(map.Find(Attr("c", 1)) == nullptr);
+}
+
 TEST_CASE("index_result_check", "[be posting list correction check]") {
   std::map<int, T*> targets;
   component::BeIndexerBuilder builder;
@@ -227,6 +295,51 @@ TEST_CASE("index_result_check", "[be posting list correction check]") {
   }
 }
 
+TEST_CASE("index_scanner_batch", "[batch retrieve and limit]") {
+  BeIndexerBuilder builder;
+  for (int i = 1; i < 5000; i++) {
+    Document doc(i);
+    doc.AddConjunction(new Conjunction({
+        {"a", rand_assigns(5, 50, 100), base::RandInt(0, 100) > 80},
+        {"b", rand_assigns(10, 0, 100), base::RandInt(0, 100) > 80},
+    }));
+    if (i % 7 == 0) {
+      doc.AddConjunction(new Conjunction({{"c", rand_assigns(3, 0, 10), true}}));
+    }
+    builder.AddDocument(std::move(doc));
+  }
+  auto index = builder.BuildIndexer();
+
+  std::vector<QueryAssigns> queries;
+  for (int i = 0; i < 500; i++) {
+    // shared assigns across queries
+    queries.push_back({
+        {"a", rand_assigns(1, 50, 60)},
+        {"b", {std::to_string(i % 10)}},
+        {"c", {std::to_string(i % 3)}},
+    });
+  }
+
+  IndexScanner scanner(index.get());
+  IndexScanner::Context ctx;
+  auto batch_results = scanner.BatchRetrieve(queries, nullptr, &ctx);
+  REQUIRE(batch_results.size() == queries.size());
+
+  IndexScanner::Option limit_option;
+  limit_option.limit = 5;
+  for (size_t i = 0; i < queries.size(); i++) {
+    auto result = scanner.Retrieve(queries[i]);
+    REQUIRE(result.result == scanner.Retrieve(queries[i], nullptr, &ctx).result);
+    REQUIRE(result.result == batch_results[i].result);
+
+    auto limited = scanner.Retrieve(queries[i], &limit_option, &ctx);
+    size_t expect_size = std::min<size_t>(5, result.result.size());
+    REQUIRE(limited.result.size() == expect_size);
+    REQUIRE(std::equal(limited.result.begin(), limited.result.end(),
+                       result.result.begin()));
+  }
+}
+
 TEST_CASE("index_build", "[build posting list correction check]") {
   /*
    * >>>>>>>>>t:8
@@ -267,3 +380,364 @@ query:
   oss << r.to_string();
   std::cout << oss.str();
 }
+
+TEST_CASE("parallel_index_build", "[parallel build same as single thread]") {
+  ParallelIndexerBuilder::Options options;
+  options.threads = 4;
+  options.batch_size = 7;
+  options.max_pending_batches = 2;
+  ParallelIndexerBuilder parallel_builder(options);
+  BeIndexerBuilder builder;
+
+  auto new_document = [](int id, const T& t, bool wildcard) {
+    Document doc(id);
+    doc.AddConjunction(new Conjunction({t.a, t.b, t.c}));
+    if (wildcard) {
+      doc.AddConjunction(new Conjunction({{"c", {"1"}, true}}));
+    }
+    return doc;
+  };
+  for (int i = 1; i < 5000; i++) {
+    T t({
+        .id = i,
+        .a = {"a", rand_assigns(5, 50, 100), base::RandInt(0, 100) > 80},
+        .b = {"b", rand_assigns(10, 0, 100), base::RandInt(0, 100) > 80},
+        .c = {"c", rand_assigns(8, 10, 70), base::RandInt(0, 100) > 80},
+    });
+    bool wildcard = i % 10 == 0;
+    builder.AddDocument(new_document(i, t, wildcard));
+    parallel_builder.AddDocument(new_document(i, t, wildcard));
+  }
+  auto index = builder.BuildIndexer();
+  auto parallel_index = parallel_builder.BuildIndexer();
+  REQUIRE(parallel_index);
+  REQUIRE(parallel_builder.BuildIndexer() == nullptr);
+
+  const BuildStats& stats = parallel_builder.Stats();
+  std::cout << "parallel build:" << stats.ToString() << std::endl;
+  REQUIRE(stats.threads == 4);
+  REQUIRE(stats.documents == 4999);
+  REQUIRE(stats.conjunctions == 4999 + 499);
+  REQUIRE(stats.wildcards >= 499);
+  REQUIRE(stats.bad_documents == 0);
+
+  for (int i = 0; i < 1000; i++) {
+    QueryAssigns assigns = {
+        {"a", rand_assigns(1, 50, 100)},
+        {"b", rand_assigns(2, 0, 100)},
+        {"c", rand_assigns(3, 10, 70)},
+    };
+    auto r1 = IndexScanner(index.get()).Retrieve(assigns);
+    auto r2 = IndexScanner(parallel_index.get()).Retrieve(assigns);
+    std::sort(r1.result.begin(), r1.result.end());
+    std::sort(r2.result.begin(), r2.result.end());
+    REQUIRE(r1.result == r2.result);
+  }
+
+  BooleanIndexerHolder holder(index);
+  REQUIRE(holder.Get() == index);
+  REQUIRE(holder.Publish(parallel_index) == index);
+  REQUIRE(holder.Publish(nullptr) == nullptr);
+  REQUIRE(holder.Get() == parallel_index);
+}
+
+TEST_CASE("index_segment", "[save and open mapped index segment]") {
+  BeIndexerBuilder builder;
+  for (int i = 1; i < 3000; i++) {
+    Document doc(i);
+    doc.AddConjunction(new Conjunction({
+        {"a", rand_assigns(5, 50, 100), base::RandInt(0, 100) > 80},
+        {"b", rand_assigns(10, 0, 100), base::RandInt(0, 100) > 80},
+    }));
+    if (i % 10 == 0) {
+      doc.AddConjunction(new Conjunction({{"c", {"1"}, true}}));
+    }
+    builder.AddDocument(std::move(doc));
+  }
+  auto index = builder.BuildIndexer();
+
+  const std::string path = "boolean_indexer_test.seg";
+  REQUIRE(IndexSegment::Save(index.get(), path));
+  auto mapped = IndexSegment::Open(path);
+  REQUIRE(mapped);
+  REQUIRE(mapped->GetMeta("a"));
+  REQUIRE_FALSE(IndexSegment::Save(mapped.get(), path + ".copy"));
+
+  for (int i = 0; i < 1000; i++) {
+    QueryAssigns assigns = {
+        {"a", rand_assigns(1, 50, 100)},
+        {"b", rand_assigns(2, 0, 100)},
+        {"c", rand_assigns(1, 0, 3)},
+    };
+    auto r1 = IndexScanner(index.get()).Retrieve(assigns);
+    auto r2 = IndexScanner(mapped.get()).Retrieve(assigns);
+    REQUIRE(r1.result == r2.result);
+  }
+
+  // a flipped byte in payload
+  std::string content;
+  {
+    std::ifstream ifs(path, std::ios::binary);
+    content.assign(std::istreambuf_iterator<char>(ifs),
+                   std::istreambuf_iterator<char>());
+  }
+  auto write_file = [&path](const std::string& data) {
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    ofs.write(data.data(), data.size());
+  };
+  std::string flipped = content;
+  flipped[flipped.size() - 16] ^= 0x01;
+  write_file(flipped);
+  REQUIRE_FALSE(IndexSegment::Open(path));
+
+  // a slot table without empty slot, probe a missing key never ends
+  uint64_t slot_count, slots_offset;
+  memcpy(&slot_count, &content[56], sizeof(uint64_t));
+  memcpy(&slots_offset, &content[64], sizeof(uint64_t));
+  std::string full = content;
+  for (uint64_t i = 0; i < slot_count; i++) {
+    uint32_t slot = 1;
+    memcpy(&full[slots_offset + i * sizeof(uint32_t)], &slot, sizeof(slot));
+  }
+  write_file(full);
+  IndexSegment::Options options;
+  options.verify_checksum = false;
+  REQUIRE_FALSE(IndexSegment::Open(path, options));
+  write_file(content);
+  REQUIRE(IndexSegment::Open(path, options));
+  unlink(path.c_str());
+  REQUIRE_FALSE(IndexSegment::Open(path));
+}
+
+TEST_CASE("incremental_indexer", "[delta, tombstones and compaction]") {
+  // doc id -> conjunction, wildcard documents have a all-exclude one
+  std::map<int, std::vector<BooleanExpr>> docs;
+  auto rand_doc = [](int id) {
+    std::vector<BooleanExpr> exprs = {
+        {"a", rand_assigns(3, 0, 30), base::RandInt(0, 100) > 80},
+        {"b", rand_assigns(5, 0, 50), base::RandInt(0, 100) > 80},
+    };
+    if (id % 7 == 0) {
+      exprs = {{"c", {"1"}, true}};
+    }
+    return exprs;
+  };
+  auto new_document = [&docs](int id) {
+    Document doc(id);
+    Conjunction* conj = new Conjunction();
+    for (const BooleanExpr& expr : docs[id]) {
+      conj->AddExpression(expr);
+    }
+    doc.AddConjunction(conj);
+    return doc;
+  };
+  auto check = [&](const RefIndexSnapshot& snapshot) {
+    BeIndexerBuilder builder;
+    for (const auto& kv : docs) {
+      builder.AddDocument(new_document(kv.first));
+    }
+    auto index = builder.BuildIndexer();
+    IndexScanner::Context ctx;
+    for (int i = 0; i < 300; i++) {
+      QueryAssigns assigns = {
+          {"a", rand_assigns(2, 0, 30)},
+          {"b", rand_assigns(3, 0, 50)},
+          {"c", rand_assigns(1, 0, 3)},
+      };
+      auto expect = IndexScanner(index.get()).Retrieve(assigns);
+      auto result = snapshot->Retrieve(assigns, nullptr, &ctx);
+      std::sort(expect.result.begin(), expect.result.end());
+      std::sort(result.result.begin(), result.result.end());
+      REQUIRE(expect.result == result.result);
+    }
+  };
+
+  BeIndexerBuilder builder;
+  for (int i = 1; i <= 2000; i++) {
+    docs[i] = rand_doc(i);
+    builder.AddDocument(new_document(i));
+  }
+  IncrementalIndexer::Options options;
+  options.compact_threshold = 0;
+  IncrementalIndexer indexer(builder.BuildIndexer(), options);
+  RefIndexSnapshot origin = indexer.Snapshot();
+  REQUIRE(origin->Delta() == nullptr);
+
+  auto rand_changes = [&](int count) {
+    for (int n = 0; n < count; n++) {
+      int id = base::RandInt(1, 2300);
+      if (base::RandInt(0, 100) < 30) {
+        docs.erase(id);
+        indexer.Remove(id);
+      } else {
+        docs[id] = rand_doc(id);
+        REQUIRE(indexer.Upsert(new_document(id)));
+      }
+    }
+  };
+  rand_changes(300);
+  // not visible before commit
+  REQUIRE(indexer.Snapshot() == origin);
+  RefIndexSnapshot snapshot = indexer.Commit();
+  REQUIRE(snapshot->Version() > origin->Version());
+  REQUIRE(snapshot->Delta());
+  check(snapshot);
+
+  IndexScanner::Option option;
+  option.limit = 5;
+  QueryAssigns assigns = {{"a", rand_assigns(10, 0, 30)},
+                          {"b", rand_assigns(20, 0, 50)}};
+  REQUIRE(snapshot->Retrieve(assigns, &option).result.size() <= 5);
+
+  REQUIRE(indexer.Compact());
+  REQUIRE(indexer.DeltaSize() == 0);
+  REQUIRE(indexer.Snapshot()->Delta() == nullptr);
+  check(indexer.Snapshot());
+
+  rand_changes(200);
+  check(indexer.Commit());
+  REQUIRE(indexer.Compact());
+  check(indexer.Snapshot());
+
+  // background compaction when delta grows over threshold
+  options.compact_threshold = 100;
+  IncrementalIndexer bg_indexer(indexer.Snapshot()->Base(), options);
+  for (int id = 3000; id < 3150; id++) {
+    docs[id] = rand_doc(id);
+    REQUIRE(bg_indexer.Upsert(new_document(id)));
+  }
+  bg_indexer.Commit();
+  for (int i = 0; i < 500 && bg_indexer.DeltaSize() > 0; i++) {
+    usleep(10000);
+  }
+  REQUIRE(bg_indexer.DeltaSize() == 0);
+  check(bg_indexer.Snapshot());
+}
+
+TEST_CASE("range_container", "[segment tree of numeric ranges]") {
+  // age ranges in [0, 100], same as its values expanded one by one
+  auto rand_range = [](AttrValues::ValueContainer* expanded) {
+    int a = base::RandInt(0, 100), b = base::RandInt(0, 100);
+    int min = std::min(a, b), max = std::max(a, b);
+    std::string range;
+    switch (base::RandInt(0, 5)) {
+      case 0: range = fmt::format(">={}", min); max = 100; break;
+      case 1: range = fmt::format("<={}", max); min = 0; break;
+      case 2: range = fmt::format(">{}", min); min++; max = 100; break;
+      case 3: range = fmt::format("<{}", max); max--; min = 0; break;
+      case 4: range = fmt::format("{}", min); max = min; break;
+      default: range = fmt::format("{}~{}", min, max); break;
+    }
+    for (int v = min; v <= max; v++) {
+      expanded->insert(std::to_string(v));
+    }
+    return range;
+  };
+
+  BeIndexerBuilder builder;
+  BeIndexerBuilder expanded_builder;
+  REQUIRE(builder.ConfigureField("age", std::make_shared<RangeParser>(),
+                                 EntriesContainerPtr(new RangeContainer())));
+  REQUIRE_FALSE(builder.ConfigureField("age", std::make_shared<RangeParser>()));
+  for (int i = 1; i <= 2000; i++) {
+    AttrValues::ValueContainer ranges, expanded;
+    for (int n = base::RandInt(1, 3); n > 0; n--) {
+      ranges.insert(rand_range(&expanded));
+    }
+    bool exclude = base::RandInt(0, 100) > 80;
+    BooleanExpr b("b", rand_assigns(3, 0, 10), false);
+
+    Document doc(i);
+    doc.AddConjunction(new Conjunction({{"age", ranges, exclude}, b}));
+    builder.AddDocument(std::move(doc));
+    if (expanded.empty()) {  // eg: "<0"
+      expanded.insert("-1");
+    }
+    Document expanded_doc(i);
+    expanded_doc.AddConjunction(
+        new Conjunction({{"age", expanded, exclude}, b}));
+    expanded_builder.AddDocument(std::move(expanded_doc));
+  }
+  auto index = builder.BuildIndexer();
+  auto expanded_index = expanded_builder.BuildIndexer();
+  REQUIRE(index->GetContainer("age") != index->GetContainer("b"));
+
+  for (int i = 0; i < 1000; i++) {
+    QueryAssigns assigns = {
+        {"age", rand_assigns(base::RandInt(1, 2), 0, 100)},
+        {"b", rand_assigns(2, 0, 10)},
+    };
+    auto expect = IndexScanner(expanded_index.get()).Retrieve(assigns);
+    auto result = IndexScanner(index.get()).Retrieve(assigns);
+    std::sort(expect.result.begin(), expect.result.end());
+    std::sort(result.result.begin(), result.result.end());
+    REQUIRE(expect.result == result.result);
+  }
+
+  RangeParser parser;
+  REQUIRE(parser.ParseIndexing({"5~1"})->BadToken());
+  REQUIRE(parser.ParseIndexing({"x~1"})->BadToken());
+  REQUIRE(parser.ParseIndexing({"-10~-5", "<=3"})->Int64().size() == 4);
+}
+
+TEST_CASE("geo_cell", "[geohash cells targeting]") {
+  REQUIRE(geo::GeoHash::Encode(57.64911, 10.40744, 11) == "u4pruydqqvj");
+  geo::GeoBox box;
+  REQUIRE(geo::GeoHash::Decode("wx4g0", &box));
+  REQUIRE(box.lat_min <= 39.92);
+  REQUIRE(box.lat_max >= 39.92);
+
+  BeIndexerBuilder builder;
+  REQUIRE(builder.ConfigureField("geo", std::make_shared<GeoCellParser>()));
+  Document cell_doc(1);
+  cell_doc.AddConjunction(new Conjunction({{"geo", {"wx4g0"}, false}}));
+  builder.AddDocument(std::move(cell_doc));
+  // 2km around Beijing
+  Document circle_doc(2);
+  circle_doc.AddConjunction(
+      new Conjunction({{"geo", {"39.9,116.4,2000"}, false}}));
+  builder.AddDocument(std::move(circle_doc));
+  Document exclude_doc(3);
+  exclude_doc.AddConjunction(new Conjunction({{"geo", {"wx4"}, true}}));
+  builder.AddDocument(std::move(exclude_doc));
+  auto index = builder.BuildIndexer();
+
+  auto query = [&index](const std::string& location) {
+    QueryAssigns assigns = {{"geo", {location}}};
+    auto result = IndexScanner(index.get()).Retrieve(assigns).result;
+    std::sort(result.begin(), result.end());
+    return result;
+  };
+  REQUIRE(query("39.92,116.41") == std::vector<int64_t>({1, 2}));
+  REQUIRE(query("39.89,116.39") == std::vector<int64_t>({2}));
+  REQUIRE(query("31.23,121.47") == std::vector<int64_t>({3}));
+  REQUIRE(query("wx4g0") == std::vector<int64_t>({1, 2}));
+
+  GeoCellParser parser;
+  REQUIRE(parser.ParseQueryAssign({"91,0"})->BadToken());
+  REQUIRE(parser.ParseIndexing({"1,2,-5"})->BadToken());
+  REQUIRE(parser.ParseIndexing({"wx4a"})->BadToken());
+
+  // 12 chars cells fill all 64 bits of the id
+  int64_t full_id = 0, prefix_id = 0, max_id = 0;
+  REQUIRE(GeoCellParser::CellId("wx4g0gpnve77", &full_id));
+  REQUIRE(GeoCellParser::CellId("wx4g0gpnve7", &prefix_id));
+  REQUIRE(GeoCellParser::CellId("zzzzzzzzzzzz", &max_id));
+  REQUIRE(full_id != prefix_id);
+  REQUIRE((uint64_t(full_id) & 0xF) == 12);
+  REQUIRE(uint64_t(max_id) == ~uint64_t(0xF) + 12);
+  REQUIRE_FALSE(GeoCellParser::CellId("wx4g0gpnve77w", &full_id));
+
+  BeIndexerBuilder precise_builder;
+  precise_builder.ConfigureField("geo", std::make_shared<GeoCellParser>());
+  Document precise_doc(4);
+  precise_doc.AddConjunction(
+      new Conjunction({{"geo", {"zzzzzzzzzzzz"}, false}}));
+  precise_builder.AddDocument(std::move(precise_doc));
+  auto precise = precise_builder.BuildIndexer();
+  QueryAssigns hit = {{"geo", {"zzzzzzzzzzzz"}}};
+  QueryAssigns miss = {{"geo", {"zzzzzzzzzzzy"}}};
+  REQUIRE(IndexScanner(precise.get()).Retrieve(hit).result ==
+          std::vector<int64_t>({4}));
+  REQUIRE(IndexScanner(precise.get()).Retrieve(miss).result.empty());
+}
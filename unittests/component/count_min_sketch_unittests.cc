@@ -1,8 +1,13 @@
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <atomic>
 #include <iostream>
+#include <thread>
+#include <vector>
 #include "components/count_min_sketch/count_min_sketch.h"
+#include "components/count_min_sketch/heavy_hitters.h"
+#include "components/count_min_sketch/sharded_count_min_sketch.h"
 
 #include <catch/catch.hpp>
 
@@ -53,3 +58,117 @@ TEST_CASE("cm.falserate", "[Add New Item To BloomFilter]") {
   std::cout << " value error estimate count:" << value_err_count << std::endl;
   REQUIRE(value_err_count < 10);
 }
+
+TEST_CASE("cm.sharded", "[sharded sketch concurrent increase]") {
+  component::ShardedCountMinSketch::Options options;
+  options.shards = 4;
+  options.conservative = true;
+  component::ShardedCountMinSketch sketch(options);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&]() {
+      for (uint32_t i = 0; i < 10000; i++) {
+        uint32_t key = i % 100;
+        sketch.Increase(&key, sizeof(key), 1);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  sketch.Merge();
+
+  for (uint32_t key = 0; key < 100; key++) {
+    uint64_t count = sketch.Estimate(&key, sizeof(key));
+    REQUIRE(count >= 400);
+    REQUIRE(count <= 410);
+  }
+  uint32_t absent = 1000;
+  REQUIRE(sketch.Estimate(&absent, sizeof(absent)) == 0);
+}
+
+TEST_CASE("cm.decay", "[sliding window and exponential decay]") {
+  component::ShardedCountMinSketch::Options options;
+  options.shards = 1;
+  options.decay = component::ShardedCountMinSketch::kSlidingWindow;
+  options.window_buckets = 3;
+  component::ShardedCountMinSketch window(options);
+
+  window.Increase("uid", 10);
+  window.Tick();
+  window.Increase("uid", 5);
+  REQUIRE(window.Estimate("uid") == 15);
+  window.Tick();
+  window.Tick();
+  // the first 10 slide out of window
+  REQUIRE(window.Estimate("uid") == 5);
+  window.Tick();
+  REQUIRE(window.Estimate("uid") == 0);
+
+  options.decay = component::ShardedCountMinSketch::kExponential;
+  options.decay_factor = 0.5;
+  component::ShardedCountMinSketch decayed(options);
+  decayed.Increase("uid", 100);
+  decayed.Tick();
+  REQUIRE(decayed.Estimate("uid") == 50);
+  decayed.Tick();
+  REQUIRE(decayed.Estimate("uid") == 25);
+}
+
+TEST_CASE("cm.serialize", "[merge sketches across process]") {
+  component::ShardedCountMinSketch::Options options;
+  options.shards = 2;
+  options.decay = component::ShardedCountMinSketch::kSlidingWindow;
+  component::ShardedCountMinSketch a(options), b(options);
+
+  a.Increase("uid", 3);
+  b.Increase("uid", 4);
+  b.Increase("other", 1);
+
+  std::string data = b.Serialize();
+  REQUIRE(a.MergeFrom(data));
+  REQUIRE(a.Estimate("uid") == 7);
+  REQUIRE(a.Estimate("other") == 1);
+
+  auto c = component::ShardedCountMinSketch::Deserialize(a.Serialize());
+  REQUIRE(c);
+  REQUIRE(c->Estimate("uid") == 7);
+
+  // corrupted input rejected before allocating anything
+  std::string bad = data;
+  bad[0] = 'X';
+  REQUIRE_FALSE(component::ShardedCountMinSketch::Deserialize(bad));
+  bad = data.substr(0, data.size() - 4);
+  REQUIRE_FALSE(component::ShardedCountMinSketch::Deserialize(bad));
+  bad = data;
+  uint64_t huge_width = uint64_t(1) << 60;
+  memcpy(&bad[16], &huge_width, sizeof(huge_width));
+  REQUIRE_FALSE(component::ShardedCountMinSketch::Deserialize(bad));
+
+  options.seed = 1;
+  component::ShardedCountMinSketch mismatch(options);
+  REQUIRE_FALSE(mismatch.MergeFrom(data));
+}
+
+TEST_CASE("cm.heavy_hitters", "[top k keys]") {
+  component::ShardedCountMinSketch::Options options;
+  options.shards = 1;
+  component::ShardedCountMinSketch sketch(options);
+  component::HeavyHitters hitters(&sketch, 3);
+
+  for (int i = 0; i < 1000; i++) {
+    hitters.Increase("key_" + std::to_string(i % 50), 1);
+    if (i % 10 == 0) {
+      hitters.Increase("hot_a", 10);
+      hitters.Increase("hot_b", 5);
+      hitters.Increase("hot_c", 3);
+    }
+  }
+  auto top = hitters.TopK();
+  REQUIRE(top.size() == 3);
+  REQUIRE(top[0].first == "hot_a");
+  REQUIRE(top[1].first == "hot_b");
+  REQUIRE(top[2].first == "hot_c");
+  REQUIRE(top[0].second == 1000);
+}
@@ -6,6 +6,7 @@
 #include <sstream>
 #include <string>
 #include "components/inverted_indexer/indexer.h"
+#include "components/inverted_indexer/posting_field/roaring_bitmap.h"
 
 #include <thirdparty/catch/catch.hpp>
 
@@ -95,6 +96,14 @@ TEST_CASE("indexer_file", "[load document from text file]") {
   component::Json query_request = querys;
   component::Json query_result = indexer.UnifyQuery(querys);
 
+  component::MergeResult result = indexer.Query(querys);
+  std::set<int64_t> ids;
+  for (auto iter = result.Begin(); iter.Valid(); iter.Next()) {
+    ids.insert(iter.Value());
+  }
+  REQUIRE(result.Count() == ids.size());
+  REQUIRE(ids == indexer.UnifyQuery(querys));
+
   std::ostringstream oss;
   indexer.DebugDump(oss);
   std::cout << oss.str() << std::endl;
@@ -138,3 +147,111 @@ TEST_CASE("bitmap_base", "[load document from text file]") {
   j_s = manager.GetIdsFromPostingList(p4);
   std::cout << "id from bitmap:" << j_s << std::endl;
 }
+
+TEST_CASE("roaring_bitmap", "[roaring bitmap containers and operations]") {
+  auto to_set = [](const component::RoaringBitmap& bitmap) {
+    std::set<uint32_t> values;
+    for (auto iter = bitmap.Begin(); iter.Valid(); iter.Next()) {
+      values.insert(iter.Value());
+    }
+    std::set<uint32_t> each;
+    bitmap.ForEach([&each](uint32_t v) { each.insert(v); });
+    REQUIRE(values == each);
+    REQUIRE(values.size() == bitmap.Cardinality());
+    return values;
+  };
+  // sparse(array), dense(bitmap) and continuous(run) values
+  auto generate = [](component::RoaringBitmap* bitmap, std::set<uint32_t>* s,
+                     uint32_t seed) {
+    srand(seed);
+    for (int i = 0; i < 3000; i++) {
+      uint32_t v = rand() % (1 << 20);
+      bitmap->Add(v);
+      s->insert(v);
+    }
+    for (int i = 0; i < 20000; i++) {
+      uint32_t v = (3 << 16) + rand() % 30000;
+      bitmap->Add(v);
+      s->insert(v);
+    }
+    uint32_t begin = (5 << 16) + rand() % 1000;
+    uint32_t end = begin + 70000 + rand() % 1000;
+    bitmap->AddRange(begin, end);
+    for (uint32_t v = begin; v < end; v++) {
+      s->insert(v);
+    }
+  };
+
+  component::RoaringBitmap a, b;
+  std::set<uint32_t> sa, sb;
+  generate(&a, &sa, 1);
+  generate(&b, &sb, 2);
+  REQUIRE(to_set(a) == sa);
+  size_t memory = a.MemoryUsage();
+  a.Optimize();
+  b.Optimize();
+  REQUIRE(a.MemoryUsage() < memory);
+  REQUIRE(to_set(a) == sa);
+  for (uint32_t v : sa) {
+    REQUIRE(a.Contains(v));
+  }
+  REQUIRE_FALSE(a.Contains(1 << 21));
+
+  std::set<uint32_t> expect;
+  component::RoaringBitmap c = a;
+  c.UnionWith(b);
+  std::set_union(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                 std::inserter(expect, expect.end()));
+  REQUIRE(to_set(c) == expect);
+
+  expect.clear();
+  c = a;
+  c.IntersectWith(b);
+  std::set_intersection(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                        std::inserter(expect, expect.end()));
+  REQUIRE(to_set(c) == expect);
+
+  expect.clear();
+  c = a;
+  c.SubtractWith(b);
+  std::set_difference(sa.begin(), sa.end(), sb.begin(), sb.end(),
+                      std::inserter(expect, expect.end()));
+  REQUIRE(to_set(c) == expect);
+
+  // remove back to empty
+  for (uint32_t v : sa) {
+    a.Remove(v);
+  }
+  REQUIRE(a.Empty());
+
+  component::RoaringBitmap full;
+  full.AddRange(0, 1 << 17);
+  REQUIRE(full.Cardinality() == (1 << 17));
+  full.SubtractWith(b);
+  REQUIRE(full.Cardinality() ==
+          (1 << 17) - std::distance(sb.begin(), sb.lower_bound(1 << 17)));
+}
+
+TEST_CASE("roaring_bitmap.runs", "[iterate and probe a many runs container]") {
+  // 2000 runs of 8 values, run container is the smallest after Optimize
+  component::RoaringBitmap bitmap;
+  std::set<uint32_t> expect;
+  for (uint32_t r = 0; r < 2000; r++) {
+    for (uint32_t v = r * 32; v < r * 32 + 8; v++) {
+      bitmap.Add(v);
+      expect.insert(v);
+    }
+  }
+  size_t memory = bitmap.MemoryUsage();
+  bitmap.Optimize();
+  REQUIRE(bitmap.MemoryUsage() < memory);
+
+  std::set<uint32_t> values;
+  for (auto iter = bitmap.Begin(); iter.Valid(); iter.Next()) {
+    values.insert(iter.Value());
+  }
+  REQUIRE(values == expect);
+  for (uint32_t v = 0; v < (1 << 16); v++) {
+    REQUIRE(bitmap.Contains(v) == (expect.count(v) > 0));
+  }
+}
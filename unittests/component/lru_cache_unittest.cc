@@ -2,9 +2,13 @@
 // Created by gh on 18-9-15.
 //
 #include "components/lru_cache/lru_cache.h"
+#include "components/lru_cache/sharded_cache.h"
 #include <stdlib.h>
 #include <unistd.h>
+#include <atomic>
 #include <iostream>
+#include <thread>
+#include <vector>
 
 #include <thirdparty/catch/catch.hpp>
 
@@ -39,3 +43,110 @@ TEST_CASE("lru.base", "[base lru function case]") {
   REQUIRE(cache.Get("name2", &value) == true);
   REQUIRE(value == 10);
 }
+
+TEST_CASE("sharded_cache.base", "[sharded cache base function]") {
+  component::ShardedCache<std::string, int64_t>::Options options;
+  options.capacity = 100;
+  options.shards = 1;
+  component::ShardedCache<std::string, int64_t> cache(options);
+
+  int64_t value = 0;
+  REQUIRE(cache.Put("pear", 10));
+  REQUIRE(cache.Get("pear", &value));
+  REQUIRE(value == 10);
+  REQUIRE(cache.Put("pear", 20));
+  REQUIRE(cache.Get("pear", &value));
+  REQUIRE(value == 20);
+  REQUIRE_FALSE(cache.Get("apple", &value));
+  REQUIRE(cache.Remove("pear"));
+  REQUIRE_FALSE(cache.Exists("pear"));
+
+  // ttl expire lazily
+  REQUIRE(cache.Put("banana", 1, 1, 20));
+  REQUIRE(cache.Exists("banana"));
+  usleep(30 * 1000);
+  REQUIRE_FALSE(cache.Get("banana", &value));
+
+  // charge larger than capacity
+  REQUIRE_FALSE(cache.Put("huge", 1, 1000));
+
+  auto stats = cache.GetStats();
+  REQUIRE(stats.hits == 2);
+  REQUIRE(stats.misses == 2);
+  REQUIRE(stats.expirations == 1);
+  REQUIRE(stats.entries == 0);
+}
+
+TEST_CASE("sharded_cache.small", "[capacity less than shards]") {
+  component::ShardedCache<std::string, int64_t>::Options options;
+  options.capacity = 4;
+  options.shards = 64;
+  component::ShardedCache<std::string, int64_t> cache(options);
+
+  for (int i = 0; i < 100; i++) {
+    cache.Put(std::to_string(i), i);
+  }
+  REQUIRE(cache.GetStats().entries <= options.capacity);
+
+  options.capacity = 1;
+  component::ShardedCache<std::string, int64_t> one(options);
+  REQUIRE(one.Put("pear", 10));
+  one.Put("apple", 20);
+  REQUIRE(one.GetStats().entries == 1);
+}
+
+TEST_CASE("sharded_cache.admission", "[tinylfu keep hot keys]") {
+  component::ShardedCache<int, int>::Options options;
+  options.capacity = 100;
+  options.shards = 1;
+  component::ShardedCache<int, int> cache(options);
+
+  int value = 0;
+  for (int round = 0; round < 5; round++) {
+    for (int key = 0; key < 50; key++) {
+      cache.Put(key, key);
+      REQUIRE(cache.Get(key, &value));
+    }
+  }
+  // a scan of one-hit keys can't flush the hot ones
+  for (int key = 1000; key < 3000; key++) {
+    cache.Put(key, key);
+  }
+  int hot_hits = 0;
+  for (int key = 0; key < 50; key++) {
+    hot_hits += cache.Get(key, &value);
+  }
+  REQUIRE(hot_hits >= 45);
+  REQUIRE(cache.GetStats().charge <= 100);
+  REQUIRE(cache.GetStats().rejections > 0);
+}
+
+TEST_CASE("sharded_cache.concurrent", "[sharded cache multi thread]") {
+  component::ShardedCache<int, int>::Options options;
+  options.capacity = 1000;
+  options.shards = 16;
+  component::ShardedCache<int, int> cache(options);
+
+  std::atomic<int> mismatch(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      int value = 0;
+      for (int i = 0; i < 20000; i++) {
+        int key = (i * 7 + t) % 2000;
+        if (!cache.Get(key, &value)) {
+          cache.Put(key, key);
+        } else if (value != key) {
+          mismatch++;
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  REQUIRE(mismatch == 0);
+  auto stats = cache.GetStats();
+  REQUIRE(stats.hits + stats.misses == 80000);
+  REQUIRE(stats.charge <= 1000);
+}
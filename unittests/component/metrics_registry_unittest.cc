@@ -0,0 +1,131 @@
+#include <stdlib.h>
+#include <unistd.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "components/log_metrics/loop_metrics.h"
+#include "components/log_metrics/metrics_registry.h"
+
+#include <catch/catch.hpp>
+
+using component::HistogramSnapshot;
+
+TEST_CASE("metrics.bucket", "[log linear bucket index]") {
+  for (uint32_t bits = 1; bits <= 7; bits++) {
+    uint32_t last = 0;
+    for (int64_t v = 0; v < 100000; v += 7) {
+      uint32_t index = HistogramSnapshot::BucketIndex(bits, v);
+      REQUIRE(index >= last);
+      REQUIRE(index < HistogramSnapshot::BucketCount(bits));
+      int64_t highest = HistogramSnapshot::BucketHighest(bits, index);
+      REQUIRE(highest >= v);
+      // relative error < 1/2^bits
+      REQUIRE(double(highest - v) <= double(v) / (1 << bits) + 1);
+      last = index;
+    }
+  }
+  REQUIRE(HistogramSnapshot::BucketIndex(4, -10) == 0);
+  REQUIRE(HistogramSnapshot::BucketIndex(4, INT64_MAX) ==
+          HistogramSnapshot::BucketCount(4) - 1);
+}
+
+TEST_CASE("metrics.registry", "[counter gauge histogram]") {
+  component::MetricsRegistry::Options options;
+  options.shards = 4;
+  component::MetricsRegistry registry(options);
+
+  auto counter = registry.NewCounter("requests_total", "all requests",
+                                     {{"method", "GET"}});
+  REQUIRE(counter == registry.NewCounter("requests_total", "all requests",
+                                         {{"method", "GET"}}));
+  auto gauge = registry.NewGauge("connections", "alive connections");
+  auto latency = registry.NewHistogram("latency_us", "request latency");
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&]() {
+      for (int64_t i = 1; i <= 10000; i++) {
+        counter->Inc();
+        latency->Record(i);
+      }
+      gauge->Add(1);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  REQUIRE(counter->Value() == 40000);
+  REQUIRE(gauge->Value() == 4);
+
+  auto snapshot = latency->Snapshot();
+  REQUIRE(snapshot.count == 40000);
+  REQUIRE(snapshot.max == 10000);
+  REQUIRE(snapshot.sum == 4 * 10000 * 10001 / 2);
+  int64_t p50 = snapshot.Percentile(0.5);
+  int64_t p99 = snapshot.Percentile(0.99);
+  REQUIRE(p50 >= 5000);
+  REQUIRE(p50 <= 5000 * 1.07);
+  REQUIRE(p99 >= 9900);
+  REQUIRE(p99 <= 10000);
+
+  // quantiles of the last interval
+  registry.Collect();
+  for (int i = 0; i < 100; i++) {
+    latency->Record(7);
+  }
+  registry.Collect();
+
+  std::string text = registry.PrometheusText();
+  std::cout << text << std::endl;
+  REQUIRE(text.find("# TYPE requests_total counter") != std::string::npos);
+  REQUIRE(text.find("requests_total{method=\"GET\"} 40000") !=
+          std::string::npos);
+  REQUIRE(text.find("connections 4") != std::string::npos);
+  REQUIRE(text.find("latency_us{quantile=\"0.99\"} 7") != std::string::npos);
+  REQUIRE(text.find("latency_us_count 40100") != std::string::npos);
+}
+
+TEST_CASE("metrics.loop_metrics", "[loop tracer feed registry]") {
+  component::MetricsRegistry::Options options;
+  options.shards = 2;
+  component::MetricsRegistry registry(options);
+  component::LoopMetrics metrics(&registry);
+
+  base::Location location("HandleRequest", "/src/app/handler.cc", 42);
+  REQUIRE(component::LoopMetrics::LocationLabel(location) ==
+          "HandleRequest@handler.cc:42");
+
+  for (int i = 0; i < 10; i++) {
+    metrics.OnTaskRun(nullptr, location, 100, 2000);
+  }
+  metrics.OnTaskRun(nullptr, FROM_HERE, -1, 5);
+  metrics.OnSlowTask(nullptr, location, 60000);
+  metrics.OnLoopLag(nullptr, 300);
+
+  std::string text = registry.PrometheusText();
+  REQUIRE(text.find("loop_task_run_us_count{location=\"HandleRequest@"
+                    "handler.cc:42\"} 10") != std::string::npos);
+  REQUIRE(text.find("loop_task_queue_us_count{loop=\"none\"} 10") !=
+          std::string::npos);
+  REQUIRE(text.find("loop_slow_tasks_total{loop=\"none\"} 1") !=
+          std::string::npos);
+  REQUIRE(text.find("loop_lag_us_count{loop=\"none\"} 1") !=
+          std::string::npos);
+
+  // series of locations bounded
+  for (int line = 0; line < 2 * int(component::LoopMetrics::kMaxLocations);
+       line++) {
+    metrics.OnTaskRun(nullptr, base::Location("Run", "/src/x.cc", line), 1, 1);
+  }
+  text = registry.PrometheusText();
+  size_t series = 0;
+  for (size_t pos = 0;
+       (pos = text.find("loop_task_run_us_count{", pos)) != std::string::npos;
+       pos++) {
+    series++;
+  }
+  REQUIRE(series == component::LoopMetrics::kMaxLocations + 1);
+  REQUIRE(text.find("loop_task_run_us_count{location=\"other\"}") !=
+          std::string::npos);
+}
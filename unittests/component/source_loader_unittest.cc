@@ -6,8 +6,11 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <vector>
 #include "components/source_loader/loader/file_loader.h"
+#include "components/source_loader/parser/column_batch.h"
 #include "components/source_loader/source_impl/name_struct_source.h"
+#include "components/source_loader/source_reloader.h"
 
 #include <thirdparty/catch/catch.hpp>
 
@@ -126,7 +129,206 @@ TEST_CASE("name_struct", "[test namestruct source]") {
   REQUIRE(source.Initialize());
 
   source.StartLoad();
+  // the last line ended without '\n'
   const Person& p = source.GetByName("gonghuan");
+  REQUIRE(p.name == "gonghuan");
+  REQUIRE(p.age == 26);
   std::cout << "name:" << p.name << " age:" << p.age << " info:" << p.ext
             << std::endl;
 }
+
+TEST_CASE("parallel_file_loader", "[mmap chunks parsed by threads]") {
+  const char* file = "./source_loader_parallel_test.txt";
+  const int kLines = 50000;
+  {
+    std::ofstream ofs(file);
+    for (int i = 0; i < kLines; i++) {
+      ofs << "name_" << i << "#" << i << "#{\"id\":" << i << "}#"
+          << (i % 2 ? "true" : "false") << "\n";
+    }
+    ofs << "bad line without delimiter\n";
+  }
+
+  class BatchSource : public component::sl::Source {
+  public:
+    explicit BatchSource(component::sl::Json& config) : Source(config) {}
+
+    void OnContentParsed(const component::sl::Json& data) override {
+      rows.push_back(data);
+    }
+    void OnBatchParsed(const component::sl::ColumnBatch& batch) override {
+      auto name = batch.GetColumn("name");
+      auto age = batch.GetColumn("age");
+      auto ext = batch.GetColumn("ext");
+      for (size_t row = 0; row < batch.Rows(); row++) {
+        std::string n(name->Str(row).data(), name->Str(row).size());
+        REQUIRE(n == "name_" + std::to_string(age->Int(row)));
+        REQUIRE(ext->Int(row) == age->Int(row) % 2);
+        ages.push_back(age->Int(row));
+      }
+      if (batch.Rows() > 0) {
+        rows.push_back(batch.RowJson(0));
+      }
+    }
+    std::vector<int64_t> ages;
+    std::vector<component::sl::Json> rows;
+  };
+
+  for (bool ordered : {true, false}) {
+    component::sl::Json config = R"({
+      "loader": {
+        "type": "file",
+        "threads": 4,
+        "chunk_size": 4096,
+        "resources": [{"path": "./source_loader_parallel_test.txt"}]
+      },
+      "parser": {
+        "type": "column",
+        "delimiter":"#",
+        "primary": "name",
+        "content_mode": "line",
+        "header": ["name","age","info","ext"],
+        "schemes": [
+          {"name": "name", "type": "string", "default": "", "allow_null": false},
+          {"name": "age", "type": "int", "default": 5, "allow_null": true},
+          {"name": "info", "type": "json", "default": {}, "allow_null": true},
+          {"name": "ext", "type": "bool", "default": false, "allow_null": true}
+        ]
+      }
+    })"_json;
+    config["loader"]["ordered"] = ordered;
+    BatchSource source(config);
+    REQUIRE(source.Initialize());
+    REQUIRE(source.StartLoad() == 0);
+
+    REQUIRE(source.ages.size() == kLines);
+    if (!ordered) {
+      std::sort(source.ages.begin(), source.ages.end());
+    }
+    for (int i = 0; i < kLines; i++) {
+      REQUIRE(source.ages[i] == i);
+    }
+    REQUIRE(source.rows.size() > 1);
+    const component::sl::Json& row = source.rows.front();
+    REQUIRE(row["info"]["id"] == row["age"]);
+  }
+  ::unlink(file);
+}
+
+TEST_CASE("file_loader_append", "[partial last line loaded once completed]") {
+  const char* file = "./file_loader_append_test.txt";
+  {
+    std::ofstream ofs(file, std::ios::trunc);
+    ofs << "line0\nline1\nlin";
+  }
+
+  class LinesDelegate : public component::sl::LoaderDelegate {
+  public:
+    void OnReadData(const std::string& data) override {
+      lines.push_back(data);
+    }
+    std::vector<std::string> lines;
+  };
+  LinesDelegate delegate;
+  component::sl::Json config = R"({
+    "type": "file",
+    "append": true,
+    "resources": [{"path": "./file_loader_append_test.txt"}]
+  })"_json;
+  component::sl::FileLoader loader(&delegate, config);
+  REQUIRE(loader.Initialize() == 0);
+  loader.SetParserContentMode("line");
+  REQUIRE(loader.Load() == 0);
+  REQUIRE(delegate.lines == std::vector<std::string>({"line0", "line1"}));
+
+  // the partial line completed, still partial one left
+  {
+    std::ofstream ofs(file, std::ios::app);
+    ofs << "e2\nline3\nli";
+  }
+  delegate.lines.clear();
+  REQUIRE(loader.LoadAppended() == 0);
+  REQUIRE(delegate.lines == std::vector<std::string>({"line2", "line3"}));
+
+  delegate.lines.clear();
+  REQUIRE(loader.LoadAppended() == 0);
+  REQUIRE(delegate.lines.empty());
+  ::unlink(file);
+}
+
+TEST_CASE("source_reloader", "[double buffered hot reload]") {
+  const char* file = "./source_reloader_test.txt";
+  auto write = [](const char* path, int from, int to, bool append) {
+    std::ofstream ofs(path, append ? std::ios::app : std::ios::trunc);
+    for (int i = from; i < to; i++) {
+      ofs << "p" << i << "#" << i << "#{}#ext\n";
+    }
+  };
+  write(file, 0, 100, false);
+
+  component::sl::Json config = R"({
+    "loader": {
+      "type": "file",
+      "resources": [{"path": "./source_reloader_test.txt"}]
+    },
+    "parser": {
+      "type": "column",
+      "delimiter":"#",
+      "primary": "name",
+      "content_mode": "line",
+      "header": ["name","age","info","ext"],
+      "schemes": [
+        {"name": "name", "type": "string", "default": "", "allow_null": false},
+        {"name": "age", "type": "int", "default": 5, "allow_null": true},
+        {"name": "info", "type": "json", "default": {}, "allow_null": true}
+      ]
+    },
+    "reloader": {"mode": "watch", "interval": 20, "append": true}
+  })"_json;
+  typedef component::sl::NameStructSource<Person> PersonSource;
+  component::sl::ReloadableSource<PersonSource> persons(config);
+  REQUIRE(persons.Initialize());
+  REQUIRE(persons.Version() == 1);
+  auto v1 = persons.Get();
+  REQUIRE(v1->GetByName("p99").age == 99);
+
+  // v1 still used by reader, a full load
+  write(file, 100, 200, true);
+  REQUIRE(persons.Reload());
+  REQUIRE(persons.Version() == 2);
+  REQUIRE_FALSE(persons.Current()->appended);
+  REQUIRE(persons.Get()->GetByName("p150").age == 150);
+  REQUIRE(v1->GetByName("p150").name.empty());
+  v1.reset();
+
+  // v1 released, the appended lines loaded into it
+  write(file, 200, 300, true);
+  REQUIRE(persons.Reload());
+  REQUIRE(persons.Version() == 3);
+  REQUIRE(persons.Current()->appended);
+  REQUIRE(persons.Get()->GetByName("p250").age == 250);
+  REQUIRE(persons.Get()->GetByName("p150").age == 150);
+
+  // file replaced, a full load
+  write("./source_reloader_test.tmp", 1000, 1010, false);
+  ::rename("./source_reloader_test.tmp", file);
+  REQUIRE(persons.Reload());
+  REQUIRE_FALSE(persons.Current()->appended);
+  REQUIRE(persons.Get()->GetByName("p250").name.empty());
+  REQUIRE(persons.Get()->GetByName("p1005").age == 1005);
+
+  // watched changes reloaded in background
+  persons.Start();
+  write(file, 2000, 2010, true);
+  for (int i = 0; i < 300 && persons.Version() < 5; i++) {
+    usleep(10000);
+  }
+  REQUIRE(persons.Version() == 5);
+  REQUIRE(persons.Get()->GetByName("p2005").age == 2005);
+  REQUIRE(persons.Get()->GetByName("p1005").age == 1005);
+  persons.Stop();
+
+  ::unlink(file);
+  REQUIRE_FALSE(persons.Reload());
+  REQUIRE(persons.Version() == 5);
+}
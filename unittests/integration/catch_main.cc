@@ -0,0 +1,3 @@
+#define CATCH_CONFIG_MAIN  // only once
+#define CATCH_CONFIG_FAST_COMPILE
+#include <thirdparty/catch/catch.hpp>
@@ -0,0 +1,130 @@
+#include <unistd.h>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "base/coroutine/co_runner.h"
+#include "base/message_loop/message_loop.h"
+#include "base/time/time_utils.h"
+#include "glog/logging.h"
+#include "async_mysql/mysql_pool.h"
+
+#include <thirdparty/catch/catch.hpp>
+
+using namespace lt;
+
+namespace {
+
+// a local mysqld, overridden by LTIO_MYSQL_{HOST,PORT,USER,PASSWD,DB}
+MysqlPoolOptions test_options() {
+  auto env = [](const char* name, const char* dft) -> std::string {
+    const char* value = getenv(name);
+    return value ? value : dft;
+  };
+  MysqlPoolOptions options;
+  options.mysql.host = env("LTIO_MYSQL_HOST", "127.0.0.1");
+  options.mysql.port = std::atoi(env("LTIO_MYSQL_PORT", "3306").c_str());
+  options.mysql.user = env("LTIO_MYSQL_USER", "root");
+  options.mysql.passwd = env("LTIO_MYSQL_PASSWD", "");
+  options.mysql.dbname = env("LTIO_MYSQL_DB", "test");
+  options.mysql.query_timeout = 2000;
+  options.min_connections = 1;
+  options.max_connections = 1;
+  return options;
+}
+
+// false when no mysqld reachable in 2s
+bool wait_ready(MysqlPool* pool) {
+  int64_t start = base::time_ms();
+  while (pool->ReadyCount() == 0 && base::time_ms() - start < 2000) {
+    usleep(10000);
+  }
+  return pool->ReadyCount() > 0;
+}
+
+// pool closes connections in their loop, destroy it before loop quit
+void wait_and_quit(base::MessageLoop* loop,
+                   std::unique_ptr<MysqlPool>* pool,
+                   std::atomic<bool>* done) {
+  int64_t start = base::time_ms();
+  while (!done->load() && base::time_ms() - start < 10000) {
+    usleep(10000);
+  }
+  pool->reset();
+  loop->QuitLoop();
+  loop->WaitLoopEnd();
+}
+
+}  // namespace
+
+TEST_CASE("mysql.stmt_evict", "[prepared statements evicted and closed]") {
+  base::MessageLoop loop("mysql");
+  loop.Start();
+
+  std::atomic<bool> done(false);
+  std::unique_ptr<MysqlPool> pool(new MysqlPool({&loop}));
+  MysqlPoolOptions options = test_options();
+  options.mysql.max_prepared = 2;
+  pool->Initialize(options);
+  if (!wait_ready(pool.get())) {
+    WARN("mysqld not reachable, skipped");
+    done = true;
+  }
+
+  // one connection, every round evicts the least recent statement
+  co_go &loop << [&]() {
+    if (done) {
+      return;
+    }
+    for (int round = 0; round < 3; round++) {
+      for (int i = 0; i < 4; i++) {
+        std::string sql = "select ? + " + std::to_string(i);
+        auto rows = pool->Execute(sql, {std::to_string(round)});
+        ResultRow row;
+        REQUIRE(rows->Next(&row));
+        REQUIRE(row[0] == std::to_string(round + i));
+        REQUIRE_FALSE(rows->Next(&row));
+        REQUIRE(rows->Code() == 0);
+      }
+    }
+    done = true;
+  };
+  wait_and_quit(&loop, &pool, &done);
+}
+
+TEST_CASE("mysql.stream_dropped", "[row stream dropped while paused]") {
+  base::MessageLoop loop("mysql");
+  loop.Start();
+
+  std::atomic<bool> done(false);
+  std::unique_ptr<MysqlPool> pool(new MysqlPool({&loop}));
+  pool->Initialize(test_options());
+  if (!wait_ready(pool.get())) {
+    WARN("mysqld not reachable, skipped");
+    done = true;
+  }
+
+  co_go &loop << [&]() {
+    if (done) {
+      return;
+    }
+    {
+      // paused after two rows buffered, reader gone with rows left
+      auto rows = pool->Query(
+        "select 1 union all select 2 union all select 3 union all select 4",
+        2);
+      ResultRow row;
+      REQUIRE(rows->Next(&row));
+      co_sleep(50);
+    }
+    // the only connection not left paused
+    auto rows = pool->Query("select 'next'");
+    ResultRow row;
+    REQUIRE(rows->Next(&row));
+    REQUIRE(row[0] == "next");
+    REQUIRE_FALSE(rows->Next(&row));
+    done = true;
+  };
+  wait_and_quit(&loop, &pool, &done);
+}
@@ -2,8 +2,10 @@
 #include <unistd.h>
 #include <atomic>
 #include <iostream>
+#include <map>
 
 #include <base/coroutine/co_runner.h>
+#include <base/coroutine/wait_group.h>
 #include <base/message_loop/message_loop.h>
 #include <base/time/time_utils.h>
 #include <base/utils/string/str_utils.h>
@@ -24,6 +26,8 @@
 #include "net_io/codec/redis/redis_request.h"
 #include "net_io/codec/redis/redis_response.h"
 #include "net_io/codec/redis/resp_codec_service.h"
+#include "net_io/server/admin_server/admin_server.h"
+#include "net_io/server/http_server/http_server.h"
 #include "net_io/server/raw_server/raw_server.h"
 #include "net_io/socket_acceptor.h"
 #include "net_io/socket_utils.h"
@@ -34,6 +38,9 @@
 #include <net_io/clients/router/roundrobin_router.h>
 #include "net_io/clients/client.h"
 #include "net_io/clients/client_connector.h"
+#include "net_io/clients/clients_manager.h"
+
+#include "components/log_metrics/metrics_registry.h"
 
 static std::atomic_int io_round_count;
 
@@ -286,6 +293,72 @@ TEST_CASE("client.raw.cs", "[raw client/server request/response test]") {
   LOG(INFO) << "<<<<<< end test client.raw.request, raw client send request";
 }
 
+TEST_CASE("client.raw.pool", "[raw client pool warmup/grow/reap]") {
+  LOG(INFO) << ">>>>>>> start test client.raw.pool";
+
+  base::MessageLoop loop;
+  loop.SetLoopName("client");
+  loop.Start();
+
+  std::vector<base::MessageLoop*> loops = {&loop};
+
+  lt::net::RawCoroServer server;
+  server.WithIOLoops(loops);
+  server.ServeAddress("raw://127.0.0.1:5006", NewRawCoroHandler([](lt::net::RefRawRequestContext ctx){
+    co_sleep(20);
+    auto res = net::LtRawMessage::CreateResponse(ctx->GetRequest<net::LtRawMessage>());
+    ctx->Response(res);
+  }));
+
+  net::url::RemoteInfo server_info;
+  LOG_IF(ERROR, !net::url::ParseRemote("raw://127.0.0.1:5006", server_info))
+      << " server can't be resolve";
+
+  net::Client raw_client(&loop, server_info);
+
+  net::ClientConfig config;
+  config.connections = 2;
+  config.max_connections = 8;
+  config.grow_threshold = 2;
+  config.idle_timeout_ms = 500;
+  config.heartbeat_ms = 200;
+  config.keepalive_sec = 10;
+  raw_client.Initialize(config);
+
+  REQUIRE(raw_client.WaitForWarmup(2000));
+  REQUIRE(raw_client.ConnectedCount() >= 2);
+
+  std::atomic<int> finished = {0};
+  for (int i = 0; i < 64; i++) {
+    CO_GO &loop << [&]() {
+      auto request = net::LtRawMessage::Create();
+      request->SetMethod(12);
+      request->SetContent("RawRequest");
+      raw_client.SendRecieve(request);
+      finished++;
+    };
+  }
+
+  co_go &loop << [&]() {
+    co_sleep(500);
+    REQUIRE(finished == 64);
+    REQUIRE(raw_client.InflightCount() == 0);
+    REQUIRE(raw_client.ConnectedCount() > 2);
+
+    // idle connections reaped back to min connections
+    co_sleep(2000);
+    REQUIRE(raw_client.ConnectedCount() == 2);
+
+    raw_client.Finalize();
+    server.StopServer();
+    co_sleep(500);
+    loop.QuitLoop();
+  };
+
+  loop.WaitLoopEnd();
+  LOG(INFO) << "<<<<<< end test client.raw.pool";
+}
+
 TEST_CASE("client.timer.request", "[fetch resource every interval]") {
   LOG(INFO) << " start test client.timer.request, raw client send request";
 
@@ -769,3 +842,302 @@ TEST_CASE("client.http_pool", "[http client pool manager]") {
 
   LOG(INFO) << " end test client.http.request, http client send request";
 }
+
+TEST_CASE("client.clients_manager", "[client pool per origin]") {
+  ClientD delegate;
+  base::MessageLoop loop;
+  loop.SetLoopName("client");
+  loop.Start();
+
+  net::ClientConfig config;
+  config.connections = 1;
+  config.recon_interval = 100;
+
+  net::ClientsManager manager(&loop, &delegate);
+  manager.SetClientConfig(config);
+
+  net::RefClient a = manager.GetClient("http://127.0.0.1:5007");
+  net::RefClient b = manager.GetClient("http://127.0.0.1:5007");
+  net::RefClient c = manager.GetClient("http://127.0.0.1:5008");
+  REQUIRE(a);
+  REQUIRE(a == b);
+  REQUIRE(a != c);
+  REQUIRE(manager.ClientCount() == 2);
+  REQUIRE(manager.GetClient("bad remote") == nullptr);
+
+  manager.Finalize();
+  REQUIRE(manager.ClientCount() == 0);
+  REQUIRE(manager.GetClient("http://127.0.0.1:5007") == nullptr);
+
+  loop.QuitLoop();
+  loop.WaitLoopEnd();
+}
+
+namespace {
+
+// echo url and body, "/close" reply with Connection: close,
+// "/slow" reply after 500ms
+net::CodecService::Handler* NewEchoHttpHandler() {
+  return NewHttpCoroHandler([](net::RefHttpRequestCtx ctx) {
+    const net::HttpRequest* req = ctx->Request();
+    if (req->RequestUrl() == "/slow") {
+      co_sleep(500);
+    }
+    net::RefHttpResponse res = net::HttpResponse::CreateWithCode(200);
+    res->InsertHeader("X-Url", req->RequestUrl());
+    res->MutableBody() = req->Body();
+    if (req->RequestUrl() == "/close") {
+      res->InsertHeader("Connection", "close");
+      res->SetKeepAlive(false);
+    }
+    ctx->Response(res);
+  });
+}
+
+net::RefHttpRequest NewEchoRequest(const std::string& url,
+                                   const std::string& body) {
+  net::RefHttpRequest request = std::make_shared<net::HttpRequest>();
+  request->SetMethod(body.empty() ? "GET" : "POST");
+  request->SetRequestURL(url);
+  request->MutableBody() = body;
+  return request;
+}
+
+}  // namespace
+
+TEST_CASE("client.http.cs", "[http1.1 client/server keepalive and close]") {
+  base::MessageLoop loop;
+  loop.SetLoopName("client");
+  loop.Start();
+
+  std::unique_ptr<net::CodecService::Handler> handler(NewEchoHttpHandler());
+  net::HttpCoroServer server;
+  server.WithIOLoops({&loop}).ServeAddress("http://127.0.0.1:5011",
+                                           handler.get());
+
+  net::url::RemoteInfo server_info;
+  REQUIRE(net::url::ParseRemote("http://127.0.0.1:5011", server_info));
+  net::Client client(&loop, server_info);
+  net::ClientConfig config;
+  config.connections = 1;
+  config.recon_interval = 100;
+  config.message_timeout = 1000;
+  client.Initialize(config);
+  REQUIRE(client.WaitForWarmup(5000));
+
+  int success = 0;
+  co_go &loop << [&]() {
+    // responses parsed by the response parser, connection persisted
+    for (int i = 0; i < 10; i++) {
+      std::string url = "/echo/" + std::to_string(i);
+      auto request = NewEchoRequest(url, i % 2 ? "body" : "");
+      net::HttpResponse* response = client.SendRecieve(request);
+      if (response && response->ResponseCode() == 200 &&
+          response->GetHeader("X-Url") == url &&
+          response->Body() == request->Body()) {
+        success++;
+      }
+    }
+    // server close the connection, the pool reconnect for next one
+    auto request = NewEchoRequest("/close", "");
+    net::HttpResponse* response = client.SendRecieve(request);
+    if (response && response->ResponseCode() == 200) {
+      success++;
+    }
+    co_sleep(500);
+    request = NewEchoRequest("/after_close", "");
+    response = client.SendRecieve(request);
+    if (response && response->GetHeader("X-Url") == "/after_close") {
+      success++;
+    }
+
+    client.Finalize();
+    server.StopServer();
+    co_sleep(200);
+    loop.QuitLoop();
+  };
+  loop.WaitLoopEnd();
+  REQUIRE(success == 12);
+}
+
+TEST_CASE("client.h2c.cs", "[h2c client multiplexing and flow control]") {
+  base::MessageLoop loop;
+  loop.SetLoopName("client");
+  loop.Start();
+
+  std::unique_ptr<net::CodecService::Handler> handler(NewEchoHttpHandler());
+  net::HttpCoroServer server;
+  server.WithIOLoops({&loop}).ServeAddress("h2c://127.0.0.1:5012",
+                                           handler.get());
+
+  net::url::RemoteInfo server_info;
+  REQUIRE(net::url::ParseRemote("h2c://127.0.0.1:5012", server_info));
+  net::Client client(&loop, server_info);
+  net::ClientConfig config;
+  config.connections = 1;
+  config.recon_interval = 100;
+  config.message_timeout = 5000;
+  client.Initialize(config);
+  REQUIRE(client.WaitForWarmup(5000));
+
+  const int kConcurrent = 100;
+  // larger than the default 64k stream window
+  const std::string big_body(1024 * 1024, 'x');
+
+  std::atomic<int> success = {0};
+  auto wg = co::WaitGroup::New();
+  co_go &loop << [&]() {
+    // all streams in flight on one connection
+    wg->Add(kConcurrent + 1);
+    for (int i = 0; i < kConcurrent; i++) {
+      co_go [&, i]() {
+        std::string url = "/stream/" + std::to_string(i);
+        auto request = NewEchoRequest(url, std::to_string(i));
+        net::HttpResponse* response = client.SendRecieve(request);
+        if (response && response->GetHeader("x-url") == url &&
+            response->Body() == request->Body()) {
+          success++;
+        }
+        wg->Done();
+      };
+    }
+    co_go [&]() {
+      auto request = NewEchoRequest("/big", big_body);
+      net::HttpResponse* response = client.SendRecieve(request);
+      if (response && response->Body() == big_body) {
+        success++;
+      }
+      wg->Done();
+    };
+    wg->Wait(10000);
+    REQUIRE(client.ConnectedCount() == 1);
+
+    client.Finalize();
+    server.StopServer();
+    co_sleep(200);
+    loop.QuitLoop();
+  };
+  loop.WaitLoopEnd();
+  REQUIRE(success == kConcurrent + 1);
+}
+
+TEST_CASE("client.h2c.timeout", "[h2c timeout stream reset]") {
+  base::MessageLoop loop;
+  loop.SetLoopName("client");
+  loop.Start();
+
+  std::unique_ptr<net::CodecService::Handler> handler(NewEchoHttpHandler());
+  net::HttpCoroServer server;
+  server.WithIOLoops({&loop}).ServeAddress("h2c://127.0.0.1:5013",
+                                           handler.get());
+
+  net::url::RemoteInfo server_info;
+  REQUIRE(net::url::ParseRemote("h2c://127.0.0.1:5013", server_info));
+  net::Client client(&loop, server_info);
+  net::ClientConfig config;
+  config.connections = 1;
+  config.recon_interval = 100;
+  config.message_timeout = 100;
+  client.Initialize(config);
+  REQUIRE(client.WaitForWarmup(5000));
+
+  net::MessageCode slow_code = net::MessageCode::kSuccess;
+  bool after_ok = false;
+  co_go &loop << [&]() {
+    auto request = NewEchoRequest("/slow", "");
+    client.SendRecieve(request);
+    slow_code = request->FailCode();
+
+    // stream reset, the session still usable after late response dropped
+    co_sleep(600);
+    request = NewEchoRequest("/after_slow", "");
+    net::HttpResponse* response = client.SendRecieve(request);
+    after_ok = response && response->GetHeader("x-url") == "/after_slow";
+
+    client.Finalize();
+    server.StopServer();
+    co_sleep(200);
+    loop.QuitLoop();
+  };
+  loop.WaitLoopEnd();
+  REQUIRE(slow_code == net::MessageCode::kTimeOut);
+  REQUIRE(after_ok);
+}
+
+TEST_CASE("client.admin", "[admin server status and metrics endpoints]") {
+  base::MessageLoop loop;
+  loop.SetLoopName("client");
+  loop.Start();
+
+  std::unique_ptr<net::CodecService::Handler> handler(NewEchoHttpHandler());
+  net::HttpCoroServer server;
+  server.WithIOLoops({&loop}).ServeAddress("http://127.0.0.1:5014",
+                                           handler.get());
+
+  component::MetricsRegistry::Default()
+      ->NewCounter("admin_test_requests", "admin test counter")
+      ->Inc(3);
+
+  net::url::RemoteInfo echo_info;
+  REQUIRE(net::url::ParseRemote("http://127.0.0.1:5014", echo_info));
+  auto echo_client = std::make_shared<net::Client>(&loop, echo_info);
+  net::ClientConfig echo_config;
+  echo_config.connections = 1;
+  echo_client->Initialize(echo_config);
+  REQUIRE(echo_client->WaitForWarmup(5000));
+  net::RoundRobinRouter router;
+  router.AddClient(net::RefClient(echo_client));
+
+  net::AdminServer admin;
+  admin.WatchServer("echo", &server);
+  admin.WatchRouter("echo_router", &router);
+  admin.Serve("http://127.0.0.1:5015", {&loop});
+
+  net::url::RemoteInfo server_info;
+  REQUIRE(net::url::ParseRemote("http://127.0.0.1:5015", server_info));
+  net::Client client(&loop, server_info);
+  net::ClientConfig config;
+  config.connections = 1;
+  config.recon_interval = 100;
+  config.message_timeout = 1000;
+  client.Initialize(config);
+  REQUIRE(client.WaitForWarmup(5000));
+
+  std::map<std::string, std::pair<int, std::string>> responses;
+  co_go &loop << [&]() {
+    for (const char* url :
+         {"/", "/loops", "/servers", "/clients", "/metrics", "/bad"}) {
+      auto request = NewEchoRequest(url, "");
+      net::HttpResponse* response = client.SendRecieve(request);
+      if (response) {
+        responses[url] = {response->ResponseCode(), response->Body()};
+      }
+    }
+    client.Finalize();
+    echo_client->Finalize();
+    admin.Stop(nullptr);
+    server.StopServer();
+    co_sleep(200);
+    loop.QuitLoop();
+  };
+  loop.WaitLoopEnd();
+
+  REQUIRE(responses.size() == 6);
+  REQUIRE(responses["/"].first == 200);
+  REQUIRE(responses["/"].second.find("\"coroutines\"") != std::string::npos);
+  REQUIRE(responses["/loops"].first == 200);
+  REQUIRE(responses["/loops"].second.find("\"client\"") != std::string::npos);
+  REQUIRE(responses["/servers"].first == 200);
+  REQUIRE(responses["/servers"].second.find("\"echo\"") != std::string::npos);
+  REQUIRE(responses["/clients"].first == 200);
+  REQUIRE(responses["/clients"].second.find("\"echo_router\"") !=
+          std::string::npos);
+  REQUIRE(responses["/clients"].second.find("\"healthy\": 1") !=
+          std::string::npos);
+  REQUIRE(responses["/clients"].second.find("\"connecting\": 0") !=
+          std::string::npos);
+  REQUIRE(responses["/metrics"].first == 200);
+  REQUIRE(responses["/metrics"].second.find("admin_test_requests 3") !=
+          std::string::npos);
+  REQUIRE(responses["/bad"].first == 404);
+}
@@ -0,0 +1,160 @@
+#include <unistd.h>
+
+#include "base/coroutine/co_runner.h"
+#include "base/message_loop/message_loop.h"
+#include "base/time/time_utils.h"
+#include "glog/logging.h"
+#include "net_io/co_so/io_service.h"
+#include "net_io/co_so/tcp_stream.h"
+#include "net_io/codec/codec_message.h"
+
+#include <thirdparty/catch/catch.hpp>
+
+using lt::net::IPEndPoint;
+
+namespace {
+
+// echo lines back until peer closed
+void echo_lines(int fd) {
+  co::TcpStream stream(fd);
+  do {
+    int len = stream.ReadUntil("\r\n", 5000);
+    if (len <= 0) {
+      break;
+    }
+    auto in = stream.ReadBuffer();
+    if (stream.Write(in->GetRead(), len, 5000) != len) {
+      break;
+    }
+    in->Consume(len);
+  } while (true);
+}
+
+class EchoHandler : public lt::net::CodecService::Handler {
+public:
+  void OnCodecMessage(const lt::net::RefCodecMessage& message) override {
+    auto codec = message->GetIOCtx().codec.lock();
+    ignore_result(codec->SendResponse(message.get(), message.get()));
+  };
+};
+
+// lines echoed by server, qps of the client side
+int64_t bench_echo(const IPEndPoint& address, int count) {
+  int64_t start = base::time_us();
+  co::TcpStream stream(co::ConnectTcp(address, 1000));
+  const std::string line("hello ltio\r\n");
+  for (int i = 0; i < count; i++) {
+    if (stream.Write(line, 1000) != int(line.size()) ||
+        stream.ReadExact(line.size(), 1000) != int(line.size())) {
+      return 0;
+    }
+    stream.ReadBuffer()->Consume(line.size());
+  }
+  int64_t cost = std::max<int64_t>(base::time_us() - start, 1);
+  return count * 1000000L / cost;
+}
+
+}  // namespace
+
+TEST_CASE("co_so.tcp_stream", "[coroutine tcp stream]") {
+  base::MessageLoop loop("co_so");
+  loop.Start();
+
+  IPEndPoint address("127.0.0.1", 5012);
+  std::string big(1 << 21, 'x');
+  big.append("\r\n");
+
+  co_go &loop << [&]() {
+    co::TcpListener listener(address);
+
+    co_go [&]() {
+      int fd = co::ConnectTcp(address, 1000);
+      REQUIRE(fd > 0);
+      co::TcpStream stream(fd);
+
+      REQUIRE(stream.Write("hello\r\nwor") == 10);
+      REQUIRE(stream.ReadUntil("\r\n", 1000) == 7);
+      REQUIRE(std::string(stream.ReadBuffer()->GetRead(), 7) == "hello\r\n");
+      stream.ReadBuffer()->Consume(7);
+
+      // half line echoed nothing
+      REQUIRE(stream.ReadSome(50) == co::TcpStream::kTimeout);
+
+      REQUIRE(stream.Write("ld\r\n") == 4);
+      REQUIRE(stream.ReadExact(7, 1000) == 7);
+      REQUIRE(std::string(stream.ReadBuffer()->GetRead(), 7) == "world\r\n");
+      stream.ReadBuffer()->Consume(7);
+
+      // yield until flushed, much more than socket buffer
+      REQUIRE(stream.Write(big, 5000) == int(big.size()));
+      REQUIRE(stream.ReadExact(big.size(), 5000) == int(big.size()));
+      stream.ReadBuffer()->Consume(big.size());
+
+      REQUIRE(stream.ReadUntil("\r\n", 50) == co::TcpStream::kTimeout);
+      REQUIRE(stream.Write("no delimiter in limit\r\n") == 23);
+      REQUIRE(stream.ReadUntil("\r\n", 1000, 16) == co::TcpStream::kOverflow);
+
+      REQUIRE(stream.Write("tail") == 4);
+
+      stream.Close();
+      REQUIRE(stream.IsClosed());
+      REQUIRE(stream.Write("closed\r\n") == co::TcpStream::kError);
+    };
+
+    IPEndPoint peer;
+    int fd = listener.Accept(&peer, 1000);
+    REQUIRE(fd > 0);
+    LOG(INFO) << "accept connection from:" << peer.ToString();
+    co::TcpStream stream(fd);
+    int len = 0;
+    while ((len = stream.ReadUntil("\r\n", 5000, 4 << 20)) > 0) {
+      stream.Write(stream.ReadBuffer()->GetRead(), static_cast<size_t>(len));
+      stream.ReadBuffer()->Consume(len);
+    }
+    // the line without delimiter left
+    REQUIRE(len == co::TcpStream::kClosed);
+    REQUIRE(stream.ReadBuffer()->CanReadSize() == 4);
+
+    REQUIRE(listener.Accept(nullptr, 20) == -1);
+    loop.QuitLoop();
+  };
+  loop.WaitLoopEnd();
+}
+
+TEST_CASE("co_so.bench", "[coroutine tcp stream vs codec service]") {
+  base::MessageLoop loop("co_so");
+  loop.Start();
+
+  const int count = 20000;
+  IPEndPoint stream_address("127.0.0.1", 5013);
+  IPEndPoint codec_address("127.0.0.1", 5014);
+
+  // server side: a TcpStream coroutine per connection
+  co_go &loop << [&]() {
+    co::TcpListener listener(stream_address);
+    int fd = 0;
+    while ((fd = listener.Accept()) > 0) {
+      co_go [fd]() { echo_lines(fd); };
+    }
+  };
+
+  // server side: line CodecService driven by IOEvent
+  EchoHandler handler;
+  co_go &loop << [&]() {
+    coso::IOService service(codec_address);
+    service.WithProtocal("line").WithHandler(&handler);
+    service.Run();
+  };
+
+  co_go &loop << [&]() {
+    co_sleep(10);
+    int64_t stream_qps = bench_echo(stream_address, count);
+    int64_t codec_qps = bench_echo(codec_address, count);
+    LOG(INFO) << "line echo qps, tcp stream:" << stream_qps
+              << ", codec service:" << codec_qps;
+    REQUIRE(stream_qps > 0);
+    REQUIRE(codec_qps > 0);
+    loop.QuitLoop();
+  };
+  loop.WaitLoopEnd();
+}
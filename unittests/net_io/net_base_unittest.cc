@@ -14,6 +14,7 @@
 #include "net_io/clients/client_connector.h"
 #include "net_io/codec/codec_factory.h"
 #include "net_io/codec/codec_service.h"
+#include "net_io/codec/http/http_compression.h"
 #include "net_io/codec/http/http_request.h"
 #include "net_io/codec/http/http_response.h"
 #include "net_io/codec/line/line_message.h"
@@ -28,6 +29,7 @@
 #include "net_io/base/ip_address.h"
 #include "net_io/base/ip_endpoint.h"
 #include "net_io/base/sockaddr_storage.h"
+#include "net_io/udp_io/udp_server.h"
 #include "net_io/udp_io/udp_service.h"
 
 using namespace lt;
@@ -139,17 +141,93 @@ TEST_CASE("ip.endpoint", "[ip endpoint test]") {
 
 TEST_CASE("udp.pollbuffer", "[udp pollbuffer]") {
   net::UDPPollBuffer buffer(5);
+  REQUIRE(buffer.Count() == 5);
+  REQUIRE(buffer.BufferSize() == LT_UDP_MTU_SIZE);
+  REQUIRE(buffer.Data(0).size() == 0);
+  REQUIRE(buffer.SegmentSize(0) == 0);
 }
 
+struct UDPEchoMessage {
+  std::string content;
+  bool Decode(const char* data, size_t len) {
+    content.assign(data, len);
+    return len > 0;
+  }
+  bool Encode(std::string* out) const {
+    out->append(content);
+    return true;
+  }
+};
+
 TEST_CASE("udp.udpservice", "[udp serivce]") {
   base::MessageLoop main;
   main.Start();
 
+  net::UDPCodecHandler<UDPEchoMessage> echo(
+      [](const net::IPEndPoint& peer,
+         const UDPEchoMessage& req,
+         UDPEchoMessage* rsp) {
+        rsp->content = req.content;
+        return true;
+      });
+
+  const int kCount = 200;
+  std::atomic<int> replied = {0};
+  struct Counter : public net::UDPService::Reciever {
+    void OnDataRecieve(net::UDPIOContext* context) override {
+      for (auto& seg : context->Segments()) {
+        if (seg.data == "ping") {
+          (*count)++;
+        }
+      }
+      if (*count == total) {
+        done();
+      }
+    }
+    std::atomic<int>* count;
+    int total;
+    std::function<void()> done;
+  } counter;
+  counter.count = &replied;
+  counter.total = kCount;
+
+  net::RefUDPService server, client;
+  // all replies or timeout, both run in loop
+  bool stopped = false;
+  counter.done = [&]() {
+    if (stopped) {
+      return;
+    }
+    stopped = true;
+    server->StopService();
+    client->StopService();
+    main.QuitLoop();
+  };
+
   net::IPEndPoint ep("127.0.0.1", 8888);
-  auto service = net::UDPService::Create(&main, ep);
-  service->StartService();
+  server = net::UDPService::Create(&main, ep);
+  server->SetReciever(&echo);
+  server->StartService();
 
+  client = net::UDPService::Create(&main, net::IPEndPoint("127.0.0.1", 0));
+  client->SetReciever(&counter);
+  client->StartService();
+
+  uint16_t client_port = 0;
+  main.PostTask(FROM_HERE, [&]() {
+    client_port = client->LocalEndpoint().port();
+    for (int i = 0; i < kCount; i++) {
+      client->SendTo(ep, "ping");
+    }
+  });
+  main.PostDelayTask(NewClosure(counter.done), 5000);
   main.WaitLoopEnd();
+
+  REQUIRE(client_port != 0);
+  // udp may drop datagrams under load, but most should come back
+  REQUIRE(replied > kCount / 2);
+  // datagrams sent in batch
+  REQUIRE(client->GetStats().send_syscalls < kCount);
 }
 
 #include "net_io/codec/http/parser_context.h"
@@ -166,3 +244,60 @@ TEST_CASE("http.parser.tpl", "[http parser template]") {
   net::HttpParser<T, net::HttpResponse> res_parser(&handler);
   res_parser.AppendURL("abck", 4);
 }
+
+TEST_CASE("http.compression", "[http compression negotiate]") {
+  using base::Compressor;
+  using net::HttpCompression;
+
+  CHECK(HttpCompression::Negotiate("") == nullptr);
+  CHECK(HttpCompression::Negotiate("identity") == nullptr);
+  CHECK(HttpCompression::Negotiate("gzip;q=0, deflate;q=0") == nullptr);
+  CHECK(HttpCompression::Negotiate("deflate, gzip;q=0.5")->Id() ==
+        Compressor::kDeflate);
+  CHECK(HttpCompression::Negotiate("x-gzip")->Id() == Compressor::kGzip);
+  // tie, server side preference win
+  CHECK(HttpCompression::Negotiate("deflate, gzip")->Id() == Compressor::kGzip);
+  CHECK(HttpCompression::Negotiate("*;q=0.1, deflate;q=0") != nullptr);
+
+  auto request = std::make_shared<net::HttpRequest>();
+  request->InsertHeader("Accept-Encoding", "gzip");
+  auto response = net::HttpResponse::CreateWithCode(200);
+  std::string body;
+  for (int i = 0; i < 1000; i++) {
+    body.append("hello ltio ");
+  }
+  response->SetBody(body);
+  REQUIRE(HttpCompression::CompressResponse(request.get(), response.get()));
+  CHECK(response->GetHeader("Content-Encoding") == "gzip");
+  CHECK(response->GetHeader("Vary") == "Accept-Encoding");
+  CHECK(response->Body().size() < body.size());
+  // already encoded, never twice
+  CHECK_FALSE(HttpCompression::CompressResponse(request.get(), response.get()));
+
+  // hit precompressed cache, opt-in
+  net::HttpCompressionConfig config;
+  config.cache_capacity = 64;
+  HttpCompression::SetConfig(config);
+  auto response2 = net::HttpResponse::CreateWithCode(200);
+  response2->SetBody(body);
+  REQUIRE(HttpCompression::CompressResponse(request.get(), response2.get()));
+  auto response3 = net::HttpResponse::CreateWithCode(200);
+  response3->SetBody(body);
+  REQUIRE(HttpCompression::CompressResponse(request.get(), response3.get()));
+  CHECK(response3->Body() == response->Body());
+
+  // decoded larger than limit, eg: a zip bomb
+  config.max_decompressed_size = body.size() - 1;
+  HttpCompression::SetConfig(config);
+  CHECK_FALSE(HttpCompression::DecompressBody(response2.get()));
+  HttpCompression::SetConfig(net::HttpCompressionConfig());
+
+  REQUIRE(HttpCompression::DecompressBody(response.get()));
+  CHECK(response->Body() == body);
+  CHECK_FALSE(response->HasHeader("Content-Encoding"));
+
+  auto image = net::HttpResponse::CreateWithCode(200);
+  image->InsertHeader("Content-Type", "image/png");
+  image->SetBody(body);
+  CHECK_FALSE(HttpCompression::CompressResponse(request.get(), image.get()));
+}
@@ -0,0 +1,315 @@
+#include <unistd.h>
+#include <atomic>
+
+#include <base/coroutine/co_runner.h>
+#include <base/message_loop/message_loop.h>
+#include "glog/logging.h"
+
+#include <thirdparty/catch/catch.hpp>
+
+#include "net_io/clients/client.h"
+#include "net_io/rpc/rpc_service.h"
+#include "net_io/server/raw_server/raw_server.h"
+
+using namespace lt;
+
+struct EchoItem {
+  int32_t id = 0;
+  std::string tag;
+  LT_RPC_FIELDS(id, tag);
+};
+
+struct EchoRequest {
+  std::string content;
+  uint32_t sleep_ms = 0;
+  std::vector<EchoItem> items;
+  LT_RPC_FIELDS(content, sleep_ms, items);
+};
+
+struct EchoResponse {
+  std::string content;
+  uint64_t item_count = 0;
+  LT_RPC_FIELDS(content, item_count);
+};
+
+// an older version of EchoResponse
+struct EchoResponseV0 {
+  std::string content;
+  LT_RPC_FIELDS(content);
+};
+
+class EchoService : public net::RpcStub {
+public:
+  LT_RPC_SERVICE(EchoService, "test.EchoService");
+  LT_RPC_METHOD(Echo, EchoRequest, EchoResponse);
+  LT_RPC_METHOD(NotServed, EchoRequest, EchoResponse);
+};
+
+TEST_CASE("rpc.serialize", "[rpc payload serialize]") {
+  EchoRequest req;
+  req.content = "hello";
+  req.sleep_ms = 300;
+  req.items.push_back({-1, "a"});
+  req.items.push_back({1 << 20, "bb"});
+
+  std::string payload;
+  REQUIRE(net::RpcSerialize(req, &payload));
+
+  EchoRequest out;
+  REQUIRE(net::RpcParse(payload, &out));
+  REQUIRE(out.content == "hello");
+  REQUIRE(out.sleep_ms == 300);
+  REQUIRE(out.items.size() == 2);
+  REQUIRE(out.items[0].id == -1);
+  REQUIRE(out.items[1].id == (1 << 20));
+  REQUIRE(out.items[1].tag == "bb");
+
+  // truncated payload must fail
+  REQUIRE_FALSE(net::RpcParse(payload.substr(0, payload.size() - 1), &out));
+
+  // append only evolution, both direction
+  EchoResponse v1;
+  v1.content = "v1";
+  v1.item_count = 10;
+  payload.clear();
+  REQUIRE(net::RpcSerialize(v1, &payload));
+  EchoResponseV0 v0;
+  REQUIRE(net::RpcParse(payload, &v0));
+  REQUIRE(v0.content == "v1");
+
+  payload.clear();
+  REQUIRE(net::RpcSerialize(v0, &payload));
+  EchoResponse v1_out;
+  REQUIRE(net::RpcParse(payload, &v1_out));
+  REQUIRE(v1_out.content == "v1");
+  REQUIRE(v1_out.item_count == 0);
+
+  static_assert(EchoService::EchoMethod::Id() !=
+                    EchoService::NotServedMethod::Id(),
+                "method id should differ");
+}
+
+TEST_CASE("rpc.bad_frame", "[rpc decode reject bad frame]") {
+  net::RpcHeader header;
+  header.magic = net::RpcHeader::kMagic;
+  header.frame_size = net::RpcHeader::kHeaderSize + 4;
+
+  auto decode = [](const net::RpcHeader& header) {
+    net::RpcHeader wire;
+    header.ToNetOrder(&wire);
+    net::IOBuffer buffer;
+    buffer.WriteRawData(&wire, sizeof(wire));
+    buffer.WriteRawData("abcd", 4);
+    return net::RpcMessage::Decode(&buffer, true);
+  };
+  auto message = decode(header);
+  REQUIRE(message);
+  REQUIRE(message->Payload() == "abcd");
+
+  // not decoded/dispatched even the size is plausible
+  net::RpcHeader bad_magic = header;
+  bad_magic.magic = net::RpcHeader::kMagic + 1;
+  REQUIRE_FALSE(decode(bad_magic));
+
+  net::RpcHeader oversized = header;
+  oversized.frame_size = net::RpcHeader::kMaxFrameSize + 1;
+  REQUIRE_FALSE(decode(oversized));
+
+  // a small frame inflated over kMaxFrameSize
+  auto gzip = base::Compressor::Get(base::Compressor::kGzip);
+  REQUIRE(gzip);
+  std::string bomb;
+  REQUIRE(gzip->Compress(
+      std::string(net::RpcHeader::kMaxFrameSize + 1, 0), &bomb));
+  net::RpcHeader compressed = header;
+  compressed.frame_size = net::RpcHeader::kHeaderSize + bomb.size();
+  compressed.flags |= base::Compressor::kGzip;
+  net::RpcHeader wire;
+  compressed.ToNetOrder(&wire);
+  net::IOBuffer buffer;
+  buffer.WriteRawData(&wire, sizeof(wire));
+  buffer.WriteRawData(bomb.data(), bomb.size());
+  message = net::RpcMessage::Decode(&buffer, true);
+  REQUIRE(message);
+  REQUIRE(message->Payload().empty());
+  REQUIRE(message->Code() == net::kRpcBadRequest);
+}
+
+TEST_CASE("rpc.call", "[rpc client/server call with deadline]") {
+  base::MessageLoop loop;
+  loop.SetLoopName("rpc");
+  loop.Start();
+
+  net::RpcDispatcher dispatcher;
+  REQUIRE(dispatcher.Register<EchoService::EchoMethod>(
+      [](const net::RpcContext& ctx,
+         const EchoRequest& req,
+         EchoResponse* rsp) -> int {
+        if (req.sleep_ms > 0) {
+          co_sleep(req.sleep_ms);
+        }
+        rsp->content = req.content;
+        rsp->item_count = req.items.size();
+        return net::kRpcOk;
+      }));
+  // duplicated registration
+  REQUIRE_FALSE(dispatcher.Register<EchoService::EchoMethod>(
+      [](const net::RpcContext&, const EchoRequest&, EchoResponse*) -> int {
+        return net::kRpcOk;
+      }));
+
+  std::unique_ptr<net::CodecService::Handler> handler(dispatcher.NewHandler());
+
+  std::vector<base::MessageLoop*> loops = {&loop};
+  net::RawCoroServer server;
+  server.WithIOLoops(loops);
+  server.ServeAddress("rpc://127.0.0.1:5008", handler.get());
+
+  net::url::RemoteInfo server_info;
+  REQUIRE(net::url::ParseRemote("rpc://127.0.0.1:5008", server_info));
+  net::Client client(&loop, server_info);
+
+  net::ClientConfig config;
+  config.connections = 2;
+  config.message_timeout = 2000;
+  client.Initialize(config);
+  REQUIRE(client.WaitForWarmup(2000));
+
+  net::RpcChannel channel(&client);
+  EchoService stub(&channel);
+
+  std::atomic_int done = {0};
+  int echo_code = -1, deadline_code = -1, not_found_code = -1, async_code = -1;
+  std::string echo_content;
+
+  co_go &loop << [&]() {
+    EchoRequest req;
+    req.content = "ltio rpc";
+    req.items.resize(3);
+    EchoResponse rsp;
+    echo_code = stub.Echo(req, &rsp);
+    echo_content = rsp.content;
+    REQUIRE(rsp.item_count == 3);
+
+    req.sleep_ms = 500;
+    deadline_code = stub.Echo(req, &rsp, 100);
+
+    req.sleep_ms = 0;
+    not_found_code = stub.NotServed(req, &rsp);
+    done++;
+  };
+
+  EchoRequest async_req;
+  async_req.content = "async";
+  stub.AsyncEcho(async_req, [&](int code, const EchoResponse* rsp) {
+    async_code = code;
+    done++;
+  });
+
+  co_go &loop << [&]() {
+    while (done < 2) {
+      co_sleep(10);
+    }
+    client.Finalize();
+    server.StopServer(CO_RESUMER);
+    CO_YIELD;
+    loop.QuitLoop();
+  };
+  loop.WaitLoopEnd();
+
+  REQUIRE(echo_code == net::kRpcOk);
+  REQUIRE(echo_content == "ltio rpc");
+  REQUIRE(deadline_code == net::kRpcDeadlineExceeded);
+  REQUIRE(not_found_code == net::kRpcMethodNotFound);
+  REQUIRE(async_code == net::kRpcOk);
+}
+
+namespace {
+
+// channels and workers spread over loops in turn
+class LoopsDelegate : public net::ClientDelegate {
+public:
+  explicit LoopsDelegate(std::vector<base::MessageLoop*> loops)
+    : loops_(loops) {}
+  base::MessageLoop* NextIOLoopForClient() override {
+    return loops_[next_++ % loops_.size()];
+  }
+
+private:
+  std::vector<base::MessageLoop*> loops_;
+  std::atomic<uint32_t> next_ = {0};
+};
+
+}  // namespace
+
+TEST_CASE("rpc.async_worker", "[rpc async call resumed in other loop]") {
+  base::MessageLoop loop("rpc");
+  base::MessageLoop io("rpc_io");
+  base::MessageLoop worker("rpc_worker");
+  loop.Start();
+  io.Start();
+  worker.Start();
+
+  net::RpcDispatcher dispatcher;
+  REQUIRE(dispatcher.Register<EchoService::EchoMethod>(
+      [](const net::RpcContext& ctx,
+         const EchoRequest& req,
+         EchoResponse* rsp) -> int {
+        rsp->content = req.content;
+        return net::kRpcOk;
+      }));
+  std::unique_ptr<net::CodecService::Handler> handler(dispatcher.NewHandler());
+
+  std::vector<base::MessageLoop*> loops = {&loop};
+  net::RawCoroServer server;
+  server.WithIOLoops(loops);
+  server.ServeAddress("rpc://127.0.0.1:5009", handler.get());
+
+  net::url::RemoteInfo server_info;
+  REQUIRE(net::url::ParseRemote("rpc://127.0.0.1:5009", server_info));
+  net::Client client(&loop, server_info);
+  LoopsDelegate delegate({&io, &worker});
+  client.SetDelegate(&delegate);
+
+  net::ClientConfig config;
+  config.connections = 1;
+  config.message_timeout = 2000;
+  client.Initialize(config);
+  REQUIRE(client.WaitForWarmup(2000));
+
+  net::RpcChannel channel(&client);
+  EchoService stub(&channel);
+
+  // request dropped by channel before callback run in the other loop
+  const int kCount = 8;
+  std::atomic_int done = {0};
+  std::atomic_int ok_count = {0};
+  for (int i = 0; i < kCount; i++) {
+    EchoRequest req;
+    req.content = "async " + std::to_string(i);
+    stub.AsyncEcho(req, [&, i](int code, const EchoResponse* rsp) {
+      if (code == net::kRpcOk && rsp &&
+          rsp->content == "async " + std::to_string(i)) {
+        ok_count++;
+      }
+      done++;
+    });
+  }
+
+  co_go &loop << [&]() {
+    while (done < kCount) {
+      co_sleep(10);
+    }
+    client.Finalize();
+    server.StopServer(CO_RESUMER);
+    CO_YIELD;
+    loop.QuitLoop();
+  };
+  loop.WaitLoopEnd();
+  io.QuitLoop();
+  worker.QuitLoop();
+  io.WaitLoopEnd();
+  worker.WaitLoopEnd();
+
+  REQUIRE(ok_count == kCount);
+}
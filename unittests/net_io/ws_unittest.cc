@@ -0,0 +1,271 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include <base/message_loop/message_loop.h>
+#include <base/time/time_utils.h>
+#include "glog/logging.h"
+
+#include <thirdparty/catch/catch.hpp>
+
+#include "net_io/codec/websocket/ws_util.h"
+#include "net_io/server/ws_server/ws_broadcaster.h"
+#include "net_io/server/ws_server/ws_server.h"
+
+using namespace lt;
+
+namespace {
+
+// "sub {topic}" subscribe and echo back as ack
+class TopicService : public net::WSService {
+public:
+  explicit TopicService(net::WSBroadcaster* broadcaster)
+    : broadcaster_(broadcaster) {}
+
+  void OnOpen(net::Websocket* ws) override {}
+  void OnClose(net::Websocket* ws) override {}
+  void OnMessage(net::Websocket* ws,
+                 const net::RefWebsocketFrame& message) override {
+    std::string content(message->Payload());
+    if (content.compare(0, 4, "sub ") == 0) {
+      broadcaster_->Subscribe(ws, content.substr(4));
+    }
+    ws->Send(message);
+  }
+
+private:
+  net::WSBroadcaster* broadcaster_;
+};
+
+// blocking websocket client, enough for test
+class WSTestClient {
+public:
+  ~WSTestClient() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  bool Connect(int port, int rcvbuf = 0) {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (rcvbuf > 0) {
+      setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    }
+    struct timeval tv = {2, 0};
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (connect(fd_, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+      return false;
+    }
+    std::string handshake =
+        "GET /chat HTTP/1.1\r\n"
+        "Host: 127.0.0.1\r\n"
+        "Upgrade: websocket\r\n"
+        "Connection: Upgrade\r\n"
+        "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+        "Sec-WebSocket-Version: 13\r\n\r\n";
+    if (!write_all(handshake.data(), handshake.size())) {
+      return false;
+    }
+    std::string response;
+    char c;
+    while (response.find("\r\n\r\n") == std::string::npos) {
+      if (recv(fd_, &c, 1, 0) != 1) {
+        return false;
+      }
+      response.push_back(c);
+    }
+    return response.find(" 101 ") != std::string::npos;
+  }
+
+  bool Send(const std::string& content) {
+    std::string frame(
+        WebsocketUtil::CalculateFrameSize(content.size(), true), 0);
+    WebsocketUtil::BuildClientFrame(&frame[0], content.data(), content.size(),
+                                    WS_OPCODE_TEXT);
+    return write_all(frame.data(), frame.size());
+  }
+
+  // payload of a unmasked server frame, false when closed or timeout
+  bool Recv(std::string* payload) {
+    uint8_t hd[2];
+    if (!read_all((char*)hd, 2)) {
+      return false;
+    }
+    uint64_t len = hd[1] & 0x7F;
+    if (len == 126) {
+      uint16_t ext;
+      if (!read_all((char*)&ext, 2)) {
+        return false;
+      }
+      len = ntohs(ext);
+    } else if (len == 127) {
+      uint64_t ext;
+      if (!read_all((char*)&ext, 8)) {
+        return false;
+      }
+      len = be64toh(ext);
+    }
+    payload->resize(len);
+    return read_all(&(*payload)[0], len);
+  }
+
+private:
+  bool write_all(const char* data, size_t len) {
+    while (len > 0) {
+      ssize_t n = send(fd_, data, len, 0);
+      if (n <= 0) {
+        return false;
+      }
+      data += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  bool read_all(char* data, size_t len) {
+    while (len > 0) {
+      ssize_t n = recv(fd_, data, len, 0);
+      if (n <= 0) {
+        return false;
+      }
+      data += n;
+      len -= n;
+    }
+    return true;
+  }
+
+  int fd_ = -1;
+};
+
+}  // namespace
+
+TEST_CASE("ws.broadcast", "[websocket broadcast fan-out]") {
+  base::MessageLoop loop("ws_io");
+  loop.Start();
+  std::vector<base::MessageLoop*> loops = {&loop};
+
+  net::WSBroadcaster broadcaster(loops);
+  TopicService service(&broadcaster);
+  net::WsServer server;
+  server.WithIOLoops(loops);
+  server.WithBroadcaster(&broadcaster);
+  server.Register("/chat", &service);
+  server.ServeAddress("ws://127.0.0.1:5021");
+  usleep(100000);
+
+  // three subscribers of `news`, one of `sport`
+  std::string payload;
+  WSTestClient clients[4];
+  for (int i = 0; i < 4; i++) {
+    REQUIRE(clients[i].Connect(5021));
+    std::string sub = i < 3 ? "sub news" : "sub sport";
+    REQUIRE(clients[i].Send(sub));
+    REQUIRE(clients[i].Recv(&payload));
+    REQUIRE(payload == sub);
+  }
+
+  REQUIRE(broadcaster.Publish("news", "hello") == 1);
+  REQUIRE(broadcaster.Publish("nobody", "hello") == 1);
+  for (int i = 0; i < 3; i++) {
+    REQUIRE(clients[i].Recv(&payload));
+    REQUIRE(payload == "hello");
+  }
+  // the shared frame not delivered to other topic
+  REQUIRE(clients[3].Send("ping"));
+  REQUIRE(clients[3].Recv(&payload));
+  REQUIRE(payload == "ping");
+
+  auto stats = broadcaster.GetStats();
+  REQUIRE(stats.published == 2);
+  REQUIRE(stats.delivered == 3);
+  REQUIRE(stats.dropped == 0);
+
+  server.StopServer();
+  usleep(100000);
+  loop.QuitLoop();
+  loop.WaitLoopEnd();
+}
+
+TEST_CASE("ws.slow_consumer", "[websocket broadcast drop for slow consumer]") {
+  base::MessageLoop loop("ws_io");
+  loop.Start();
+  std::vector<base::MessageLoop*> loops = {&loop};
+
+  net::WSBroadcaster::Config config;
+  config.max_pending_bytes = 64 * 1024;
+  config.policy = net::WSBroadcaster::kDropMessage;
+  net::WSBroadcaster broadcaster(loops, config);
+  TopicService service(&broadcaster);
+  net::WsServer server;
+  server.WithIOLoops(loops);
+  server.WithBroadcaster(&broadcaster);
+  server.Register("/chat", &service);
+  server.ServeAddress("ws://127.0.0.1:5022");
+  usleep(100000);
+
+  // never read after subscribed
+  WSTestClient client;
+  std::string payload;
+  REQUIRE(client.Connect(5022, 4096));
+  REQUIRE(client.Send("sub news"));
+  REQUIRE(client.Recv(&payload));
+
+  const std::string big(32 * 1024, 'x');
+  int64_t start = base::time_ms();
+  while (broadcaster.GetStats().dropped == 0 &&
+         base::time_ms() - start < 5000) {
+    broadcaster.Publish("news", big);
+    usleep(1000);
+  }
+  auto stats = broadcaster.GetStats();
+  REQUIRE(stats.dropped > 0);
+  REQUIRE(stats.closed == 0);
+
+  server.StopServer();
+  usleep(100000);
+  loop.QuitLoop();
+  loop.WaitLoopEnd();
+}
+
+TEST_CASE("ws.broadcaster_gone", "[broadcaster destroyed with task pending]") {
+  base::MessageLoop loop("ws_io");
+  loop.Start();
+  std::vector<base::MessageLoop*> loops = {&loop};
+
+  std::unique_ptr<net::WSBroadcaster> broadcaster(
+      new net::WSBroadcaster(loops));
+  TopicService service(broadcaster.get());
+  net::WsServer server;
+  server.WithIOLoops(loops);
+  server.Register("/chat", &service);
+  server.ServeAddress("ws://127.0.0.1:5023");
+  usleep(100000);
+
+  WSTestClient client;
+  std::string payload;
+  REQUIRE(client.Connect(5023));
+  REQUIRE(client.Send("sub news"));
+  REQUIRE(client.Recv(&payload));
+
+  // drain task pending in loop when broadcaster destroyed
+  loop.PostTask(FROM_HERE, []() { usleep(50000); });
+  for (int i = 0; i < 100; i++) {
+    broadcaster->Publish("news", "hello");
+  }
+  broadcaster.reset();
+  usleep(100000);
+
+  server.StopServer();
+  usleep(100000);
+  loop.QuitLoop();
+  loop.WaitLoopEnd();
+}